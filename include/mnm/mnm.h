@@ -342,8 +342,8 @@ double toc(void);
 ///
 /// Meshes are made out of one or two vertex buffers and optionally also one
 /// index buffer. The vertex data are split into position-only buffer / stream,
-/// and attributes-only one. Mesh types (static / transient / dynamic)
-/// correspond to BGFX notation.
+/// and attributes-only one (unless `VERTEX_INTERLEAVED` is used). Mesh types
+/// (static / transient / dynamic) correspond to BGFX notation.
 ///
 /// Transient meshes do not have index buffers, while index buffer of static and
 /// dynamic meshes is automatically created from the list of submitted vertices.
@@ -372,11 +372,16 @@ enum
     PRIMITIVE_LINE_STRIP     = 0x00040,
     PRIMITIVE_POINTS         = 0x00050,
 
-    // Vertex attribute flags. 3D position always on.
+    // Vertex attribute flags. 3D position always on (see `VERTEX_POSITION_2D`).
     VERTEX_COLOR             = 0x00080,
     VERTEX_NORMAL            = 0x00100,
     VERTEX_TEXCOORD          = 0x00200,
 
+    // Stores positions and attributes interleaved in a single vertex buffer,
+    // saving a vertex stream binding per submission. Only for static and
+    // dynamic meshes, and ignored for skinned ones.
+    VERTEX_INTERLEAVED       = 0x00800,
+
     // Texcoord uses full float range.
     TEXCOORD_F32             = 0x01000,
 
@@ -395,6 +400,16 @@ enum
     // be specified in the flags.
     GENEREATE_SMOOTH_NORMALS = 0x10000,
     GENEREATE_FLAT_NORMALS   = 0x20000,
+
+    // Records up to four joint indices and weights per vertex, so that the mesh
+    // can be deformed via `skin`. Only for dynamic meshes.
+    VERTEX_SKINNED           = 0x40000,
+
+    // Stores only the X and Y position components, for flat 2D content (UI,
+    // charts, text). The current matrix is applied as a 2D affine transform
+    // and the Z coordinate is dropped. Can't be combined with `VERTEX_SKINNED`
+    // or the normal generation flags.
+    VERTEX_POSITION_2D       = 0x80000,
 };
 
 /// Mesh draw state flags. Subset of the most comonly used ones from BGFX.
@@ -449,10 +464,19 @@ void begin_mesh(int id, int flags);
 ///
 void end_mesh(void);
 
+/// Destroys the mesh. Its GPU buffers are released once the current frame is
+/// submitted, so it's safe to call even after the mesh was already submitted.
+///
+/// @param[in] id Mesh identifier.
+///
+void destroy_mesh(int id);
+
 /// Emits a vertex with given coordinates and current state (color, etc.). The
 /// vertex position is multiplied by the current model matrix, unless the
 /// `NO_VERTEX_TRANSFORM` flag was provided in the `begin_mesh` call.
 ///
+/// With the `VERTEX_POSITION_2D` flag, the `z` coordinate is ignored.
+///
 /// @param[in] x X coordinate of the vertex.
 /// @param[in] y Y coordinate of the vertex.
 /// @param[in] z Z coordinate of the vertex.
@@ -481,12 +505,54 @@ void normal(float nx, float ny, float nz);
 ///
 void texcoord(float u, float v);
 
+/// Sets current joint indices. Only stored with the `VERTEX_SKINNED` flag.
+///
+/// @param[in] j0 First joint index.
+/// @param[in] j1 Second joint index.
+/// @param[in] j2 Third joint index.
+/// @param[in] j3 Fourth joint index.
+///
+void joints(int j0, int j1, int j2, int j3);
+
+/// Sets current joint weights. They should sum up to one, unused joints having
+/// zero weight. Only stored with the `VERTEX_SKINNED` flag.
+///
+/// @param[in] w0 Weight of the first joint.
+/// @param[in] w1 Weight of the second joint.
+/// @param[in] w2 Weight of the third joint.
+/// @param[in] w3 Weight of the fourth joint.
+///
+void weights(float w0, float w1, float w2, float w3);
+
+/// Deforms the mesh recorded with the `VERTEX_SKINNED` flag by linear blend
+/// skinning of its original vertices, and uploads the result into its vertex
+/// buffers. Normals are skinned too, if present. Large meshes are processed in
+/// parallel. Must not be called while the same mesh is being re-recorded.
+///
+/// @param[in] id Mesh identifier.
+/// @param[in] joint_matrices Column-major 4x4 matrices, one for each joint.
+/// @param[in] joint_count Number of joint matrices.
+///
+void skin(int id, const float* joint_matrices, int joint_count);
+
 /// Submits recorded mesh geometry.
 ///
 /// @param[in] id Mesh identifier.
 ///
 void mesh(int id);
 
+/// Submits recorded mesh geometry into multiple passes at once (e.g., shadow
+/// cascades or stereo views). The draw state is set only once and reused for
+/// each pass, which is cheaper than repeated `pass` and `mesh` calls. Doesn't
+/// change the active pass. Can't be used with occlusion queries, uniforms set
+/// via `uniform`, or while recording a draw list.
+///
+/// @param[in] id Mesh identifier.
+/// @param[in] passes Pass identifiers.
+/// @param[in] count Number of passes.
+///
+void mesh_multi(int id, const int* passes, int count);
+
 /// Sets alias for next submited mesh's vertex buffer.
 ///
 /// @param[in] flags Vertex attribute flags.
@@ -518,6 +584,215 @@ void state(int flags);
 ///
 void scissor(int x, int y, int width, int height);
 
+/// Issues an occlusion query for the next submitted mesh call, after which it
+/// gets cleared. Mesh's bounding box is drawn with the query, and the mesh
+/// itself is only rendered if the box was visible in the previous frame.
+///
+/// @param[in] id Query identifier, in range `0 ... limit(MAX_OCCLUSION_QUERIES) - 1`.
+///
+/// @attention The box only tests depth, so the occluders must be drawn before
+///   it, either in an earlier pass, or in the same pass with `SORT_SEQUENTIAL`.
+///
+void occlusion_query(int id);
+
+/// Returns whether the mesh submitted with given occlusion query was visible.
+/// Always nonzero if queries aren't supported (e.g., with the Noop renderer),
+/// or if the query's result isn't available yet.
+///
+/// @param[in] id Query identifier.
+///
+/// @returns Nonzero if visible.
+///
+int occlusion_visible(int id);
+
+
+// -----------------------------------------------------------------------------
+/// @section PROCEDURAL MESHES
+///
+/// Common primitives, generated directly as indexed static or dynamic meshes,
+/// which is much faster than recording them vertex by vertex. Apart from the
+/// mesh type, only `VERTEX_NORMAL`, `VERTEX_TEXCOORD`, `TEXCOORD_F32` and
+/// `NO_VERTEX_TRANSFORM` flags are supported.
+///
+/// Unless transformed by the current matrix, the primitives fit into the unit
+/// cube centered at the origin, with the rotationally symmetric ones having the
+/// Y axis as their axis.
+
+/// Creates a box mesh.
+///
+/// @param[in] id Mesh identifier.
+/// @param[in] flags Mesh flags.
+///
+void box_mesh(int id, int flags);
+
+/// Creates a plane mesh in the XZ plane, facing up.
+///
+/// @param[in] id Mesh identifier.
+/// @param[in] flags Mesh flags.
+/// @param[in] columns Number of subdivisions along the X axis.
+/// @param[in] rows Number of subdivisions along the Z axis.
+///
+void plane_mesh(int id, int flags, int columns, int rows);
+
+/// Creates a UV sphere mesh.
+///
+/// @param[in] id Mesh identifier.
+/// @param[in] flags Mesh flags.
+/// @param[in] segments Number of subdivisions around the axis (at least 3).
+/// @param[in] rings Number of subdivisions from pole to pole (at least 2).
+///
+void sphere_mesh(int id, int flags, int segments, int rings);
+
+/// Creates a sphere mesh by subdividing an icosahedron. Its triangles are more
+/// uniform than the UV sphere's, but the texture coordinates have a seam.
+///
+/// @param[in] id Mesh identifier.
+/// @param[in] flags Mesh flags.
+/// @param[in] subdivisions Number of subdivisions, in range `0 ... 7`. Each
+///   one quadruples the number of triangles.
+///
+void icosphere_mesh(int id, int flags, int subdivisions);
+
+/// Creates a capped cylinder mesh.
+///
+/// @param[in] id Mesh identifier.
+/// @param[in] flags Mesh flags.
+/// @param[in] segments Number of subdivisions around the axis (at least 3).
+///
+void cylinder_mesh(int id, int flags, int segments);
+
+/// Creates a capped cone mesh, with the apex pointing up.
+///
+/// @param[in] id Mesh identifier.
+/// @param[in] flags Mesh flags.
+/// @param[in] segments Number of subdivisions around the axis (at least 3).
+///
+void cone_mesh(int id, int flags, int segments);
+
+/// Creates a torus mesh lying in the XZ plane. The distance from its center to
+/// the center of the tube is 0.5.
+///
+/// @param[in] id Mesh identifier.
+/// @param[in] flags Mesh flags.
+/// @param[in] thickness Radius of the tube.
+/// @param[in] segments Number of subdivisions around the axis (at least 3).
+/// @param[in] sides Number of subdivisions around the tube (at least 3).
+///
+void torus_mesh(int id, int flags, float thickness, int segments, int sides);
+
+/// Creates a capsule mesh, made of two hemispheres joined by a cylinder.
+///
+/// @param[in] id Mesh identifier.
+/// @param[in] flags Mesh flags.
+/// @param[in] radius Radius of the hemispheres, in range `(0, 0.5]`.
+/// @param[in] segments Number of subdivisions around the axis (at least 3).
+/// @param[in] rings Number of subdivisions of each hemisphere (at least 1).
+///
+void capsule_mesh(int id, int flags, float radius, int segments, int rings);
+
+
+// -----------------------------------------------------------------------------
+/// @section SHAPES
+///
+/// Batched 2D shapes, meant for large amounts of simple geometry like UI
+/// elements or sprites. Shapes are transformed by the current model matrix
+/// right away, and submitted into the active pass at the end of the frame,
+/// merged into as few draw calls as possible. They are alpha-blended, without
+/// depth testing and face culling.
+///
+/// Shapes in the same pass are sorted by their layer, and then by texture, so
+/// the submission order of overlapping shapes on the same layer is not
+/// preserved. The layer is used as the sort depth, so it's only respected in
+/// passes with `SORT_SEQUENTIAL` or `SORT_FRONT_TO_BACK` modes.
+
+/// Sets the layer of subsequent shapes submitted from the current thread.
+///
+/// @param[in] layer Layer value (0 ... 65535). Zero by default.
+///
+void shape_layer(int layer);
+
+/// Submits a solid rectangle.
+///
+/// @param[in] x X coordinate of the top-left corner.
+/// @param[in] y Y coordinate of the top-left corner.
+/// @param[in] width Rectangle width.
+/// @param[in] height Rectangle height.
+/// @param[in] rgba Color value in hexadecimal format.
+///
+void rect(float x, float y, float width, float height, unsigned int rgba);
+
+/// Submits a solid rectangle with rounded corners. The tessellation density
+/// adapts to the radius (scaled by the current model matrix).
+///
+/// @param[in] x X coordinate of the top-left corner.
+/// @param[in] y Y coordinate of the top-left corner.
+/// @param[in] width Rectangle width.
+/// @param[in] height Rectangle height.
+/// @param[in] radius Corner radius, clamped to half of the smaller side.
+/// @param[in] rgba Color value in hexadecimal format.
+///
+void rounded_rect(float x, float y, float width, float height, float radius, unsigned int rgba);
+
+/// Submits a solid circle.
+///
+/// @param[in] x X coordinate of the center.
+/// @param[in] y Y coordinate of the center.
+/// @param[in] radius Circle radius.
+/// @param[in] rgba Color value in hexadecimal format.
+///
+void circle(float x, float y, float radius, unsigned int rgba);
+
+/// Submits a textured rectangle. The texture is modulated by the color.
+///
+/// @param[in] texture Texture identifier.
+/// @param[in] x X coordinate of the top-left corner.
+/// @param[in] y Y coordinate of the top-left corner.
+/// @param[in] width Rectangle width.
+/// @param[in] height Rectangle height.
+/// @param[in] u0 U texture coordinate of the top-left corner.
+/// @param[in] v0 V texture coordinate of the top-left corner.
+/// @param[in] u1 U texture coordinate of the bottom-right corner.
+/// @param[in] v1 V texture coordinate of the bottom-right corner.
+/// @param[in] rgba Color value in hexadecimal format.
+///
+void sprite(int texture, float x, float y, float width, float height, float u0, float v0, float u1, float v1, unsigned int rgba);
+
+/// Polyline flags.
+///
+enum
+{
+    // Join style. Miter joins longer than four times the line width are
+    // beveled.
+    LINE_JOIN_MITER = 0x0000,
+    LINE_JOIN_BEVEL = 0x0001,
+    LINE_JOIN_ROUND = 0x0002,
+
+    // Cap style of open polylines.
+    LINE_CAP_BUTT   = 0x0000,
+    LINE_CAP_SQUARE = 0x0004,
+    LINE_CAP_ROUND  = 0x0008,
+
+    // Last point is connected to the first one.
+    LINE_CLOSED     = 0x0010,
+};
+
+/// Submits a thick polyline. The edges are anti-aliased by a transparent
+/// fringe, which is one unit wide after the current model matrix is applied
+/// (i.e., a pixel, with a pixel-sized projection).
+///
+/// Long polylines are tessellated in parallel by the task scheduler.
+///
+/// @param[in] points Point coordinates as X and Y pairs.
+/// @param[in] count Number of points (at least two).
+/// @param[in] width Line width.
+/// @param[in] flags Join and cap style, and `LINE_CLOSED`.
+/// @param[in] rgba Color value in hexadecimal format.
+///
+/// @attention Overlapping parts of the line (e.g., the inner sides of the
+///   joins) are blended multiple times, which shows with translucent colors.
+///
+void polyline(const float* points, int count, float width, int flags, unsigned int rgba);
+
 
 // -----------------------------------------------------------------------------
 /// @section TEXTURING
@@ -548,7 +823,7 @@ enum
     TEXTURE_TARGET     = 0x0040,
     TEXTURE_READ_BACK  = 0x0080,
     TEXTURE_WRITE_ONLY = 0x0100,
-    TEXTURE_BLIT_DST   = 0x0200,
+    TEXTURE_BLIT_DST   = 0x0200, // Destination of `copy_texture`.
 };
 
 /// Automatic texture size related to backbuffer size. When a window is resized,
@@ -587,6 +862,14 @@ void load_texture(int id, int flags, int width, int height, int stride, const vo
 ///
 void create_texture(int id, int flags, int width, int height);
 
+/// Destroys the texture (or font atlas with the same ID). Its GPU resources are
+/// released once the current frame is submitted. Framebuffers using the texture
+/// aren't destroyed.
+///
+/// @param[in] id Texture identifier.
+///
+void destroy_texture(int id);
+
 /// Sets the active texture which is used with next `mesh` call, or, if called
 /// between `begin_framebuffer` and `end_framebuffer` calls, it adds the texture
 /// as the framebuffer's attachment.
@@ -632,6 +915,54 @@ int read_screen(void* data);
 int readable(int id);
 
 
+// -----------------------------------------------------------------------------
+/// @section TEXTURE COPY
+///
+/// GPU-side copies between textures (including framebuffer attachments),
+/// without a round trip through the CPU. Like the texture reads, copies are
+/// executed after all passes of the frame are rendered, in the order of the
+/// passes they were scheduled from.
+
+/// Schedules a copy of a rectangular region of one texture into another one.
+/// Both textures must have the same format, and the destination must have been
+/// created with `TEXTURE_BLIT_DST` flag. Depth textures can only be copied as a
+/// whole.
+///
+/// @param[in] dst Destination texture identifier.
+/// @param[in] dst_x X coordinate of the destination region's top-left corner.
+/// @param[in] dst_y Y coordinate of the destination region's top-left corner.
+/// @param[in] src Source texture identifier.
+/// @param[in] src_x X coordinate of the source region's top-left corner.
+/// @param[in] src_y Y coordinate of the source region's top-left corner.
+/// @param[in] width Region width in pixels.
+/// @param[in] height Region height in pixels.
+///
+/// @returns Non-zero if the copy was scheduled. Zero if the renderer doesn't
+///   support texture blits (e.g., in headless runs), if no encoder was
+///   available, or if the copy failed validation (e.g., the region doesn't fit
+///   into either texture). Each of the reasons is logged separately.
+///
+int copy_texture(int dst, int dst_x, int dst_y, int src, int src_x, int src_y, int width, int height);
+
+/// Same as `copy_texture`, but between given mip levels, whose sizes the
+/// region is checked against.
+///
+/// @param[in] dst Destination texture identifier.
+/// @param[in] dst_mip Destination mip level.
+/// @param[in] dst_x X coordinate of the destination region's top-left corner.
+/// @param[in] dst_y Y coordinate of the destination region's top-left corner.
+/// @param[in] src Source texture identifier.
+/// @param[in] src_mip Source mip level.
+/// @param[in] src_x X coordinate of the source region's top-left corner.
+/// @param[in] src_y Y coordinate of the source region's top-left corner.
+/// @param[in] width Region width in pixels.
+/// @param[in] height Region height in pixels.
+///
+/// @returns Non-zero if the copy was scheduled.
+///
+int copy_texture_mip(int dst, int dst_mip, int dst_x, int dst_y, int src, int src_mip, int src_x, int src_y, int width, int height);
+
+
 // -----------------------------------------------------------------------------
 /// @section INSTANCING
 ///
@@ -687,6 +1018,161 @@ void instance(const void* data);
 void instances(int id);
 
 
+// -----------------------------------------------------------------------------
+/// @section PARTICLES
+///
+/// CPU-simulated particle emitters, rendered as camera-facing quads with a
+/// single instanced draw call. Particles are spawned at the emitter's origin
+/// and simulated in its local space, which is transformed by the current model
+/// matrix when submitted.
+///
+/// Every random value is drawn from the emitter's own generator, so given the
+/// same seed and sequence of time steps, the simulation always arrives at the
+/// same state, regardless of how it was split among the worker threads.
+///
+/// @attention An emitter must not be used from more threads at once.
+
+/// Particle property curves over the normalized particle age. All of them are
+/// constant one by default.
+///
+enum
+{
+    // Particle size (quad side length).
+    PARTICLE_SIZE,
+
+    // Velocity multiplier.
+    PARTICLE_SPEED,
+
+    // Acceleration multiplier.
+    PARTICLE_ACCELERATION,
+};
+
+/// Starts the definition of a particle emitter. Any existing particles and
+/// parameters of the emitter are discarded.
+///
+/// @param[in] id Emitter identifier (0 ... 63).
+/// @param[in] capacity Maximum number of simultaneously alive particles.
+/// @param[in] seed Random generator seed.
+///
+void begin_particles(int id, int capacity, unsigned int seed);
+
+/// Ends the current particle emitter definition.
+///
+void end_particles(void);
+
+/// Sets the number of particles spawned per second. Zero by default.
+///
+/// @param[in] rate Spawn rate.
+///
+void particle_rate(float rate);
+
+/// Sets the range the particle lifetime is randomly chosen from. One second by
+/// default.
+///
+/// @param[in] shortest Minimum lifetime in seconds (positive).
+/// @param[in] longest Maximum lifetime in seconds.
+///
+void particle_lifetime(float shortest, float longest);
+
+/// Sets the initial particle velocity. Each of its components is randomly
+/// offset by up to `spread` in both directions.
+///
+/// @param[in] x Velocity X component.
+/// @param[in] y Velocity Y component.
+/// @param[in] z Velocity Z component.
+/// @param[in] spread Maximum random offset.
+///
+void particle_velocity(float x, float y, float z, float spread);
+
+/// Sets the constant particle acceleration (e.g., gravity), scaled by the
+/// `PARTICLE_ACCELERATION` curve.
+///
+/// @param[in] x Acceleration X component.
+/// @param[in] y Acceleration Y component.
+/// @param[in] z Acceleration Z component.
+///
+void particle_acceleration(float x, float y, float z);
+
+/// Adds a key to one of the `PARTICLE_*` curves. The curves are piecewise
+/// linear, with up to eight keys each.
+///
+/// @param[in] curve Curve type.
+/// @param[in] t Normalized particle age (0 ... 1).
+/// @param[in] value Curve value.
+///
+void particle_curve(int curve, float t, float value);
+
+/// Adds a key to the color curve (white by default). The color is interpolated
+/// like the `PARTICLE_*` curves.
+///
+/// @param[in] t Normalized particle age (0 ... 1).
+/// @param[in] rgba Color value in hexadecimal format.
+///
+void particle_color(float t, unsigned int rgba);
+
+/// Advances the emitter's simulation by a single time step. Long-lived emitters
+/// are split among the worker threads.
+///
+/// @param[in] id Emitter identifier.
+/// @param[in] dt Time step in seconds.
+///
+void update_particles(int id, float dt);
+
+/// Returns the number of alive particles.
+///
+/// @param[in] id Emitter identifier.
+///
+/// @returns Particle count.
+///
+int particle_count(int id);
+
+/// Submits the emitter's particles into the active pass. Unless a different
+/// state was set, they're alpha-blended and depth-tested without depth writes.
+///
+/// @param[in] id Emitter identifier.
+///
+/// @attention Particles aren't sorted by depth.
+///
+void particles(int id);
+
+
+// -----------------------------------------------------------------------------
+/// @section DRAW LISTS
+///
+/// Draw lists capture a sequence of `mesh` submissions, together with their
+/// fully resolved draw state, so that it can be cheaply replayed every frame.
+/// Meshes are referenced by their identifiers, so re-recording a mesh doesn't
+/// invalidate the lists it appears in (as long as its attributes stay same).
+
+/// Starts draw list recording. All `mesh` calls (and the preceding `texture`,
+/// `state`, `shader`, `uniform`, `alias` and `range` calls) until the
+/// `end_draw_list` call are captured instead of being submitted. The current
+/// matrix stack's top is captured for each submission as well.
+///
+/// Using existing ID will result in destruction of the previously recorded
+/// list.
+///
+/// @param[in] id Draw list identifier.
+///
+/// @attention Instance buffers and scissor can't be recorded.
+///
+void begin_draw_list(int id);
+
+/// Ends the current draw list recording.
+///
+void end_draw_list(void);
+
+/// Replays the recorded draw list into the active pass. The current matrix
+/// stack's top is applied on top of each of the captured transformations.
+///
+/// @param[in] id Draw list identifier.
+///
+/// @attention Replays of the same list (and its re-recording) are serialized,
+///   only different lists get submitted from multiple threads in parallel.
+///
+void draw_list(int id);
+
+
 // -----------------------------------------------------------------------------
 /// @section FONT ATLASES
 ///
@@ -696,6 +1182,14 @@ void instances(int id);
 ///
 void create_font(int id, const void* data);
 
+/// Destroys the font face, together with all atlases created from it (their
+/// textures are released once the current frame is submitted). The data blob
+/// passed to `create_font` can be freed afterwards.
+///
+/// @param[in] id Font identifier.
+///
+void destroy_font(int id);
+
 /// Text atlas flags.
 ///
 enum
@@ -777,6 +1271,9 @@ enum
 
     // Aligns glyph quads to integer coordinates.
     TEXT_ALIGN_TO_INTEGER   = 0x0800,
+
+    // Stores only 2D glyph positions (see `VERTEX_POSITION_2D`).
+    TEXT_POSITION_2D        = 0x1000,
 };
 
 /// Starts text mesh recording. Internally, the regular mesh recorder is used,
@@ -901,6 +1398,100 @@ void viewport(int x, int y, int width, int height);
 ///
 void full_viewport(void);
 
+/// Pass submission sort modes.
+///
+enum
+{
+    // Sorted by the program and draw state (default).
+    SORT_STATE,
+
+    // Kept in the order of submission.
+    SORT_SEQUENTIAL,
+
+    // Sorted by the distance of mesh's bounding box center from the camera.
+    SORT_FRONT_TO_BACK,
+    SORT_BACK_TO_FRONT,
+};
+
+/// Sets the order in which the submissions in the active pass are rendered.
+/// Depth-sorted modes use the pass' view transformation, so it should be set
+/// before any meshes are submitted.
+///
+/// @param[in] mode Sort mode.
+///
+void pass_sort(int mode);
+
+/// Enables or disables frustum culling in the active pass. When enabled, each
+/// `mesh` submission's bounding volumes (computed when the mesh is recorded)
+/// are tested against the pass' view and projection transformations, and
+/// invisible meshes are skipped. Disabled by default.
+///
+/// Submissions with an instance buffer or recorded into a draw list are never
+/// culled.
+///
+/// @param[in] enabled Non-zero to enable frustum culling.
+///
+void frustum_culling(int enabled);
+
+/// Returns the number of `mesh` submissions culled in the active pass during
+/// the previous frame.
+///
+/// @returns Culled submission count.
+///
+int culled_count(void);
+
+/// Enables or disables automatic instancing in the active pass. When enabled,
+/// `mesh` submissions that share the same mesh, texture and draw state, and use
+/// a default program with an instancing variant, are deferred until the end of
+/// the frame and merged into a single instanced draw call, using the matrix
+/// stack's top from each submission as the per-instance transform.
+///
+/// Submissions with a custom shader, uniforms, scissor, element range or an
+/// explicit instance buffer are always submitted immediately. Disabled by
+/// default.
+///
+/// @param[in] enabled Non-zero to enable automatic instancing.
+///
+/// @attention The order of the submissions merged into one draw call is not
+///   preserved.
+///
+void auto_instancing(int enabled);
+
+/// Enables or disables dirty-region rendering in the active pass, which must
+/// render into the backbuffer with a full viewport. When enabled, the pass is
+/// rendered into a persistent color target instead, only the union of the
+/// rectangles marked via `damage` is cleared (always both color and depth,
+/// with the pass' clear values) and redrawn each frame, and the whole target is
+/// then blended over the backbuffer as premultiplied color. `mesh` submissions
+/// whose screen-space bounds don't intersect the damaged region are skipped on
+/// the CPU (and counted in `culled_count`). Disabled by default.
+///
+/// Enabling it, as well as resizing the window, damages the whole pass.
+/// Submissions with an instance buffer or recorded into a draw list are never
+/// skipped.
+///
+/// @param[in] enabled Non-zero to enable dirty-region rendering.
+///
+/// @attention The composited target is drawn over the backbuffer after all the
+///   passes, so the pass should be the last one rendering into it (e.g., a UI
+///   overlay of a mostly static 2D tool). To keep the content of the earlier
+///   passes visible, clear the pass to a transparent color.
+///
+void dirty_regions(int enabled);
+
+/// Marks a rectangle of the active pass as damaged in the current frame.
+/// Coordinates are in pixels, with the origin in the top-left corner. Must be
+/// called before the affected `mesh` submissions.
+///
+/// @param[in] x Left edge.
+/// @param[in] y Top edge.
+/// @param[in] width Rectangle width.
+/// @param[in] height Rectangle height.
+///
+/// @warning The dirty-region rendering must be enabled in the active pass.
+///
+void damage(int x, int y, int width, int height);
+
 
 // -----------------------------------------------------------------------------
 /// @section FRAMEBUFFERS
@@ -924,6 +1515,151 @@ void begin_framebuffer(int id);
 ///
 void end_framebuffer(void);
 
+/// Destroys the framebuffer, but not its textures. Passes rendering into it
+/// are switched to the backbuffer. The GPU resource is released once the
+/// current frame is submitted.
+///
+/// @param[in] id Framebuffer identifier.
+///
+void destroy_framebuffer(int id);
+
+
+// -----------------------------------------------------------------------------
+/// @section RENDER GRAPH
+///
+/// Render graph is an alternative to manually managed framebuffers. Each frame,
+/// passes declare the transient targets they read and write, and the library
+/// derives the pass order, culls passes that don't contribute to any output
+/// pass, and lets targets with matching parameters and non-overlapping
+/// lifetimes share the same texture. The graph has to be declared and compiled
+/// again every frame, before any submissions into its passes.
+
+/// Render graph pass flags.
+///
+enum
+{
+    // Pass result is consumed outside of the graph (e.g., it renders into the
+    // backbuffer). Only output passes and their dependencies are kept.
+    GRAPH_OUTPUT = 0x0001,
+};
+
+/// Declares a transient render target for the current frame.
+///
+/// @param[in] id Target identifier (0 ... 63).
+/// @param[in] flags Texture flags (`TEXTURE_TARGET` is implied, and
+///   `TEXTURE_READ_BACK` isn't supported).
+/// @param[in] width Width in pixels, or one of `SIZE_*` values.
+/// @param[in] height Height in pixels, or the same `SIZE_*` value as `width`.
+///
+/// @attention Must be called from the main thread only.
+///
+void graph_target(int id, int flags, int width, int height);
+
+/// Starts the declaration of a pass' dependencies. Passes writing into any
+/// target have their framebuffer set by the graph for the current frame.
+///
+/// @param[in] id Pass identifier.
+/// @param[in] flags Pass flags.
+///
+/// @attention Must be called from the main thread only.
+///
+void begin_graph_pass(int id, int flags);
+
+/// Declares that the pass being declared samples the target.
+///
+/// @param[in] id Target identifier.
+///
+void graph_read(int id);
+
+/// Declares that the pass being declared renders into the target. Up to eight
+/// targets can be written by a single pass.
+///
+/// @param[in] id Target identifier.
+///
+void graph_write(int id);
+
+/// Ends the pass declaration.
+///
+void end_graph_pass(void);
+
+/// Compiles the declared graph, assigns the textures and framebuffers, and
+/// reorders the passes. Submissions into culled passes are ignored for the
+/// rest of the frame.
+///
+/// @attention Must be called from the main thread only.
+///
+void compile_graph(void);
+
+/// Uses the target's texture in subsequent submissions. Only valid after the
+/// graph was compiled in the current frame.
+///
+/// @param[in] id Target identifier.
+///
+void graph_texture(int id);
+
+
+// -----------------------------------------------------------------------------
+/// @section LAYERS
+///
+/// Layers are offscreen images with persistent content, meant for complex UI
+/// panels that rarely change. Their content is only rendered when the layer is
+/// created, resized or invalidated, and drawn as a single textured rectangle
+/// otherwise.
+///
+/// A layer is rendered in the pass that's active when it's begun, which gets
+/// its framebuffer and viewport set to the layer's target, and shouldn't be
+/// used for anything else. The content is cleared according to the pass'
+/// settings whenever it's redrawn (so typically `clear_color(0x00000000)` is
+/// desired), and should use a transformation matching the layer size (e.g., a
+/// pixel-sized `ortho` projection). The pass isn't touched while the layer is
+/// clean, so the target keeps its content.
+
+/// Starts the layer. The content has to be submitted only if the function
+/// returns non-zero, but `end_layer` has to be called in either case. Other
+/// submissions into the pass are ignored while the layer is clean.
+///
+/// @param[in] id Layer identifier (0 ... 63).
+/// @param[in] width Width in pixels, or one of `SIZE_*` values.
+/// @param[in] height Height in pixels, or the same `SIZE_*` value as `width`.
+///   Layer content is redrawn whenever the resulting size changes, so layers
+///   with `SIZE_*` values follow the window size.
+///
+/// @returns Non-zero if the layer content has to be rendered.
+///
+/// @attention Must be called from the main thread only.
+///
+int begin_layer(int id, int width, int height);
+
+/// Ends the layer started by `begin_layer`.
+///
+void end_layer(void);
+
+/// Marks the layer content as invalid, so it gets rendered again the next time
+/// the layer is begun.
+///
+/// @param[in] id Layer identifier.
+///
+void invalidate_layer(int id);
+
+/// Destroys the layer's target. The pass it was rendered in is switched to the
+/// backbuffer. The GPU resource is released once the current frame is
+/// submitted.
+///
+/// @param[in] id Layer identifier.
+///
+/// @attention Must be called from the main thread only.
+///
+void destroy_layer(int id);
+
+/// Submits the layer's content as an alpha-blended rectangle (transformed by
+/// the current model matrix) spanning from the origin to the layer size, the
+/// same way as `sprite`. Layers are rendered in the order of their passes, so
+/// the layer's pass must precede the active one.
+///
+/// @param[in] id Layer identifier.
+///
+void layer(int id);
+
 
 // -----------------------------------------------------------------------------
 /// @section SHADERS
@@ -1099,6 +1835,76 @@ void scale(float scale);
 void translate(float x, float y, float z);
 
 
+// -----------------------------------------------------------------------------
+/// @section TRANSFORM HIERARCHY
+///
+/// Global hierarchy of nodes with local translation, rotation and scale. World
+/// matrices are only recomputed for nodes whose local transform (or that of any
+/// of their ancestors) changed since the last update. Large hierarchies are
+/// updated level by level, with the nodes of each level split among the worker
+/// threads.
+///
+/// Node's local transform is applied in the scale, rotation, translation order,
+/// and the result is then transformed by its parent's world matrix.
+
+/// Creates a node with an identity local transform, or changes its parent if
+/// it already exists. Must be called from the main thread.
+///
+/// @param[in] id Node identifier (0 ... 1048575).
+/// @param[in] parent Parent node identifier, or negative value for root nodes.
+///
+void node(int id, int parent);
+
+/// Sets the node's local translation.
+///
+/// @param[in] id Node identifier.
+/// @param[in] x X coordinate of the translation vector.
+/// @param[in] y Y coordinate of the translation vector.
+/// @param[in] z Z coordinate of the translation vector.
+///
+void node_translation(int id, float x, float y, float z);
+
+/// Sets the node's local rotation.
+///
+/// @param[in] id Node identifier.
+/// @param[in] angle Angle of rotation in degrees.
+/// @param[in] x X direction of the rotation axis vector.
+/// @param[in] y Y direction of the rotation axis vector.
+/// @param[in] z Z direction of the rotation axis vector.
+///
+void node_rotation(int id, float angle, float x, float y, float z);
+
+/// Sets the node's local scale.
+///
+/// @param[in] id Node identifier.
+/// @param[in] x Scale factor in the X direction.
+/// @param[in] y Scale factor in the Y direction.
+/// @param[in] z Scale factor in the Z direction.
+///
+void node_scale(int id, float x, float y, float z);
+
+/// Recomputes world matrices of the changed nodes. Must be called from the
+/// main thread, and no node functions may be called concurrently.
+///
+void update_nodes(void);
+
+/// Multiplies the top of the active matrix stack with the node's world matrix,
+/// as computed by the last `update_nodes` call.
+///
+/// @param[in] id Node identifier.
+///
+void node_transform(int id);
+
+/// Returns the node's world matrix, as computed by the last `update_nodes`
+/// call. The column-major matrix can be directly used as instance data.
+///
+/// @param[in] id Node identifier.
+///
+/// @returns Pointer to sixteen floats, valid until the next `node` call.
+///
+const float* node_matrix(int id);
+
+
 // -----------------------------------------------------------------------------
 /// @section MULTITHREADING
 ///
@@ -1237,6 +2043,18 @@ int renderer(void);
 ///
 void transient_memory(int megabytes);
 
+/// Enables the on-disk cache of compiled shader programs, so that the graphics
+/// driver doesn't have to compile them again in the subsequent runs (only some
+/// backends make use of it). Disabled by default. Must be called in the `init`
+/// callback (otherwise has no effect).
+///
+/// @param[in] directory Cache directory, created if it doesn't exist. Passing
+///   `NULL` or an empty string disables the cache.
+/// @param[in] megabytes Cache size limit in MB. Oldest programs are evicted
+///   when it's exceeded.
+///
+void shader_cache(const char* directory, int megabytes);
+
 /// Returns the current frame number, starting with zero-th frame.
 ///
 /// @returns Frame number.
@@ -1246,19 +2064,37 @@ int frame(void);
 enum
 {
     MAX_FONTS,
-    // MAX_FRAMEBUFFERS,
-    // MAX_INSTANCE_BUFFERS,
-    // MAX_MESHES,
-    // MAX_PASSES,
-    // MAX_SHADERS,
-    // MAX_TEXTURES,
-    // MAX_UNIFORMS,
+    MAX_OCCLUSION_QUERIES,
+    MAX_ENCODERS,
+    MAX_FRAMEBUFFERS,
+    MAX_INSTANCE_BUFFERS,
+    MAX_MESHES,
+    MAX_PASSES,
+    MAX_SHADERS,
+    MAX_TEXTURES,
+    MAX_UNIFORMS,
 };
 
-/// Returns the limit / maximum count of a particular resource type.
+/// Returns the limit / maximum count of a particular resource type. Resource
+/// IDs must be smaller than the limit.
 ///
 int limit(int resource);
 
+/// Sets the maximum count of a particular resource type. Only encoders,
+/// framebuffers, instance buffers, meshes, occlusion queries, passes, shaders,
+/// textures and uniforms can be changed, up to 65535 (128 for encoders and
+/// passes). Must be called in the `init` callback (otherwise has no effect).
+///
+/// Encoders limit how many threads can submit draws in a single frame, and
+/// default to the number of threads the library uses. Submissions from threads
+/// that run out of encoders are dropped for the rest of the frame (with a
+/// warning in debug builds).
+///
+/// @param[in] resource Resource type (e.g., `MAX_MESHES`).
+/// @param[in] count Maximum resource count.
+///
+void set_limit(int resource, int count);
+
 
 // -----------------------------------------------------------------------------
 /// @section MAIN ENTRY
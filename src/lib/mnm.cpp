@@ -359,6 +359,12 @@ public:
     {
         m_handles .fill(BGFX_INVALID_HANDLE);
         m_builtins.fill(BGFX_INVALID_HANDLE);
+        m_sources .fill({});
+
+        for (Atomic<bool>& created : m_created)
+        {
+            created.store(false);
+        }
     }
 
     void clear()
@@ -374,6 +380,12 @@ public:
         {
             destroy_if_valid(handle);
         }
+
+        // So that the builtins get recreated on their next use.
+        for (Atomic<bool>& created : m_created)
+        {
+            created.store(false, std::memory_order_release);
+        }
     }
 
     bool add(u16 id, bgfx::ShaderHandle vertex, bgfx::ShaderHandle fragment, u32 attribs = UINT32_MAX)
@@ -444,10 +456,54 @@ public:
         return m_handles[id];
     }
 
-    inline bgfx::ProgramHandle builtin(u32 attribs) const
+    // Only remembers the shader names, the program itself is created on the
+    // first `builtin` call with matching attributes.
+    void add_builtin(u32 attribs, const bgfx::EmbeddedShader* shaders, bgfx::RendererType::Enum renderer, const char* vs_name, const char* fs_name = nullptr)
+    {
+        BuiltinSource& source = m_sources[get_index_from_attribs(attribs)];
+
+        source.shaders  = shaders;
+        source.renderer = renderer;
+        source.vs_name  = vs_name;
+        source.fs_name  = fs_name ? fs_name : vs_name;
+    }
+
+    bgfx::ProgramHandle builtin(u32 attribs)
     {
-        auto idx = get_index_from_attribs(attribs);
-        return m_builtins[get_index_from_attribs(attribs)];
+        const u16 idx = get_index_from_attribs(attribs);
+
+        if (!m_created[idx].load(std::memory_order_acquire))
+        {
+            MutexScope lock(m_mutex);
+
+            if (!m_created[idx].load(std::memory_order_relaxed))
+            {
+                const BuiltinSource& source = m_sources[idx];
+
+                if (source.shaders)
+                {
+                    char vs_name[32];
+                    char fs_name[32];
+
+                    strcpy(vs_name, source.vs_name);
+                    strcat(vs_name, "_vs");
+
+                    strcpy(fs_name, source.fs_name);
+                    strcat(fs_name, "_fs");
+
+                    bgfx::ShaderHandle vertex   = bgfx::createEmbeddedShader(source.shaders, source.renderer, vs_name);
+                    bgfx::ShaderHandle fragment = bgfx::createEmbeddedShader(source.shaders, source.renderer, fs_name);
+                    ASSERT(bgfx::isValid(vertex) && bgfx::isValid(fragment));
+
+                    m_builtins[idx] = bgfx::createProgram(vertex, fragment, true);
+                    ASSERT(bgfx::isValid(m_builtins[idx]));
+                }
+
+                m_created[idx].store(true, std::memory_order_release);
+            }
+        }
+
+        return m_builtins[idx];
     }
 
 private:
@@ -469,11 +525,21 @@ private:
     }
 
 private:
+    struct BuiltinSource
+    {
+        const bgfx::EmbeddedShader* shaders;
+        bgfx::RendererType::Enum    renderer;
+        const char*                 vs_name;
+        const char*                 fs_name;
+    };
+
     static constexpr u32                MAX_BUILTINS = 64;
 
     Mutex                                    m_mutex;
     Array<bgfx::ProgramHandle, MAX_PROGRAMS> m_handles;
     Array<bgfx::ProgramHandle, MAX_BUILTINS> m_builtins;
+    Array<BuiltinSource      , MAX_BUILTINS> m_sources;
+    Array<Atomic<bool>       , MAX_BUILTINS> m_created;
 };
 
 
@@ -1765,18 +1831,9 @@ int run(void (* init)(void), void (*setup)(void), void (*draw)(void), void (*cle
             },
         };
 
-        char vs_name[32];
-        char fs_name[32];
-
         for (size_t i = 0; i < BX_COUNTOF(programs); i++)
         {
-            strcpy(vs_name, programs[i].vs_name);
-            strcat(vs_name, "_vs");
-
-            strcpy(fs_name, programs[i].fs_name ? programs[i].fs_name : programs[i].vs_name);
-            strcat(fs_name, "_fs");
-
-            (void)g_ctx.program_cache.add(UINT16_MAX, s_shaders, type, vs_name, fs_name, programs[i].attribs);
+            g_ctx.program_cache.add_builtin(programs[i].attribs, s_shaders, type, programs[i].vs_name, programs[i].fs_name);
         }
     }
 
@@ -16,4 +16,13 @@
 #include <shaders/position_color_r_texcoord_fs.h> // position_color_r_texcoord_fs
 #include <shaders/position_color_r_pixcoord_fs.h> // position_color_r_pixcoord_fs
 
-#include <shaders/instancing_position_color_vs.h> // instancing_position_color_vs
\ No newline at end of file
+#include <shaders/instancing_billboard_color_vs.h> // instancing_billboard_color_vs
+#include <shaders/instancing_position_color_vs.h>  // instancing_position_color_vs
+
+#include <shaders/position_2d_vs.h>                   // position_2d_vs
+#include <shaders/position_2d_color_vs.h>             // position_2d_color_vs
+#include <shaders/position_2d_color_normal_vs.h>      // position_2d_color_normal_vs
+#include <shaders/position_2d_color_texcoord_vs.h>    // position_2d_color_texcoord_vs
+#include <shaders/position_2d_normal_vs.h>            // position_2d_normal_vs
+#include <shaders/position_2d_texcoord_vs.h>          // position_2d_texcoord_vs
+#include <shaders/instancing_position_2d_color_vs.h>  // instancing_position_2d_color_vs
\ No newline at end of file
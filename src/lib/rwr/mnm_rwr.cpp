@@ -1,10 +1,11 @@
 #include <mnm/mnm.h>
 
+#include <float.h>                // FLT_MAX
 #include <inttypes.h>             // PRI*, SCNuPTR
-#include <math.h>                 // acosf
+#include <math.h>                 // acosf, atan2f, ceilf, cosf, sinf, sqrtf
 #include <stddef.h>               // offsetof, size_t
 #include <stdint.h>               // *int*_t, ptrdiff_t, UINT*_MAX, uintptr_t
-#include <stdio.h>                // sscanf
+#include <stdio.h>                // fclose, fgetc, fopen, fread, fwrite, remove, rename, sscanf
 
 #include <algorithm>              // sort, unique
 #include <thread>                 // hardware_concurrency
@@ -13,11 +14,15 @@
 #include <bx/allocator.h>         // alignPtr, AllocatorI, BX_ALIGNED_*
 #include <bx/bx.h>                // BX_ASSERT, BX_CONCATENATE, BX_WARN, memCmp, memCopy, min/max
 #include <bx/cpu.h>               // atomicFetchAndAdd, atomicCompareAndSwap
+#include <bx/debug.h>             // debugPrintf
 #include <bx/endian.h>            // endianSwap
+#include <bx/file.h>              // makeAll
+#include <bx/filepath.h>          // FilePath
 #include <bx/mutex.h>             // Mutex, MutexScope
-#include <bx/pixelformat.h>       // packRg16S, packRgb8
+#include <bx/pixelformat.h>       // packRg16S, packRgb8, unpackRgb8
 #include <bx/platform.h>          // BX_CACHE_LINE_SIZE
 #include <bx/ringbuffer.h>        // RingBufferControl
+#include <bx/simd_t.h>            // simd128_t, simd_ld, simd_madd, simd_max, simd_min, simd_mul, simd_splat, simd_st, simd_swiz_*, simd_x/y/z, simd_zero
 #include <bx/string.h>            // strCat, strCopy
 #include <bx/timer.h>             // getHPCounter, getHPFrequency
 #include <bx/uint32_t.h>          // alignUp
@@ -134,6 +139,7 @@ using f64 = double;
 constexpr u8  U8_MAX  = UINT8_MAX;
 constexpr u16 U16_MAX = UINT16_MAX;
 constexpr u32 U32_MAX = UINT32_MAX;
+constexpr u64 U64_MAX = UINT64_MAX;
 
 
 // -----------------------------------------------------------------------------
@@ -157,13 +163,20 @@ constexpr u32 INSTANCING_SUPPORTED     = 0x100000;
 constexpr u32 SAMPLER_COLOR_R          = 0x200000;
 constexpr u32 TEXT_MESH                = 0x400000;
 constexpr u32 VERTEX_PIXCOORD          = 0x800000;
+constexpr u32 BILLBOARD_MESH           = 0x1000000;
 
-// TODO : Ideally these are overridable by user via preprocessor directives. 
+// TODO : Ideally these are overridable by user via preprocessor directives.
+// NOTE : Counts of resources that are also in `Limits` are just the defaults.
+constexpr u32 MAX_DRAW_LISTS           = 256;
 constexpr u32 MAX_FONTS                = 128;
 constexpr u32 MAX_FONT_ATLASES         = 32;
 constexpr u32 MAX_FRAMEBUFFERS         = 128;
+constexpr u32 MAX_GRAPH_ATTACHMENTS    = 8;   // Default `BGFX_CONFIG_MAX_FRAME_BUFFER_ATTACHMENTS`.
+constexpr u32 MAX_GRAPH_PASSES         = 128; // Maximum pass count.
+constexpr u32 MAX_GRAPH_TARGETS        = 64;  // Target sets are stored as 64-bit masks.
 constexpr u32 MAX_INSTANCE_BUFFERS     = 32;
 constexpr u32 MAX_MESHES               = 4096;
+constexpr u32 MAX_OCCLUSION_QUERIES    = 256;
 constexpr u32 MAX_PASSES               = 64;
 constexpr u32 MAX_PROGRAMS             = 128;
 constexpr u32 MAX_TASKS                = 64;
@@ -171,6 +184,15 @@ constexpr u32 MAX_TEXTURES             = 1024;
 constexpr u32 MAX_TRANSIENT_BUFFERS    = 64;
 constexpr u32 MAX_UNIFORMS             = 256;
 
+constexpr u32 MAX_BGFX_ENCODERS        = 128; // Hard limit on `bgfx::Init::Limits::maxEncoders`.
+constexpr u32 MAX_BGFX_VIEWS           = 256; // Default `BGFX_CONFIG_MAX_VIEWS`.
+
+constexpr u16 LINE_CAP_MASK            = LINE_CAP_SQUARE |
+                                         LINE_CAP_ROUND  ;
+
+constexpr u16 LINE_JOIN_MASK           = LINE_JOIN_BEVEL |
+                                         LINE_JOIN_ROUND ;
+
 constexpr u16 MESH_TYPE_MASK           = MESH_STATIC    |
                                          MESH_TRANSIENT |
                                          MESH_DYNAMIC   |
@@ -231,12 +253,16 @@ constexpr u32 USER_MESH_FLAGS          = MESH_TYPE_MASK           |
                                          NO_VERTEX_TRANSFORM      |
                                          KEEP_CPU_GEOMETRY        |
                                          GENEREATE_SMOOTH_NORMALS |
-                                         GENEREATE_FLAT_NORMALS   ;
+                                         GENEREATE_FLAT_NORMALS   |
+                                         VERTEX_SKINNED           |
+                                         VERTEX_POSITION_2D       |
+                                         VERTEX_INTERLEAVED       ;
 
 constexpr u32 INTERNAL_MESH_FLAGS      = INSTANCING_SUPPORTED     |
                                          SAMPLER_COLOR_R          |
                                          TEXT_MESH                |
-                                         VERTEX_PIXCOORD          ;
+                                         VERTEX_PIXCOORD          |
+                                         BILLBOARD_MESH           ;
 
 static_assert(
     0 == (INTERNAL_MESH_FLAGS & USER_MESH_FLAGS),
@@ -257,6 +283,10 @@ static_assert(
 #define TRACE  BX_TRACE
 #define WARN   BX_WARN
 
+// Unlike `TRACE`, printed in release builds as well.
+#define INFO(format, ...) \
+    bx::debugPrintf("MiNiMo: " format "\n", ##__VA_ARGS__)
+
 
 // -----------------------------------------------------------------------------
 // CONCURRENCY-RELATED TYPES
@@ -392,6 +422,8 @@ using Vec3 = hmm_vec3;
 
 using Vec4 = hmm_vec4;
 
+using Quat = hmm_quaternion;
+
 struct Vec2i
 {
     i32 X;
@@ -1226,6 +1258,121 @@ void init_frame(DoubleFrameAllocator& allocator)
 }
 
 
+// -----------------------------------------------------------------------------
+// HANDLE TABLE
+// -----------------------------------------------------------------------------
+
+// Resource slots addressed by (user-provided) IDs. The size is only set once,
+// from the configured limits, so that the slots never move and can be read
+// without locking. Each slot has a generation, bumped every time its content
+// gets replaced, so that retained references can detect they went stale.
+template <typename T>
+struct HandleTable
+{
+    static_assert(
+        std::is_trivially_copyable<T>::value,
+        "`HandleTable` only supports trivially copyable types."
+    );
+
+    T*         data        = nullptr;
+    u16*       generations = nullptr;
+    u32        size        = 0;
+    Allocator* allocator   = nullptr;
+
+    const T& operator[](u32 i) const
+    {
+        ASSERT(data, "Invalid data pointer.");
+        ASSERT(i < size, "Index %" PRIu32 " out of range %" PRIu32 ".", i, size);
+
+        return data[i];
+    }
+
+    T& operator[](u32 i)
+    {
+        ASSERT(data, "Invalid data pointer.");
+        ASSERT(i < size, "Index %" PRIu32 " out of range %" PRIu32 ".", i, size);
+
+        return data[i];
+    }
+
+    operator Span<T>() const
+    {
+        return { data, size };
+    }
+};
+
+struct Handle
+{
+    u16 id;
+    u16 generation;
+};
+
+template <typename T>
+void init(HandleTable<T>& table, Allocator* allocator, u32 size, const T& value = {})
+{
+    ASSERT(!table.data, "Table already initialized.");
+    ASSERT(allocator, "Invalid allocator pointer.");
+    ASSERT(size > 0 && size <= U16_MAX, "Invalid table size %" PRIu32 ".", size);
+
+    table.data = static_cast<T*>(BX_ALIGNED_ALLOC(
+        allocator,
+        size * sizeof(T),
+        std::alignment_of<T>::value
+    ));
+    ASSERT(table.data, "Table data allocation failed.");
+
+    table.generations = static_cast<u16*>(BX_ALLOC(allocator, size * sizeof(u16)));
+    ASSERT(table.generations, "Table generations allocation failed.");
+
+    table.size      = size;
+    table.allocator = allocator;
+
+    fill_value(table.data, value, size);
+    bx::memSet(table.generations, 0, size * sizeof(u16));
+}
+
+template <typename T>
+void deinit(HandleTable<T>& table)
+{
+    if (table.allocator)
+    {
+        BX_ALIGNED_FREE(table.allocator, table.data, std::alignment_of<T>::value);
+        BX_FREE(table.allocator, table.generations);
+    }
+
+    table = {};
+}
+
+template <typename T>
+void fill(HandleTable<T>& table, const T& value)
+{
+    fill_value(table.data, value, table.size);
+}
+
+// Called when slot's content is replaced (with the owning cache locked).
+template <typename T>
+void next_generation(HandleTable<T>& table, u16 id)
+{
+    ASSERT(id < table.size, "Index %" PRIu16 " out of range %" PRIu32 ".", id, table.size);
+
+    table.generations[id]++;
+}
+
+template <typename T>
+Handle handle(const HandleTable<T>& table, u16 id)
+{
+    ASSERT(id < table.size, "Index %" PRIu16 " out of range %" PRIu32 ".", id, table.size);
+
+    return { id, table.generations[id] };
+}
+
+template <typename T>
+bool is_current(const HandleTable<T>& table, Handle handle)
+{
+    return handle.id < table.size && handle.generation == table.generations[handle.id];
+}
+
+
 // -----------------------------------------------------------------------------
 // FIXED STACK
 // -----------------------------------------------------------------------------
@@ -1261,189 +1408,592 @@ T& pop(FixedStack<T, Size>& stack)
 
 
 // -----------------------------------------------------------------------------
-// MATRIX STACK
+// MATRIX MATH
 // -----------------------------------------------------------------------------
 
-template <u32 Size>
-using MatrixStack = FixedStack<Mat4, Size>;
-
-template <u32 Size>
-void init(MatrixStack<Size>& stack)
+// Column-major `lhs * rhs` product. BX picks the SIMD implementation (SSE, NEON
+// or the scalar reference one) at compile time.
+Mat4 multiply(const Mat4& lhs, const Mat4& rhs)
 {
-    init(stack, HMM_Mat4d(1.0f));
-}
+    using bx::simd128_t;
 
-template <u32 Size>
-void multiply_top(MatrixStack<Size>& stack, const Mat4& matrix)
-{
-    stack.top = matrix * stack.top;
-}
+    const simd128_t a0 = bx::simd_ld<simd128_t>(lhs.Elements[0]);
+    const simd128_t a1 = bx::simd_ld<simd128_t>(lhs.Elements[1]);
+    const simd128_t a2 = bx::simd_ld<simd128_t>(lhs.Elements[2]);
+    const simd128_t a3 = bx::simd_ld<simd128_t>(lhs.Elements[3]);
 
+    Mat4 result;
 
-// -----------------------------------------------------------------------------
-// UTF-8 HANDLING
-// -----------------------------------------------------------------------------
+    for (u32 i = 0; i < 4; i++)
+    {
+        const simd128_t b = bx::simd_ld<simd128_t>(rhs.Elements[i]);
 
-enum : u32
-{
-    UTF8_ACCEPT = 0,
-    UTF8_REJECT = 12,
-};
+        simd128_t column = bx::simd_mul (a0, bx::simd_swiz_xxxx(b));
+        column           = bx::simd_madd(a1, bx::simd_swiz_yyyy(b), column);
+        column           = bx::simd_madd(a2, bx::simd_swiz_zzzz(b), column);
+        column           = bx::simd_madd(a3, bx::simd_swiz_wwww(b), column);
 
-// Copyright (c) 2008-2010 Bjoern Hoehrmann <bjoern@hoehrmann.de>
-// See http://bjoern.hoehrmann.de/utf-8/decoder/dfa/ for details.
-constexpr u8 s_utf8_decoder_table[] =
-{
-    // The first part of the table maps bytes to character classes that
-    // to reduce the size of the transition table and create bitmasks.
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
-     7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,  7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
-     8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
-    10,3,3,3,3,3,3,3,3,3,3,3,3,4,3,3, 11,6,6,6,5,8,8,8,8,8,8,8,8,8,8,8,
+        bx::simd_st(result.Elements[i], column);
+    }
 
-    // The second part is a transition table that maps a combination
-    // of a state of the automaton and a character class to a state.
-     0,12,24,36,60,96,84,12,12,12,48,72, 12,12,12,12,12,12,12,12,12,12,12,12,
-    12, 0,12,12,12,12,12, 0,12, 0,12,12, 12,24,12,12,12,12,12,24,12,24,12,12,
-    12,12,12,12,12,12,12,24,12,12,12,12, 12,24,12,12,12,12,12,12,12,24,12,12,
-    12,12,12,12,12,12,12,36,12,36,12,12, 12,36,12,12,12,12,12,36,12,36,12,12,
-    12,36,12,12,12,12,12,12,12,12,12,12, 
-};
+    return result;
+}
 
-// Decodes next `byte` and transitions the decoder state.
-u32 utf8_decode(u32& inout_state, u32 byte)
+// `translation * matrix`. Only the XYZ components of each column change, by
+// the translation scaled by the column's W component.
+Mat4 pre_translate(const Mat4& matrix, f32 x, f32 y, f32 z)
 {
-    const u32 type = s_utf8_decoder_table[byte];
+    using bx::simd128_t;
 
-    inout_state = s_utf8_decoder_table[256 + inout_state + type];
+    const simd128_t offset = bx::simd_ld<simd128_t>(x, y, z, 0.0f);
 
-    return inout_state;
+    Mat4 result;
+
+    for (u32 i = 0; i < 4; i++)
+    {
+        const simd128_t column = bx::simd_ld<simd128_t>(matrix.Elements[i]);
+
+        bx::simd_st(result.Elements[i], bx::simd_madd(offset, bx::simd_swiz_wwww(column), column));
+    }
+
+    return result;
 }
 
-// Decodes next `byte`, transitions the decoder state, and accumulates the codepoint.
-u32 utf8_decode(u32& inout_state, u32 byte, u32& out_codepoint)
+// `scale * matrix`, i.e., the XYZ rows multiplied by the scale factors.
+Mat4 pre_scale(const Mat4& matrix, f32 x, f32 y, f32 z)
 {
-    const u32 type = s_utf8_decoder_table[byte];
+    using bx::simd128_t;
 
-    out_codepoint = (inout_state != UTF8_ACCEPT)
-        ? (byte & 0x3fu) | (out_codepoint << 6)
-        : (0xff >> type) & (byte);
+    const simd128_t factors = bx::simd_ld<simd128_t>(x, y, z, 1.0f);
 
-    inout_state = s_utf8_decoder_table[256 + inout_state + type];
+    Mat4 result;
 
-    return inout_state;
+    for (u32 i = 0; i < 4; i++)
+    {
+        bx::simd_st(result.Elements[i], bx::simd_mul(bx::simd_ld<simd128_t>(matrix.Elements[i]), factors));
+    }
+
+    return result;
 }
 
-// Encodes the `codepoint` bytes into `out_string` buffer and returns its size.
-u32 utf8_encode(u32 codepoint, char* out_string)
+// `rotation * matrix` for rotations around the X, Y or Z axis (0, 1 or 2), which
+// only mix two of the XYZ rows. Angle is in degrees.
+Mat4 pre_rotate(const Mat4& matrix, u32 axis, f32 angle)
 {
-    ASSERT(out_string, "Invalid output string pointer.");
+    using bx::simd128_t;
 
-    if (0 == (UINT32_C(0xffffff80) & codepoint))
-    {
-        out_string[0] = char(codepoint);
+    ASSERT(axis < 3, "Invalid rotation axis %" PRIu32 ".", axis);
 
-        return 1;
-    }
-    else if (0 == (UINT32_C(0xfffff800) & codepoint))
+    const f32 c = HMM_CosF(HMM_ToRadians(angle));
+    const f32 s = HMM_SinF(HMM_ToRadians(angle));
+
+    const simd128_t diagonal[] =
     {
-        out_string[0] = char(0xc0 | ((codepoint >> 6) & 0x1f));
-        out_string[1] = char(0x80 | ((codepoint     ) & 0x3f));
+        bx::simd_ld<simd128_t>(1.0f,    c,    c, 1.0f),
+        bx::simd_ld<simd128_t>(   c, 1.0f,    c, 1.0f),
+        bx::simd_ld<simd128_t>(   c,    c, 1.0f, 1.0f),
+    };
 
-        return 2;
-    }
-    else if (0 == (UINT32_C(0xffff0000) & codepoint))
+    const simd128_t mixing[] =
     {
-        out_string[0] = char(0xe0 | ((codepoint >> 12) & 0x0f));
-        out_string[1] = char(0x80 | ((codepoint >>  6) & 0x3f));
-        out_string[2] = char(0x80 | ((codepoint      ) & 0x3f));
+        bx::simd_ld<simd128_t>(0.0f,   -s,    s, 0.0f),
+        bx::simd_ld<simd128_t>(   s, 0.0f,   -s, 0.0f),
+        bx::simd_ld<simd128_t>(  -s,    s, 0.0f, 0.0f),
+    };
 
-        return 3;
-    }
-    else if (0 == (UINT32_C(0xffe00000) & codepoint))
+    Mat4 result;
+
+    for (u32 i = 0; i < 4; i++)
     {
-        out_string[0] = char(0xf0 | ((codepoint >> 18) & 0x07));
-        out_string[1] = char(0x80 | ((codepoint >> 12) & 0x3f));
-        out_string[2] = char(0x80 | ((codepoint >>  6) & 0x3f));
-        out_string[3] = char(0x80 | ((codepoint      ) & 0x3f));
+        const simd128_t column = bx::simd_ld<simd128_t>(matrix.Elements[i]);
 
-        return 4;
-    }
+        const simd128_t swapped =
+            axis == 0 ? bx::simd_swiz_xzyw(column) :
+            axis == 1 ? bx::simd_swiz_zyxw(column) :
+                        bx::simd_swiz_yxzw(column) ;
 
-    ASSERT(false, "Invalid codepoint.");
+        bx::simd_st(result.Elements[i], bx::simd_madd(swapped, mixing[axis], bx::simd_mul(column, diagonal[axis])));
+    }
 
-    return 0;
+    return result;
 }
 
-// Number of codepoints in `string`, looking at most at first `max_bytes` bytes.
-u32 utf8_length(const char* string, u32 max_bytes = U32_MAX)
+
+// -----------------------------------------------------------------------------
+// MATRIX STACK
+// -----------------------------------------------------------------------------
+
+template <u32 Size>
+using MatrixStack = FixedStack<Mat4, Size>;
+
+template <u32 Size>
+void init(MatrixStack<Size>& stack)
 {
-    ASSERT(string, "Invalid string pointer");
+    init(stack, HMM_Mat4d(1.0f));
+}
 
-    u32 state = UTF8_ACCEPT;
-    u32 count = 0;
+template <u32 Size>
+void multiply_top(MatrixStack<Size>& stack, const Mat4& matrix)
+{
+    stack.top = multiply(matrix, stack.top);
+}
 
-    for (; *string && max_bytes; string++, max_bytes--)
-    {
-        if (UTF8_ACCEPT == utf8_decode(state, *reinterpret_cast<const u8*>(string)))
-        {
-            count ++;
-        }
-    }
+template <u32 Size>
+void translate_top(MatrixStack<Size>& stack, f32 x, f32 y, f32 z)
+{
+    stack.top = pre_translate(stack.top, x, y, z);
+}
 
-    ASSERT(state == UTF8_ACCEPT, "Ill-formated UTF-8 string.");
+template <u32 Size>
+void scale_top(MatrixStack<Size>& stack, f32 x, f32 y, f32 z)
+{
+    stack.top = pre_scale(stack.top, x, y, z);
+}
 
-    return count;
+template <u32 Size>
+void rotate_top(MatrixStack<Size>& stack, u32 axis, f32 angle)
+{
+    stack.top = pre_rotate(stack.top, axis, angle);
 }
 
-// Number of bytes in `string`, looking at most at first `max_bytes` bytes.
-// Excludes the `NULL` terminator.
-u32 utf8_size(const char* string, u32 max_bytes = U32_MAX)
+
+// -----------------------------------------------------------------------------
+// TRANSFORM HIERARCHY
+// -----------------------------------------------------------------------------
+
+// Nodes are addressed by user IDs and stored in parallel arrays. World matrices
+// are updated one depth level at a time (each level possibly split among
+// tasks), and only for nodes whose local transform or any ancestor changed.
+
+constexpr u32 MAX_NODES                = 1 << 20;
+constexpr u32 NODE_ROOT                = U32_MAX;
+constexpr u32 NODE_UNUSED              = U32_MAX - 1;
+constexpr u32 NODE_TASK_SIZE           = 1024; // Minimum nodes per task.
+
+enum : u8
 {
-    ASSERT(string, "Invalid string pointer.");
+    NODE_LOCAL_DIRTY   = 0x01,
+    NODE_WORLD_CHANGED = 0x02, // Set during the update, read by the children.
+};
 
-    u32 size = 0;
+struct NodeHierarchy
+{
+    DynamicArray<Mat4> worlds;
+    DynamicArray<Quat> rotations;
+    DynamicArray<Vec3> translations;
+    DynamicArray<Vec3> scales;
+    DynamicArray<u32 > parents;
+    DynamicArray<u8  > flags;
+    DynamicArray<u32 > depths;
+    DynamicArray<u32 > order;     // Node IDs, sorted by depth.
+    DynamicArray<u32 > levels;    // Offsets of depth levels in `order`, plus its end.
+    bool               reordered = true;
+};
 
-    for (; *string && size < max_bytes; string++, size++);
+void init(NodeHierarchy& hierarchy, Allocator* allocator)
+{
+    init(hierarchy.worlds      , allocator);
+    init(hierarchy.rotations   , allocator);
+    init(hierarchy.translations, allocator);
+    init(hierarchy.scales      , allocator);
+    init(hierarchy.parents     , allocator);
+    init(hierarchy.flags       , allocator);
+    init(hierarchy.depths      , allocator);
+    init(hierarchy.order       , allocator);
+    init(hierarchy.levels      , allocator);
+}
 
-    return size;
+void deinit(NodeHierarchy& hierarchy)
+{
+    deinit(hierarchy.worlds      );
+    deinit(hierarchy.rotations   );
+    deinit(hierarchy.translations);
+    deinit(hierarchy.scales      );
+    deinit(hierarchy.parents     );
+    deinit(hierarchy.flags       );
+    deinit(hierarchy.depths      );
+    deinit(hierarchy.order       );
+    deinit(hierarchy.levels      );
 }
 
-// Size of the first codepoint in `string`.
-u32 utf8_codepoint_size(const char* string)
+bool is_valid(const NodeHierarchy& hierarchy, u32 node)
 {
-    ASSERT(string, "Invalid string pointer.");
+    return node < hierarchy.parents.size && hierarchy.parents[node] != NODE_UNUSED;
+}
 
-    u32 state = UTF8_ACCEPT;
-    u32 size  = 0;
+// Creates the node, if needed, and (re)attaches it to the parent.
+void set_parent(NodeHierarchy& hierarchy, u32 node, u32 parent)
+{
+    ASSERT(node < MAX_NODES, "Node ID %" PRIu32 " out of range.", node);
 
-    for (; *string; string++, size++)
+    ASSERT(
+        parent == NODE_ROOT || is_valid(hierarchy, parent),
+        "Invalid parent node %" PRIu32 ".",
+        parent
+    );
+
+    if (node >= hierarchy.parents.size)
     {
-        if (UTF8_ACCEPT == utf8_decode(state, *reinterpret_cast<const u8*>(string)))
-        {
-            break;
-        }
+        const u32 size = node + 1;
+
+        resize(hierarchy.worlds      , size, HMM_Mat4d(1.0f));
+        resize(hierarchy.rotations   , size, HMM_Quaternion(0.0f, 0.0f, 0.0f, 1.0f));
+        resize(hierarchy.translations, size, HMM_Vec3(0.0f, 0.0f, 0.0f));
+        resize(hierarchy.scales      , size, HMM_Vec3(1.0f, 1.0f, 1.0f));
+        resize(hierarchy.parents     , size, NODE_UNUSED);
+        resize(hierarchy.flags       , size, u8(0));
+        resize(hierarchy.depths      , size, 0u);
     }
 
-    ASSERT(state == UTF8_ACCEPT, "Ill-formated UTF8 string.");
-    ASSERT(size > 0 && size < 5, "Invalid codepoint size %" PRIu32 ".", size);
+    for (u32 ancestor = parent; ancestor != NODE_ROOT; ancestor = hierarchy.parents[ancestor])
+    {
+        ASSERT(ancestor != node, "Node %" PRIu32 " can't be its own ancestor.", node);
+    }
 
-    return size;
+    if (hierarchy.parents[node] != parent)
+    {
+        hierarchy.parents[node]  = parent;
+        hierarchy.flags  [node] |= NODE_LOCAL_DIRTY;
+        hierarchy.reordered      = true;
+    }
 }
 
-// Reads next codepoint from `string` and advances the pointer accordingly.
-u32 utf8_next_codepoint(const char*& string)
+// Counting sort of the nodes by their depth, stable with respect to the IDs.
+void sort_by_depth(NodeHierarchy& hierarchy)
 {
-    ASSERT(string, "Invalid string pointer.");
+    const u32 count = hierarchy.parents.size;
 
-    u32 codepoint = 0;
-    u32 state     = UTF8_ACCEPT;
+    fill_value(hierarchy.depths.data, U32_MAX, count);
 
-    while (*string)
+    // NOTE : `order` is used as a scratch stack of the visited ancestors.
+    resize(hierarchy.order, count);
+
+    u32 level_count = 0;
+
+    for (u32 i = 0; i < count; i++)
+    {
+        if (hierarchy.parents[i] == NODE_UNUSED || hierarchy.depths[i] != U32_MAX)
+        {
+            continue;
+        }
+
+        u32 path = 0;
+        u32 node = i;
+
+        while (node != NODE_ROOT && hierarchy.depths[node] == U32_MAX)
+        {
+            hierarchy.order[path++] = node;
+            node = hierarchy.parents[node];
+        }
+
+        u32 depth = node == NODE_ROOT ? 0 : hierarchy.depths[node] + 1;
+
+        while (path)
+        {
+            hierarchy.depths[hierarchy.order[--path]] = depth++;
+        }
+
+        level_count = bx::max(level_count, depth);
+    }
+
+    // Level sizes shifted by one, turned into the level offsets.
+    resize(hierarchy.levels, level_count + 1);
+    fill_value(hierarchy.levels.data, 0u, level_count + 1);
+
+    for (u32 i = 0; i < count; i++)
+    {
+        if (hierarchy.parents[i] != NODE_UNUSED)
+        {
+            hierarchy.levels[hierarchy.depths[i] + 1]++;
+        }
+    }
+
+    for (u32 i = 1; i <= level_count; i++)
+    {
+        hierarchy.levels[i] += hierarchy.levels[i - 1];
+    }
+
+    resize(hierarchy.order, hierarchy.levels[level_count]);
+
+    // Placement advances each level's offset to the start of the next one.
+    for (u32 i = 0; i < count; i++)
+    {
+        if (hierarchy.parents[i] != NODE_UNUSED)
+        {
+            hierarchy.order[hierarchy.levels[hierarchy.depths[i]]++] = i;
+        }
+    }
+
+    for (u32 i = level_count; i > 0; i--)
+    {
+        hierarchy.levels[i] = hierarchy.levels[i - 1];
+    }
+
+    hierarchy.levels[0] = 0;
+    hierarchy.reordered = false;
+}
+
+// Local transform is `translation * rotation * scale`.
+Mat4 local_matrix(const NodeHierarchy& hierarchy, u32 node)
+{
+    const Vec3& translation = hierarchy.translations[node];
+    const Vec3& scale       = hierarchy.scales      [node];
+
+    Mat4 matrix = HMM_QuaternionToMat4(hierarchy.rotations[node]);
+
+    for (u32 i = 0; i < 3; i++)
+    {
+        matrix.Elements[0][i] *= scale.X;
+        matrix.Elements[1][i] *= scale.Y;
+        matrix.Elements[2][i] *= scale.Z;
+    }
+
+    matrix.Elements[3][0] = translation.X;
+    matrix.Elements[3][1] = translation.Y;
+    matrix.Elements[3][2] = translation.Z;
+
+    return matrix;
+}
+
+// Updates nodes `order[first] ... order[last - 1]`, all from the same level.
+void update_worlds(NodeHierarchy& hierarchy, u32 first, u32 last)
+{
+    for (u32 i = first; i < last; i++)
+    {
+        const u32 node   = hierarchy.order  [i];
+        const u32 parent = hierarchy.parents[node];
+
+        const bool changed =
+            (hierarchy.flags[node] & NODE_LOCAL_DIRTY) ||
+            (parent != NODE_ROOT && (hierarchy.flags[parent] & NODE_WORLD_CHANGED));
+
+        if (!changed)
+        {
+            hierarchy.flags[node] = 0;
+            continue;
+        }
+
+        const Mat4 local = local_matrix(hierarchy, node);
+
+        hierarchy.worlds[node] = parent == NODE_ROOT
+            ? local
+            : multiply(hierarchy.worlds[parent], local);
+
+        hierarchy.flags[node] = NODE_WORLD_CHANGED;
+    }
+}
+
+struct NodeTask : enki::ITaskSet
+{
+    NodeHierarchy* hierarchy = nullptr;
+    u32            offset    = 0;
+
+    NodeTask(NodeHierarchy* hierarchy, u32 first, u32 last)
+        : enki::ITaskSet(last - first, NODE_TASK_SIZE)
+        , hierarchy(hierarchy)
+        , offset(first)
+    {
+    }
+
+    void ExecuteRange(enki::TaskSetPartition range, u32) override
+    {
+        update_worlds(*hierarchy, offset + range.start, offset + range.end);
+    }
+};
+
+// Levels are processed in order, since the children read the parents' flags
+// and world matrices. Nodes within a level are independent of each other.
+void update(NodeHierarchy& hierarchy, enki::TaskScheduler* scheduler)
+{
+    if (hierarchy.reordered)
+    {
+        sort_by_depth(hierarchy);
+    }
+
+    for (u32 i = 0; i + 1 < hierarchy.levels.size; i++)
+    {
+        const u32 first = hierarchy.levels[i    ];
+        const u32 last  = hierarchy.levels[i + 1];
+
+        if (scheduler && last - first >= NODE_TASK_SIZE * 2)
+        {
+            NodeTask task(&hierarchy, first, last);
+
+            scheduler->AddTaskSetToPipe(&task);
+            scheduler->WaitforTask(&task);
+        }
+        else
+        {
+            update_worlds(hierarchy, first, last);
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// UTF-8 HANDLING
+// -----------------------------------------------------------------------------
+
+enum : u32
+{
+    UTF8_ACCEPT = 0,
+    UTF8_REJECT = 12,
+};
+
+// Copyright (c) 2008-2010 Bjoern Hoehrmann <bjoern@hoehrmann.de>
+// See http://bjoern.hoehrmann.de/utf-8/decoder/dfa/ for details.
+constexpr u8 s_utf8_decoder_table[] =
+{
+    // The first part of the table maps bytes to character classes that
+    // to reduce the size of the transition table and create bitmasks.
+     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+     1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+     7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,  7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
+     8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+    10,3,3,3,3,3,3,3,3,3,3,3,3,4,3,3, 11,6,6,6,5,8,8,8,8,8,8,8,8,8,8,8,
+
+    // The second part is a transition table that maps a combination
+    // of a state of the automaton and a character class to a state.
+     0,12,24,36,60,96,84,12,12,12,48,72, 12,12,12,12,12,12,12,12,12,12,12,12,
+    12, 0,12,12,12,12,12, 0,12, 0,12,12, 12,24,12,12,12,12,12,24,12,24,12,12,
+    12,12,12,12,12,12,12,24,12,12,12,12, 12,24,12,12,12,12,12,12,12,24,12,12,
+    12,12,12,12,12,12,12,36,12,36,12,12, 12,36,12,12,12,12,12,36,12,36,12,12,
+    12,36,12,12,12,12,12,12,12,12,12,12, 
+};
+
+// Decodes next `byte` and transitions the decoder state.
+u32 utf8_decode(u32& inout_state, u32 byte)
+{
+    const u32 type = s_utf8_decoder_table[byte];
+
+    inout_state = s_utf8_decoder_table[256 + inout_state + type];
+
+    return inout_state;
+}
+
+// Decodes next `byte`, transitions the decoder state, and accumulates the codepoint.
+u32 utf8_decode(u32& inout_state, u32 byte, u32& out_codepoint)
+{
+    const u32 type = s_utf8_decoder_table[byte];
+
+    out_codepoint = (inout_state != UTF8_ACCEPT)
+        ? (byte & 0x3fu) | (out_codepoint << 6)
+        : (0xff >> type) & (byte);
+
+    inout_state = s_utf8_decoder_table[256 + inout_state + type];
+
+    return inout_state;
+}
+
+// Encodes the `codepoint` bytes into `out_string` buffer and returns its size.
+u32 utf8_encode(u32 codepoint, char* out_string)
+{
+    ASSERT(out_string, "Invalid output string pointer.");
+
+    if (0 == (UINT32_C(0xffffff80) & codepoint))
+    {
+        out_string[0] = char(codepoint);
+
+        return 1;
+    }
+    else if (0 == (UINT32_C(0xfffff800) & codepoint))
+    {
+        out_string[0] = char(0xc0 | ((codepoint >> 6) & 0x1f));
+        out_string[1] = char(0x80 | ((codepoint     ) & 0x3f));
+
+        return 2;
+    }
+    else if (0 == (UINT32_C(0xffff0000) & codepoint))
+    {
+        out_string[0] = char(0xe0 | ((codepoint >> 12) & 0x0f));
+        out_string[1] = char(0x80 | ((codepoint >>  6) & 0x3f));
+        out_string[2] = char(0x80 | ((codepoint      ) & 0x3f));
+
+        return 3;
+    }
+    else if (0 == (UINT32_C(0xffe00000) & codepoint))
+    {
+        out_string[0] = char(0xf0 | ((codepoint >> 18) & 0x07));
+        out_string[1] = char(0x80 | ((codepoint >> 12) & 0x3f));
+        out_string[2] = char(0x80 | ((codepoint >>  6) & 0x3f));
+        out_string[3] = char(0x80 | ((codepoint      ) & 0x3f));
+
+        return 4;
+    }
+
+    ASSERT(false, "Invalid codepoint.");
+
+    return 0;
+}
+
+// Number of codepoints in `string`, looking at most at first `max_bytes` bytes.
+u32 utf8_length(const char* string, u32 max_bytes = U32_MAX)
+{
+    ASSERT(string, "Invalid string pointer");
+
+    u32 state = UTF8_ACCEPT;
+    u32 count = 0;
+
+    for (; *string && max_bytes; string++, max_bytes--)
+    {
+        if (UTF8_ACCEPT == utf8_decode(state, *reinterpret_cast<const u8*>(string)))
+        {
+            count ++;
+        }
+    }
+
+    ASSERT(state == UTF8_ACCEPT, "Ill-formated UTF-8 string.");
+
+    return count;
+}
+
+// Number of bytes in `string`, looking at most at first `max_bytes` bytes.
+// Excludes the `NULL` terminator.
+u32 utf8_size(const char* string, u32 max_bytes = U32_MAX)
+{
+    ASSERT(string, "Invalid string pointer.");
+
+    u32 size = 0;
+
+    for (; *string && size < max_bytes; string++, size++);
+
+    return size;
+}
+
+// Size of the first codepoint in `string`.
+u32 utf8_codepoint_size(const char* string)
+{
+    ASSERT(string, "Invalid string pointer.");
+
+    u32 state = UTF8_ACCEPT;
+    u32 size  = 0;
+
+    for (; *string; string++, size++)
+    {
+        if (UTF8_ACCEPT == utf8_decode(state, *reinterpret_cast<const u8*>(string)))
+        {
+            break;
+        }
+    }
+
+    ASSERT(state == UTF8_ACCEPT, "Ill-formated UTF8 string.");
+    ASSERT(size > 0 && size < 5, "Invalid codepoint size %" PRIu32 ".", size);
+
+    return size;
+}
+
+// Reads next codepoint from `string` and advances the pointer accordingly.
+u32 utf8_next_codepoint(const char*& string)
+{
+    ASSERT(string, "Invalid string pointer.");
+
+    u32 codepoint = 0;
+    u32 state     = UTF8_ACCEPT;
+
+    while (*string)
     {
         utf8_decode(state, *reinterpret_cast<const u8*>(string), codepoint);
 
@@ -1924,8 +2474,10 @@ using BgfxAttribType = BgfxReducedEnum<bgfx::AttribType, u8>;
 
 struct VertexLayoutCache
 {
-    FixedArray<bgfx::VertexLayout      , 256> layouts;
-    FixedArray<bgfx::VertexLayoutHandle, 256> handles;
+    Mutex                                      mutex;
+    FixedArray<bgfx::VertexLayout      , 1024> layouts;
+    FixedArray<bgfx::VertexLayoutHandle, 1024> handles;
+    FixedArray<u32                     , 1024> created; // Accessed atomically.
 };
 
 struct VertexLayoutAttribInfo
@@ -1943,6 +2495,7 @@ struct VertexLayoutAttribInfo
 const VertexLayoutAttribInfo s_vertex_layout_attribs[] =
 {
     { VERTEX_POSITION    , {bgfx::Attrib::Position }, {bgfx::AttribType::Float}, 3, 0, false, false, 0            },
+    { VERTEX_POSITION_2D , {bgfx::Attrib::Position }, {bgfx::AttribType::Float}, 2, 0, false, false, 0            },
     { VERTEX_COLOR       , {bgfx::Attrib::Color0   }, {bgfx::AttribType::Uint8}, 4, 4, true , false, 0            },
     { VERTEX_NORMAL      , {bgfx::Attrib::Normal   }, {bgfx::AttribType::Uint8}, 4, 4, true , true , 0            },
     { VERTEX_TEXCOORD    , {bgfx::Attrib::TexCoord0}, {bgfx::AttribType::Int16}, 2, 4, true , true , TEXCOORD_F32 },
@@ -1955,7 +2508,9 @@ constexpr u32 vertex_layout_index(u32 attribs, u32 skips = 0)
         VERTEX_ATTRIB_MASK  >>  VERTEX_ATTRIB_SHIFT       == 0b00000111 &&
         TEXCOORD_F32        >>  9                         == 0b00001000 &&
         (VERTEX_ATTRIB_MASK >> (VERTEX_ATTRIB_SHIFT - 4)) == 0b01110000 &&
-        TEXCOORD_F32        >>  5                         == 0b10000000,
+        TEXCOORD_F32        >>  5                         == 0b10000000 &&
+        VERTEX_POSITION_2D  >> 11                         == 0b0100000000 &&
+        VERTEX_INTERLEAVED  >>  2                         == 0b1000000000,
         "Invalid index assumptions in `vertex_layout_index`."
     );
 
@@ -1963,7 +2518,9 @@ constexpr u32 vertex_layout_index(u32 attribs, u32 skips = 0)
         ((attribs & VERTEX_ATTRIB_MASK) >>  VERTEX_ATTRIB_SHIFT     ) | // Bits 0..2.
         ((attribs & TEXCOORD_F32      ) >>  9                       ) | // Bit  3.
         ((skips   & VERTEX_ATTRIB_MASK) >> (VERTEX_ATTRIB_SHIFT - 4)) | // Bits 4..6.
-        ((skips   & TEXCOORD_F32      ) >>  5                       ) ; // Bit  7.
+        ((skips   & TEXCOORD_F32      ) >>  5                       ) | // Bit  7.
+        ((attribs & VERTEX_POSITION_2D) >> 11                       ) | // Bit  8.
+        ((attribs & VERTEX_INTERLEAVED) >>  2                       ) ; // Bit  9.
 }
 
 constexpr u32 vertex_layout_skips(u32 attribs, u32 alias)
@@ -1971,6 +2528,11 @@ constexpr u32 vertex_layout_skips(u32 attribs, u32 alias)
     return (attribs & VERTEX_ATTRIB_MASK) & ~(alias & VERTEX_ATTRIB_MASK);
 }
 
+constexpr u32 vertex_position_size(u32 flags)
+{
+    return (flags & VERTEX_POSITION_2D) ? sizeof(Vec2) : sizeof(Vec3);
+}
+
 void add_vertex_layout(VertexLayoutCache& cache, u32 attribs, u32 skips)
 {
     ASSERT(attribs, "Empty attributes.");
@@ -2014,64 +2576,62 @@ void add_vertex_layout(VertexLayoutCache& cache, u32 attribs, u32 skips)
 void init(VertexLayoutCache& cache)
 {
     fill(cache.handles, BGFX_INVALID_HANDLE);
+    fill(cache.created, 0u);
+}
 
-    add_vertex_layout(cache, VERTEX_POSITION, 0);
+// Layouts are only created on first use. The fast path is a single atomic
+// read, the mutex is only taken when the layout doesn't exist yet.
+u32 acquire_vertex_layout(VertexLayoutCache& cache, u32 attribs, u32 skips = 0)
+{
+    constexpr u32 ATTRIB_MASK = VERTEX_ATTRIB_MASK | TEXCOORD_F32;
 
-    for (u32 attrib_mask = 1; attrib_mask < 16; attrib_mask++)
-    {
-        if ((attrib_mask & 0xc) == 0xc)
-        {
-            // Exclude mixing `VERTEX_TEXCOORD` and `VERTEX_TEXCOORD_F32`.
-            continue;
-        }
+    const u32 position    = (attribs & VERTEX_POSITION_2D) ? VERTEX_POSITION_2D : VERTEX_POSITION;
+    const u32 interleaved = (attribs & VERTEX_INTERLEAVED);
 
-        u32 attribs = 0;
-
-        for (u32 i = 1; i < BX_COUNTOF(s_vertex_layout_attribs); i++)
-        {
-            if (attrib_mask & (1 << (i - 1)))
-            {
-                attribs |= s_vertex_layout_attribs[i].flag;
-            }
-        }
+    attribs &= ATTRIB_MASK;
+    skips   &= ATTRIB_MASK;
 
-        add_vertex_layout(cache, attribs, 0);
+    if (!(attribs & VERTEX_TEXCOORD)) { attribs &= ~TEXCOORD_F32; }
+    if (!(skips   & VERTEX_TEXCOORD)) { skips   &= ~TEXCOORD_F32; }
 
-        if (bx::isPowerOf2(attrib_mask))
-        {
-            continue;
-        }
+    if (!attribs)
+    {
+        ASSERT(!skips, "Position-only layout can't skip attributes.");
 
-        // Add variants with skipped attributes (for aliasing).
-        for (u32 skip_mask = 1; skip_mask < 16; skip_mask++)
-        {
-            const u32 skipped_attribs = attrib_mask & skip_mask;
+        attribs = position;
+    }
+    else if (interleaved)
+    {
+        // NOTE : Position goes first, so that the layout is the same as for
+        //        the standalone positions, just with a bigger stride.
+        attribs |= position | VERTEX_INTERLEAVED;
+    }
 
-            if (skipped_attribs == skip_mask)
-            {
-                u32 skips = 0;
+    const u32 index = vertex_layout_index(attribs, skips);
 
-                for (u32 i = 1; i < BX_COUNTOF(s_vertex_layout_attribs); i++)
-                {
-                    if (skip_mask & (1 << (i - 1)))
-                    {
-                        skips |= s_vertex_layout_attribs[i].flag;
-                    }
-                }
+    if (0 == bx::atomicCompareAndSwap(&cache.created[index], 0u, 0u))
+    {
+        MutexScope lock(cache.mutex);
 
-                ASSERT(
-                    (attribs & skips) == skips,
-                    "Skips %" PRIu32 "not fully contained in attribs %" PRIu32 ".",
-                    skips, attribs
-                );
+        if (!cache.created[index])
+        {
+            add_vertex_layout(cache, attribs, skips);
 
-                if (attribs != skips)
-                {
-                    add_vertex_layout(cache, attribs & ~skips, skips);
-                }
-            }
+            bx::atomicCompareAndSwap(&cache.created[index], 0u, 1u);
         }
     }
+
+    return index;
+}
+
+const bgfx::VertexLayout& vertex_layout(VertexLayoutCache& cache, u32 attribs, u32 skips = 0)
+{
+    return cache.layouts[acquire_vertex_layout(cache, attribs, skips)];
+}
+
+bgfx::VertexLayoutHandle vertex_layout_handle(VertexLayoutCache& cache, u32 attribs, u32 skips = 0)
+{
+    return cache.handles[acquire_vertex_layout(cache, attribs, skips)];
 }
 
 void deinit(VertexLayoutCache& cache)
@@ -2080,6 +2640,8 @@ void deinit(VertexLayoutCache& cache)
     {
         destroy_if_valid(cache.handles[i]);
     }
+
+    fill(cache.created, 0u);
 }
 
 
@@ -2225,9 +2787,11 @@ enum struct RecordType : u8
     NONE,
 
     ATLAS,
+    DRAW_LIST,
     FRAMEBUFFER,
     INSTANCES,
     MESH,
+    PARTICLES,
     TEXT,
 };
 
@@ -2256,12 +2820,23 @@ void reset(VertexStoreFunc& func, u32 flags);
 // MESH RECORDING
 // -----------------------------------------------------------------------------
 
+// Joint influences of a skinned vertex. Never uploaded to the GPU.
+struct SkinVertex
+{
+    f32 weights[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+    u8  joints [4] = {};
+};
+
 struct MeshRecorder
 {
     DynamicArray<u8>  attrib_buffer;
     DynamicArray<u8>  position_buffer;
+    DynamicArray<u8>  skin_buffer;
     VertexAttribState attrib_state;
+    SkinVertex        skin_state;
     VertexStoreFunc   store_vertex     = nullptr;
+    bx::simd128_t     bounds_min;
+    bx::simd128_t     bounds_max;
     u32               vertex_count     = 0;
     u32               invocation_count = 0;
 };
@@ -2272,12 +2847,14 @@ void init(MeshRecorder& recorder, Allocator* allocator)
 
     init(recorder.attrib_buffer  , allocator);
     init(recorder.position_buffer, allocator);
+    init(recorder.skin_buffer    , allocator);
 }
 
 void deinit(MeshRecorder& recorder)
 {
     deinit(recorder.attrib_buffer  );
     deinit(recorder.position_buffer);
+    deinit(recorder.skin_buffer    );
 }
 
 void start(MeshRecorder& recorder, u32 flags)
@@ -2286,8 +2863,16 @@ void start(MeshRecorder& recorder, u32 flags)
     reset(recorder.store_vertex, flags);
 
     reserve(recorder.attrib_buffer  , 32_kB * recorder.attrib_state.size);
-    reserve(recorder.position_buffer, 32_kB * sizeof(float) * 3);
+    reserve(recorder.position_buffer, 32_kB * vertex_position_size(flags));
+
+    if (flags & VERTEX_SKINNED)
+    {
+        reserve(recorder.skin_buffer, 32_kB * sizeof(SkinVertex));
+    }
 
+    recorder.skin_state       = {};
+    recorder.bounds_min       = bx::simd_splat<bx::simd128_t>( FLT_MAX);
+    recorder.bounds_max       = bx::simd_splat<bx::simd128_t>(-FLT_MAX);
     recorder.vertex_count     = 0;
     recorder.invocation_count = 0;
 }
@@ -2298,6 +2883,7 @@ void end(MeshRecorder& recorder)
 
     clear(recorder.attrib_buffer  );
     clear(recorder.position_buffer);
+    clear(recorder.skin_buffer    );
 
     recorder.store_vertex     = nullptr;
     recorder.vertex_count     = 0;
@@ -2332,20 +2918,41 @@ void emulate_quad(DynamicArray<u8>& buffer, u32 vertex_size)
     bx::memCopy(end -     vertex_size, end - 3 * vertex_size, vertex_size);
 }
 
-template <bool IsQuadMesh, bool HasAttribs>
+// 2D affine part of the transform, for meshes with `VERTEX_POSITION_2D`. Skips
+// the third column and the bottom row, so it's only exact for transforms that
+// keep the Z = 0 plane in place, which is the case for the 2D content.
+Vec3 transform_affine_2d(const Mat4& transform, f32 x, f32 y)
+{
+    const f32 (&m)[4][4] = transform.Elements;
+
+    return HMM_Vec3(
+        m[0][0] * x + m[1][0] * y + m[3][0],
+        m[0][1] * x + m[1][1] * y + m[3][1],
+        0.0f
+    );
+}
+
+template <bool IsQuadMesh, bool HasAttribs, bool IsSkinned, bool IsPosition2D>
 void store_vertex(const Vec3& position, const VertexAttribState& attrib_state, MeshRecorder& recorder)
 {
+    constexpr u32 position_size = IsPosition2D ? sizeof(Vec2) : sizeof(Vec3);
+
     if constexpr (IsQuadMesh)
     {
         if ((recorder.invocation_count & 3) == 3)
         {
-            emulate_quad(recorder.position_buffer, sizeof(position));
+            emulate_quad(recorder.position_buffer, position_size);
 
             if constexpr (HasAttribs)
             {
                 emulate_quad(recorder.attrib_buffer, attrib_state.size);
             }
 
+            if constexpr (IsSkinned)
+            {
+                emulate_quad(recorder.skin_buffer, sizeof(SkinVertex));
+            }
+
             recorder.vertex_count += 2;
         }
 
@@ -2354,28 +2961,55 @@ void store_vertex(const Vec3& position, const VertexAttribState& attrib_state, M
 
     recorder.vertex_count++;
 
-    append(recorder.position_buffer, &position, sizeof(position));
+    append(recorder.position_buffer, &position, position_size);
+
+    // NOTE : Quad emulation only duplicates existing vertices, so it doesn't
+    //        affect the bounds. The dropped Z of 2D positions counts as zero.
+    const bx::simd128_t vertex = bx::simd_ld<bx::simd128_t>(
+        position.X, position.Y, IsPosition2D ? 0.0f : position.Z, 0.0f
+    );
+
+    recorder.bounds_min = bx::simd_min(recorder.bounds_min, vertex);
+    recorder.bounds_max = bx::simd_max(recorder.bounds_max, vertex);
 
     if constexpr (HasAttribs)
     {
         append(recorder.attrib_buffer, attrib_state.data, attrib_state.size);
     }
+
+    if constexpr (IsSkinned)
+    {
+        append(recorder.skin_buffer, &recorder.skin_state, sizeof(SkinVertex));
+    }
 }
 
+// NOTE : Skinning is done in 3D, so the skinned 2D variants aren't needed.
 const VertexStoreFunc s_vertex_store_funcs[] =
 {
-    store_vertex<0, 0>,
-    store_vertex<0, 1>,
-    store_vertex<1, 0>,
-    store_vertex<1, 1>,
+    store_vertex<0, 0, 0, 0>,
+    store_vertex<0, 0, 0, 1>,
+    store_vertex<0, 0, 1, 0>,
+    store_vertex<0, 1, 0, 0>,
+    store_vertex<0, 1, 0, 1>,
+    store_vertex<0, 1, 1, 0>,
+    store_vertex<1, 0, 0, 0>,
+    store_vertex<1, 0, 0, 1>,
+    store_vertex<1, 0, 1, 0>,
+    store_vertex<1, 1, 0, 0>,
+    store_vertex<1, 1, 0, 1>,
+    store_vertex<1, 1, 1, 0>,
 };
 
 void reset(VertexStoreFunc& func, u32 flags)
 {
-    const bool is_quad_mesh = flags & PRIMITIVE_QUADS;
-    const bool has_attribs  = flags & VERTEX_ATTRIB_MASK;
+    const bool is_quad_mesh   = flags & PRIMITIVE_QUADS;
+    const bool has_attribs    = flags & VERTEX_ATTRIB_MASK;
+    const bool is_skinned     = flags & VERTEX_SKINNED;
+    const bool is_position_2d = flags & VERTEX_POSITION_2D;
+
+    ASSERT(!(is_skinned && is_position_2d), "2D positions can't be skinned.");
 
-    func = s_vertex_store_funcs[is_quad_mesh * 2 + has_attribs];
+    func = s_vertex_store_funcs[is_quad_mesh * 6 + has_attribs * 3 + is_skinned * 2 + is_position_2d];
 }
 
 
@@ -2449,6 +3083,7 @@ IndexBufferUnion create_persistent_index_buffer
     u32        vertex_count,
     u32        indexed_vertex_count,
     const f32* vertex_positions,
+    u32        vertex_positions_stride,
     const u32* remap_table,
     Allocator* temp_allocator,
     bool       optimize
@@ -2478,15 +3113,20 @@ IndexBufferUnion create_persistent_index_buffer
 
     meshopt_remapIndexBuffer(indices, nullptr, vertex_count, remap_table);
 
-    if (optimize && vertex_positions)
+    if (optimize)
     {
         meshopt_optimizeVertexCache(indices, indices, vertex_count,
             indexed_vertex_count
         );
 
-        meshopt_optimizeOverdraw(indices, indices, vertex_count,
-            vertex_positions, indexed_vertex_count, 3 * sizeof(f32), 1.05f
-        );
+        // NOTE : Only done for 3D positions, flat geometry has no overdraw to
+        //        optimize for anyway.
+        if (vertex_positions)
+        {
+            meshopt_optimizeOverdraw(indices, indices, vertex_count,
+                vertex_positions, indexed_vertex_count, vertex_positions_stride, 1.05f
+            );
+        }
 
         // TODO : Consider also doing `meshopt_optimizeVertexFetch`?
     }
@@ -2548,6 +3188,41 @@ bool create_transient_vertex_buffer
     return true;
 }
 
+// Merges the position and attribute streams into a single interleaved one.
+void interleave_vertices
+(
+    const Span<u8>&   positions,
+    u32               position_size,
+    const Span<u8>&   attribs,
+    u32               attrib_size,
+    DynamicArray<u8>& output
+)
+{
+    const u32 vertex_count = positions.size / position_size;
+    const u32 stride       = position_size + attrib_size;
+
+    ASSERT(
+        vertex_count * attrib_size == attribs.size,
+        "Mismatched position and attribute vertex counts."
+    );
+
+    resize(output, vertex_count * stride);
+
+    const u8* src_positions = positions.data;
+    const u8* src_attribs   = attribs  .data;
+    u8*       dst           = output   .data;
+
+    for (u32 i = 0; i < vertex_count; i++)
+    {
+        bx::memCopy(dst                , src_positions, position_size);
+        bx::memCopy(dst + position_size, src_attribs  , attrib_size  );
+
+        src_positions += position_size;
+        src_attribs   += attrib_size;
+        dst           += stride;
+    }
+}
+
 
 // -----------------------------------------------------------------------------
 // NORMALS' GENERATION
@@ -2708,1789 +3383,7019 @@ void generate_smooth_normals
 
 
 // -----------------------------------------------------------------------------
-// MESH & MESH CACHING
+// DEFERRED RESOURCE RELEASE
 // -----------------------------------------------------------------------------
 
-struct Mesh
+enum struct ReleaseType : u8
 {
-    u32               element_count = 0;
-    u32               extra_data    = 0;
-    u32               flags         = 0;
-    VertexBufferUnion positions     = { bgfx::kInvalidHandle };
-    VertexBufferUnion attribs       = { bgfx::kInvalidHandle };
-    IndexBufferUnion  indices       = { bgfx::kInvalidHandle };
+    VERTEX_BUFFER,
+    DYNAMIC_VERTEX_BUFFER,
+    INDEX_BUFFER,
+    DYNAMIC_INDEX_BUFFER,
+    TEXTURE,
+    FRAMEBUFFER,
 };
 
-struct MeshCache
+struct ReleaseItem
 {
-    Mutex                                                          mutex;
-    FixedArray<Mesh, MAX_MESHES>                                   meshes;
-    FixedArray<bgfx::TransientVertexBuffer, MAX_TRANSIENT_BUFFERS> transient_buffers;
-    u32                                                            transient_buffer_count     = 0;
-    u32                                                            transient_memory_exhausted = 0;
+    u32         frame; // Last frame that could have referenced the handle.
+    u16         handle;
+    ReleaseType type;
 };
 
-u16 mesh_type(u32 flags)
+// BGFX handles that are no longer accessible via their IDs, but could still
+// be referenced by the submissions in the current frame.
+struct ReleaseQueue
 {
-    constexpr u16 types[] =
-    {
-        MESH_STATIC,
-        MESH_TRANSIENT,
-        MESH_DYNAMIC,
-        MESH_INVALID,
-    };
+    Mutex                     mutex;
+    DynamicArray<ReleaseItem> items;
+    u32                       frame = 0;
+};
 
-    return types[(flags & MESH_TYPE_MASK) >> MESH_TYPE_SHIFT];
+void init(ReleaseQueue& queue, Allocator* allocator)
+{
+    init(queue.items, allocator);
 }
 
-bool is_valid(const Mesh& mesh)
+void destroy(const ReleaseItem& item)
 {
-    // TODO : A more complete check might be in order (at least an assertion).
-    return mesh.element_count != 0;
+    switch (item.type)
+    {
+    case ReleaseType::VERTEX_BUFFER:
+        bgfx::destroy(bgfx::VertexBufferHandle { item.handle });
+        break;
+    case ReleaseType::DYNAMIC_VERTEX_BUFFER:
+        bgfx::destroy(bgfx::DynamicVertexBufferHandle { item.handle });
+        break;
+    case ReleaseType::INDEX_BUFFER:
+        bgfx::destroy(bgfx::IndexBufferHandle { item.handle });
+        break;
+    case ReleaseType::DYNAMIC_INDEX_BUFFER:
+        bgfx::destroy(bgfx::DynamicIndexBufferHandle { item.handle });
+        break;
+    case ReleaseType::TEXTURE:
+        bgfx::destroy(bgfx::TextureHandle { item.handle });
+        break;
+    case ReleaseType::FRAMEBUFFER:
+        bgfx::destroy(bgfx::FrameBufferHandle { item.handle });
+        break;
+    }
 }
 
-void destroy(Mesh& mesh)
+void deinit(ReleaseQueue& queue)
 {
-    const u16 type = mesh_type(mesh.flags);
-
-    if (type == MESH_STATIC)
+    for (u32 i = 0; i < queue.items.size; i++)
     {
-        destroy_if_valid(mesh.positions.static_buffer);
-        destroy_if_valid(mesh.attribs  .static_buffer);
-        destroy_if_valid(mesh.indices  .static_buffer);
+        destroy(queue.items[i]);
     }
-    else if (type == MESH_DYNAMIC)
+
+    deinit(queue.items);
+}
+
+void release(ReleaseQueue& queue, ReleaseType type, u16 handle)
+{
+    if (handle == bgfx::kInvalidHandle)
     {
-        destroy_if_valid(mesh.positions.dynamic_buffer);
-        destroy_if_valid(mesh.attribs  .dynamic_buffer);
-        destroy_if_valid(mesh.indices  .dynamic_buffer);
+        return;
     }
 
-    mesh = {};
+    MutexScope lock(queue.mutex);
+
+    append(queue.items, { queue.frame, handle, type });
 }
 
-bool create_persistent_geometry
-(
-    u32                        flags,
-    u32                        count,
-    const Span<u8>*            attribs,
-    const bgfx::VertexLayout** layouts,
-    Allocator*                 temp_allocator,
-    VertexBufferUnion*         output_vertex_buffers,
-    IndexBufferUnion&          output_index_buffer
-)
+// Called right after `bgfx::frame`, with the number of the frame that starts.
+// Everything queued before was referenced by already submitted frames at most,
+// and BGFX executes destruction only after those get rendered.
+void release_frame(ReleaseQueue& queue, u32 frame)
 {
-    const u32 type = mesh_type(flags);
-    const u32 vertex_count = attribs[0].size / layouts[0]->getStride();
+    MutexScope lock(queue.mutex);
 
-    FixedArray<meshopt_Stream, 2> streams;
-    ASSERT(streams.size >= count, "Insufficient stream array size.");
+    u32 kept = 0;
 
-    for (u32 i = 0; i < count; i++)
+    for (u32 i = 0; i < queue.items.size; i++)
     {
-        ASSERT(
-            vertex_count == attribs[i].size / layouts[i]->getStride(),
-            "Mismatched number of vertices for attribute buffer %" PRIu32 ".",
-            i
-        );
-
-        streams[i] = {
-            attribs[i].data,
-            layouts[i]->getStride(),
-            layouts[i]->getStride()
-        };
+        if (queue.items[i].frame < frame)
+        {
+            destroy(queue.items[i]);
+        }
+        else
+        {
+            queue.items[kept++] = queue.items[i];
+        }
     }
 
-    DynamicArray<u32> remap_table;
-    init(remap_table, temp_allocator);
-    defer(deinit(remap_table));
+    resize(queue.items, kept);
 
-    resize(remap_table, vertex_count);
+    queue.frame = frame;
+}
 
-    const u32 indexed_vertex_count = count > 1
-        ? u32(meshopt_generateVertexRemapMulti(
-            remap_table.data, nullptr, vertex_count, vertex_count, streams.data,
-            count
-        ))
-        : u32(meshopt_generateVertexRemap(
-            remap_table.data, nullptr, vertex_count, streams[0].data,
-            vertex_count, streams[0].size
-        ));
 
-    void* vertex_positions = nullptr;
+// -----------------------------------------------------------------------------
+// MESH SKINNING (I / II)
+// -----------------------------------------------------------------------------
 
-    for (u32 i = 0; i < count; i++)
-    {
-        output_vertex_buffers[i] = create_persistent_vertex_buffer(
-            type, streams[i], *layouts[i], vertex_count, indexed_vertex_count,
-            remap_table.data, temp_allocator, i ? nullptr : &vertex_positions
-        );
-    }
+// Skinned meshes keep a copy of their recorded vertices on the CPU, in the same
+// order as in their GPU buffers. Every `skin` call transforms the copy anew, so
+// that errors don't accumulate over time.
 
-    const bool optimize_geometry =
-         (flags & OPTIMIZE_GEOMETRY) &&
-        ((flags & PRIMITIVE_TYPE_MASK) <= PRIMITIVE_QUADS);
+constexpr u32 MAX_SKIN_JOINTS = 256;  // Joint indices are stored as `u8`.
+constexpr u32 SKIN_TASK_SIZE  = 4096; // Vertices per task.
 
-    output_index_buffer = create_persistent_index_buffer(
-        type, vertex_count, indexed_vertex_count,
-        static_cast<f32*>(vertex_positions), remap_table.data, temp_allocator,
-        optimize_geometry
-    );
+struct SkinnedMesh
+{
+    Vec3*       positions;
+    SkinVertex* vertices;
+    u8*         attribs;       // Only if the normals get skinned as well.
+    Allocator*  allocator;
+    u32         vertex_count;
+    u32         attrib_stride;
+    u32         normal_offset;
+    u32         joint_count;   // Minimum number of joints to skin with.
+};
 
-    // TODO : Check that all the buffers were successfully created and perform
-    //        the cleanup if not.
+void deinit(SkinnedMesh& skin)
+{
+    if (skin.allocator && skin.positions)
+    {
+        BX_FREE(skin.allocator, skin.positions);
+    }
 
-    return true;
+    skin = {};
 }
 
-bool create_transient_geometry
+// Stores the recorded data remapped the same way as the GPU buffers. Normals
+// are only kept if `attrib_layout` is given.
+void init
 (
-    u32                          count,
-    const Span<u8>*              attribs,
-    const bgfx::VertexLayout**   layouts,
-    bgfx::TransientVertexBuffer* output_vertex_buffers
+    SkinnedMesh&              skin,
+    Allocator*                allocator,
+    u32                       vertex_count,
+    u32                       indexed_vertex_count,
+    const u32*                remap_table,
+    const Span<u8>&           positions,
+    const Span<u8>&           vertices,
+    const Span<u8>&           attribs,
+    const bgfx::VertexLayout* attrib_layout
 )
 {
-    for (u32 i = 0; i < count; i++)
+    ASSERT(allocator, "Invalid allocator pointer.");
+    ASSERT(remap_table, "Invalid remapping table.");
+
+    const u32 attrib_stride = attrib_layout ? attrib_layout->getStride() : 0;
+    const u32 vertex_size   = sizeof(Vec3) + sizeof(SkinVertex) + attrib_stride;
+
+    u8* memory = static_cast<u8*>(BX_ALLOC(allocator, indexed_vertex_count * vertex_size));
+    ASSERT(memory, "Skinned mesh memory allocation failed.");
+
+    skin = {};
+    skin.positions    = reinterpret_cast<Vec3*>(memory);
+    skin.vertices     = reinterpret_cast<SkinVertex*>(memory + indexed_vertex_count * sizeof(Vec3));
+    skin.allocator    = allocator;
+    skin.vertex_count = indexed_vertex_count;
+
+    meshopt_remapVertexBuffer(skin.positions, positions.data, vertex_count, sizeof(Vec3      ), remap_table);
+    meshopt_remapVertexBuffer(skin.vertices , vertices .data, vertex_count, sizeof(SkinVertex), remap_table);
+
+    if (attrib_layout)
     {
-        if (!create_transient_vertex_buffer(
-            attribs[i],
-            *layouts[i],
-            &output_vertex_buffers[i]
-        ))
+        skin.attribs       = memory + indexed_vertex_count * (sizeof(Vec3) + sizeof(SkinVertex));
+        skin.attrib_stride = attrib_stride;
+        skin.normal_offset = attrib_layout->getOffset(bgfx::Attrib::Normal);
+
+        meshopt_remapVertexBuffer(skin.attribs, attribs.data, vertex_count, attrib_stride, remap_table);
+    }
+
+    for (u32 i = 0; i < skin.vertex_count; i++)
+    for (u32 j = 0; j < 4; j++)
+    {
+        if (skin.vertices[i].weights[j] != 0.0f)
         {
-            return false;
+            skin.joint_count = bx::max(skin.joint_count, skin.vertices[i].joints[j] + 1u);
         }
     }
-
-    return true;
 }
 
-void add_mesh
+// Linear blend skinning of the vertices in range `[first, last)`. The weighted
+// joint matrices are summed up first, so that each vertex is transformed only
+// once. Normals use the blended matrix directly, which is exact only for joints
+// without non-uniform scaling. Writes the bounds of the skinned positions into
+// `bounds[0]` and `bounds[1]`.
+void skin_vertices
 (
-    MeshCache&                      cache,
-    const RecordInfo&               info,
-    const MeshRecorder&             recorder,
-    const Span<bgfx::VertexLayout>& layouts_,
-    Allocator*                      thread_local_temp_allocator
+    const SkinnedMesh& skin,
+    const Mat4*        joints,
+    u32                first,
+    u32                last,
+    Vec3*              positions,
+    u8*                attribs,
+    bx::simd128_t*     bounds
 )
 {
-    ASSERT(info.id < cache.meshes.size,
-        "Mesh id %" PRIu16 " out of bounds (%" PRIu32").",
-        info.id, cache.meshes.size
-    );
+    using bx::simd128_t;
 
-    const u16 type = mesh_type(info.flags);
+    simd128_t bounds_min = bx::simd_splat<simd128_t>( FLT_MAX);
+    simd128_t bounds_max = bx::simd_splat<simd128_t>(-FLT_MAX);
 
-    if (type == MESH_INVALID)
+    for (u32 i = first; i < last; i++)
     {
-        WARN(true, "Invalid registered mesh type.");
-        return;
-    }
+        const SkinVertex& vertex = skin.vertices[i];
 
-    const u32 count = 1 + (recorder.attrib_buffer.size > 0);
+        simd128_t c0 = bx::simd_zero<simd128_t>();
+        simd128_t c1 = bx::simd_zero<simd128_t>();
+        simd128_t c2 = bx::simd_zero<simd128_t>();
+        simd128_t c3 = bx::simd_zero<simd128_t>();
 
-    Span<u8>                  attribs[2];
-    const bgfx::VertexLayout* layouts[2];
+        for (u32 j = 0; j < 4; j++)
+        {
+            if (vertex.weights[j] == 0.0f)
+            {
+                continue;
+            }
 
-    attribs[0] = recorder.position_buffer;
-    layouts[0] = &layouts_[vertex_layout_index(VERTEX_POSITION)];
+            const Mat4&     joint  = joints[vertex.joints[j]];
+            const simd128_t weight = bx::simd_splat<simd128_t>(vertex.weights[j]);
 
-    if (count > 1)
-    {
-        attribs[1] = recorder.attrib_buffer;
-        layouts[1] = &layouts_[vertex_layout_index(info.flags)];
-    }
+            c0 = bx::simd_madd(weight, bx::simd_ld<simd128_t>(joint.Elements[0]), c0);
+            c1 = bx::simd_madd(weight, bx::simd_ld<simd128_t>(joint.Elements[1]), c1);
+            c2 = bx::simd_madd(weight, bx::simd_ld<simd128_t>(joint.Elements[2]), c2);
+            c3 = bx::simd_madd(weight, bx::simd_ld<simd128_t>(joint.Elements[3]), c3);
+        }
 
-    Mesh mesh;
+        const Vec3& bind = skin.positions[i];
 
-    mesh.element_count = recorder.vertex_count;
-    mesh.extra_data    = info.extra_data;
-    mesh.flags         = info.flags;
+        simd128_t position = bx::simd_madd(c0, bx::simd_splat<simd128_t>(bind.X), c3);
+        position           = bx::simd_madd(c1, bx::simd_splat<simd128_t>(bind.Y), position);
+        position           = bx::simd_madd(c2, bx::simd_splat<simd128_t>(bind.Z), position);
 
-    if (type != MESH_TRANSIENT)
-    {
-        static_assert(
-            offsetof(Mesh, positions) + sizeof(Mesh::positions) ==
-            offsetof(Mesh, attribs),
-            "Invalid `Mesh` structure layout assumption."
-        );
-
-        if (!create_persistent_geometry(
-            info.flags, count, attribs, layouts, thread_local_temp_allocator,
-            &mesh.positions, mesh.indices
-        ))
-        {
-            WARN(true, "Failed to create %s mesh with ID %" PRIu16 ".",
-                type == MESH_STATIC ? "static" : "dynamic", info.id
-            );
+        bounds_min = bx::simd_min(bounds_min, position);
+        bounds_max = bx::simd_max(bounds_max, position);
 
-            return;
-        }
-    }
-    else if (0 == bx::atomicCompareAndSwap(&cache.transient_memory_exhausted, 0u, 0u))
-    {
-        const u32 offset = bx::atomicFetchAndAdd(&cache.transient_buffer_count, count);
+        positions[i] = HMM_Vec3(bx::simd_x(position), bx::simd_y(position), bx::simd_z(position));
 
-        if (offset + count > cache.transient_buffers.size)
+        if (attribs)
         {
-            // TODO : This should be a once-per-frame warning.
-            WARN(true, "Transient buffer count limit %" PRIu32 " exceeded.",
-                cache.transient_buffers.size
-            );
+            const u8* src = skin.attribs + i * skin.attrib_stride;
+            u8*       dst = attribs      + i * skin.attrib_stride;
 
-            return;
-        }
+            bx::memCopy(dst, src, skin.attrib_stride);
 
-        bool success;
-        {
-            // NOTE : Mutexing since it seems that both
-            //        `getAvailTransientVertexBuffer` and
-            //        `allocTransientVertexBuffer` aren't thread safe.
-            MutexScope lock(cache.mutex);
+            f32 unpacked[3];
+            bx::unpackRgb8(unpacked, src + skin.normal_offset);
 
-            success = create_transient_geometry(
-                count, attribs, layouts, &cache.transient_buffers[offset]
-            );
-        }
+            simd128_t normal = bx::simd_mul (c0, bx::simd_splat<simd128_t>(unpacked[0] * 2.0f - 1.0f));
+            normal           = bx::simd_madd(c1, bx::simd_splat<simd128_t>(unpacked[1] * 2.0f - 1.0f), normal);
+            normal           = bx::simd_madd(c2, bx::simd_splat<simd128_t>(unpacked[2] * 2.0f - 1.0f), normal);
 
-        if (!success)
-        {
-            WARN(true, "Transient memory of %" PRIu32 " MB exhausted.",
-                0 // TODO : Provide the actual limit.
-            );
+            const Vec3 n = HMM_NormalizeVec3(HMM_Vec3(bx::simd_x(normal), bx::simd_y(normal), bx::simd_z(normal)));
 
-            bx::atomicCompareAndSwap(&cache.transient_memory_exhausted, 0u, 1u);
+            const f32 normalized[] =
+            {
+                n.X * 0.5f + 0.5f,
+                n.Y * 0.5f + 0.5f,
+                n.Z * 0.5f + 0.5f,
+            };
 
-            return;
+            bx::packRgb8(dst + skin.normal_offset, normalized);
         }
+    }
 
-        mesh.positions.transient_index = u16(offset);
+    bounds[0] = bounds_min;
+    bounds[1] = bounds_max;
+}
 
-        if (count > 1)
-        {
-            mesh.attribs.transient_index = u16(offset + 1);
-        }
-    }
+// Each task item is a chunk of `SKIN_TASK_SIZE` vertices, so that the chunk
+// bounds have a fixed place to be written to.
+struct SkinTask : enki::ITaskSet
+{
+    const SkinnedMesh* skin      = nullptr;
+    const Mat4*        joints    = nullptr;
+    Vec3*              positions = nullptr;
+    u8*                attribs   = nullptr;
+    bx::simd128_t*     bounds    = nullptr; // Minimum and maximum per chunk.
 
+    SkinTask(const SkinnedMesh* skin, u32 chunk_count)
+        : enki::ITaskSet(chunk_count, 1)
+        , skin(skin)
     {
-        MutexScope lock(cache.mutex);
+    }
 
-        destroy(cache.meshes[info.id]);
+    void ExecuteRange(enki::TaskSetPartition range, u32) override
+    {
+        for (u32 i = range.start; i < range.end; i++)
+        {
+            const u32 first = i * SKIN_TASK_SIZE;
+            const u32 last  = bx::min(first + SKIN_TASK_SIZE, skin->vertex_count);
 
-        cache.meshes[info.id] = mesh;
+            skin_vertices(*skin, joints, first, last, positions, attribs, bounds + i * 2);
+        }
     }
-}
+};
 
-void deinit(MeshCache& cache)
+u32 skin_chunk_count(const SkinnedMesh& skin)
 {
-    for (u32 i = 0; i < cache.meshes.size; i++)
-    {
-        destroy(cache.meshes[i]);
-    }
+    return (skin.vertex_count + SKIN_TASK_SIZE - 1) / SKIN_TASK_SIZE;
 }
 
-void init_frame(MeshCache& cache)
+// Skins all vertices into `positions` and `attribs` (can be null), split among
+// tasks if the mesh is large enough and a scheduler is given. The `bounds`
+// must have space for two values per chunk.
+void skin_vertices
+(
+    const SkinnedMesh&   skin,
+    const Mat4*          joints,
+    Vec3*                positions,
+    u8*                  attribs,
+    bx::simd128_t*       bounds,
+    enki::TaskScheduler* scheduler
+)
 {
-    MutexScope lock(cache.mutex);
+    const u32 chunk_count = skin_chunk_count(skin);
 
-    cache.transient_buffer_count     = 0;
-    cache.transient_memory_exhausted = 0;
+    SkinTask task(&skin, chunk_count);
+    task.joints    = joints;
+    task.positions = positions;
+    task.attribs   = attribs;
+    task.bounds    = bounds;
+
+    if (scheduler && chunk_count >= 2)
+    {
+        scheduler->AddTaskSetToPipe(&task);
+        scheduler->WaitforTask(&task);
+    }
+    else
+    {
+        task.ExecuteRange({ 0, chunk_count }, 0);
+    }
 }
 
 
 // -----------------------------------------------------------------------------
-// TEXTURE & TEXTURE CACHING
+// MESH & MESH CACHING
 // -----------------------------------------------------------------------------
 
-using BgfxTextureFormat   = BgfxReducedEnum<bgfx::TextureFormat  , u8>;
-using BgfxBackbufferRatio = BgfxReducedEnum<bgfx::BackbufferRatio, u8>;
-
-struct Texture
+struct Mesh
 {
-    bgfx::TextureHandle handle      = BGFX_INVALID_HANDLE;
-    u16                 width       = 0;
-    u16                 height      = 0;
-    BgfxTextureFormat   format      = { bgfx::TextureFormat  ::Count };
-    BgfxBackbufferRatio ratio       = { bgfx::BackbufferRatio::Count };
-    u32                 read_frame  = U32_MAX;
-    bgfx::TextureHandle blit_handle = BGFX_INVALID_HANDLE;
+    u32               element_count = 0;
+    u32               extra_data    = 0;
+    u32               flags         = 0;
+    VertexBufferUnion positions     = { bgfx::kInvalidHandle };
+    VertexBufferUnion attribs       = { bgfx::kInvalidHandle };
+    IndexBufferUnion  indices       = { bgfx::kInvalidHandle };
+    Vec3              bounds_min    = {};
+    Vec3              bounds_max    = {};
+    f32               bounds_radius = 0.0f; // Sphere centered in the middle of the bounding box.
 };
 
-struct TextureCache
+struct MeshCache
 {
-    Mutex                             mutex;
-    FixedArray<Texture, MAX_TEXTURES> textures;
+    Mutex                                                          mutex;
+    HandleTable<Mesh>                                              meshes;
+    DynamicArray<SkinnedMesh>                                      skins; // Indexed by mesh ID.
+    FixedArray<bgfx::TransientVertexBuffer, MAX_TRANSIENT_BUFFERS> transient_buffers;
+    u32                                                            transient_buffer_count     = 0;
+    u32                                                            transient_memory_exhausted = 0;
 };
 
-void destroy(Texture& texture)
+u16 mesh_type(u32 flags)
 {
-    ASSERT(bgfx::isValid(texture.blit_handle) <= bgfx::isValid(texture.handle),
-        "Blit handle %" PRIu16 " valid, but the main one is not.",
-        texture.blit_handle
-    );
-
-    destroy_if_valid(texture.handle);
-    destroy_if_valid(texture.blit_handle);
+    constexpr u16 types[] =
+    {
+        MESH_STATIC,
+        MESH_TRANSIENT,
+        MESH_DYNAMIC,
+        MESH_INVALID,
+    };
 
-    texture = {};
+    return types[(flags & MESH_TYPE_MASK) >> MESH_TYPE_SHIFT];
 }
 
-void deinit(TextureCache& cache)
+// Whether the attributes are stored in a vertex buffer separate from positions.
+constexpr bool has_attrib_stream(u32 flags)
 {
-    for (u32 i = 0; i < cache.textures.size; i++)
-    {
-        destroy(cache.textures[i]);
-    }
+    return (flags & VERTEX_ATTRIB_MASK) && !(flags & VERTEX_INTERLEAVED);
 }
 
-void add_texture
-(
-    TextureCache& cache,
-    u16           id,
-    u16           flags,
-    u16           width,
-    u16           height,
-    u16           stride,
-    const void*   data,
-    Allocator*    temp_allocator
-)
+void compute_bounds(const MeshRecorder& recorder, Mesh& mesh)
 {
-    ASSERT(temp_allocator, "Invalid temporary allocator pointer.");
-
-    constexpr u64 sampling_flags[] =
-    {
-        BGFX_SAMPLER_NONE,
-        BGFX_SAMPLER_POINT,
-    };
-
-    constexpr u64 border_flags[] =
-    {
-        BGFX_SAMPLER_NONE,
-        BGFX_SAMPLER_UVW_MIRROR,
-        BGFX_SAMPLER_UVW_CLAMP,
-    };
-
-    constexpr u64 target_flags[] =
-    {
-        BGFX_TEXTURE_NONE,
-        BGFX_TEXTURE_RT,
-    };
-
-    struct FormatInfo
-    {
-        u32                       size;
-        bgfx::TextureFormat::Enum type;
-    };
-
-    constexpr FormatInfo formats[] =
+    if (!recorder.vertex_count)
     {
-        { 4, bgfx::TextureFormat::RGBA8 },
-        { 1, bgfx::TextureFormat::R8    },
-        { 0, bgfx::TextureFormat::D24S8 },
-        { 0, bgfx::TextureFormat::D32F  },
-    };
+        return;
+    }
 
-    const FormatInfo format = formats[
-        (flags & TEXTURE_FORMAT_MASK) >> TEXTURE_FORMAT_SHIFT
-    ];
+    mesh.bounds_min = HMM_Vec3(
+        bx::simd_x(recorder.bounds_min),
+        bx::simd_y(recorder.bounds_min),
+        bx::simd_z(recorder.bounds_min)
+    );
 
-    bgfx::BackbufferRatio::Enum ratio = bgfx::BackbufferRatio::Count;
+    mesh.bounds_max = HMM_Vec3(
+        bx::simd_x(recorder.bounds_max),
+        bx::simd_y(recorder.bounds_max),
+        bx::simd_z(recorder.bounds_max)
+    );
 
-    if (width >= SIZE_EQUAL && width <= SIZE_DOUBLE && width == height)
-    {
-        ratio = bgfx::BackbufferRatio::Enum(width - SIZE_EQUAL);
-    }
+    const Vec3 center = (mesh.bounds_min + mesh.bounds_max) * 0.5f;
+    const u32  stride = vertex_position_size(mesh.flags) / sizeof(f32);
+    const f32* data   = reinterpret_cast<const f32*>(recorder.position_buffer.data);
+    const u32  count  = recorder.position_buffer.size / (stride * sizeof(f32));
 
-    const bgfx::Memory* memory = nullptr;
+    f32 radius_squared = 0.0f;
 
-    if (data && format.size > 0 && ratio == bgfx::BackbufferRatio::Count)
+    for (u32 i = 0; i < count; i++, data += stride)
     {
-        memory = alloc_bgfx_memory(temp_allocator, width * height * format.size);
-        ASSERT(memory && memory->data, "Invalid BGFX-created memory.");
-
-        if (stride == 0 || stride == width * format.size)
-        {
-            bx::memCopy(memory->data, data, memory->size);
-        }
-        else
-        {
-            const u8* src = static_cast<const u8*>(data);
-            u8*       dst = memory->data;
-
-            for (u16 y = 0; y < height; y++)
-            {
-                bx::memCopy(dst, src, width * format.size);
+        const Vec3 position = HMM_Vec3(data[0], data[1], stride > 2 ? data[2] : 0.0f);
 
-                src += stride;
-                dst += width * format.size;
-            }
-        }
+        radius_squared = bx::max(radius_squared, HMM_LengthSquaredVec3(position - center));
     }
 
-    const u64 texture_flags =
-        sampling_flags[(flags & TEXTURE_SAMPLING_MASK) >> TEXTURE_SAMPLING_SHIFT] |
-        border_flags  [(flags & TEXTURE_BORDER_MASK  ) >> TEXTURE_BORDER_SHIFT  ] |
-        target_flags  [(flags & TEXTURE_TARGET_MASK  ) >> TEXTURE_TARGET_SHIFT  ] ;
+    mesh.bounds_radius = sqrtf(radius_squared);
+}
 
-    Texture texture;
+bool is_valid(const Mesh& mesh)
+{
+    // NOTE : Transient meshes have no index buffer.
+    return
+        mesh.element_count       != 0                    &&
+        mesh.positions.raw_index != bgfx::kInvalidHandle &&
+        (mesh.indices.raw_index  != bgfx::kInvalidHandle || mesh_type(mesh.flags) == MESH_TRANSIENT);
+}
 
-    if (ratio == bgfx::BackbufferRatio::Count)
+void destroy(Mesh& mesh)
+{
+    const u16 type = mesh_type(mesh.flags);
+
+    if (type == MESH_STATIC)
     {
-        texture.handle = bgfx::createTexture2D(
-            width, height, false, 1, format.type, texture_flags, memory
-        );
+        destroy_if_valid(mesh.positions.static_buffer);
+        destroy_if_valid(mesh.attribs  .static_buffer);
+        destroy_if_valid(mesh.indices  .static_buffer);
     }
-    else
+    else if (type == MESH_DYNAMIC)
     {
-        WARN(!memory, "Content of texture %" PRIu16 " ignored.", id);
-
-        texture.handle = bgfx::createTexture2D(
-            ratio, false, 1, format.type, texture_flags
-        );
+        destroy_if_valid(mesh.positions.dynamic_buffer);
+        destroy_if_valid(mesh.attribs  .dynamic_buffer);
+        destroy_if_valid(mesh.indices  .dynamic_buffer);
     }
 
-    ASSERT(
-        bgfx::isValid(texture.handle),
-        "Creation of texture %" PRIu16 " failed.", id
-    );
+    mesh = {};
+}
 
-    texture.format = format.type;
-    texture.ratio  = ratio;
-    texture.width  = width;
-    texture.height = height;
+void release(ReleaseQueue& queue, Mesh& mesh)
+{
+    const u16 type = mesh_type(mesh.flags);
 
+    if (type == MESH_STATIC)
     {
-        MutexScope lock(cache.mutex);
-
-        destroy(cache.textures[id]);
-
-        cache.textures[id] = texture;
+        release(queue, ReleaseType::VERTEX_BUFFER, mesh.positions.raw_index);
+        release(queue, ReleaseType::VERTEX_BUFFER, mesh.attribs  .raw_index);
+        release(queue, ReleaseType::INDEX_BUFFER , mesh.indices  .raw_index);
+    }
+    else if (type == MESH_DYNAMIC)
+    {
+        release(queue, ReleaseType::DYNAMIC_VERTEX_BUFFER, mesh.positions.raw_index);
+        release(queue, ReleaseType::DYNAMIC_VERTEX_BUFFER, mesh.attribs  .raw_index);
+        release(queue, ReleaseType::DYNAMIC_INDEX_BUFFER , mesh.indices  .raw_index);
     }
-}
-
-void remove_texture(TextureCache& cache, u16 id)
-{
-    MutexScope lock(cache.mutex);
 
-    destroy(cache.textures[id]);
+    mesh = {};
 }
 
-void schedule_texture_read
+bool create_persistent_geometry
 (
-    TextureCache&  cache,
-    u16            id,
-    bgfx::ViewId   pass,
-    bgfx::Encoder* encoder,
-    void*          output_data
+    u32                        flags,
+    u32                        count,
+    const Span<u8>*            attribs,
+    const bgfx::VertexLayout** layouts,
+    Allocator*                 temp_allocator,
+    VertexBufferUnion*         output_vertex_buffers,
+    IndexBufferUnion&          output_index_buffer,
+    const Span<u8>&            skin_buffer    = {},
+    Allocator*                 skin_allocator = nullptr,
+    SkinnedMesh*               output_skin    = nullptr
 )
 {
-    MutexScope lock(cache.mutex);
+    const u32 type = mesh_type(flags);
+    const u32 vertex_count = attribs[0].size / layouts[0]->getStride();
 
-    Texture& texture = cache.textures[id];
-    ASSERT(
-        bgfx::isValid(texture.handle),
-        "Invalid BGFX handle of texture %" PRIu16 " .", id
-    );
+    FixedArray<meshopt_Stream, 3> streams;
+    ASSERT(streams.size > count, "Insufficient stream array size.");
 
-    if (!bgfx::isValid(texture.blit_handle))
+    for (u32 i = 0; i < count; i++)
     {
-        constexpr u64 flags =
-            BGFX_TEXTURE_BLIT_DST  |
-            BGFX_TEXTURE_READ_BACK |
-            BGFX_SAMPLER_MIN_POINT |
-            BGFX_SAMPLER_MAG_POINT |
-            BGFX_SAMPLER_MIP_POINT |
-            BGFX_SAMPLER_U_CLAMP   |
-            BGFX_SAMPLER_V_CLAMP   ;
+        ASSERT(
+            vertex_count == attribs[i].size / layouts[i]->getStride(),
+            "Mismatched number of vertices for attribute buffer %" PRIu32 ".",
+            i
+        );
 
-        texture.blit_handle = texture.ratio == bgfx::BackbufferRatio::Count
-            ? texture.blit_handle = bgfx::createTexture2D(
-                texture.width, texture.height, false, 1, texture.format, flags
-            )
-            : texture.blit_handle = bgfx::createTexture2D(
-                texture.ratio, false, 1, texture.format, flags
-            );
+        streams[i] = {
+            attribs[i].data,
+            layouts[i]->getStride(),
+            layouts[i]->getStride()
+        };
+    }
 
+    u32 stream_count = count;
+
+    if (output_skin)
+    {
         ASSERT(
-            bgfx::isValid(texture.blit_handle),
-            "Creating blitting texture failed for texture %" PRIu16 " .", id
+            vertex_count == skin_buffer.size / sizeof(SkinVertex),
+            "Mismatched number of skinned vertices."
         );
+
+        // Only used to prevent merging of vertices with different influences.
+        streams[stream_count++] = {
+            skin_buffer.data,
+            sizeof(SkinVertex),
+            sizeof(SkinVertex)
+        };
     }
 
-    encoder->blit(pass, texture.blit_handle, 0, 0, texture.handle);
+    DynamicArray<u32> remap_table;
+    init(remap_table, temp_allocator);
+    defer(deinit(remap_table));
 
-    texture.read_frame = bgfx::readTexture(texture.blit_handle, output_data);
-}
+    resize(remap_table, vertex_count);
 
+    const u32 indexed_vertex_count = stream_count > 1
+        ? u32(meshopt_generateVertexRemapMulti(
+            remap_table.data, nullptr, vertex_count, vertex_count, streams.data,
+            stream_count
+        ))
+        : u32(meshopt_generateVertexRemap(
+            remap_table.data, nullptr, vertex_count, streams[0].data,
+            vertex_count, streams[0].size
+        ));
 
-// -----------------------------------------------------------------------------
-// INSTANCE RECORDING
-// -----------------------------------------------------------------------------
+    void* vertex_positions = nullptr;
 
-struct InstanceRecorder
-{
-    DynamicArray<u8> buffer;
-    u16              instance_size = 0;
-};
+    for (u32 i = 0; i < count; i++)
+    {
+        output_vertex_buffers[i] = create_persistent_vertex_buffer(
+            type, streams[i], *layouts[i], vertex_count, indexed_vertex_count,
+            remap_table.data, temp_allocator, i ? nullptr : &vertex_positions
+        );
+    }
 
-void init(InstanceRecorder& recorder, Allocator* allocator)
-{
-    recorder = {};
+    const bool optimize_geometry =
+         (flags & OPTIMIZE_GEOMETRY) &&
+        ((flags & PRIMITIVE_TYPE_MASK) <= PRIMITIVE_QUADS);
 
-    init(recorder.buffer, allocator);
-}
+    if (flags & VERTEX_POSITION_2D)
+    {
+        vertex_positions = nullptr;
+    }
 
-void deinit(InstanceRecorder& recorder)
-{
-    deinit(recorder.buffer);
-}
+    output_index_buffer = create_persistent_index_buffer(
+        type, vertex_count, indexed_vertex_count,
+        static_cast<f32*>(vertex_positions), layouts[0]->getStride(),
+        remap_table.data, temp_allocator, optimize_geometry
+    );
 
-void start(InstanceRecorder& recorder, u32 type)
-{
-    constexpr u32 type_sizes[] =
+    if (output_skin)
     {
-        sizeof(Mat4), // INSTANCE_TRANSFORM
-        16,           // INSTANCE_DATA_16
-        32,           // INSTANCE_DATA_32
-        48,           // INSTANCE_DATA_48
-        64,           // INSTANCE_DATA_64
-        80,           // INSTANCE_DATA_80
-        96,           // INSTANCE_DATA_96
-        112,          // INSTANCE_DATA_112
-    };
-
-    reserve(recorder.buffer, bx::min(4_MB, 2048u * recorder.instance_size));
+        const bool skin_normals = count > 1 && (flags & VERTEX_NORMAL);
 
-    recorder.instance_size = type_sizes[bx::max<u32>(type, BX_COUNTOF(type_sizes) - 1)];
-}
+        init(
+            *output_skin, skin_allocator, vertex_count, indexed_vertex_count,
+            remap_table.data, attribs[0], skin_buffer,
+            skin_normals ? attribs[1] : Span<u8>{},
+            skin_normals ? layouts[1] : nullptr
+        );
+    }
 
-void end(InstanceRecorder& recorder)
-{
-    clear(recorder.buffer);
+    // TODO : Check that all the buffers were successfully created and perform
+    //        the cleanup if not.
 
-    recorder.instance_size = 0;
+    return true;
 }
 
-void append(InstanceRecorder& recorder, const void* instance_data)
+bool create_transient_geometry
+(
+    u32                          count,
+    const Span<u8>*              attribs,
+    const bgfx::VertexLayout**   layouts,
+    bgfx::TransientVertexBuffer* output_vertex_buffers
+)
 {
-    ASSERT(instance_data, "Invalid `instance_data` pointer.");
+    for (u32 i = 0; i < count; i++)
+    {
+        if (!create_transient_vertex_buffer(
+            attribs[i],
+            *layouts[i],
+            &output_vertex_buffers[i]
+        ))
+        {
+            return false;
+        }
+    }
 
-    append(recorder.buffer, instance_data, recorder.instance_size);
+    return true;
 }
 
-u32 instance_count(const InstanceRecorder& recorder)
+// Releases the mesh previously stored under the ID (if any) and takes over the
+// given one.
+void replace_mesh
+(
+    MeshCache&         cache,
+    ReleaseQueue&      release_queue,
+    u16                id,
+    const Mesh&        mesh,
+    const SkinnedMesh& skin
+)
 {
-    return recorder.buffer.size / recorder.instance_size;
-}
-
-
-// -----------------------------------------------------------------------------
-// INSTANCE & INSTANCE CACHE
-// -----------------------------------------------------------------------------
+    MutexScope lock(cache.mutex);
 
-struct InstanceData
-{
-    bgfx::InstanceDataBuffer buffer       = { nullptr, 0, 0, 0, 0, BGFX_INVALID_HANDLE };
-    bool                     is_transform = false;
-};
+    release(release_queue, cache.meshes[id]);
+    deinit(cache.skins[id]);
 
-struct InstanceCache
-{
-    Mutex                                          mutex;
-    FixedArray<InstanceData, MAX_INSTANCE_BUFFERS> data;
-};
+    // NOTE : Generation is kept, so that draw lists referencing the mesh stay
+    //        valid. Only `remove_mesh` invalidates them.
+    cache.meshes[id] = mesh;
+    cache.skins [id] = skin;
+}
 
-void add_instances
+void add_mesh
 (
-    InstanceCache&          cache,
-    const InstanceRecorder& recorder,
-    u16                     id,
-    bool                    is_transform
+    MeshCache&                      cache,
+    ReleaseQueue&                   release_queue,
+    const RecordInfo&               info,
+    const MeshRecorder&             recorder,
+    VertexLayoutCache&              layouts_,
+    Allocator*                      thread_local_temp_allocator
 )
 {
-    ASSERT(id < cache.data.size,
+    ASSERT(info.id < cache.meshes.size,
         "Mesh id %" PRIu16 " out of bounds (%" PRIu32").",
-        id, cache.data.size
+        info.id, cache.meshes.size
     );
 
-    const u32 count  = instance_count(recorder);
-    const u16 stride = recorder.instance_size;
-
-    // NOTE : Mutexing since it seems that both `getAvailInstanceDataBuffer`
-    //        and `allocInstanceDataBuffer` aren't thread safe.
-    MutexScope lock(cache.mutex);
+    const u16 type = mesh_type(info.flags);
 
-    if (bgfx::getAvailInstanceDataBuffer(count, stride) < count)
+    if (type == MESH_INVALID)
     {
-        WARN(true, "Instance buffer memory exhausted.");
+        WARN(true, "Invalid registered mesh type.");
         return;
     }
 
-    InstanceData &instance_data = cache.data[id];
-
-    instance_data.is_transform = is_transform;
+    const bool is_skinned = (info.flags & VERTEX_SKINNED) && type == MESH_DYNAMIC;
 
-    bgfx::allocInstanceDataBuffer(&instance_data.buffer, count, stride);
-    bx::memCopy(instance_data.buffer.data, recorder.buffer.data,
-        recorder.buffer.size
+    WARN(
+        !(info.flags & VERTEX_SKINNED) || is_skinned,
+        "Only dynamic meshes can be skinned, mesh %" PRIu16 " won't be.",
+        info.id
     );
-}
-
-// -----------------------------------------------------------------------------
-// UNIFORMS & UNIFORMS CACHING
-// -----------------------------------------------------------------------------
 
-enum struct DefaultUniform : u32
-{
-    COLOR_TEXTURE_RED,
-    COLOR_TEXTURE_RGBA,
-    TEXTURE_SIZE,
-};
+    u32 flags = info.flags;
 
-struct DefaultUniformInfo
-{
-    const char*             name;
-    bgfx::UniformType::Enum type;
-    DefaultUniform          index;
-};
+    // NOTE : Transient meshes are uploaded as recorded, and skinning updates
+    //        the positions on their own.
+    if (type == MESH_TRANSIENT || is_skinned)
+    {
+        flags &= ~VERTEX_INTERLEAVED;
+    }
 
-const DefaultUniformInfo s_default_uniforms[] =
-{
-    { "s_tex_color_r"     , bgfx::UniformType::Sampler, DefaultUniform::COLOR_TEXTURE_RED  },
-    { "color_texture_rgba", bgfx::UniformType::Sampler, DefaultUniform::COLOR_TEXTURE_RGBA },
-    { "u_tex_size"        , bgfx::UniformType::Vec4   , DefaultUniform::TEXTURE_SIZE       },
-};
+    u32 count = 1 + (recorder.attrib_buffer.size > 0);
 
-using DefaultUniforms = FixedArray<bgfx::UniformHandle, BX_COUNTOF(s_default_uniforms)>;
+    Span<u8>                  attribs[2];
+    const bgfx::VertexLayout* layouts[2];
 
-struct UniformCache
-{
-    Mutex                                         mutex;
-    FixedArray<bgfx::UniformHandle, MAX_UNIFORMS> handles;
-};
+    attribs[0] = recorder.position_buffer;
+    layouts[0] = &vertex_layout(layouts_, VERTEX_POSITION | (flags & VERTEX_POSITION_2D));
 
-void init(UniformCache& cache)
-{
-    for (u32 i = 0; i < cache.handles.size; i++)
+    if (count > 1)
     {
-        cache.handles[i] = BGFX_INVALID_HANDLE;
+        attribs[1] = recorder.attrib_buffer;
+        layouts[1] = &vertex_layout(layouts_, flags & ~VERTEX_INTERLEAVED);
     }
-}
 
-void deinit(UniformCache& cache)
-{
-    for (u32 i = 0; i < cache.handles.size; i++)
+    DynamicArray<u8> interleaved;
+    init(interleaved, thread_local_temp_allocator);
+    defer(deinit(interleaved));
+
+    if (count > 1 && (flags & VERTEX_INTERLEAVED))
     {
-        destroy_if_valid(cache.handles[i]);
+        interleave_vertices(
+            attribs[0], layouts[0]->getStride(),
+            attribs[1], layouts[1]->getStride(),
+            interleaved
+        );
+
+        attribs[0] = interleaved;
+        layouts[0] = &vertex_layout(layouts_, flags);
+        count      = 1;
     }
-}
 
-void add_uniform
-(
-    UniformCache& cache,
-    u16           id,
-    u16           type,
-    u16           count,
-    const char*   name
-)
-{
-    constexpr bgfx::UniformType::Enum types[] =
-    {
-        bgfx::UniformType::Count,
+    Mesh        mesh;
+    SkinnedMesh skin = {};
 
-        bgfx::UniformType::Vec4,
-        bgfx::UniformType::Mat4,
-        bgfx::UniformType::Mat3,
-        bgfx::UniformType::Sampler,
-    };
+    mesh.element_count = recorder.vertex_count;
+    mesh.extra_data    = info.extra_data;
+    mesh.flags         = flags;
 
-    bgfx::UniformHandle handle = bgfx::createUniform(name, types[type], count);
-    ASSERT(bgfx::isValid(handle), "Uniform creation failed.");
+    compute_bounds(recorder, mesh);
 
-    MutexScope lock(cache.mutex);
+    if (type != MESH_TRANSIENT)
+    {
+        static_assert(
+            offsetof(Mesh, positions) + sizeof(Mesh::positions) ==
+            offsetof(Mesh, attribs),
+            "Invalid `Mesh` structure layout assumption."
+        );
 
-    destroy_if_valid(cache.handles[id]);
-    cache.handles[id] = handle;
-}
+        if (!create_persistent_geometry(
+            flags, count, attribs, layouts, thread_local_temp_allocator,
+            &mesh.positions, mesh.indices, recorder.skin_buffer,
+            cache.skins.allocator, is_skinned ? &skin : nullptr
+        ))
+        {
+            WARN(true, "Failed to create %s mesh with ID %" PRIu16 ".",
+                type == MESH_STATIC ? "static" : "dynamic", info.id
+            );
 
-void init(DefaultUniforms& uniforms)
-{
-    for (u32 i = 0; i < uniforms.size; i++)
+            return;
+        }
+    }
+    else if (0 == bx::atomicCompareAndSwap(&cache.transient_memory_exhausted, 0u, 0u))
     {
-        const u32 index = u32(s_default_uniforms[i].index);
+        const u32 offset = bx::atomicFetchAndAdd(&cache.transient_buffer_count, count);
 
-        uniforms[index] = bgfx::createUniform(
-            s_default_uniforms[i].name,
-            s_default_uniforms[i].type
-        );
+        if (offset + count > cache.transient_buffers.size)
+        {
+            // TODO : This should be a once-per-frame warning.
+            WARN(true, "Transient buffer count limit %" PRIu32 " exceeded.",
+                cache.transient_buffers.size
+            );
 
-        ASSERT(bgfx::isValid(uniforms[index]),
-            "Failed to create default uniform '%s'.",
-            s_default_uniforms[i].name
-        );
+            return;
+        }
+
+        bool success;
+        {
+            // NOTE : Mutexing since it seems that both
+            //        `getAvailTransientVertexBuffer` and
+            //        `allocTransientVertexBuffer` aren't thread safe.
+            MutexScope lock(cache.mutex);
+
+            success = create_transient_geometry(
+                count, attribs, layouts, &cache.transient_buffers[offset]
+            );
+        }
+
+        if (!success)
+        {
+            WARN(true, "Transient memory of %" PRIu32 " MB exhausted.",
+                0 // TODO : Provide the actual limit.
+            );
+
+            bx::atomicCompareAndSwap(&cache.transient_memory_exhausted, 0u, 1u);
+
+            return;
+        }
+
+        mesh.positions.transient_index = u16(offset);
+
+        if (count > 1)
+        {
+            mesh.attribs.transient_index = u16(offset + 1);
+        }
     }
+
+    replace_mesh(cache, release_queue, info.id, mesh, skin);
 }
 
-void deinit(DefaultUniforms& uniforms)
+void remove_mesh(MeshCache& cache, ReleaseQueue& release_queue, u16 id)
 {
-    for (u32 i = 0; i < uniforms.size; i++)
-    {
-        destroy_if_valid(uniforms[i]);
-    }
+    MutexScope lock(cache.mutex);
+
+    release(release_queue, cache.meshes[id]);
+    deinit(cache.skins[id]);
+
+    next_generation(cache.meshes, id);
 }
 
-bgfx::UniformHandle default_sampler
-(
-    const DefaultUniforms&    uniforms,
-    bgfx::TextureFormat::Enum format
-)
+void init(MeshCache& cache, Allocator* allocator, u32 mesh_count)
 {
-    switch (format)
+    init(cache.meshes, allocator, mesh_count);
+
+    init(cache.skins, allocator);
+    resize(cache.skins, mesh_count, SkinnedMesh{});
+}
+
+void deinit(MeshCache& cache)
+{
+    for (u32 i = 0; i < cache.meshes.size; i++)
     {
-    case bgfx::TextureFormat::RGBA8:
-        return uniforms[u32(DefaultUniform::COLOR_TEXTURE_RGBA)];
-    case bgfx::TextureFormat::R8:
-        return uniforms[u32(DefaultUniform::COLOR_TEXTURE_RED)];
-    default:
-        return BGFX_INVALID_HANDLE;
+        destroy(cache.meshes[i]);
+        deinit (cache.skins [i]);
     }
+
+    deinit(cache.meshes);
+    deinit(cache.skins );
+}
+
+void init_frame(MeshCache& cache)
+{
+    MutexScope lock(cache.mutex);
+
+    cache.transient_buffer_count     = 0;
+    cache.transient_memory_exhausted = 0;
 }
 
 
 // -----------------------------------------------------------------------------
-// DEFAULT PROGRAMS
+// MESH SKINNING (II / II)
 // -----------------------------------------------------------------------------
 
-const bgfx::EmbeddedShader s_default_shaders[] =
+// Skins the mesh and replaces the contents of its dynamic buffers. The bounding
+// sphere is the one around the new bounding box, which is cheaper to get than
+// the tight one computed for the recorded meshes.
+void skin
+(
+    MeshCache&           cache,
+    u16                  id,
+    const f32*           joint_matrices,
+    u32                  joint_count,
+    Allocator*           temp_allocator,
+    enki::TaskScheduler* scheduler
+)
 {
-    BGFX_EMBEDDED_SHADER(position_fs),
-    BGFX_EMBEDDED_SHADER(position_vs),
+    ASSERT(joint_matrices, "Invalid joint matrices pointer.");
+    ASSERT(temp_allocator, "Invalid temporary allocator pointer.");
 
-    BGFX_EMBEDDED_SHADER(position_color_fs),
-    BGFX_EMBEDDED_SHADER(position_color_vs),
+    Mesh        mesh;
+    SkinnedMesh skin;
+    {
+        MutexScope lock(cache.mutex);
 
-    BGFX_EMBEDDED_SHADER(position_color_normal_fs),
-    BGFX_EMBEDDED_SHADER(position_color_normal_vs),
+        mesh = cache.meshes[id];
+        skin = cache.skins [id];
+    }
 
-    BGFX_EMBEDDED_SHADER(position_color_texcoord_fs),
-    BGFX_EMBEDDED_SHADER(position_color_texcoord_vs),
+    WARN(skin.vertex_count, "Mesh %" PRIu16 " isn't skinned.", id);
+    WARN(
+        joint_count >= skin.joint_count,
+        "Mesh %" PRIu16 " needs %" PRIu32 " joints, but only %" PRIu32 " given.",
+        id, skin.joint_count, joint_count
+    );
 
-    BGFX_EMBEDDED_SHADER(position_normal_fs),
-    BGFX_EMBEDDED_SHADER(position_normal_vs),
+    if (!skin.vertex_count || joint_count < skin.joint_count)
+    {
+        return;
+    }
 
-    BGFX_EMBEDDED_SHADER(position_texcoord_fs),
-    BGFX_EMBEDDED_SHADER(position_texcoord_vs),
+    // NOTE : Copied, as the user data might not be aligned for SIMD loads.
+    Mat4* joints = static_cast<Mat4*>(BX_ALIGNED_ALLOC(
+        temp_allocator, joint_count * sizeof(Mat4), 16
+    ));
 
-    BGFX_EMBEDDED_SHADER(position_color_r_texcoord_fs),
-    BGFX_EMBEDDED_SHADER(position_color_r_pixcoord_fs),
+    bx::simd128_t* bounds = static_cast<bx::simd128_t*>(BX_ALIGNED_ALLOC(
+        temp_allocator, skin_chunk_count(skin) * 2 * sizeof(bx::simd128_t), 16
+    ));
 
-    BGFX_EMBEDDED_SHADER(instancing_position_color_vs),
-};
+    ASSERT(joints && bounds, "Skinning temporary memory allocation failed.");
 
-struct DefaultProgramInfo
-{
-    u32         attribs;
-    const char* vs_name;
-    const char* fs_name = nullptr;
-};
+    bx::memCopy(joints, joint_matrices, joint_count * sizeof(Mat4));
 
-const DefaultProgramInfo s_default_program_info[] =
-{
-    {
-        0, // NOTE : Position only. It's assumed everywhere else.
-        "position"
-    },
-    {
-        VERTEX_COLOR,
-        "position_color"
-    },
-    {
-        VERTEX_COLOR | VERTEX_NORMAL,
-        "position_color_normal"
-    },
-    {
-        VERTEX_COLOR | VERTEX_TEXCOORD,
-        "position_color_texcoord"
-    },
-    {
-        VERTEX_NORMAL,
-        "position_normal"
-    },
-    {
-        VERTEX_TEXCOORD,
-        "position_texcoord"
-    },
+    const bgfx::Memory* positions = bgfx::alloc(skin.vertex_count * sizeof(Vec3));
+    const bgfx::Memory* attribs   = skin.attribs
+        ? bgfx::alloc(skin.vertex_count * skin.attrib_stride)
+        : nullptr;
+
+    skin_vertices(
+        skin,
+        joints,
+        reinterpret_cast<Vec3*>(positions->data),
+        attribs ? attribs->data : nullptr,
+        bounds,
+        scheduler
+    );
+
+    bgfx::update(mesh.positions.dynamic_buffer, 0, positions);
+
+    if (attribs)
     {
-        VERTEX_COLOR | INSTANCING_SUPPORTED,
-        "instancing_position_color",
-        "position_color"
-    },
+        bgfx::update(mesh.attribs.dynamic_buffer, 0, attribs);
+    }
+
+    bx::simd128_t bounds_min = bounds[0];
+    bx::simd128_t bounds_max = bounds[1];
+
+    for (u32 i = 1, n = skin_chunk_count(skin); i < n; i++)
     {
-        VERTEX_COLOR | VERTEX_TEXCOORD | SAMPLER_COLOR_R,
-        "position_color_texcoord",
-        "position_color_r_texcoord"
-    },
+        bounds_min = bx::simd_min(bounds_min, bounds[i * 2    ]);
+        bounds_max = bx::simd_max(bounds_max, bounds[i * 2 + 1]);
+    }
+
+    BX_ALIGNED_FREE(temp_allocator, bounds, 16);
+    BX_ALIGNED_FREE(temp_allocator, joints, 16);
+
     {
-        VERTEX_COLOR | VERTEX_TEXCOORD | VERTEX_PIXCOORD | SAMPLER_COLOR_R,
-        "position_color_texcoord",
-        "position_color_r_pixcoord"
-    },
+        MutexScope lock(cache.mutex);
+
+        Mesh& target = cache.meshes[id];
+
+        target.bounds_min    = HMM_Vec3(bx::simd_x(bounds_min), bx::simd_y(bounds_min), bx::simd_z(bounds_min));
+        target.bounds_max    = HMM_Vec3(bx::simd_x(bounds_max), bx::simd_y(bounds_max), bx::simd_z(bounds_max));
+        target.bounds_radius = HMM_LengthVec3(target.bounds_max - target.bounds_min) * 0.5f;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// PROCEDURAL PRIMITIVES
+// -----------------------------------------------------------------------------
+
+// Primitives are generated as indexed triangle lists straight into the memory
+// handed over to BGFX, skipping the recorder and the vertex remapping, as their
+// vertex and index counts are known up front. Untransformed, they fit into the
+// unit cube centered at the origin, rotationally symmetric ones around Y axis.
+
+constexpr u32 MAX_ICOSPHERE_SUBDIVISIONS = 7;
+
+struct PrimitiveSize
+{
+    u32 vertex_count;
+    u32 index_count;
 };
 
-using DefaultPrograms = FixedArray<bgfx::ProgramHandle, 64>;
+struct PrimitiveWriter
+{
+    VertexAttribState attrib_state;
+    Mat4              transform;
+    Vec3              normal_transform[3]; // Cofactor matrix columns.
+    Vec3              bounds_min;
+    Vec3              bounds_max;
+    Vec3*             positions;
+    u8*               attribs;             // Null if no attributes are stored.
+    u8*               indices;
+    u32               vertex_count;
+    u32               index_count;
+    bool              index32;
+};
 
-constexpr u32 default_program_index(u32 attribs)
+void init(PrimitiveWriter& writer, u32 flags, const Mat4& transform)
 {
-    static_assert(
-        VERTEX_ATTRIB_MASK   >> VERTEX_ATTRIB_SHIFT == 0b000111 &&
-        INSTANCING_SUPPORTED >> 17                  == 0b001000 &&
-        SAMPLER_COLOR_R      >> 17                  == 0b010000 &&
-        VERTEX_PIXCOORD      >> 18                  == 0b100000,
-        "Invalid index assumptions in default_program_index`."
-    );
+    writer = {};
 
-    return
-        ((attribs & VERTEX_ATTRIB_MASK  ) >> VERTEX_ATTRIB_SHIFT) | // Bits 0..2.
-        ((attribs & INSTANCING_SUPPORTED) >> 17                 ) | // Bit 3.
-        ((attribs & SAMPLER_COLOR_R     ) >> 17                 ) | // Bit 4.
-        ((attribs & VERTEX_PIXCOORD     ) >> 18                 ) ; // Bit 5.
+    reset(writer.attrib_state, flags);
+
+    writer.transform  = transform;
+    writer.bounds_min = HMM_Vec3( FLT_MAX,  FLT_MAX,  FLT_MAX);
+    writer.bounds_max = HMM_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    // The cofactor matrix is the inverse transpose scaled by the determinant,
+    // so only the sign needs fixing, as the normals get normalized anyway.
+    const Vec3 a = HMM_Vec3(transform.Elements[0][0], transform.Elements[0][1], transform.Elements[0][2]);
+    const Vec3 b = HMM_Vec3(transform.Elements[1][0], transform.Elements[1][1], transform.Elements[1][2]);
+    const Vec3 c = HMM_Vec3(transform.Elements[2][0], transform.Elements[2][1], transform.Elements[2][2]);
+
+    const f32 sign = HMM_DotVec3(a, HMM_Cross(b, c)) < 0.0f ? -1.0f : 1.0f;
+
+    writer.normal_transform[0] = HMM_Cross(b, c) * sign;
+    writer.normal_transform[1] = HMM_Cross(c, a) * sign;
+    writer.normal_transform[2] = HMM_Cross(a, b) * sign;
 }
 
-void init(DefaultPrograms& programs, bgfx::RendererType::Enum renderer)
+u32 emit_vertex(PrimitiveWriter& writer, const Vec3& position, const Vec3& normal, f32 u, f32 v)
 {
-    fill(programs, BGFX_INVALID_HANDLE);
-
-    char vs_name[32];
-    char fs_name[32];
+    const u32  index       = writer.vertex_count++;
+    const Vec3 transformed = (writer.transform * HMM_Vec4v(position, 1.0f)).XYZ;
 
-    for (u32 i = 0; i < BX_COUNTOF(s_default_program_info); i++)
-    {
-        const DefaultProgramInfo& info = s_default_program_info[i];
+    writer.positions[index] = transformed;
 
-        bx::strCopy(vs_name, sizeof(vs_name), info.vs_name);
-        bx::strCat (vs_name, sizeof(vs_name), "_vs");
+    writer.bounds_min = HMM_Vec3(
+        bx::min(writer.bounds_min.X, transformed.X),
+        bx::min(writer.bounds_min.Y, transformed.Y),
+        bx::min(writer.bounds_min.Z, transformed.Z)
+    );
 
-        bx::strCopy(fs_name, sizeof(fs_name), info.fs_name ? info.fs_name : info.vs_name);
-        bx::strCat (fs_name, sizeof(fs_name), "_fs");
+    writer.bounds_max = HMM_Vec3(
+        bx::max(writer.bounds_max.X, transformed.X),
+        bx::max(writer.bounds_max.Y, transformed.Y),
+        bx::max(writer.bounds_max.Z, transformed.Z)
+    );
 
-        const bgfx::ShaderHandle vertex = bgfx::createEmbeddedShader(
-            s_default_shaders, renderer, vs_name
-        );
-        ASSERT(
-            bgfx::isValid(vertex),
-            "Invalid default vertex shader '%s'.",
-            vs_name
-        );
+    if (writer.attribs)
+    {
+        VertexAttribState& state = writer.attrib_state;
 
-        const bgfx::ShaderHandle fragment = bgfx::createEmbeddedShader(
-            s_default_shaders, renderer, fs_name
-        );
-        ASSERT(
-            bgfx::isValid(fragment),
-            "Invalid default fragment shader '%s'.",
-            fs_name
+        const Vec3 n = HMM_NormalizeVec3(
+            writer.normal_transform[0] * normal.X +
+            writer.normal_transform[1] * normal.Y +
+            writer.normal_transform[2] * normal.Z
         );
 
-        const bgfx::ProgramHandle program = bgfx::createProgram(vertex, fragment, true);
-        ASSERT(
-            bgfx::isValid(program),
-            "Invalid default program with shaders '%s' and '%s'.",
-            vs_name, fs_name
-        );
+        (*state.store_normal  )(state, n.X, n.Y, n.Z);
+        (*state.store_texcoord)(state, u, v);
 
-        const u32 index = default_program_index(info.attribs);
-        programs[index] = program;
+        bx::memCopy(writer.attribs + index * state.size, state.data, state.size);
     }
+
+    return index;
 }
 
-void deinit(DefaultPrograms& programs)
+void emit_triangle(PrimitiveWriter& writer, u32 a, u32 b, u32 c)
 {
-    for (u32 i = 0; i < programs.size; i++)
+    if (writer.index32)
     {
-        destroy_if_valid(programs[i]);
+        u32* indices = reinterpret_cast<u32*>(writer.indices) + writer.index_count;
+
+        indices[0] = a;
+        indices[1] = b;
+        indices[2] = c;
     }
-}
+    else
+    {
+        u16* indices = reinterpret_cast<u16*>(writer.indices) + writer.index_count;
 
+        indices[0] = u16(a);
+        indices[1] = u16(b);
+        indices[2] = u16(c);
+    }
 
-// -----------------------------------------------------------------------------
-// PROGRAM CACHE
-// -----------------------------------------------------------------------------
+    writer.index_count += 3;
+}
 
-struct ProgramCache
+// Grid of `rows + 1` rows of `columns + 1` vertices. Quad `(a, b, c, d)`, with
+// `b` being next in the row and `d` in the column, is split into triangles
+// `(a, d, c)` and `(a, c, b)`, so its front face normal is `cross(ad, ab)`.
+// Collapsed first or last row (pole) only gets the non-degenerate triangles.
+PrimitiveSize grid_size(u32 columns, u32 rows, bool closed_first, bool closed_last)
 {
-    Mutex                                         mutex;
-    FixedArray<bgfx::ProgramHandle, MAX_PROGRAMS> handles;
-};
+    return
+    {
+        (columns + 1) * (rows + 1),
+        columns * (rows * 6 - (closed_first + closed_last) * 3),
+    };
+}
 
-void init(ProgramCache& cache)
+void emit_grid_indices(PrimitiveWriter& writer, u32 first, u32 columns, u32 rows, bool closed_first, bool closed_last)
 {
-    fill(cache.handles, BGFX_INVALID_HANDLE);
+    for (u32 j = 0; j < rows; j++)
+    for (u32 i = 0; i < columns; i++)
+    {
+        const u32 a = first + j * (columns + 1) + i;
+        const u32 b = a + 1;
+        const u32 d = a + columns + 1;
+        const u32 c = d + 1;
+
+        if (!closed_last || j + 1 < rows)
+        {
+            emit_triangle(writer, a, d, c);
+        }
+
+        if (!closed_first || j > 0)
+        {
+            emit_triangle(writer, a, c, b);
+        }
+    }
 }
 
-void deinit(ProgramCache& cache)
+// Flat grid spanned by the axes from the corner, facing `cross(v_axis, u_axis)`.
+void emit_patch(PrimitiveWriter& writer, const Vec3& corner, const Vec3& u_axis, const Vec3& v_axis, u32 columns, u32 rows)
 {
-    for (u32 i = 0; i < cache.handles.size; i++)
+    const u32  first  = writer.vertex_count;
+    const Vec3 normal = HMM_NormalizeVec3(HMM_Cross(v_axis, u_axis));
+
+    for (u32 j = 0; j <= rows   ; j++)
+    for (u32 i = 0; i <= columns; i++)
     {
-        destroy_if_valid(cache.handles[i]);
+        const f32 u = f32(i) / f32(columns);
+        const f32 v = f32(j) / f32(rows   );
+
+        emit_vertex(writer, corner + u_axis * u + v_axis * v, normal, u, v);
     }
+
+    emit_grid_indices(writer, first, columns, rows, false, false);
 }
 
-void add_program
-(
-    ProgramCache& cache,
-    u16           id,
-    const void*   vs_data,
-    u32           vs_size,
-    const void*   fs_data,
-    u32           fs_size
-)
+struct LatheRow
 {
-    ASSERT(
-        id < cache.handles.size,
-        "Program id %" PRIu16 " out of bounds (%" PRIu32").",
-        id, cache.handles.size
-    )
-    ASSERT(vs_data, "Invalid vertex shader blob pointer.");
-    ASSERT(vs_size, "Zero vertex shader blob size.");
-    ASSERT(fs_data, "Invalid fragment shader blob pointer.");
-    ASSERT(fs_size, "Zero fragment shader blob size.");
+    f32 radius;
+    f32 height;
+    f32 normal_radial;
+    f32 normal_height;
+    f32 v;
+};
 
-    // NOTE : `vs_data` and `fs_data` are assumed to be valid according to
-    //        `bgfx::Memory`'s requirements (i.e., at least for two frames).
-    bgfx::ShaderHandle  vertex   = bgfx::createShader(bgfx::makeRef(vs_data, vs_size));
-    bgfx::ShaderHandle  fragment = bgfx::createShader(bgfx::makeRef(fs_data, fs_size));
-    bgfx::ProgramHandle program  = bgfx::createProgram(vertex, fragment, true);
+// Surface of revolution around the Y axis, with the profile rows given from the
+// top down, so that the faces point outwards.
+template <typename Func>
+void emit_lathe(PrimitiveWriter& writer, u32 segments, u32 rows, bool closed_top, bool closed_bottom, Func&& profile)
+{
+    const u32 first = writer.vertex_count;
 
-    if (!bgfx::isValid(program))
+    for (u32 j = 0; j <= rows; j++)
     {
-        ASSERT(false, "Custom program creation failed.");
+        const LatheRow row = profile(j);
 
-        destroy_if_valid(vertex);
-        destroy_if_valid(fragment);
-        destroy_if_valid(program);
+        for (u32 i = 0; i <= segments; i++)
+        {
+            const f32 angle = HMM_PI32 * 2.0f * f32(i) / f32(segments);
+            const f32 x     =  cosf(angle);
+            const f32 z     = -sinf(angle);
+
+            emit_vertex(
+                writer,
+                HMM_Vec3(row.radius        * x, row.height       , row.radius        * z),
+                HMM_Vec3(row.normal_radial * x, row.normal_height, row.normal_radial * z),
+                f32(i) / f32(segments),
+                row.v
+            );
+        }
     }
-    else
-    {
-        MutexScope lock(cache.mutex);
 
-        destroy_if_valid(cache.handles[id]);
+    emit_grid_indices(writer, first, segments, rows, closed_top, closed_bottom);
+}
 
-        cache.handles[id] = program;
-    }
+PrimitiveSize disc_size(u32 segments)
+{
+    return { segments + 1, segments * 3 };
 }
 
+// Horizontal disc of radius 0.5, facing up or down.
+void emit_disc(PrimitiveWriter& writer, u32 segments, f32 height, bool up)
+{
+    const Vec3 normal = HMM_Vec3(0.0f, up ? 1.0f : -1.0f, 0.0f);
+    const u32  center = emit_vertex(writer, HMM_Vec3(0.0f, height, 0.0f), normal, 0.5f, 0.5f);
 
-// -----------------------------------------------------------------------------
-// FRAMEBUFFER & FRAMEBUFFER RECORDING & FRAMEBUFFER CACHE
-// -----------------------------------------------------------------------------
+    for (u32 i = 0; i < segments; i++)
+    {
+        const f32 angle = HMM_PI32 * 2.0f * f32(i) / f32(segments);
+        const f32 x     =  cosf(angle) * 0.5f;
+        const f32 z     = -sinf(angle) * 0.5f;
 
-struct FramebufferRecorder
-{
-    FixedArray<bgfx::TextureHandle, 16> attachments;
-    u16                                 count  = 0;
-    u16                                 width  = 0;
-    u16                                 height = 0;
-};
+        emit_vertex(writer, HMM_Vec3(x, height, z), normal, 0.5f + x, up ? 0.5f + z : 0.5f - z);
+    }
 
-void start(FramebufferRecorder& recorder)
-{
-    recorder.count  = 0;
-    recorder.width  = 0;
-    recorder.height = 0;
+    for (u32 i = 0; i < segments; i++)
+    {
+        const u32 a = center + 1 + i;
+        const u32 b = center + 1 + (i + 1) % segments;
+
+        if (up)
+        {
+            emit_triangle(writer, center, a, b);
+        }
+        else
+        {
+            emit_triangle(writer, center, b, a);
+        }
+    }
 }
 
-void end(FramebufferRecorder& recorder)
+PrimitiveSize box_size()
 {
-    start(recorder);
+    return { 6 * 4, 6 * 6 };
 }
 
-void add_attachment(FramebufferRecorder& recorder, const Texture& attachment)
+void generate_box(PrimitiveWriter& writer)
 {
-    ASSERT(
-        attachment.width > 0 && attachment.height > 0,
-        "Zero attachment texture width or height."
-    );
+    // Side faces have U axis going right and V axis down, when looked at.
+    static const Vec3 s_faces[][2] =
+    {
+        { HMM_Vec3( 0.0f,  0.0f, -1.0f), HMM_Vec3( 0.0f, -1.0f,  0.0f) }, // +X
+        { HMM_Vec3( 0.0f,  0.0f,  1.0f), HMM_Vec3( 0.0f, -1.0f,  0.0f) }, // -X
+        { HMM_Vec3( 1.0f,  0.0f,  0.0f), HMM_Vec3( 0.0f,  0.0f,  1.0f) }, // +Y
+        { HMM_Vec3( 1.0f,  0.0f,  0.0f), HMM_Vec3( 0.0f,  0.0f, -1.0f) }, // -Y
+        { HMM_Vec3( 1.0f,  0.0f,  0.0f), HMM_Vec3( 0.0f, -1.0f,  0.0f) }, // +Z
+        { HMM_Vec3(-1.0f,  0.0f,  0.0f), HMM_Vec3( 0.0f, -1.0f,  0.0f) }, // -Z
+    };
 
-    if (!recorder.count)
+    for (u32 i = 0; i < BX_COUNTOF(s_faces); i++)
     {
-        recorder.width  = attachment.width;
-        recorder.height = attachment.height;
+        const Vec3& u_axis = s_faces[i][0];
+        const Vec3& v_axis = s_faces[i][1];
+        const Vec3  normal = HMM_Cross(v_axis, u_axis);
+
+        emit_patch(writer, (normal - u_axis - v_axis) * 0.5f, u_axis, v_axis, 1, 1);
     }
+}
 
-    ASSERT(
-        attachment.width == recorder.width && attachment.height == recorder.height,
-        "Mismatched framebuffer recording size. Started as %" PRIu16 "x%" PRIu16
-        ", but the next attachment texture has size %" PRIu16 "x%" PRIu16".",
-        recorder.width, recorder.height, attachment.width, attachment.height
-    );
+PrimitiveSize plane_size(u32 columns, u32 rows)
+{
+    return grid_size(columns, rows, false, false);
+}
 
-    ASSERT(
-        recorder.count < recorder.attachments.size,
-        "Maximum attachment texture count (" PRIu32 ") exhausted.",
-        recorder.attachments.size
+// Plane in the XZ plane, facing up.
+void generate_plane(PrimitiveWriter& writer, u32 columns, u32 rows)
+{
+    emit_patch(
+        writer,
+        HMM_Vec3(-0.5f, 0.0f, -0.5f),
+        HMM_Vec3( 1.0f, 0.0f,  0.0f),
+        HMM_Vec3( 0.0f, 0.0f,  1.0f),
+        columns,
+        rows
     );
+}
 
-    recorder.attachments[recorder.count++] = attachment.handle;
+PrimitiveSize sphere_size(u32 segments, u32 rings)
+{
+    return grid_size(segments, rings, true, true);
 }
 
-struct Framebuffer
+void generate_sphere(PrimitiveWriter& writer, u32 segments, u32 rings)
 {
-    bgfx::FrameBufferHandle handle = BGFX_INVALID_HANDLE;
-    u16                     width  = 0;
-    u16                     height = 0;
-};
+    emit_lathe(writer, segments, rings, true, true, [&](u32 j)
+    {
+        const f32 v      = f32(j) / f32(rings);
+        const f32 angle  = HMM_PI32 * v;
+        const f32 radial = j == rings ? 0.0f : sinf(angle); // Exact pole.
+        const f32 height = cosf(angle);
 
-struct FramebufferCache
+        return LatheRow{ radial * 0.5f, height * 0.5f, radial, height, v };
+    });
+}
+
+PrimitiveSize cylinder_size(u32 segments)
 {
-    Mutex                                     mutex;
-    FixedArray<Framebuffer, MAX_FRAMEBUFFERS> framebuffers;
-};
+    const PrimitiveSize side = grid_size(segments, 1, false, false);
+    const PrimitiveSize cap  = disc_size(segments);
 
-void destroy(Framebuffer& framebuffer)
+    return
+    {
+        side.vertex_count + cap.vertex_count * 2,
+        side.index_count  + cap.index_count  * 2,
+    };
+}
+
+void generate_cylinder(PrimitiveWriter& writer, u32 segments)
 {
-    destroy_if_valid(framebuffer.handle);
+    emit_lathe(writer, segments, 1, false, false, [](u32 j)
+    {
+        return LatheRow{ 0.5f, 0.5f - f32(j), 1.0f, 0.0f, f32(j) };
+    });
 
-    framebuffer = {};
+    emit_disc(writer, segments,  0.5f, true );
+    emit_disc(writer, segments, -0.5f, false);
 }
 
-void deinit(FramebufferCache& cache)
+PrimitiveSize cone_size(u32 segments)
 {
-    for (u32 i = 0; i < cache.framebuffers.size; i++)
+    const PrimitiveSize side = grid_size(segments, 1, true, false);
+    const PrimitiveSize cap  = disc_size(segments);
+
+    return
     {
-        destroy(cache.framebuffers[i]);
-    }
+        side.vertex_count + cap.vertex_count,
+        side.index_count  + cap.index_count ,
+    };
 }
 
-void add_framebuffer
-(
-    FramebufferCache&                cache,
-    u16                              id,
-    u16                              width,
-    u16                              height,
-    const Span<bgfx::TextureHandle>& attachments
-)
+void generate_cone(PrimitiveWriter& writer, u32 segments)
 {
-    ASSERT(attachments.size, "Attachment texture list empty.");
+    // Slope normal of a cone with the height twice the base radius.
+    const f32 normal_radial = 2.0f / sqrtf(5.0f);
+    const f32 normal_height = 1.0f / sqrtf(5.0f);
 
-    Framebuffer framebuffer;
-    framebuffer.width  = width;
-    framebuffer.height = height;
+    emit_lathe(writer, segments, 1, true, false, [&](u32 j)
+    {
+        return LatheRow{ 0.5f * f32(j), 0.5f - f32(j), normal_radial, normal_height, f32(j) };
+    });
 
-    framebuffer.handle = bgfx::createFrameBuffer(
-        u8(attachments.size),
-        attachments.data,
-        false
-    );
+    emit_disc(writer, segments, -0.5f, false);
+}
 
-    ASSERT(bgfx::isValid(framebuffer.handle), "Framebuffer creation failed.");
+PrimitiveSize torus_size(u32 segments, u32 sides)
+{
+    return grid_size(segments, sides, false, false);
+}
 
+// Ring of radius 0.5 (to the tube center) lying in the XZ plane. The tube
+// profile starts at its outer equator.
+void generate_torus(PrimitiveWriter& writer, f32 thickness, u32 segments, u32 sides)
+{
+    emit_lathe(writer, segments, sides, false, false, [&](u32 j)
     {
-        MutexScope lock(cache.mutex);
+        const f32 v      = f32(j) / f32(sides);
+        const f32 angle  = HMM_PI32 * 2.0f * v;
+        const f32 radial =  cosf(angle);
+        const f32 height = -sinf(angle);
 
-        destroy(cache.framebuffers[id]);
+        return LatheRow{ 0.5f + thickness * radial, thickness * height, radial, height, v };
+    });
+}
 
-        cache.framebuffers[id] = framebuffer;
-    }
+PrimitiveSize capsule_size(u32 segments, u32 rings)
+{
+    return grid_size(segments, rings * 2 + 1, true, true);
 }
 
+// Two hemispheres of the given radius (with `rings` rows each), joined by
+// a cylinder, so that the total height is one.
+void generate_capsule(PrimitiveWriter& writer, f32 radius, u32 segments, u32 rings)
+{
+    const f32 offset = 0.5f - radius;
 
-// -----------------------------------------------------------------------------
-// PASS & PASS CACHE
-// -----------------------------------------------------------------------------
+    emit_lathe(writer, segments, rings * 2 + 1, true, true, [&](u32 j)
+    {
+        const bool bottom = j > rings;
+        const f32  angle  = HMM_PI32 * 0.5f * f32(j - bottom) / f32(rings);
+        const f32  radial = j == rings * 2 + 1 ? 0.0f : sinf(angle); // Exact pole.
+        const f32  height = cosf(angle);
 
-struct Pass
+        return LatheRow
+        {
+            radial * radius,
+            height * radius + (bottom ? -offset : offset),
+            radial,
+            height,
+            f32(j) / f32(rings * 2 + 1),
+        };
+    });
+}
+
+PrimitiveSize icosphere_size(u32 subdivisions)
 {
-    enum : u8
+    u32 faces = 20;
+
+    for (u32 i = 0; i < subdivisions; i++)
     {
-        DIRTY_NONE        = 0x00,
-        DIRTY_CLEAR       = 0x01,
-        DIRTY_TOUCH       = 0x02,
-        DIRTY_TRANSFORM   = 0x04,
-        DIRTY_RECT        = 0x08,
-        DIRTY_FRAMEBUFFER = 0x10,
-    };
+        faces *= 4;
+    }
 
-    Mat4                    view_matrix     = HMM_Mat4d(1.0f);
-    Mat4                    proj_matrix     = HMM_Mat4d(1.0f);
+    // Euler's formula, with each edge shared by two faces.
+    return { faces / 2 + 2, faces * 3 };
+}
 
-    u16                     viewport_x      = 0;
-    u16                     viewport_y      = 0;
-    u16                     viewport_width  = SIZE_EQUAL;
-    u16                     viewport_height = SIZE_EQUAL;
+// Icosahedron with each triangle recursively split into four, with the new
+// vertices pushed onto the sphere. Shared edge midpoints are looked up in a
+// small open addressing hash table. Texture coordinates use the spherical
+// mapping, so they're discontinuous along the seam.
+void generate_icosphere(PrimitiveWriter& writer, u32 subdivisions, Allocator* temp_allocator)
+{
+    ASSERT(temp_allocator, "Invalid temporary allocator pointer.");
 
-    bgfx::FrameBufferHandle framebuffer     = BGFX_INVALID_HANDLE;
+    const f32 t = 1.61803399f; // Golden ratio.
 
-    u16                     clear_flags     = BGFX_CLEAR_NONE;
-    f32                     clear_depth     = 1.0f;
-    u32                     clear_rgba      = 0x000000ff;
-    u8                      clear_stencil   = 0;
+    const Vec3 base_vertices[] =
+    {
+        HMM_Vec3(-1.0f,  t   ,  0.0f), HMM_Vec3( 1.0f,  t   ,  0.0f),
+        HMM_Vec3(-1.0f, -t   ,  0.0f), HMM_Vec3( 1.0f, -t   ,  0.0f),
+        HMM_Vec3( 0.0f, -1.0f,  t   ), HMM_Vec3( 0.0f,  1.0f,  t   ),
+        HMM_Vec3( 0.0f, -1.0f, -t   ), HMM_Vec3( 0.0f,  1.0f, -t   ),
+        HMM_Vec3( t   ,  0.0f, -1.0f), HMM_Vec3( t   ,  0.0f,  1.0f),
+        HMM_Vec3(-t   ,  0.0f, -1.0f), HMM_Vec3(-t   ,  0.0f,  1.0f),
+    };
 
-    u8                      dirty_flags     = DIRTY_CLEAR;
-};
+    static const u32 s_indices[] =
+    {
+         0, 11,  5,    0,  5,  1,    0,  1,  7,    0,  7, 10,    0, 10, 11,
+         1,  5,  9,    5, 11,  4,   11, 10,  2,   10,  7,  6,    7,  1,  8,
+         3,  9,  4,    3,  4,  2,    3,  2,  6,    3,  6,  8,    3,  8,  9,
+         4,  9,  5,    2,  4, 11,    6,  2, 10,    8,  6,  7,    9,  8,  1,
+    };
 
-struct PassCache
-{
-    FixedArray<Pass, MAX_PASSES> passes;
-    bool                         backbuffer_size_changed = true;
-};
+    const PrimitiveSize size = icosphere_size(subdivisions);
 
-void update_passes(PassCache& cache, bgfx::Encoder* encoder)
-{
-    for (bgfx::ViewId id = 0; id < cache.passes.size; id++)
+    // Edges of the last subdivided level, at most half of the table is used.
+    u32 table_size = 64;
+
+    while (table_size < size.index_count / 4)
     {
-        Pass& pass = cache.passes[id];
+        table_size *= 2;
+    }
 
-        if (pass.dirty_flags & Pass::DIRTY_TOUCH)
-        {
-            encoder->touch(id);
-        }
+    Vec3* vertices  = static_cast<Vec3*>(BX_ALLOC(temp_allocator, size.vertex_count * sizeof(Vec3)));
+    u32*  triangles = static_cast<u32* >(BX_ALLOC(temp_allocator, size.index_count  * sizeof(u32 ) * 2));
+    u64*  keys      = static_cast<u64* >(BX_ALLOC(temp_allocator, table_size        * sizeof(u64 )));
+    u32*  values    = static_cast<u32* >(BX_ALLOC(temp_allocator, table_size        * sizeof(u32 )));
 
-        if (pass.dirty_flags & Pass::DIRTY_CLEAR)
-        {
-            bgfx::setViewClear(
-                id, pass.clear_flags, pass.clear_rgba, pass.clear_depth, 
-                pass.clear_stencil
-            );
-        }
+    ASSERT(vertices && triangles && keys && values,
+        "Icosphere temporary memory allocation failed.");
 
-        if (pass.dirty_flags & Pass::DIRTY_TRANSFORM)
-        {
-            bgfx::setViewTransform(id, &pass.view_matrix, &pass.proj_matrix);
-        }
+    u32  vertex_count = BX_COUNTOF(base_vertices);
+    u32  index_count  = BX_COUNTOF(s_indices );
+    u32* current      = triangles;
+    u32* next         = triangles + size.index_count;
 
-        if ((pass.dirty_flags & Pass::DIRTY_RECT) ||
-            (cache.backbuffer_size_changed && pass.viewport_width >= SIZE_EQUAL)
-        )
+    for (u32 i = 0; i < vertex_count; i++)
+    {
+        vertices[i] = HMM_NormalizeVec3(base_vertices[i]);
+    }
+
+    bx::memCopy(current, s_indices, sizeof(s_indices));
+
+    const auto midpoint = [&](u32 a, u32 b)
+    {
+        const u64 key  = (u64(bx::min(a, b)) << 32) | bx::max(a, b);
+        u32       slot = u32((key * 0x9e3779b97f4a7c15ull) >> 32) & (table_size - 1);
+
+        while (keys[slot] != key)
         {
-            if (pass.viewport_width >= SIZE_EQUAL)
-            {
-                bgfx::setViewRect(
-                    id, pass.viewport_x, pass.viewport_y,
-                    bgfx::BackbufferRatio::Enum(pass.viewport_width - SIZE_EQUAL)
-                );
-            }
-            else
+            if (keys[slot] == U64_MAX)
             {
-                bgfx::setViewRect(
-                    id, pass.viewport_x, pass.viewport_y, pass.viewport_width,
-                    pass.viewport_height
-                );
+                keys  [slot] = key;
+                values[slot] = vertex_count;
+
+                vertices[vertex_count++] = HMM_NormalizeVec3(vertices[a] + vertices[b]);
+
+                break;
             }
+
+            slot = (slot + 1) & (table_size - 1);
         }
 
-        if ((pass.dirty_flags & Pass::DIRTY_FRAMEBUFFER) ||
-            cache.backbuffer_size_changed
-        )
+        return values[slot];
+    };
+
+    for (u32 level = 0; level < subdivisions; level++)
+    {
+        bx::memSet(keys, 0xff, table_size * sizeof(u64));
+
+        for (u32 i = 0; i < index_count; i += 3)
         {
-            // Having `BGFX_INVALID_HANDLE` here is OK.
-            bgfx::setViewFrameBuffer(id, pass.framebuffer);
+            const u32 a  = current[i    ];
+            const u32 b  = current[i + 1];
+            const u32 c  = current[i + 2];
+            const u32 ab = midpoint(a, b);
+            const u32 bc = midpoint(b, c);
+            const u32 ca = midpoint(c, a);
+
+            const u32 split[] =
+            {
+                a , ab, ca,
+                b , bc, ab,
+                c , ca, bc,
+                ab, bc, ca,
+            };
+
+            bx::memCopy(next + i * 4, split, sizeof(split));
         }
 
-        pass.dirty_flags = Pass::DIRTY_NONE;
+        bx::swap(current, next);
+        index_count *= 4;
     }
 
-    cache.backbuffer_size_changed = false;
-}
+    ASSERT(vertex_count == size.vertex_count && index_count == size.index_count,
+        "Icosphere subdivision count mismatch.");
 
+    const u32 first = writer.vertex_count;
 
-// -----------------------------------------------------------------------------
-// DRAW STATE & SUBMISSION
-// -----------------------------------------------------------------------------
+    for (u32 i = 0; i < vertex_count; i++)
+    {
+        const Vec3& n = vertices[i];
 
-static_assert(
-    BGFX_STATE_DEFAULT == (BGFX_STATE_WRITE_RGB       |
-                           BGFX_STATE_WRITE_A         |
-                           BGFX_STATE_WRITE_Z         |
-                           BGFX_STATE_DEPTH_TEST_LESS |
-                           BGFX_STATE_CULL_CW         |
-                           BGFX_STATE_MSAA            ) &&
+        emit_vertex(
+            writer,
+            n * 0.5f,
+            n,
+            0.5f - atan2f(n.Z, n.X) / (HMM_PI32 * 2.0f),
+            acosf(bx::clamp(n.Y, -1.0f, 1.0f)) / HMM_PI32
+        );
+    }
 
-    STATE_DEFAULT      == (STATE_WRITE_RGB            |
-                           STATE_WRITE_A              |
-                           STATE_WRITE_Z              |
-                           STATE_DEPTH_TEST_LESS      |
-                           STATE_CULL_CW              |
-                           STATE_MSAA                 ) ,
+    for (u32 i = 0; i < index_count; i += 3)
+    {
+        emit_triangle(writer, first + current[i], first + current[i + 1], first + current[i + 2]);
+    }
 
-    "BGFX and MiNiMo default draw states don't match."
-);
+    BX_FREE(temp_allocator, values);
+    BX_FREE(temp_allocator, keys);
+    BX_FREE(temp_allocator, triangles);
+    BX_FREE(temp_allocator, vertices);
+}
 
-struct DrawState
+// Creates the mesh with the primitive written by `generate`. Only static and
+// dynamic meshes with normals and texture coordinates are supported.
+template <typename Func>
+void add_primitive
+(
+    MeshCache&           cache,
+    ReleaseQueue&        release_queue,
+    VertexLayoutCache&   layouts,
+    u16                  id,
+    u32                  flags,
+    const Mat4&          transform,
+    const PrimitiveSize& size,
+    Func&&               generate
+)
 {
-    const InstanceData*      instances       = nullptr;
-    u32                      element_start   = 0;
-    u32                      element_count   = U32_MAX;
-    bgfx::ViewId             pass            = U16_MAX;
-    bgfx::FrameBufferHandle  framebuffer     = BGFX_INVALID_HANDLE;
-    bgfx::ProgramHandle      program         = BGFX_INVALID_HANDLE;
-    bgfx::TextureHandle      texture         = BGFX_INVALID_HANDLE;
-    bgfx::UniformHandle      sampler         = BGFX_INVALID_HANDLE;
-    u16                      texture_size[2] = {};
-    bgfx::VertexLayoutHandle vertex_alias    = BGFX_INVALID_HANDLE;
-    u16                      flags           = STATE_DEFAULT;
-};
+    constexpr u32 SUPPORTED_FLAGS = MESH_TYPE_MASK      |
+                                    VERTEX_NORMAL       |
+                                    VERTEX_TEXCOORD     |
+                                    TEXCOORD_F32        |
+                                    NO_VERTEX_TRANSFORM ;
 
-u64 translate_draw_state_flags(u16 flags)
-{
-    if (flags == STATE_DEFAULT)
+    ASSERT(!(flags & ~SUPPORTED_FLAGS),
+        "Unsupported procedural mesh flags %" PRIx32 ".",
+        flags & ~SUPPORTED_FLAGS
+    );
+
+    const u16 type = mesh_type(flags);
+
+    ASSERT(type == MESH_STATIC || type == MESH_DYNAMIC,
+        "Procedural meshes must be either static or dynamic."
+    );
+
+    if (type != MESH_STATIC && type != MESH_DYNAMIC)
     {
-        return BGFX_STATE_DEFAULT;
+        return;
     }
 
-    constexpr u32 BLEND_STATE_MASK       = STATE_BLEND_ADD | STATE_BLEND_ALPHA | STATE_BLEND_MAX | STATE_BLEND_MIN;
-    constexpr u32 BLEND_STATE_SHIFT      = 0;
+    PrimitiveWriter writer;
+    init(writer, flags, (flags & NO_VERTEX_TRANSFORM) ? HMM_Mat4d(1.0f) : transform);
 
-    constexpr u32 CULL_STATE_MASK        = STATE_CULL_CCW | STATE_CULL_CW;
-    constexpr u32 CULL_STATE_SHIFT       = 4;
+    writer.index32 = size.vertex_count > U16_MAX;
 
-    constexpr u32 DEPTH_TEST_STATE_MASK  = STATE_DEPTH_TEST_GEQUAL | STATE_DEPTH_TEST_GREATER | STATE_DEPTH_TEST_LEQUAL | STATE_DEPTH_TEST_LESS;
-    constexpr u32 DEPTH_TEST_STATE_SHIFT = 6;
+    const bgfx::Memory* positions = bgfx::alloc(size.vertex_count * sizeof(Vec3));
+    const bgfx::Memory* indices   = bgfx::alloc(size.index_count  * (writer.index32 ? sizeof(u32) : sizeof(u16)));
+    const bgfx::Memory* attribs   = writer.attrib_state.size
+        ? bgfx::alloc(size.vertex_count * writer.attrib_state.size)
+        : nullptr;
 
-    constexpr u64 blend_table[] =
-    {
-        0,
-        BGFX_STATE_BLEND_ADD,
-        BGFX_STATE_BLEND_ALPHA,
-        BGFX_STATE_BLEND_LIGHTEN,
-        BGFX_STATE_BLEND_DARKEN,
-    };
+    writer.positions = reinterpret_cast<Vec3*>(positions->data);
+    writer.attribs   = attribs ? attribs->data : nullptr;
+    writer.indices   = indices->data;
 
-    constexpr u64 cull_table[] =
-    {
-        0,
-        BGFX_STATE_CULL_CCW,
-        BGFX_STATE_CULL_CW,
-    };
+    generate(writer);
 
-    constexpr u64 depth_test_table[] =
-    {
-        0,
-        BGFX_STATE_DEPTH_TEST_GEQUAL,
-        BGFX_STATE_DEPTH_TEST_GREATER,
-        BGFX_STATE_DEPTH_TEST_LEQUAL,
-        BGFX_STATE_DEPTH_TEST_LESS,
-    };
+    ASSERT(
+        writer.vertex_count == size.vertex_count &&
+        writer.index_count  == size.index_count,
+        "Procedural mesh size mismatch, %" PRIu32 " / %" PRIu32 " vertices, "
+        "%" PRIu32 " / %" PRIu32 " indices.",
+        writer.vertex_count, size.vertex_count,
+        writer.index_count , size.index_count
+    );
 
-    // TODO : Remove the conditions from `STATE_MSAA` and onward.
-    return
-        blend_table     [(flags & BLEND_STATE_MASK     ) >> BLEND_STATE_SHIFT         ] |
-        cull_table      [(flags & CULL_STATE_MASK      ) >> CULL_STATE_SHIFT          ] |
-        depth_test_table[(flags & DEPTH_TEST_STATE_MASK) >> DEPTH_TEST_STATE_SHIFT    ] |
-        (                (flags & STATE_MSAA           ) ?  BGFX_STATE_MSAA        : 0) |
-        (                (flags & STATE_WRITE_A        ) ?  BGFX_STATE_WRITE_A     : 0) |
-        (                (flags & STATE_WRITE_RGB      ) ?  BGFX_STATE_WRITE_RGB   : 0) |
-        (                (flags & STATE_WRITE_Z        ) ?  BGFX_STATE_WRITE_Z     : 0) ;
-}
+    const bgfx::VertexLayout& position_layout = vertex_layout(layouts, VERTEX_POSITION);
+    const bgfx::VertexLayout& attrib_layout   = vertex_layout(layouts, flags);
+    const u16                 index_flags     = writer.index32 ? BGFX_BUFFER_INDEX32 : BGFX_BUFFER_NONE;
 
-void submit_mesh
-(
-    const Mesh&                              mesh,
-    const Mat4&                              transform,
-    const DrawState&                         state,
-    const Span<bgfx::TransientVertexBuffer>& transient_buffers,
-    const DefaultUniforms&                   default_uniforms,
-    bgfx::Encoder&                           encoder
-)
-{
-    const u16  type        = mesh_type(mesh.flags);
-    const bool has_attribs = mesh.flags & VERTEX_ATTRIB_MASK;
+    Mesh mesh;
 
-    if (type == MESH_STATIC)
-    {
-                         encoder.setVertexBuffer(0, mesh.positions.static_buffer);
-        if (has_attribs) encoder.setVertexBuffer(1, mesh.attribs  .static_buffer, 0, U32_MAX, state.vertex_alias);
-                         encoder.setIndexBuffer (   mesh.indices  .static_buffer, state.element_start, state.element_count);
-    }
-    else if (type == MESH_TRANSIENT)
-    {
-                         encoder.setVertexBuffer(0, &transient_buffers[mesh.positions.transient_index], state.element_start, state.element_count);
-        if (has_attribs) encoder.setVertexBuffer(1, &transient_buffers[mesh.attribs  .transient_index], state.element_start, state.element_count, state.vertex_alias);
-    }
-    else if (type == MESH_DYNAMIC)
-    {
-                         encoder.setVertexBuffer(0, mesh.positions.static_buffer);
-        if (has_attribs) encoder.setVertexBuffer(1, mesh.attribs  .static_buffer, 0, U32_MAX, state.vertex_alias);
-                         encoder.setIndexBuffer (   mesh.indices  .static_buffer, state.element_start, state.element_count);
-    }
+    mesh.element_count = size.index_count;
+    mesh.flags         = flags;
+    mesh.bounds_min    = writer.bounds_min;
+    mesh.bounds_max    = writer.bounds_max;
 
-    if (bgfx::isValid(state.texture) && bgfx::isValid(state.sampler))
-    {
-        encoder.setTexture(0, state.sampler, state.texture);
-    }
+    const Vec3 center = (mesh.bounds_min + mesh.bounds_max) * 0.5f;
 
-    if (mesh.flags & VERTEX_PIXCOORD)
-    {
-        const f32 data[] =
-        {
-            f32(state.texture_size[0]),
-            f32(state.texture_size[1]),
-            f32(state.texture_size[0]) ? 1.0f / f32(state.texture_size[0]) : 0.0f,
-            f32(state.texture_size[1]) ? 1.0f / f32(state.texture_size[1]) : 0.0f
-        };
+    f32 radius_squared = 0.0f;
 
-        encoder.setUniform(default_uniforms[u32(DefaultUniform::TEXTURE_SIZE)], data);
+    for (u32 i = 0; i < writer.vertex_count; i++)
+    {
+        radius_squared = bx::max(radius_squared, HMM_LengthSquaredVec3(writer.positions[i] - center));
     }
 
-    encoder.setTransform(&transform);
+    mesh.bounds_radius = sqrtf(radius_squared);
 
-    u64 flags = translate_draw_state_flags(state.flags);
-
-    constexpr u64 primitive_flags[] =
+    if (type == MESH_STATIC)
     {
-        0, // Triangles.
-        0, // Quads (for users, triangles internally).
-        BGFX_STATE_PT_TRISTRIP,
-        BGFX_STATE_PT_LINES,
-        BGFX_STATE_PT_LINESTRIP,
-        BGFX_STATE_PT_POINTS,
-    };
+        mesh.positions.static_buffer = bgfx::createVertexBuffer(positions, position_layout);
+        mesh.indices  .static_buffer = bgfx::createIndexBuffer (indices  , index_flags    );
 
-    flags |= primitive_flags[(mesh.flags & PRIMITIVE_TYPE_MASK) >> PRIMITIVE_TYPE_SHIFT];
+        if (attribs)
+        {
+            mesh.attribs.static_buffer = bgfx::createVertexBuffer(attribs, attrib_layout);
+        }
+    }
+    else
+    {
+        mesh.positions.dynamic_buffer = bgfx::createDynamicVertexBuffer(positions, position_layout);
+        mesh.indices  .dynamic_buffer = bgfx::createDynamicIndexBuffer (indices  , index_flags    );
 
-    encoder.setState(flags);
+        if (attribs)
+        {
+            mesh.attribs.dynamic_buffer = bgfx::createDynamicVertexBuffer(attribs, attrib_layout);
+        }
+    }
 
-    ASSERT(bgfx::isValid(state.program), "Invalid draw state program.");
-    encoder.submit(state.pass, state.program);
+    replace_mesh(cache, release_queue, id, mesh, {});
 }
 
 
 // -----------------------------------------------------------------------------
-// CODEPOINT MAP
+// TEXTURE & TEXTURE CACHING
 // -----------------------------------------------------------------------------
 
-struct CodepointMap
-{
-    struct Map
-    {
-        u32 codepoint;
-        u16 offset;
-    };
+using BgfxTextureFormat   = BgfxReducedEnum<bgfx::TextureFormat  , u8>;
+using BgfxBackbufferRatio = BgfxReducedEnum<bgfx::BackbufferRatio, u8>;
 
-    u32                  low_offset; // TODO : Expose use of this to the user.
-    FixedArray<u16, 512> low;
-    DynamicArray<Map>    high;
+struct Texture
+{
+    bgfx::TextureHandle handle      = BGFX_INVALID_HANDLE;
+    u16                 width       = 0; // Can also be one of `SIZE_*` values.
+    u16                 height      = 0;
+    u16                 flags       = TEXTURE_DEFAULT;
+    u8                  mip_count   = 1;
+    BgfxTextureFormat   format      = { bgfx::TextureFormat  ::Count };
+    BgfxBackbufferRatio ratio       = { bgfx::BackbufferRatio::Count };
+    u32                 read_frame  = U32_MAX;
+    bgfx::TextureHandle blit_handle = BGFX_INVALID_HANDLE;
 };
 
-void clear(CodepointMap& map)
+// Resolves `SIZE_*` backbuffer ratios the same way BGFX sizes the textures.
+u16 backbuffer_relative_size(u16 size, u16 backbuffer_size)
 {
-    map.low_offset = 0; // TODO : Set to 32 (ASCII space)?
+    if (size < SIZE_EQUAL)
+    {
+        return size;
+    }
 
-    for (u32 i = 0; i < map.low.size; i++)
+    if (size == SIZE_DOUBLE)
     {
-        map.low[i] = U16_MAX;
+        return u16(bx::min(u32(backbuffer_size) * 2, u32(SIZE_EQUAL - 1)));
     }
 
-    clear(map.high);
+    return bx::max<u16>(1, backbuffer_size >> (size - SIZE_EQUAL));
 }
 
-void init(CodepointMap& map, Allocator* allocator)
+struct TextureCache
 {
-    init(map.high, allocator);
+    Mutex                mutex;
+    HandleTable<Texture> textures;
+};
 
-    clear(map);
+void destroy(Texture& texture)
+{
+    ASSERT(bgfx::isValid(texture.blit_handle) <= bgfx::isValid(texture.handle),
+        "Blit handle %" PRIu16 " valid, but the main one is not.",
+        texture.blit_handle
+    );
+
+    destroy_if_valid(texture.handle);
+    destroy_if_valid(texture.blit_handle);
+
+    texture = {};
 }
 
-void deinit(CodepointMap& map)
+void release(ReleaseQueue& queue, Texture& texture)
 {
-    deinit(map.high);
+    release(queue, ReleaseType::TEXTURE, texture.handle.idx);
+    release(queue, ReleaseType::TEXTURE, texture.blit_handle.idx);
+
+    texture = {};
 }
 
-u16 offset(const CodepointMap& map, u32 codepoint)
+void init(TextureCache& cache, Allocator* allocator, u32 texture_count)
 {
-    if (codepoint >= map.low_offset &&
-        codepoint <  map.low_offset + map.low.size)
-    {
-        return map.low[codepoint - map.low_offset];
-    }
+    init(cache.textures, allocator, texture_count);
+}
 
-    for (u32 i = 0; i < map.high.size; i++)
+void deinit(TextureCache& cache)
+{
+    for (u32 i = 0; i < cache.textures.size; i++)
     {
-        if (map.high[i].codepoint == codepoint)
-        {
-            return map.high[i].offset;
-        }
+        destroy(cache.textures[i]);
     }
 
-    return U16_MAX;
+    deinit(cache.textures);
 }
 
-bool contains(const CodepointMap& map, u32 codepoint)
+struct TextureFormatInfo
 {
-    return offset(map, codepoint) != U16_MAX;
+    u32                       size; // Bytes per pixel, zero for depth formats.
+    bgfx::TextureFormat::Enum type;
+};
+
+const TextureFormatInfo& texture_format(u16 flags)
+{
+    static const TextureFormatInfo s_formats[] =
+    {
+        { 4, bgfx::TextureFormat::RGBA8 },
+        { 1, bgfx::TextureFormat::R8    },
+        { 0, bgfx::TextureFormat::D24S8 },
+        { 0, bgfx::TextureFormat::D32F  },
+    };
+
+    return s_formats[(flags & TEXTURE_FORMAT_MASK) >> TEXTURE_FORMAT_SHIFT];
 }
 
-void insert(CodepointMap& map, u32 codepoint, u16 offset)
+// Texture and sampler flags, other than the format. `TEXTURE_READ_BACK` has no
+// BGFX counterpart, as the textures are read back via a separate blit copy.
+u64 translate_texture_flags(u16 flags)
 {
-    ASSERT(
-        !contains(map, codepoint),
-        "Codepoint %" PRIu32 " already inserted.",
-        codepoint
-    );
+    constexpr u64 sampling_flags[] =
+    {
+        BGFX_SAMPLER_NONE,
+        BGFX_SAMPLER_POINT,
+    };
 
-    if (codepoint >= map.low_offset &&
-        codepoint <  map.low_offset + map.low.size)
+    constexpr u64 border_flags[] =
     {
-        map.low[codepoint - map.low_offset] = offset;
-    }
-    else
+        BGFX_SAMPLER_NONE,
+        BGFX_SAMPLER_UVW_MIRROR,
+        BGFX_SAMPLER_UVW_CLAMP,
+    };
+
+    constexpr u64 target_flags[] =
     {
-        append(map.high, { codepoint, offset });
-    }
-}
+        BGFX_TEXTURE_NONE,
+        BGFX_TEXTURE_RT,
+    };
 
+    u64 target = target_flags[(flags & TEXTURE_TARGET_MASK) >> TEXTURE_TARGET_SHIFT];
 
-// -----------------------------------------------------------------------------
-// FONT ATLAS
-// -----------------------------------------------------------------------------
+    if ((flags & TEXTURE_TARGET) && (flags & TEXTURE_WRITE_ONLY))
+    {
+        target = BGFX_TEXTURE_RT_WRITE_ONLY;
+    }
 
-struct FontAtlas
+    return
+        sampling_flags[(flags & TEXTURE_SAMPLING_MASK) >> TEXTURE_SAMPLING_SHIFT] |
+        border_flags  [(flags & TEXTURE_BORDER_MASK  ) >> TEXTURE_BORDER_SHIFT  ] |
+        target                                                                    |
+        ((flags & TEXTURE_BLIT_DST) ? BGFX_TEXTURE_BLIT_DST : BGFX_TEXTURE_NONE);
+}
+
+void add_texture
+(
+    TextureCache& cache,
+    ReleaseQueue& release_queue,
+    u16           id,
+    u16           flags,
+    u16           width,
+    u16           height,
+    u16           stride,
+    const void*   data,
+    Allocator*    temp_allocator
+)
 {
-    Mutex mutex;
+    ASSERT(temp_allocator, "Invalid temporary allocator pointer.");
 
-    stbtt_fontinfo                 font_info     = {};
-    f32                            font_size     = 0.0f; // Cap height, in pixels.
+    const TextureFormatInfo& format = texture_format(flags);
 
-    DynamicArray<u32>              requests;
+    bgfx::BackbufferRatio::Enum ratio = bgfx::BackbufferRatio::Count;
 
-    // Packing.
-    stbrp_context                  pack_ctx      = {};
-    DynamicArray<stbrp_rect>       pack_rects;
-    DynamicArray<stbrp_node>       pack_nodes;
+    if (width >= SIZE_EQUAL && width <= SIZE_DOUBLE && width == height)
+    {
+        ratio = bgfx::BackbufferRatio::Enum(width - SIZE_EQUAL);
+    }
 
-    // Packed data.
-    DynamicArray<stbtt_packedchar> char_quads;
-    CodepointMap                   codepoints;
+    const bgfx::Memory* memory = nullptr;
 
-    // Bitmap.
-    DynamicArray<u8>               bitmap_data;
-    u16                            bitmap_width  = 0;
-    u16                            bitmap_height = 0;
+    if (data && format.size > 0 && ratio == bgfx::BackbufferRatio::Count)
+    {
+        memory = alloc_bgfx_memory(temp_allocator, width * height * format.size);
+        ASSERT(memory && memory->data, "Invalid BGFX-created memory.");
 
-    u16                            texture       = U16_MAX;
-    u16                            flags         = ATLAS_FREE;
-    u8                             padding       = 1;
-    bool                           locked        = false;
-};
+        if (stride == 0 || stride == width * format.size)
+        {
+            bx::memCopy(memory->data, data, memory->size);
+        }
+        else
+        {
+            const u8* src = static_cast<const u8*>(data);
+            u8*       dst = memory->data;
 
-void init(FontAtlas& atlas, Allocator* allocator)
-{
-    init(atlas.requests   , allocator);
-    init(atlas.pack_rects , allocator);
-    init(atlas.pack_nodes , allocator);
-    init(atlas.char_quads , allocator);
-    init(atlas.codepoints , allocator);
-    init(atlas.bitmap_data, allocator);
+            for (u16 y = 0; y < height; y++)
+            {
+                bx::memCopy(dst, src, width * format.size);
+
+                src += stride;
+                dst += width * format.size;
+            }
+        }
+    }
+
+    const u64 texture_flags = translate_texture_flags(flags);
+
+    Texture texture;
+
+    if (ratio == bgfx::BackbufferRatio::Count)
+    {
+        texture.handle = bgfx::createTexture2D(
+            width, height, false, 1, format.type, texture_flags, memory
+        );
+    }
+    else
+    {
+        WARN(!memory, "Content of texture %" PRIu16 " ignored.", id);
+
+        texture.handle = bgfx::createTexture2D(
+            ratio, false, 1, format.type, texture_flags
+        );
+    }
+
+    ASSERT(
+        bgfx::isValid(texture.handle),
+        "Creation of texture %" PRIu16 " failed.", id
+    );
+
+    texture.format = format.type;
+    texture.ratio  = ratio;
+    texture.width  = width;
+    texture.height = height;
+    texture.flags  = flags;
+
+    {
+        MutexScope lock(cache.mutex);
+
+        release(release_queue, cache.textures[id]);
+
+        cache.textures[id] = texture;
+
+        next_generation(cache.textures, id);
+    }
 }
 
-void deinit(FontAtlas& atlas)
+void remove_texture(TextureCache& cache, ReleaseQueue& release_queue, u16 id)
 {
-    deinit(atlas.requests   );
-    deinit(atlas.pack_rects );
-    deinit(atlas.pack_nodes );
-    deinit(atlas.char_quads );
-    deinit(atlas.codepoints );
-    deinit(atlas.bitmap_data);
+    MutexScope lock(cache.mutex);
+
+    release(release_queue, cache.textures[id]);
+
+    next_generation(cache.textures, id);
 }
 
-void reset
+void schedule_texture_read
 (
-    FontAtlas&    atlas,
-    TextureCache& textures,
-    u16           texture,
-    u16           flags,
-    const void*   font,
-    f32           size
+    TextureCache&  cache,
+    u16            id,
+    bgfx::ViewId   pass,
+    bgfx::Encoder* encoder,
+    void*          output_data
 )
 {
-    MutexScope lock(atlas.mutex);
+    MutexScope lock(cache.mutex);
 
-    if (atlas.texture != U16_MAX)
-    {
-        remove_texture(textures, atlas.texture);
-    }
+    Texture& texture = cache.textures[id];
+    ASSERT(
+        bgfx::isValid(texture.handle),
+        "Invalid BGFX handle of texture %" PRIu16 " .", id
+    );
 
-    clear(atlas.requests   );
-    clear(atlas.pack_rects );
-    clear(atlas.pack_nodes );
-    clear(atlas.codepoints );
-    clear(atlas.bitmap_data);
+    if (!bgfx::isValid(texture.blit_handle))
+    {
+        constexpr u64 flags =
+            BGFX_TEXTURE_BLIT_DST  |
+            BGFX_TEXTURE_READ_BACK |
+            BGFX_SAMPLER_MIN_POINT |
+            BGFX_SAMPLER_MAG_POINT |
+            BGFX_SAMPLER_MIP_POINT |
+            BGFX_SAMPLER_U_CLAMP   |
+            BGFX_SAMPLER_V_CLAMP   ;
 
-    atlas.font_info     = {};
-    atlas.pack_ctx      = {};
-    atlas.bitmap_width  = 0;
-    atlas.bitmap_height = 0;
-    atlas.padding       = 1; // TODO : Padding should probably reflect whether an SDF atlas is required.
-    atlas.locked        = false;
-    atlas.font_size     = size;
-    atlas.texture       = texture;
-    atlas.flags         = flags;
+        texture.blit_handle = texture.ratio == bgfx::BackbufferRatio::Count
+            ? texture.blit_handle = bgfx::createTexture2D(
+                texture.width, texture.height, false, 1, texture.format, flags
+            )
+            : texture.blit_handle = bgfx::createTexture2D(
+                texture.ratio, false, 1, texture.format, flags
+            );
 
-    // TODO : Check return value.
-    (void)stbtt_InitFont(&atlas.font_info, static_cast<const u8*>(font), 0);
+        ASSERT(
+            bgfx::isValid(texture.blit_handle),
+            "Creating blitting texture failed for texture %" PRIu16 " .", id
+        );
+    }
 
-    const int table = stbtt__find_table(
-        atlas.font_info.data,
-        atlas.font_info.fontstart,
-        "OS/2"
-    );
+    encoder->blit(pass, texture.blit_handle, 0, 0, texture.handle);
 
-    if (table)
-    {
-        if (ttUSHORT(atlas.font_info.data + table     ) >= 1 && // Version.
-            ttBYTE  (atlas.font_info.data + table + 32) == 2 && // PANOSE / Kind == `Latin Text`.
-            ttBYTE  (atlas.font_info.data + table + 35) == 9)   // PANOSE / bProportion == "Monospaced"
-        {
-            atlas.flags |= ATLAS_MONOSPACED;
-        }
-    }
+    texture.read_frame = bgfx::readTexture(texture.blit_handle, output_data);
 }
 
-bool is_updatable(const FontAtlas& atlas)
+struct TextureCopy
 {
-    return atlas.flags & ATLAS_ALLOW_UPDATE;
-}
+    u16 dst_x;
+    u16 dst_y;
+    u16 src_x;
+    u16 src_y;
+    u16 width;
+    u16 height;
+    u8  dst_mip;
+    u8  src_mip;
+};
 
-void add_glyph_range(FontAtlas& atlas, u32 first, u32 last)
+// Checks the copy against the limits of the GPU blit (`SIZE_*` textures are
+// resolved with the given backbuffer size).
+bool is_valid_copy
+(
+    const Texture&     dst,
+    const Texture&     src,
+    const TextureCopy& copy,
+    u16                backbuffer_width,
+    u16                backbuffer_height
+)
 {
-    if (!is_updatable(atlas) && atlas.locked)
+    if (!bgfx::isValid(dst.handle) || !bgfx::isValid(src.handle))
     {
-        ASSERT(false, "Atlas is not updatable.");
-        return;
+        WARN(false, "Copy between non-existent textures.");
+        return false;
     }
 
-    if (first > last)
+    if (!(dst.flags & TEXTURE_BLIT_DST))
     {
-        bx::swap(first, last);
+        WARN(false, "Copy destination not created with `TEXTURE_BLIT_DST`.");
+        return false;
     }
 
-    reserve(atlas.requests, atlas.requests.size + last - first + 1u);
+    if (dst.format.value != src.format.value)
+    {
+        WARN(false, "Copy between textures of different formats.");
+        return false;
+    }
 
-    for (u32 codepoint = first; codepoint <= last; codepoint++)
+    if (copy.dst_mip >= dst.mip_count || copy.src_mip >= src.mip_count)
     {
-        if (!contains(atlas.codepoints, codepoint))
-        {
-            append(atlas.requests, codepoint);
-        }
+        WARN(false, "Copy mip level out of range.");
+        return false;
     }
-}
 
-void add_glyphs_from_string(FontAtlas& atlas, const char* start, const char* end)
-{
-    if (!is_updatable(atlas) && atlas.locked)
+    if (dst.handle.idx == src.handle.idx && copy.dst_mip == copy.src_mip)
     {
-        ASSERT(false, "Atlas is not updatable.");
-        return;
+        WARN(false, "Copy within the same mip level of a single texture.");
+        return false;
     }
 
-    u32 codepoint;
-    u32 state = 0;
+    const u16 dst_width  = bx::max<u16>(1, backbuffer_relative_size(dst.width , backbuffer_width ) >> copy.dst_mip);
+    const u16 dst_height = bx::max<u16>(1, backbuffer_relative_size(dst.height, backbuffer_height) >> copy.dst_mip);
+    const u16 src_width  = bx::max<u16>(1, backbuffer_relative_size(src.width , backbuffer_width ) >> copy.src_mip);
+    const u16 src_height = bx::max<u16>(1, backbuffer_relative_size(src.height, backbuffer_height) >> copy.src_mip);
 
-    for (const char* string = start; end ? string < end : *string; string++)
+    if (!copy.width || !copy.height                  ||
+        u32(copy.dst_x) + copy.width  > dst_width    ||
+        u32(copy.dst_y) + copy.height > dst_height   ||
+        u32(copy.src_x) + copy.width  > src_width    ||
+        u32(copy.src_y) + copy.height > src_height)
     {
-        if (UTF8_ACCEPT == utf8_decode(state, *reinterpret_cast<const u8*>(string), codepoint))
-        {
-            if (!contains(atlas.codepoints, codepoint))
-            {
-                append(atlas.requests, codepoint);
-            }
-        }
+        WARN(false, "Copy rectangle out of the textures' bounds.");
+        return false;
     }
 
-    ASSERT(state == UTF8_ACCEPT, "Ill-formated UTF-8 string.");
+    // NOTE : Some backends (e.g., Direct3D 11) can only copy whole depth
+    //        textures.
+    if (bgfx::TextureFormat::Enum(src.format.value) > bgfx::TextureFormat::UnknownDepth &&
+        (copy.dst_x || copy.dst_y || copy.src_x || copy.src_y ||
+         copy.width  != src_width  || copy.width  != dst_width ||
+         copy.height != src_height || copy.height != dst_height))
+    {
+        WARN(false, "Depth textures can only be copied whole.");
+        return false;
+    }
+
+    return true;
 }
 
-void check_stbrp_context_validity
+bool schedule_texture_copy
 (
-    const stbrp_context&            ctx,
-    const DynamicArray<stbrp_node>& nodes
+    TextureCache&      cache,
+    u16                dst,
+    u16                src,
+    const TextureCopy& copy,
+    u16                backbuffer_width,
+    u16                backbuffer_height,
+    bgfx::ViewId       pass,
+    bgfx::Encoder*     encoder
 )
 {
-#ifndef NDEBUG
-    const auto check_node =[&](const stbrp_node* node)
+    MutexScope lock(cache.mutex);
+
+    const Texture& dst_texture = cache.textures[dst];
+    const Texture& src_texture = cache.textures[src];
+
+    if (!is_valid_copy(dst_texture, src_texture, copy, backbuffer_width, backbuffer_height))
     {
-        const bool is_in_range = node >= nodes.data && node < nodes.data + nodes.size;
-        const bool is_extra    = node == &ctx.extra[0] || node == &ctx.extra[1];
-        const bool is_null     = node == nullptr;
+        return false;
+    }
 
-        ASSERT(
-            is_in_range || is_extra || is_null,
-            "Invalid stbrp node state."
-        );
-    };
+    encoder->blit(
+        pass,
+        dst_texture.handle, copy.dst_mip, copy.dst_x, copy.dst_y, 0,
+        src_texture.handle, copy.src_mip, copy.src_x, copy.src_y, 0,
+        copy.width, copy.height, 1
+    );
 
-    const auto count_nodes = [](const stbrp_node* node, bool check_zero)
-    {
-        int count = 0;
+    return true;
+}
 
-        while (node)
-        {
-            ASSERT(
-                !check_zero || (node->x == 0 && node->y == 0),
-                "Non-zero stbrp node position."
-            );
 
-            node = node->next;
-            count++;
-        }
+// -----------------------------------------------------------------------------
+// INSTANCE RECORDING
+// -----------------------------------------------------------------------------
 
-        return count;
-    };
+struct InstanceRecorder
+{
+    DynamicArray<u8> buffer;
+    u16              instance_size = 0;
+};
 
-    const int active_nodes_count = count_nodes(ctx.active_head, false);
-    const int free_nodes_count   = count_nodes(ctx.free_head  , true );
+void init(InstanceRecorder& recorder, Allocator* allocator)
+{
+    recorder = {};
 
-    ASSERT(
-        2 + ctx.num_nodes == active_nodes_count + free_nodes_count,
-        "Unexpected stbrp node count."
-    );
+    init(recorder.buffer, allocator);
+}
 
-    check_node(ctx.active_head);
-    check_node(ctx.active_head->next);
+void deinit(InstanceRecorder& recorder)
+{
+    deinit(recorder.buffer);
+}
 
-    check_node(ctx.free_head);
-    check_node(ctx.free_head->next);
+void start(InstanceRecorder& recorder, u32 type)
+{
+    constexpr u32 type_sizes[] =
+    {
+        sizeof(Mat4), // INSTANCE_TRANSFORM
+        16,           // INSTANCE_DATA_16
+        32,           // INSTANCE_DATA_32
+        48,           // INSTANCE_DATA_48
+        64,           // INSTANCE_DATA_64
+        80,           // INSTANCE_DATA_80
+        96,           // INSTANCE_DATA_96
+        112,          // INSTANCE_DATA_112
+    };
 
-    check_node(ctx.extra[0].next);
-    check_node(ctx.extra[1].next);
+    reserve(recorder.buffer, bx::min(4_MB, 2048u * recorder.instance_size));
 
-    for (u32 i = 0; i < nodes.size; i++)
-    {
-        check_node(nodes[i].next);
-    }
-#endif // NDEBUG
+    recorder.instance_size = type_sizes[bx::max<u32>(type, BX_COUNTOF(type_sizes) - 1)];
 }
 
-void patch_stbrp_context
-(
-    u32                       width,
-    u32                       height,
-    u32                       padding,
-    stbrp_context&            inout_ctx,
-    DynamicArray<stbrp_node>& inout_nodes
-)
+void end(InstanceRecorder& recorder)
 {
-    check_stbrp_context_validity(inout_ctx, inout_nodes);
+    clear(recorder.buffer);
 
-    // When changing only height, number of nodes or the sentinel node don't
-    // change.
-    if (width - padding == u32(inout_ctx.width))
-    {
-        inout_ctx.height = int(height - padding);
+    recorder.instance_size = 0;
+}
 
-        return;
-    }
+void append(InstanceRecorder& recorder, const void* instance_data)
+{
+    ASSERT(instance_data, "Invalid `instance_data` pointer.");
 
-    DynamicArray<stbrp_node> nodes;
-    init(nodes, inout_nodes.allocator);
-    defer(deinit(nodes));
+    append(recorder.buffer, instance_data, recorder.instance_size);
+}
 
-    resize(nodes, width - padding);
+u32 instance_count(const InstanceRecorder& recorder)
+{
+    return recorder.buffer.size / recorder.instance_size;
+}
 
-    const auto find_node = [&](stbrp_node* node)
-    {
-        // Node can either point to one of the given array members, the two
-        // `extra` nodes allocated within the `stbrp_context` structure, or
-        // be `NULL`.
-        const uintptr_t offset = node - inout_nodes.data; // Fine even if `nullptr`.
 
-        // We're intentionally not adjusting the nodes that point to one of
-        // the context's `extra` nodes, so that we don't have to repeatedly
-        // patch them when the context would be swapped.
-        return offset < inout_nodes.size ? &nodes[offset] : node;
-    };
+// -----------------------------------------------------------------------------
+// INSTANCE & INSTANCE CACHE
+// -----------------------------------------------------------------------------
 
-    stbrp_context ctx = {};
+struct InstanceData
+{
+    bgfx::InstanceDataBuffer buffer       = { nullptr, 0, 0, 0, 0, BGFX_INVALID_HANDLE };
+    bool                     is_transform = false;
+};
 
-    stbrp_init_target(
-        &ctx,
-        int(width  - padding),
-        int(height - padding),
-        nodes.data,
-        int(nodes.size)
-    );
+struct InstanceCache
+{
+    Mutex                     mutex;
+    HandleTable<InstanceData> data;
+};
 
-    ctx.active_head   = find_node(inout_ctx.active_head  );
-    ctx.free_head     = find_node(inout_ctx.free_head    );
-    ctx.extra[0].next = find_node(inout_ctx.extra[0].next);
-    ctx.extra[0].x    =           inout_ctx.extra[0].x    ;
-    ctx.extra[0].y    =           inout_ctx.extra[0].y    ;
-    // NOTE : Node `extra[1]` is a sentinel, so no need to patch it.
+void init(InstanceCache& cache, Allocator* allocator, u32 buffer_count)
+{
+    init(cache.data, allocator, buffer_count);
+}
 
-    // TODO : It's possible that some special handling will be necessary if
-    //        the old context ran out of free nodes, but we're increasing
-    //        width. So do some special logic here (will need artifical test
-    //        as it's quite unlikely, I think).
-    ASSERT(
-        inout_ctx.free_head,
-        "stbrp context out of free nodes; handling not implemented."
+void deinit(InstanceCache& cache)
+{
+    deinit(cache.data);
+}
+
+void add_instances
+(
+    InstanceCache&          cache,
+    const InstanceRecorder& recorder,
+    u16                     id,
+    bool                    is_transform
+)
+{
+    ASSERT(id < cache.data.size,
+        "Instance buffer id %" PRIu16 " out of bounds (%" PRIu32").",
+        id, cache.data.size
     );
 
-    for (size_t i = 0; i < inout_nodes.size - 1; i++)
+    const u32 count  = instance_count(recorder);
+    const u16 stride = recorder.instance_size;
+
+    // NOTE : Mutexing since it seems that both `getAvailInstanceDataBuffer`
+    //        and `allocInstanceDataBuffer` aren't thread safe.
+    MutexScope lock(cache.mutex);
+
+    if (bgfx::getAvailInstanceDataBuffer(count, stride) < count)
     {
-        nodes[i].x    =           inout_nodes[i].x;
-        nodes[i].y    =           inout_nodes[i].y;
-        nodes[i].next = find_node(inout_nodes[i].next);
+        WARN(true, "Instance buffer memory exhausted.");
+        return;
     }
 
-    inout_ctx = ctx; // We can do this safely as no nodes point to `ctx.extra`.
-    bx::swap(inout_nodes, nodes);
+    InstanceData &instance_data = cache.data[id];
 
-    check_stbrp_context_validity(inout_ctx, inout_nodes);
-}
+    instance_data.is_transform = is_transform;
 
-bool pick_next_size(u32 min_area, u32 padding, u32* inout_size)
-{
-    const u32 max_size = bgfx::getCaps()->limits.maxTextureSize;
-    u32       size[2]  = { 64, 64 };
+    bgfx::allocInstanceDataBuffer(&instance_data.buffer, count, stride);
+    bx::memCopy(instance_data.buffer.data, recorder.buffer.data,
+        recorder.buffer.size
+    );
 
-    for (bool i = false;; i = !i)
-    {
-        if (size[0] > inout_size[0] || size[1] > inout_size[1])
-        {
-            const u32 area = (size[0] - padding) * (size[1] - padding);
+    next_generation(cache.data, id);
+}
 
-            if (area >= min_area * 1.075f) // 7.5 % extra space, as the packing won't be perfect.
-            {
-                break;
-            }
-        }
+// -----------------------------------------------------------------------------
+// UNIFORMS & UNIFORMS CACHING
+// -----------------------------------------------------------------------------
 
-        if (size[0] == max_size && size[1] == max_size)
-        {
-            TRACE("Maximum atlas size (%" PRIu32"^2) reached.", max_size);
-            return false;
-        }
+enum struct DefaultUniform : u32
+{
+    COLOR_TEXTURE_RED,
+    COLOR_TEXTURE_RGBA,
+    TEXTURE_SIZE,
+};
 
-        size[i] *= 2;
-    }
+struct DefaultUniformInfo
+{
+    const char*             name;
+    bgfx::UniformType::Enum type;
+    DefaultUniform          index;
+};
 
-    inout_size[0] = size[0];
-    inout_size[1] = size[1];
+const DefaultUniformInfo s_default_uniforms[] =
+{
+    { "s_tex_color_r"     , bgfx::UniformType::Sampler, DefaultUniform::COLOR_TEXTURE_RED  },
+    { "color_texture_rgba", bgfx::UniformType::Sampler, DefaultUniform::COLOR_TEXTURE_RGBA },
+    { "u_tex_size"        , bgfx::UniformType::Vec4   , DefaultUniform::TEXTURE_SIZE       },
+};
 
-    return true;
-}
+using DefaultUniforms = FixedArray<bgfx::UniformHandle, BX_COUNTOF(s_default_uniforms)>;
 
-void pack_rects(FontAtlas& atlas, u32 offset, u32 count, u32* inout_pack_size)
+struct UniformCache
 {
-    constexpr f32 extra_area = 1.05f;
+    Mutex                            mutex;
+    HandleTable<bgfx::UniformHandle> handles;
+};
 
-    u32 min_area = 0;
+void init(UniformCache& cache, Allocator* allocator, u32 uniform_count)
+{
+    init(cache.handles, allocator, uniform_count, BGFX_INVALID_HANDLE);
+}
 
-    for (u32 i = 0; i < atlas.pack_rects.size; i++)
+void deinit(UniformCache& cache)
+{
+    for (u32 i = 0; i < cache.handles.size; i++)
     {
-        min_area += u32(atlas.pack_rects[i].w * atlas.pack_rects[i].h);
+        destroy_if_valid(cache.handles[i]);
     }
 
-    min_area = u32(f32(min_area) * extra_area);
+    deinit(cache.handles);
+}
 
-    for (;;)
-    {
-        if (inout_pack_size[0] > 0 && inout_pack_size[1] > 0)
-        {
-            // TODO : It's maybe possible to revert the packing context without
-            //        having to make its full copy beforehand.
-            stbrp_context ctx = atlas.pack_ctx;
+void add_uniform
+(
+    UniformCache& cache,
+    u16           id,
+    u16           type,
+    u16           count,
+    const char*   name
+)
+{
+    constexpr bgfx::UniformType::Enum types[] =
+    {
+        bgfx::UniformType::Count,
+
+        bgfx::UniformType::Vec4,
+        bgfx::UniformType::Mat4,
+        bgfx::UniformType::Mat3,
+        bgfx::UniformType::Sampler,
+    };
+
+    bgfx::UniformHandle handle = bgfx::createUniform(name, types[type], count);
+    ASSERT(bgfx::isValid(handle), "Uniform creation failed.");
+
+    MutexScope lock(cache.mutex);
+
+    destroy_if_valid(cache.handles[id]);
+    cache.handles[id] = handle;
+
+    next_generation(cache.handles, id);
+}
+
+void init(DefaultUniforms& uniforms)
+{
+    for (u32 i = 0; i < uniforms.size; i++)
+    {
+        const u32 index = u32(s_default_uniforms[i].index);
+
+        uniforms[index] = bgfx::createUniform(
+            s_default_uniforms[i].name,
+            s_default_uniforms[i].type
+        );
+
+        ASSERT(bgfx::isValid(uniforms[index]),
+            "Failed to create default uniform '%s'.",
+            s_default_uniforms[i].name
+        );
+    }
+}
+
+void deinit(DefaultUniforms& uniforms)
+{
+    for (u32 i = 0; i < uniforms.size; i++)
+    {
+        destroy_if_valid(uniforms[i]);
+    }
+}
+
+bgfx::UniformHandle default_sampler
+(
+    const DefaultUniforms&    uniforms,
+    bgfx::TextureFormat::Enum format
+)
+{
+    switch (format)
+    {
+    case bgfx::TextureFormat::RGBA8:
+        return uniforms[u32(DefaultUniform::COLOR_TEXTURE_RGBA)];
+    case bgfx::TextureFormat::R8:
+        return uniforms[u32(DefaultUniform::COLOR_TEXTURE_RED)];
+    default:
+        return BGFX_INVALID_HANDLE;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// DEFAULT PROGRAMS
+// -----------------------------------------------------------------------------
+
+const bgfx::EmbeddedShader s_default_shaders[] =
+{
+    BGFX_EMBEDDED_SHADER(position_fs),
+    BGFX_EMBEDDED_SHADER(position_vs),
+
+    BGFX_EMBEDDED_SHADER(position_color_fs),
+    BGFX_EMBEDDED_SHADER(position_color_vs),
+
+    BGFX_EMBEDDED_SHADER(position_color_normal_fs),
+    BGFX_EMBEDDED_SHADER(position_color_normal_vs),
+
+    BGFX_EMBEDDED_SHADER(position_color_texcoord_fs),
+    BGFX_EMBEDDED_SHADER(position_color_texcoord_vs),
+
+    BGFX_EMBEDDED_SHADER(position_normal_fs),
+    BGFX_EMBEDDED_SHADER(position_normal_vs),
+
+    BGFX_EMBEDDED_SHADER(position_texcoord_fs),
+    BGFX_EMBEDDED_SHADER(position_texcoord_vs),
+
+    BGFX_EMBEDDED_SHADER(position_color_r_texcoord_fs),
+    BGFX_EMBEDDED_SHADER(position_color_r_pixcoord_fs),
+
+    BGFX_EMBEDDED_SHADER(position_2d_vs),
+    BGFX_EMBEDDED_SHADER(position_2d_color_vs),
+    BGFX_EMBEDDED_SHADER(position_2d_color_normal_vs),
+    BGFX_EMBEDDED_SHADER(position_2d_color_texcoord_vs),
+    BGFX_EMBEDDED_SHADER(position_2d_normal_vs),
+    BGFX_EMBEDDED_SHADER(position_2d_texcoord_vs),
+
+    BGFX_EMBEDDED_SHADER(instancing_billboard_color_vs),
+    BGFX_EMBEDDED_SHADER(instancing_position_color_vs),
+    BGFX_EMBEDDED_SHADER(instancing_position_2d_color_vs),
+};
+
+struct DefaultProgramInfo
+{
+    u32         attribs;
+    const char* vs_name;
+    const char* fs_name = nullptr;
+};
+
+const DefaultProgramInfo s_default_program_info[] =
+{
+    {
+        0, // NOTE : Position only. It's assumed everywhere else.
+        "position"
+    },
+    {
+        VERTEX_COLOR,
+        "position_color"
+    },
+    {
+        VERTEX_COLOR | VERTEX_NORMAL,
+        "position_color_normal"
+    },
+    {
+        VERTEX_COLOR | VERTEX_TEXCOORD,
+        "position_color_texcoord"
+    },
+    {
+        VERTEX_NORMAL,
+        "position_normal"
+    },
+    {
+        VERTEX_TEXCOORD,
+        "position_texcoord"
+    },
+    {
+        VERTEX_COLOR | INSTANCING_SUPPORTED,
+        "instancing_position_color",
+        "position_color"
+    },
+    {
+        VERTEX_COLOR | VERTEX_TEXCOORD | SAMPLER_COLOR_R,
+        "position_color_texcoord",
+        "position_color_r_texcoord"
+    },
+    {
+        VERTEX_COLOR | VERTEX_TEXCOORD | VERTEX_PIXCOORD | SAMPLER_COLOR_R,
+        "position_color_texcoord",
+        "position_color_r_pixcoord"
+    },
+    {
+        BILLBOARD_MESH | INSTANCING_SUPPORTED,
+        "instancing_billboard_color",
+        "position_color"
+    },
+    {
+        VERTEX_POSITION_2D,
+        "position_2d",
+        "position"
+    },
+    {
+        VERTEX_POSITION_2D | VERTEX_COLOR,
+        "position_2d_color",
+        "position_color"
+    },
+    {
+        VERTEX_POSITION_2D | VERTEX_COLOR | VERTEX_NORMAL,
+        "position_2d_color_normal",
+        "position_color_normal"
+    },
+    {
+        VERTEX_POSITION_2D | VERTEX_COLOR | VERTEX_TEXCOORD,
+        "position_2d_color_texcoord",
+        "position_color_texcoord"
+    },
+    {
+        VERTEX_POSITION_2D | VERTEX_NORMAL,
+        "position_2d_normal",
+        "position_normal"
+    },
+    {
+        VERTEX_POSITION_2D | VERTEX_TEXCOORD,
+        "position_2d_texcoord",
+        "position_texcoord"
+    },
+    {
+        VERTEX_POSITION_2D | VERTEX_COLOR | VERTEX_TEXCOORD | SAMPLER_COLOR_R,
+        "position_2d_color_texcoord",
+        "position_color_r_texcoord"
+    },
+    {
+        VERTEX_POSITION_2D | VERTEX_COLOR | VERTEX_TEXCOORD | VERTEX_PIXCOORD | SAMPLER_COLOR_R,
+        "position_2d_color_texcoord",
+        "position_color_r_pixcoord"
+    },
+    {
+        VERTEX_POSITION_2D | VERTEX_COLOR | INSTANCING_SUPPORTED,
+        "instancing_position_2d_color",
+        "position_color"
+    },
+};
+
+struct DefaultPrograms
+{
+    Mutex                               mutex;
+    FixedArray<bgfx::ProgramHandle, 256> handles;
+    FixedArray<u32                , 256> created; // Accessed atomically.
+    bgfx::RendererType::Enum            renderer = bgfx::RendererType::Noop;
+};
+
+constexpr u32 default_program_index(u32 attribs)
+{
+    static_assert(
+        VERTEX_ATTRIB_MASK   >> VERTEX_ATTRIB_SHIFT == 0b0000111 &&
+        INSTANCING_SUPPORTED >> 17                  == 0b0001000 &&
+        SAMPLER_COLOR_R      >> 17                  == 0b0010000 &&
+        VERTEX_PIXCOORD      >> 18                  == 0b0100000 &&
+        BILLBOARD_MESH       >> 18                  == 0b1000000 &&
+        VERTEX_POSITION_2D   >> 12                  == 0b10000000,
+        "Invalid index assumptions in default_program_index`."
+    );
+
+    return
+        ((attribs & VERTEX_ATTRIB_MASK  ) >> VERTEX_ATTRIB_SHIFT) | // Bits 0..2.
+        ((attribs & INSTANCING_SUPPORTED) >> 17                 ) | // Bit 3.
+        ((attribs & SAMPLER_COLOR_R     ) >> 17                 ) | // Bit 4.
+        ((attribs & VERTEX_PIXCOORD     ) >> 18                 ) | // Bit 5.
+        ((attribs & BILLBOARD_MESH      ) >> 18                 ) | // Bit 6.
+        ((attribs & VERTEX_POSITION_2D  ) >> 12                 ) ; // Bit 7.
+}
+
+void init(DefaultPrograms& programs, bgfx::RendererType::Enum renderer)
+{
+    fill(programs.handles, BGFX_INVALID_HANDLE);
+    fill(programs.created, 0u);
+
+    programs.renderer = renderer;
+}
+
+void deinit(DefaultPrograms& programs)
+{
+    for (u32 i = 0; i < programs.handles.size; i++)
+    {
+        destroy_if_valid(programs.handles[i]);
+    }
+
+    fill(programs.created, 0u);
+}
+
+bgfx::ProgramHandle create_default_program(const DefaultProgramInfo& info, bgfx::RendererType::Enum renderer)
+{
+    char vs_name[32];
+    char fs_name[32];
+
+    bx::strCopy(vs_name, sizeof(vs_name), info.vs_name);
+    bx::strCat (vs_name, sizeof(vs_name), "_vs");
+
+    bx::strCopy(fs_name, sizeof(fs_name), info.fs_name ? info.fs_name : info.vs_name);
+    bx::strCat (fs_name, sizeof(fs_name), "_fs");
+
+    const bgfx::ShaderHandle vertex = bgfx::createEmbeddedShader(
+        s_default_shaders, renderer, vs_name
+    );
+    ASSERT(
+        bgfx::isValid(vertex),
+        "Invalid default vertex shader '%s'.",
+        vs_name
+    );
+
+    const bgfx::ShaderHandle fragment = bgfx::createEmbeddedShader(
+        s_default_shaders, renderer, fs_name
+    );
+    ASSERT(
+        bgfx::isValid(fragment),
+        "Invalid default fragment shader '%s'.",
+        fs_name
+    );
+
+    const bgfx::ProgramHandle program = bgfx::createProgram(vertex, fragment, true);
+    ASSERT(
+        bgfx::isValid(program),
+        "Invalid default program with shaders '%s' and '%s'.",
+        vs_name, fs_name
+    );
+
+    return program;
+}
+
+// Programs are only created on first use (most applications need just a few
+// of them). Returns invalid handle if there's no program for given attributes.
+bgfx::ProgramHandle default_program(DefaultPrograms& programs, u32 attribs)
+{
+    const u32 index = default_program_index(attribs);
+
+    if (0 == bx::atomicCompareAndSwap(&programs.created[index], 0u, 0u))
+    {
+        MutexScope lock(programs.mutex);
+
+        if (!programs.created[index])
+        {
+            for (u32 i = 0; i < BX_COUNTOF(s_default_program_info); i++)
+            {
+                const DefaultProgramInfo& info = s_default_program_info[i];
+
+                if (default_program_index(info.attribs) == index)
+                {
+                    programs.handles[index] = create_default_program(
+                        info, programs.renderer
+                    );
+                    break;
+                }
+            }
+
+            bx::atomicCompareAndSwap(&programs.created[index], 0u, 1u);
+        }
+    }
+
+    return programs.handles[index];
+}
+
+
+// -----------------------------------------------------------------------------
+// PROGRAM CACHE
+// -----------------------------------------------------------------------------
+
+struct ProgramCache
+{
+    Mutex                            mutex;
+    HandleTable<bgfx::ProgramHandle> handles;
+};
+
+void init(ProgramCache& cache, Allocator* allocator, u32 program_count)
+{
+    init(cache.handles, allocator, program_count, BGFX_INVALID_HANDLE);
+}
+
+void deinit(ProgramCache& cache)
+{
+    for (u32 i = 0; i < cache.handles.size; i++)
+    {
+        destroy_if_valid(cache.handles[i]);
+    }
+
+    deinit(cache.handles);
+}
+
+void add_program
+(
+    ProgramCache& cache,
+    u16           id,
+    const void*   vs_data,
+    u32           vs_size,
+    const void*   fs_data,
+    u32           fs_size
+)
+{
+    ASSERT(
+        id < cache.handles.size,
+        "Program id %" PRIu16 " out of bounds (%" PRIu32").",
+        id, cache.handles.size
+    )
+    ASSERT(vs_data, "Invalid vertex shader blob pointer.");
+    ASSERT(vs_size, "Zero vertex shader blob size.");
+    ASSERT(fs_data, "Invalid fragment shader blob pointer.");
+    ASSERT(fs_size, "Zero fragment shader blob size.");
+
+    // NOTE : `vs_data` and `fs_data` are assumed to be valid according to
+    //        `bgfx::Memory`'s requirements (i.e., at least for two frames).
+    bgfx::ShaderHandle  vertex   = bgfx::createShader(bgfx::makeRef(vs_data, vs_size));
+    bgfx::ShaderHandle  fragment = bgfx::createShader(bgfx::makeRef(fs_data, fs_size));
+    bgfx::ProgramHandle program  = bgfx::createProgram(vertex, fragment, true);
+
+    if (!bgfx::isValid(program))
+    {
+        ASSERT(false, "Custom program creation failed.");
+
+        destroy_if_valid(vertex);
+        destroy_if_valid(fragment);
+        destroy_if_valid(program);
+    }
+    else
+    {
+        MutexScope lock(cache.mutex);
+
+        destroy_if_valid(cache.handles[id]);
+
+        cache.handles[id] = program;
+
+        next_generation(cache.handles, id);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// FRAMEBUFFER & FRAMEBUFFER RECORDING & FRAMEBUFFER CACHE
+// -----------------------------------------------------------------------------
+
+struct FramebufferRecorder
+{
+    FixedArray<bgfx::TextureHandle, 16> attachments;
+    u16                                 count  = 0;
+    u16                                 width  = 0;
+    u16                                 height = 0;
+};
+
+void start(FramebufferRecorder& recorder)
+{
+    recorder.count  = 0;
+    recorder.width  = 0;
+    recorder.height = 0;
+}
+
+void end(FramebufferRecorder& recorder)
+{
+    start(recorder);
+}
+
+void add_attachment(FramebufferRecorder& recorder, const Texture& attachment)
+{
+    ASSERT(
+        attachment.width > 0 && attachment.height > 0,
+        "Zero attachment texture width or height."
+    );
+
+    if (!recorder.count)
+    {
+        recorder.width  = attachment.width;
+        recorder.height = attachment.height;
+    }
+
+    ASSERT(
+        attachment.width == recorder.width && attachment.height == recorder.height,
+        "Mismatched framebuffer recording size. Started as %" PRIu16 "x%" PRIu16
+        ", but the next attachment texture has size %" PRIu16 "x%" PRIu16".",
+        recorder.width, recorder.height, attachment.width, attachment.height
+    );
+
+    ASSERT(
+        recorder.count < recorder.attachments.size,
+        "Maximum attachment texture count (" PRIu32 ") exhausted.",
+        recorder.attachments.size
+    );
+
+    recorder.attachments[recorder.count++] = attachment.handle;
+}
+
+struct Framebuffer
+{
+    bgfx::FrameBufferHandle handle = BGFX_INVALID_HANDLE;
+    u16                     width  = 0;
+    u16                     height = 0;
+};
+
+struct FramebufferCache
+{
+    Mutex                    mutex;
+    HandleTable<Framebuffer> framebuffers;
+};
+
+void destroy(Framebuffer& framebuffer)
+{
+    destroy_if_valid(framebuffer.handle);
+
+    framebuffer = {};
+}
+
+void release(ReleaseQueue& queue, Framebuffer& framebuffer)
+{
+    release(queue, ReleaseType::FRAMEBUFFER, framebuffer.handle.idx);
+
+    framebuffer = {};
+}
+
+void init(FramebufferCache& cache, Allocator* allocator, u32 framebuffer_count)
+{
+    init(cache.framebuffers, allocator, framebuffer_count);
+}
+
+void deinit(FramebufferCache& cache)
+{
+    for (u32 i = 0; i < cache.framebuffers.size; i++)
+    {
+        destroy(cache.framebuffers[i]);
+    }
+
+    deinit(cache.framebuffers);
+}
+
+void add_framebuffer
+(
+    FramebufferCache&                cache,
+    ReleaseQueue&                    release_queue,
+    u16                              id,
+    u16                              width,
+    u16                              height,
+    const Span<bgfx::TextureHandle>& attachments
+)
+{
+    ASSERT(attachments.size, "Attachment texture list empty.");
+
+    Framebuffer framebuffer;
+    framebuffer.width  = width;
+    framebuffer.height = height;
+
+    framebuffer.handle = bgfx::createFrameBuffer(
+        u8(attachments.size),
+        attachments.data,
+        false
+    );
+
+    ASSERT(bgfx::isValid(framebuffer.handle), "Framebuffer creation failed.");
+
+    {
+        MutexScope lock(cache.mutex);
+
+        release(release_queue, cache.framebuffers[id]);
+
+        cache.framebuffers[id] = framebuffer;
+
+        next_generation(cache.framebuffers, id);
+    }
+}
+
+void remove_framebuffer(FramebufferCache& cache, ReleaseQueue& release_queue, u16 id)
+{
+    MutexScope lock(cache.mutex);
+
+    release(release_queue, cache.framebuffers[id]);
+
+    next_generation(cache.framebuffers, id);
+}
+
+
+// -----------------------------------------------------------------------------
+// PASS & PASS CACHE
+// -----------------------------------------------------------------------------
+
+struct Pass
+{
+    enum : u8
+    {
+        DIRTY_NONE        = 0x00,
+        DIRTY_CLEAR       = 0x01,
+        DIRTY_TOUCH       = 0x02,
+        DIRTY_TRANSFORM   = 0x04,
+        DIRTY_RECT        = 0x08,
+        DIRTY_FRAMEBUFFER = 0x10,
+        DIRTY_SORT        = 0x20,
+    };
+
+    Mat4                    view_matrix     = HMM_Mat4d(1.0f);
+    Mat4                    proj_matrix     = HMM_Mat4d(1.0f);
+    Mat4                    view_proj       = HMM_Mat4d(1.0f);
+    Vec4                    frustum[6]      = {}; // Normalized planes, pointing inside.
+
+    u16                     viewport_x      = 0;
+    u16                     viewport_y      = 0;
+    u16                     viewport_width  = SIZE_EQUAL;
+    u16                     viewport_height = SIZE_EQUAL;
+
+    bgfx::FrameBufferHandle framebuffer     = BGFX_INVALID_HANDLE;
+    bgfx::FrameBufferHandle damage_target   = BGFX_INVALID_HANDLE; // Persistent, with dirty regions on.
+    u32                     damage_rect[4]  = { U16_MAX, U16_MAX, 0, 0 }; // Current frame, min / max corners, updated atomically.
+
+    u16                     clear_flags     = BGFX_CLEAR_NONE;
+    f32                     clear_depth     = 1.0f;
+    u32                     clear_rgba      = 0x000000ff;
+    u8                      clear_stencil   = 0;
+
+    u8                      sort_mode       = SORT_STATE;
+
+    u8                      dirty_flags     = DIRTY_CLEAR;
+
+    bool                    auto_instancing = false;
+    bool                    frustum_culling = false;
+    bool                    dirty_regions   = false;
+    bool                    graph_culled    = false; // Current frame only.
+    bool                    keep_content    = false; // Targets clean layer, current frame only.
+
+    u32                     culled_count    = 0; // Current frame, updated atomically.
+    u32                     culled_last     = 0; // Previous frame.
+};
+
+// Makes sure the pass gets submitted (and cleared) even if it stays empty,
+// unless its target keeps the content from the previous frames.
+void touch(Pass& pass)
+{
+    if (!pass.keep_content)
+    {
+        pass.dirty_flags |= Pass::DIRTY_TOUCH;
+    }
+}
+
+void update_view_proj(Pass& pass)
+{
+    pass.view_proj = pass.proj_matrix * pass.view_matrix;
+
+    const f32 (&m)[4][4] = pass.view_proj.Elements;
+
+    // Gribb-Hartmann plane extraction (`m[column][row]`).
+    for (u32 i = 0; i < 3; i++)
+    {
+        for (u32 j = 0; j < 2; j++)
+        {
+            const f32 sign = j ? -1.0f : 1.0f;
+
+            Vec4& plane = pass.frustum[i * 2 + j];
+
+            plane.X = m[0][3] + sign * m[0][i];
+            plane.Y = m[1][3] + sign * m[1][i];
+            plane.Z = m[2][3] + sign * m[2][i];
+            plane.W = m[3][3] + sign * m[3][i];
+
+            const f32 length = HMM_LengthVec3(plane.XYZ);
+
+            if (length > 0.0f)
+            {
+                plane = plane * (1.0f / length);
+            }
+        }
+    }
+}
+
+bool is_visible(const Pass& pass, const Mesh& mesh, const Mat4& model)
+{
+    const Vec3 center = (mesh.bounds_min + mesh.bounds_max) * 0.5f;
+    const Vec3 world  = (model * HMM_Vec4v(center, 1.0f)).XYZ;
+
+    f32 scale = 0.0f;
+
+    for (u32 i = 0; i < 3; i++)
+    {
+        scale = bx::max(scale, HMM_LengthSquaredVec3(HMM_Vec3(
+            model.Elements[i][0],
+            model.Elements[i][1],
+            model.Elements[i][2]
+        )));
+    }
+
+    const f32 radius = mesh.bounds_radius * sqrtf(scale);
+
+    bool is_inside = true;
+
+    for (u32 i = 0; i < BX_COUNTOF(pass.frustum); i++)
+    {
+        const f32 distance = HMM_DotVec3(pass.frustum[i].XYZ, world) + pass.frustum[i].W;
+
+        if (distance < -radius)
+        {
+            return false;
+        }
+
+        is_inside &= distance >= radius;
+    }
+
+    if (is_inside)
+    {
+        return true;
+    }
+
+    // Sphere intersects the frustum's boundary, so test whether all bounding
+    // box corners lie outside of the same clip plane.
+    const Mat4 clip = pass.view_proj * model;
+
+    u32 outside = 0x3f;
+
+    for (u32 i = 0; i < 8; i++)
+    {
+        const Vec4 corner = clip * HMM_Vec4(
+            (i & 1) ? mesh.bounds_max.X : mesh.bounds_min.X,
+            (i & 2) ? mesh.bounds_max.Y : mesh.bounds_min.Y,
+            (i & 4) ? mesh.bounds_max.Z : mesh.bounds_min.Z,
+            1.0f
+        );
+
+        outside &=
+            (u32(corner.X < -corner.W)     ) |
+            (u32(corner.X >  corner.W) << 1) |
+            (u32(corner.Y < -corner.W) << 2) |
+            (u32(corner.Y >  corner.W) << 3) |
+            (u32(corner.Z < -corner.W) << 4) |
+            (u32(corner.Z >  corner.W) << 5) ;
+    }
+
+    return outside == 0;
+}
+
+bool is_full_viewport(const Pass& pass)
+{
+    return
+        pass.viewport_x      == 0          &&
+        pass.viewport_y      == 0          &&
+        pass.viewport_width  == SIZE_EQUAL &&
+        pass.viewport_height == SIZE_EQUAL;
+}
+
+// Damage can be added from any thread, while the others read it to cull their
+// submissions, so the rectangle's corners are only accessed atomically.
+u32 load_damage(const Pass& pass, u32 i)
+{
+    return bx::atomicFetchAndAdd(const_cast<u32*>(&pass.damage_rect[i]), 0u);
+}
+
+template <bool IsMin>
+void merge_damage(Pass& pass, u32 i, u32 value)
+{
+    u32 current = load_damage(pass, i);
+
+    while (IsMin ? value < current : value > current)
+    {
+        const u32 previous = bx::atomicCompareAndSwap(&pass.damage_rect[i], current, value);
+
+        if (previous == current)
+        {
+            break;
+        }
+
+        current = previous;
+    }
+}
+
+// Damaged regions are in pixels, with the origin in the top-left corner, and
+// accumulated in the pass until the end of the frame.
+void add_damage(Pass& pass, u16 x0, u16 y0, u16 x1, u16 y1)
+{
+    merge_damage<true >(pass, 0, x0);
+    merge_damage<true >(pass, 1, y0);
+    merge_damage<false>(pass, 2, x1);
+    merge_damage<false>(pass, 3, y1);
+}
+
+void reset_damage(Pass& pass)
+{
+    pass.damage_rect[0] = U16_MAX;
+    pass.damage_rect[1] = U16_MAX;
+    pass.damage_rect[2] = 0;
+    pass.damage_rect[3] = 0;
+}
+
+// Rectangle that gets cleared and redrawn in the current frame, clamped to the
+// pass size.
+//
+// NOTE : BGFX can't handle empty view rectangles, so a frame without any damage
+//        redraws just the top-left pixel instead.
+void redrawn_rect(const Pass& pass, u16 width, u16 height, u16 (&rect)[4])
+{
+    rect[0] = u16(load_damage(pass, 0));
+    rect[1] = u16(load_damage(pass, 1));
+    rect[2] = u16(bx::min(load_damage(pass, 2), u32(width )));
+    rect[3] = u16(bx::min(load_damage(pass, 3), u32(height)));
+
+    if (rect[0] >= rect[2] || rect[1] >= rect[3])
+    {
+        rect[0] = 0;
+        rect[1] = 0;
+        rect[2] = 1;
+        rect[3] = 1;
+    }
+}
+
+// Projection adjustment that maps the redrawn rectangle onto the whole clip
+// space, so that the pass can use it as its view rectangle (which limits both
+// the view clear and the rasterization), while the content stays where it'd be
+// in a full-size view.
+Mat4 damage_projection(const u16 (&rect)[4], u16 width, u16 height)
+{
+    const f32 x = rect[0];
+    const f32 y = rect[1];
+    const f32 w = rect[2] - rect[0];
+    const f32 h = rect[3] - rect[1];
+
+    Mat4 adjustment = HMM_Mat4d(1.0f);
+    adjustment.Elements[0][0] = width  / w;
+    adjustment.Elements[1][1] = height / h;
+    adjustment.Elements[3][0] = (width - w - 2.0f * x) / w;
+    adjustment.Elements[3][1] = (h - height + 2.0f * y) / h;
+
+    return adjustment;
+}
+
+// Conservative test whether the mesh's screen-space bounding rectangle
+// intersects the redrawn rectangle of the pass (`width` and `height` being the
+// pass size, i.e., the backbuffer size).
+bool is_damaged(const Pass& pass, const Mesh& mesh, const Mat4& model, u16 width, u16 height)
+{
+    const Mat4 clip = pass.view_proj * model;
+
+    f32 min_x =  FLT_MAX;
+    f32 min_y =  FLT_MAX;
+    f32 max_x = -FLT_MAX;
+    f32 max_y = -FLT_MAX;
+
+    for (u32 i = 0; i < 8; i++)
+    {
+        const Vec4 corner = clip * HMM_Vec4(
+            (i & 1) ? mesh.bounds_max.X : mesh.bounds_min.X,
+            (i & 2) ? mesh.bounds_max.Y : mesh.bounds_min.Y,
+            (i & 4) ? mesh.bounds_max.Z : mesh.bounds_min.Z,
+            1.0f
+        );
+
+        // Corners behind the camera would need clipping, so just give up.
+        if (corner.W <= 0.0f)
+        {
+            return true;
+        }
+
+        const f32 x = (0.5f + 0.5f * corner.X / corner.W) * width;
+        const f32 y = (0.5f - 0.5f * corner.Y / corner.W) * height;
+
+        min_x = bx::min(min_x, x);
+        min_y = bx::min(min_y, y);
+        max_x = bx::max(max_x, x);
+        max_y = bx::max(max_y, y);
+    }
+
+    u16 rect[4];
+    redrawn_rect(pass, width, height, rect);
+
+    return
+        min_x < f32(rect[2]) && max_x > f32(rect[0]) &&
+        min_y < f32(rect[3]) && max_y > f32(rect[1]);
+}
+
+struct PassCache
+{
+    HandleTable<Pass> passes;
+    bool              backbuffer_size_changed = true;
+};
+
+void init(PassCache& cache, Allocator* allocator, u32 pass_count)
+{
+    init(cache.passes, allocator, pass_count);
+}
+
+void deinit(PassCache& cache)
+{
+    for (u32 i = 0; i < cache.passes.size; i++)
+    {
+        destroy_if_valid(cache.passes[i].damage_target);
+    }
+
+    deinit(cache.passes);
+}
+
+// Persistent targets get recreated by BGFX when the backbuffer is resized, so
+// their whole content has to be redrawn.
+void damage_all(PassCache& cache)
+{
+    for (u32 i = 0; i < cache.passes.size; i++)
+    {
+        if (cache.passes[i].dirty_regions)
+        {
+            add_damage(cache.passes[i], 0, 0, U16_MAX, U16_MAX);
+        }
+    }
+}
+
+// Picks the passes a mesh submission goes into, skipping the graph-culled ones
+// and those the mesh is culled from (`culling` being false when the final
+// transform isn't known). Passes other than the active one get touched.
+u32 visible_passes
+(
+    PassCache&    cache,
+    const int*    passes,
+    u32           count,
+    const Mesh&   mesh,
+    const Mat4&   model,
+    bool          culling,
+    u16           width,
+    u16           height,
+    bgfx::ViewId  active_pass,
+    bgfx::ViewId* visible
+)
+{
+    u32 visible_count = 0;
+
+    for (u32 i = 0; i < count; i++)
+    {
+        ASSERT(
+            passes[i] >= 0 && passes[i] < int(cache.passes.size),
+            "Pass ID %i out of available range 0 ... %i.",
+            passes[i], int(cache.passes.size - 1)
+        );
+
+        Pass& pass = cache.passes[passes[i]];
+
+        if (pass.graph_culled)
+        {
+            continue;
+        }
+
+        if (culling && pass.frustum_culling && !is_visible(pass, mesh, model))
+        {
+            bx::atomicFetchAndAdd(&pass.culled_count, 1u);
+
+            continue;
+        }
+
+        if (culling && pass.dirty_regions && !is_damaged(pass, mesh, model, width, height))
+        {
+            bx::atomicFetchAndAdd(&pass.culled_count, 1u);
+
+            continue;
+        }
+
+        if (passes[i] != int(active_pass))
+        {
+            touch(pass);
+        }
+
+        visible[visible_count++] = bgfx::ViewId(passes[i]);
+    }
+
+    return visible_count;
+}
+
+static_assert(
+    SORT_STATE         == bgfx::ViewMode::Default         &&
+    SORT_SEQUENTIAL    == bgfx::ViewMode::Sequential      &&
+    SORT_FRONT_TO_BACK == bgfx::ViewMode::DepthAscending  &&
+    SORT_BACK_TO_FRONT == bgfx::ViewMode::DepthDescending ,
+
+    "BGFX and MiNiMo pass sort modes don't match."
+);
+
+// Switches passes rendering into given (destroyed) framebuffer back to the
+// default backbuffer.
+void detach_framebuffer(PassCache& cache, bgfx::FrameBufferHandle framebuffer)
+{
+    for (u32 i = 0; i < cache.passes.size; i++)
+    {
+        Pass& pass = cache.passes[i];
+
+        if (pass.framebuffer.idx == framebuffer.idx)
+        {
+            pass.framebuffer  = BGFX_INVALID_HANDLE;
+            pass.dirty_flags |= Pass::DIRTY_FRAMEBUFFER;
+        }
+    }
+}
+
+// Renders the pass into its persistent target, with the view rectangle shrunk
+// to the damage. The damaged region is always cleared (color and depth), and
+// the pass is touched, so that it happens even if nothing else gets submitted
+// into it.
+void update_damage_target
+(
+    Pass&          pass,
+    bgfx::ViewId   id,
+    u16            width,
+    u16            height,
+    bgfx::Encoder* encoder
+)
+{
+    if (!bgfx::isValid(pass.damage_target))
+    {
+        bgfx::TextureHandle textures[] =
+        {
+            bgfx::createTexture2D(
+                bgfx::BackbufferRatio::Equal, false, 1, bgfx::TextureFormat::RGBA8,
+                BGFX_TEXTURE_RT | BGFX_SAMPLER_UVW_CLAMP | BGFX_SAMPLER_POINT
+            ),
+            bgfx::createTexture2D(
+                bgfx::BackbufferRatio::Equal, false, 1, bgfx::TextureFormat::D24S8,
+                BGFX_TEXTURE_RT_WRITE_ONLY
+            ),
+        };
+
+        pass.damage_target = bgfx::createFrameBuffer(BX_COUNTOF(textures), textures, true);
+
+        WARN(bgfx::isValid(pass.damage_target), "Failed to create dirty region target.");
+    }
+
+    u16 rect[4];
+    redrawn_rect(pass, width, height, rect);
+
+    const Mat4 proj = damage_projection(rect, width, height) * pass.proj_matrix;
+
+    bgfx::setViewFrameBuffer(id, pass.damage_target);
+    bgfx::setViewRect(id, rect[0], rect[1], rect[2] - rect[0], rect[3] - rect[1]);
+    bgfx::setViewTransform(id, &pass.view_matrix, &proj);
+    bgfx::setViewClear(
+        id, pass.clear_flags | BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH,
+        pass.clear_rgba, pass.clear_depth, pass.clear_stencil
+    );
+
+    encoder->touch(id);
+
+    reset_damage(pass);
+}
+
+// Blends the persistent targets of the passes with dirty regions over the
+// backbuffer, in views following all the passes (shared with the blits). The
+// content is treated as premultiplied, so the areas cleared to a transparent
+// color leave the backbuffer intact.
+void composite_damage_targets
+(
+    PassCache&             cache,
+    VertexLayoutCache&     layouts,
+    DefaultPrograms&       programs,
+    const DefaultUniforms& uniforms,
+    bgfx::Encoder*         encoder
+)
+{
+    struct Vertex
+    {
+        Vec3 position;
+        Vec2 texcoord;
+    };
+
+    // Fullscreen triangle, the bottom edge has V = 1 (see `FIX_TEXCOORD`).
+    const Vertex vertices[] =
+    {
+        { HMM_Vec3(-1.0f, -1.0f, 0.0f), HMM_Vec2(0.0f,  1.0f) },
+        { HMM_Vec3( 3.0f, -1.0f, 0.0f), HMM_Vec2(2.0f,  1.0f) },
+        { HMM_Vec3(-1.0f,  3.0f, 0.0f), HMM_Vec2(0.0f, -1.0f) },
+    };
+
+    for (u32 i = 0; i < cache.passes.size; i++)
+    {
+        const Pass& pass = cache.passes[i];
+
+        if (!pass.dirty_regions || !bgfx::isValid(pass.damage_target))
+        {
+            continue;
+        }
+
+        const bgfx::VertexLayout& layout = vertex_layout(
+            layouts, VERTEX_TEXCOORD_F32 | VERTEX_INTERLEAVED
+        );
+        ASSERT(layout.getStride() == sizeof(Vertex), "Invalid composite vertex layout.");
+
+        if (bgfx::getAvailTransientVertexBuffer(BX_COUNTOF(vertices), layout) < BX_COUNTOF(vertices))
+        {
+            WARN(false, "Transient memory exhausted, pass %" PRIu32 " not composited.", i);
+            continue;
+        }
+
+        const bgfx::ViewId view = bgfx::ViewId(i + cache.passes.size);
+
+        bgfx::setViewRect       (view, 0, 0, bgfx::BackbufferRatio::Equal);
+        bgfx::setViewFrameBuffer(view, BGFX_INVALID_HANDLE);
+        bgfx::setViewClear      (view, BGFX_CLEAR_NONE);
+        bgfx::setViewTransform  (view, nullptr, nullptr);
+
+        bgfx::TransientVertexBuffer buffer;
+        bgfx::allocTransientVertexBuffer(&buffer, BX_COUNTOF(vertices), layout);
+        bx::memCopy(buffer.data, vertices, sizeof(vertices));
+
+        // NOTE : Previous submissions preserve their state.
+        encoder->discard();
+
+        encoder->setVertexBuffer(0, &buffer);
+        encoder->setTexture(
+            0,
+            default_sampler(uniforms, bgfx::TextureFormat::RGBA8),
+            bgfx::getTexture(pass.damage_target, 0)
+        );
+        encoder->setState(
+            BGFX_STATE_WRITE_RGB |
+            BGFX_STATE_WRITE_A   |
+            BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_ONE, BGFX_STATE_BLEND_INV_SRC_ALPHA)
+        );
+        encoder->submit(view, default_program(programs, VERTEX_TEXCOORD));
+    }
+}
+
+void update_passes
+(
+    PassCache&     cache,
+    u16            backbuffer_width,
+    u16            backbuffer_height,
+    bgfx::Encoder* encoder
+)
+{
+    for (bgfx::ViewId id = 0; id < cache.passes.size; id++)
+    {
+        Pass& pass = cache.passes[id];
+
+        if (pass.dirty_flags & Pass::DIRTY_TOUCH)
+        {
+            encoder->touch(id);
+        }
+
+        if (pass.dirty_flags & Pass::DIRTY_CLEAR)
+        {
+            bgfx::setViewClear(
+                id, pass.clear_flags, pass.clear_rgba, pass.clear_depth, 
+                pass.clear_stencil
+            );
+        }
+
+        if (pass.dirty_flags & Pass::DIRTY_TRANSFORM)
+        {
+            bgfx::setViewTransform(id, &pass.view_matrix, &pass.proj_matrix);
+        }
+
+        if ((pass.dirty_flags & Pass::DIRTY_RECT) ||
+            (cache.backbuffer_size_changed && pass.viewport_width >= SIZE_EQUAL)
+        )
+        {
+            if (pass.viewport_width >= SIZE_EQUAL)
+            {
+                bgfx::setViewRect(
+                    id, pass.viewport_x, pass.viewport_y,
+                    bgfx::BackbufferRatio::Enum(pass.viewport_width - SIZE_EQUAL)
+                );
+            }
+            else
+            {
+                bgfx::setViewRect(
+                    id, pass.viewport_x, pass.viewport_y, pass.viewport_width,
+                    pass.viewport_height
+                );
+            }
+        }
+
+        if ((pass.dirty_flags & Pass::DIRTY_FRAMEBUFFER) ||
+            cache.backbuffer_size_changed
+        )
+        {
+            // Having `BGFX_INVALID_HANDLE` here is OK.
+            bgfx::setViewFrameBuffer(id, pass.framebuffer);
+        }
+
+        if (pass.dirty_flags & Pass::DIRTY_SORT)
+        {
+            bgfx::setViewMode(id, bgfx::ViewMode::Enum(pass.sort_mode));
+        }
+
+        if (pass.dirty_regions)
+        {
+            update_damage_target(pass, id, backbuffer_width, backbuffer_height, encoder);
+        }
+
+        pass.culled_last  = pass.culled_count;
+        pass.culled_count = 0;
+
+        pass.keep_content = false;
+        pass.dirty_flags  = Pass::DIRTY_NONE;
+    }
+
+    cache.backbuffer_size_changed = false;
+}
+
+
+// -----------------------------------------------------------------------------
+// RENDER GRAPH
+// -----------------------------------------------------------------------------
+
+// Per-frame declaration of passes and transient targets they read and write.
+// Compilation culls passes that don't (transitively) contribute to any output
+// pass, orders the rest so that targets are written before they're read, and
+// assigns the targets to physical textures, so that targets with the same
+// description and non-overlapping lifetimes share a single texture. It's all
+// CPU-side, the GPU resources are owned by `RenderGraphPool`.
+
+struct GraphTargetDesc
+{
+    u16 width;  // Can also be one of `SIZE_*` backbuffer ratios.
+    u16 height;
+    u16 flags;  // `TEXTURE_*` flags, other than `TEXTURE_TARGET`.
+};
+
+bool same_desc(const GraphTargetDesc& a, const GraphTargetDesc& b)
+{
+    return a.width == b.width && a.height == b.height && a.flags == b.flags;
+}
+
+struct GraphTarget
+{
+    GraphTargetDesc desc     = {};
+    u16             physical = U16_MAX; // Assigned by `compile`.
+    u16             first    = U16_MAX; // Lifetime, as positions in the pass order.
+    u16             last     = 0;
+    bool            declared = false;
+};
+
+struct GraphPass
+{
+    u64  reads  = 0; // Target bit masks.
+    u64  writes = 0;
+    u16  pass   = 0;
+    bool output = false;
+    bool culled = false;
+};
+
+struct RenderGraph
+{
+    FixedArray<GraphTarget    , MAX_GRAPH_TARGETS> targets;
+    FixedArray<GraphPass      , MAX_GRAPH_PASSES > passes;
+    FixedArray<u16            , MAX_GRAPH_PASSES > order;    // Indices into `passes`, without the culled ones.
+    FixedArray<GraphTargetDesc, MAX_GRAPH_TARGETS> physical; // Descriptions of the physical textures.
+    u32                                             pass_count     = 0;
+    u32                                             order_count    = 0;
+    u32                                             physical_count = 0;
+    u32                                             recording      = U32_MAX; // Pass being declared.
+    bool                                            compiled       = false;
+};
+
+void reset(RenderGraph& graph)
+{
+    for (u32 i = 0; i < graph.targets.size; i++)
+    {
+        graph.targets[i] = {};
+    }
+
+    graph.pass_count     = 0;
+    graph.order_count    = 0;
+    graph.physical_count = 0;
+    graph.recording      = U32_MAX;
+    graph.compiled       = false;
+}
+
+void add_target(RenderGraph& graph, u16 target, const GraphTargetDesc& desc)
+{
+    ASSERT(target < MAX_GRAPH_TARGETS, "Invalid graph target %" PRIu16 ".", target);
+    ASSERT(!graph.compiled, "Render graph already compiled in this frame.");
+
+    graph.targets[target].desc     = desc;
+    graph.targets[target].declared = true;
+}
+
+void begin_pass(RenderGraph& graph, u16 pass, bool output)
+{
+    ASSERT(graph.recording == U32_MAX, "Graph pass declarations can't be nested.");
+    ASSERT(graph.pass_count < MAX_GRAPH_PASSES, "Too many graph passes.");
+    ASSERT(!graph.compiled, "Render graph already compiled in this frame.");
+
+    for (u32 i = 0; i < graph.pass_count; i++)
+    {
+        ASSERT(
+            graph.passes[i].pass != pass,
+            "Pass %" PRIu16 " already declared in the render graph.",
+            pass
+        );
+    }
+
+    graph.recording = graph.pass_count++;
+
+    GraphPass& graph_pass = graph.passes[graph.recording];
+
+    graph_pass        = {};
+    graph_pass.pass   = pass;
+    graph_pass.output = output;
+}
+
+void add_read(RenderGraph& graph, u16 target)
+{
+    ASSERT(graph.recording != U32_MAX, "No graph pass being declared.");
+    ASSERT(target < MAX_GRAPH_TARGETS, "Invalid graph target %" PRIu16 ".", target);
+
+    graph.passes[graph.recording].reads |= u64(1) << target;
+}
+
+void add_write(RenderGraph& graph, u16 target)
+{
+    ASSERT(graph.recording != U32_MAX, "No graph pass being declared.");
+    ASSERT(target < MAX_GRAPH_TARGETS, "Invalid graph target %" PRIu16 ".", target);
+
+    graph.passes[graph.recording].writes |= u64(1) << target;
+}
+
+void end_pass(RenderGraph& graph)
+{
+    ASSERT(graph.recording != U32_MAX, "No graph pass being declared.");
+
+    ASSERT(
+        bx::uint64_cntbits(graph.passes[graph.recording].writes) <= MAX_GRAPH_ATTACHMENTS,
+        "Graph pass writes into more than %" PRIu32 " targets.",
+        MAX_GRAPH_ATTACHMENTS
+    );
+
+    graph.recording = U32_MAX;
+}
+
+// Returns `false` if the pass dependencies contain a cycle, in which case the
+// passes involved are kept in the declaration order.
+bool compile(RenderGraph& graph)
+{
+    ASSERT(graph.recording == U32_MAX, "Unfinished graph pass declaration.");
+
+    // Culling, starting from the output passes.
+    u64 needed_targets = 0;
+
+    for (u32 i = 0; i < graph.pass_count; i++)
+    {
+        GraphPass& pass = graph.passes[i];
+
+        pass.culled = !pass.output;
+
+        if (pass.output)
+        {
+            needed_targets |= pass.reads;
+        }
+    }
+
+    for (bool changed = true; changed; )
+    {
+        changed = false;
+
+        for (u32 i = 0; i < graph.pass_count; i++)
+        {
+            GraphPass& pass = graph.passes[i];
+
+            if (pass.culled && (pass.writes & needed_targets))
+            {
+                pass.culled     = false;
+                needed_targets |= pass.reads;
+                changed         = true;
+            }
+        }
+    }
+
+    // Ordering. A pass is placed once all passes writing the targets it reads
+    // are placed. Passes writing the same target keep the declaration order,
+    // which is also used to break ties.
+    FixedArray<bool, MAX_GRAPH_PASSES> placed;
+
+    u32 remaining = 0;
+
+    for (u32 i = 0; i < graph.pass_count; i++)
+    {
+        placed[i]  = graph.passes[i].culled;
+        remaining += !graph.passes[i].culled;
+    }
+
+    bool acyclic = true;
+
+    graph.order_count = 0;
+
+    while (graph.order_count < remaining)
+    {
+        u32 next  = U32_MAX;
+        u32 first = U32_MAX;
+
+        for (u32 i = 0; i < graph.pass_count && next == U32_MAX; i++)
+        {
+            if (placed[i])
+            {
+                continue;
+            }
+
+            first = bx::min(first, i);
+
+            const GraphPass& pass  = graph.passes[i];
+            bool             ready = true;
+
+            for (u32 j = 0; j < graph.pass_count && ready; j++)
+            {
+                if (j == i || placed[j])
+                {
+                    continue;
+                }
+
+                const GraphPass& other = graph.passes[j];
+
+                ready =
+                    !(other.writes & pass.reads) &&
+                    !(j < i && (other.writes & pass.writes));
+            }
+
+            if (ready)
+            {
+                next = i;
+            }
+        }
+
+        if (next == U32_MAX)
+        {
+            acyclic = false;
+            next    = first;
+        }
+
+        placed[next] = true;
+        graph.order[graph.order_count++] = u16(next);
+    }
+
+    WARN(acyclic, "Render graph contains a cycle, using declaration order.");
+
+    // Lifetimes.
+    for (u32 pos = 0; pos < graph.order_count; pos++)
+    {
+        const GraphPass& pass = graph.passes[graph.order[pos]];
+
+        for (u32 i = 0; i < MAX_GRAPH_TARGETS; i++)
+        {
+            if ((pass.reads | pass.writes) & (u64(1) << i))
+            {
+                GraphTarget& target = graph.targets[i];
+
+                ASSERT(target.declared, "Graph target %" PRIu32 " not declared.", i);
+
+                target.first = bx::min(target.first, u16(pos));
+                target.last  = bx::max(target.last , u16(pos));
+            }
+        }
+    }
+
+    // Aliasing. Targets are visited in the order of their first use, each one
+    // going into the first compatible texture that's not used anymore at that
+    // point (interval partitioning, which is optimal per target description).
+    FixedArray<u16, MAX_GRAPH_TARGETS> physical_last;
+
+    graph.physical_count = 0;
+
+    for (u32 pos = 0; pos < graph.order_count; pos++)
+    {
+        for (u32 i = 0; i < MAX_GRAPH_TARGETS; i++)
+        {
+            GraphTarget& target = graph.targets[i];
+
+            if (target.first != pos)
+            {
+                continue;
+            }
+
+            u32 physical = U32_MAX;
+
+            for (u32 j = 0; j < graph.physical_count; j++)
+            {
+                if (physical_last[j] < pos && same_desc(graph.physical[j], target.desc))
+                {
+                    physical = j;
+                    break;
+                }
+            }
+
+            if (physical == U32_MAX)
+            {
+                physical = graph.physical_count++;
+                graph.physical[physical] = target.desc;
+            }
+
+            physical_last[physical] = target.last;
+            target.physical         = u16(physical);
+        }
+    }
+
+    graph.compiled = true;
+
+    return acyclic;
+}
+
+struct GraphTexture
+{
+    GraphTargetDesc     desc   = {};
+    bgfx::TextureHandle handle = BGFX_INVALID_HANDLE;
+    u32                 frame  = 0; // Last frame it was used in.
+};
+
+struct GraphFramebuffer
+{
+    bgfx::TextureHandle     attachments[MAX_GRAPH_ATTACHMENTS] = {};
+    u32                     count                              = 0;
+    bgfx::FrameBufferHandle handle                             = BGFX_INVALID_HANDLE;
+    u32                     frame                              = 0;
+};
+
+struct RenderGraphPool
+{
+    FixedArray<GraphTexture    , MAX_GRAPH_TARGETS> textures;
+    FixedArray<GraphFramebuffer, MAX_GRAPH_PASSES > framebuffers;
+    FixedArray<u16             , MAX_GRAPH_TARGETS> assigned; // Physical texture index -> `textures` index.
+};
+
+void deinit(RenderGraphPool& pool)
+{
+    for (u32 i = 0; i < pool.framebuffers.size; i++)
+    {
+        destroy_if_valid(pool.framebuffers[i].handle);
+    }
+
+    for (u32 i = 0; i < pool.textures.size; i++)
+    {
+        destroy_if_valid(pool.textures[i].handle);
+    }
+}
+
+bgfx::TextureHandle create_graph_texture(const GraphTargetDesc& desc)
+{
+    const bgfx::TextureFormat::Enum format = texture_format(desc.flags).type;
+    const u64                       flags  = translate_texture_flags(desc.flags | TEXTURE_TARGET);
+
+    if (desc.width >= SIZE_EQUAL && desc.width <= SIZE_DOUBLE && desc.width == desc.height)
+    {
+        return bgfx::createTexture2D(
+            bgfx::BackbufferRatio::Enum(desc.width - SIZE_EQUAL), false, 1, format, flags
+        );
+    }
+
+    return bgfx::createTexture2D(desc.width, desc.height, false, 1, format, flags);
+}
+
+u16 acquire_texture(RenderGraphPool& pool, const GraphTargetDesc& desc, u32 frame)
+{
+    u32 free_slot = U32_MAX;
+
+    for (u32 i = 0; i < pool.textures.size; i++)
+    {
+        GraphTexture& texture = pool.textures[i];
+
+        if (!bgfx::isValid(texture.handle))
+        {
+            free_slot = bx::min(free_slot, i);
+        }
+        else if (texture.frame != frame && same_desc(texture.desc, desc))
+        {
+            texture.frame = frame;
+
+            return u16(i);
+        }
+    }
+
+    ASSERT(free_slot != U32_MAX, "Render graph texture pool exhausted.");
+
+    GraphTexture& texture = pool.textures[free_slot];
+
+    texture.desc   = desc;
+    texture.handle = create_graph_texture(desc);
+    texture.frame  = frame;
+
+    return u16(free_slot);
+}
+
+bgfx::FrameBufferHandle acquire_framebuffer
+(
+    RenderGraphPool&           pool,
+    const bgfx::TextureHandle* attachments,
+    u32                        count,
+    u32                        frame
+)
+{
+    u32 free_slot = U32_MAX;
+
+    for (u32 i = 0; i < pool.framebuffers.size; i++)
+    {
+        GraphFramebuffer& framebuffer = pool.framebuffers[i];
+
+        if (!bgfx::isValid(framebuffer.handle))
+        {
+            free_slot = bx::min(free_slot, i);
+        }
+        else if (
+            framebuffer.count == count &&
+            bx::memCmp(framebuffer.attachments, attachments, count * sizeof(*attachments)) == 0
+        )
+        {
+            framebuffer.frame = frame;
+
+            return framebuffer.handle;
+        }
+    }
+
+    ASSERT(free_slot != U32_MAX, "Render graph framebuffer pool exhausted.");
+
+    GraphFramebuffer& framebuffer = pool.framebuffers[free_slot];
+
+    bx::memCopy(framebuffer.attachments, attachments, count * sizeof(*attachments));
+
+    framebuffer.count  = count;
+    framebuffer.handle = bgfx::createFrameBuffer(u8(count), attachments, false);
+    framebuffer.frame  = frame;
+
+    return framebuffer.handle;
+}
+
+// Creates or reuses the textures and framebuffers of a compiled graph, points
+// the passes to them and reorders the BGFX views accordingly.
+void apply
+(
+    const RenderGraph& graph,
+    RenderGraphPool&   pool,
+    PassCache&         passes,
+    ReleaseQueue&      release_queue,
+    u32                frame
+)
+{
+    ASSERT(graph.compiled, "Render graph not compiled.");
+    ASSERT(passes.passes.size <= MAX_GRAPH_PASSES, "Too many passes for the render graph.");
+
+    for (u32 i = 0; i < graph.physical_count; i++)
+    {
+        pool.assigned[i] = acquire_texture(pool, graph.physical[i], frame);
+    }
+
+    for (u32 i = 0; i < graph.pass_count; i++)
+    {
+        const GraphPass& graph_pass = graph.passes[i];
+        Pass&            pass       = passes.passes[graph_pass.pass];
+
+        pass.graph_culled = graph_pass.culled;
+
+        if (graph_pass.culled || !graph_pass.writes)
+        {
+            continue;
+        }
+
+        bgfx::TextureHandle attachments[MAX_GRAPH_ATTACHMENTS];
+        u32                 count = 0;
+
+        for (u32 j = 0; j < MAX_GRAPH_TARGETS; j++)
+        {
+            if (graph_pass.writes & (u64(1) << j))
+            {
+                const u16 texture = pool.assigned[graph.targets[j].physical];
+
+                attachments[count++] = pool.textures[texture].handle;
+            }
+        }
+
+        const bgfx::FrameBufferHandle framebuffer = acquire_framebuffer(
+            pool, attachments, count, frame
+        );
+
+        if (pass.framebuffer.idx != framebuffer.idx)
+        {
+            pass.framebuffer  = framebuffer;
+            pass.dirty_flags |= Pass::DIRTY_FRAMEBUFFER;
+        }
+    }
+
+    // The graph passes get permuted among the view slots they occupy, other
+    // views stay in place.
+    bgfx::ViewId order[MAX_GRAPH_PASSES];
+    bgfx::ViewId slots[MAX_GRAPH_PASSES];
+
+    for (u32 i = 0; i < passes.passes.size; i++)
+    {
+        order[i] = bgfx::ViewId(i);
+    }
+
+    for (u32 i = 0; i < graph.order_count; i++)
+    {
+        slots[i] = graph.passes[graph.order[i]].pass;
+    }
+
+    std::sort(slots, slots + graph.order_count);
+
+    for (u32 i = 0; i < graph.order_count; i++)
+    {
+        order[slots[i]] = graph.passes[graph.order[i]].pass;
+    }
+
+    bgfx::setViewOrder(0, u16(passes.passes.size), order);
+
+    // Resources unused for a few frames are given back.
+    for (u32 i = 0; i < pool.framebuffers.size; i++)
+    {
+        GraphFramebuffer& framebuffer = pool.framebuffers[i];
+
+        if (bgfx::isValid(framebuffer.handle) && framebuffer.frame + 2 < frame)
+        {
+            release(release_queue, ReleaseType::FRAMEBUFFER, framebuffer.handle.idx);
+
+            framebuffer = {};
+        }
+    }
+
+    for (u32 i = 0; i < pool.textures.size; i++)
+    {
+        GraphTexture& texture = pool.textures[i];
+
+        if (bgfx::isValid(texture.handle) && texture.frame + 2 < frame)
+        {
+            release(release_queue, ReleaseType::TEXTURE, texture.handle.idx);
+
+            texture = {};
+        }
+    }
+}
+
+// Called after `bgfx::frame`. The graph has to be declared again each frame.
+void end_frame(RenderGraph& graph, PassCache& passes)
+{
+    if (!graph.pass_count)
+    {
+        return;
+    }
+
+    for (u32 i = 0; i < graph.pass_count; i++)
+    {
+        const GraphPass& graph_pass = graph.passes[i];
+        Pass&            pass       = passes.passes[graph_pass.pass];
+
+        pass.graph_culled = false;
+
+        if (graph.compiled && !graph_pass.culled && graph_pass.writes)
+        {
+            pass.framebuffer  = BGFX_INVALID_HANDLE;
+            pass.dirty_flags |= Pass::DIRTY_FRAMEBUFFER;
+        }
+    }
+
+    if (graph.compiled)
+    {
+        bgfx::setViewOrder();
+    }
+
+    reset(graph);
+}
+
+
+// -----------------------------------------------------------------------------
+// CACHED LAYERS
+// -----------------------------------------------------------------------------
+
+// Offscreen targets whose content persists across frames, and is only redrawn
+// after the layer was invalidated or resized. The content is rendered in the
+// pass that's active when the layer is begun, with its framebuffer pointed to
+// the layer's target; submissions into clean layers are dropped the same way
+// as the ones into passes culled by the render graph.
+
+constexpr u32 MAX_LAYERS = 64;
+
+struct Layer
+{
+    bgfx::FrameBufferHandle framebuffer = BGFX_INVALID_HANDLE;
+    Texture                 texture; // Color attachment, sampled by `layer`.
+    bgfx::ViewId            pass        = 0;
+    bool                    invalid     = true;
+};
+
+struct LayerCache
+{
+    FixedArray<Layer, MAX_LAYERS> layers;
+    u16                           active  = U16_MAX; // Only one layer at a time.
+    bool                          skipped = false;   // Submissions into active layer dropped.
+};
+
+void deinit(LayerCache& cache)
+{
+    for (u32 i = 0; i < cache.layers.size; i++)
+    {
+        destroy_if_valid(cache.layers[i].framebuffer);
+    }
+}
+
+// Recreates the layer's target if it doesn't match the requested size, and
+// returns `true` if the content has to be (re)drawn.
+bool update_layer(Layer& layer, ReleaseQueue& release_queue, u16 width, u16 height)
+{
+    if (bgfx::isValid(layer.framebuffer) &&
+        layer.texture.width  == width    &&
+        layer.texture.height == height)
+    {
+        return layer.invalid;
+    }
+
+    release(release_queue, ReleaseType::FRAMEBUFFER, layer.framebuffer.idx);
+
+    bgfx::TextureHandle textures[] =
+    {
+        bgfx::createTexture2D(
+            width, height, false, 1, bgfx::TextureFormat::RGBA8,
+            BGFX_TEXTURE_RT | BGFX_SAMPLER_UVW_CLAMP
+        ),
+        bgfx::createTexture2D(
+            width, height, false, 1, bgfx::TextureFormat::D24S8,
+            BGFX_TEXTURE_RT_WRITE_ONLY
+        ),
+    };
+
+    layer.framebuffer    = bgfx::createFrameBuffer(BX_COUNTOF(textures), textures, true);
+    layer.texture.handle = textures[0];
+    layer.texture.width  = width;
+    layer.texture.height = height;
+    layer.texture.format = bgfx::TextureFormat::RGBA8;
+    layer.invalid        = true;
+
+    WARN(bgfx::isValid(layer.framebuffer), "Failed to create layer target.");
+
+    return true;
+}
+
+// Points the pass to the layer's target, and returns `true` if the content has
+// to be (re)drawn. Otherwise the submissions into the pass get dropped until
+// `end_layer`.
+bool begin_layer
+(
+    LayerCache&   cache,
+    PassCache&    passes,
+    bgfx::ViewId  pass_id,
+    u16           id,
+    ReleaseQueue& release_queue,
+    u16           width,
+    u16           height
+)
+{
+    Layer& layer = cache.layers[id];
+    Pass&  pass  = passes.passes[pass_id];
+
+    const bool redraw = update_layer(layer, release_queue, width, height);
+
+    if (pass.framebuffer.idx != layer.framebuffer.idx)
+    {
+        pass.framebuffer  = layer.framebuffer;
+        pass.dirty_flags |= Pass::DIRTY_FRAMEBUFFER;
+    }
+
+    layer.pass    = pass_id;
+    layer.invalid = false;
+
+    cache.active  = id;
+    cache.skipped = !redraw && !pass.graph_culled;
+
+    if (cache.skipped)
+    {
+        pass.graph_culled = true;
+    }
+    else
+    {
+        // NOTE : Makes sure the target gets cleared even if it stays empty.
+        pass.dirty_flags |= Pass::DIRTY_TOUCH;
+    }
+
+    return redraw;
+}
+
+void end_layer(LayerCache& cache, PassCache& passes)
+{
+    if (cache.skipped)
+    {
+        Pass& pass = passes.passes[cache.layers[cache.active].pass];
+
+        // NOTE : Touching the pass would clear the persistent target, so the
+        //        touches (from `pass` calls or the end of the frame) have to be
+        //        suppressed for the rest of the frame.
+        pass.graph_culled  = false;
+        pass.keep_content  = true;
+        pass.dirty_flags  &= ~Pass::DIRTY_TOUCH;
+    }
+
+    cache.active  = U16_MAX;
+    cache.skipped = false;
+}
+
+void remove_layer(Layer& layer, ReleaseQueue& release_queue)
+{
+    release(release_queue, ReleaseType::FRAMEBUFFER, layer.framebuffer.idx);
+
+    layer = {};
+}
+
+
+// -----------------------------------------------------------------------------
+// DRAW STATE & SUBMISSION
+// -----------------------------------------------------------------------------
+
+static_assert(
+    BGFX_STATE_DEFAULT == (BGFX_STATE_WRITE_RGB       |
+                           BGFX_STATE_WRITE_A         |
+                           BGFX_STATE_WRITE_Z         |
+                           BGFX_STATE_DEPTH_TEST_LESS |
+                           BGFX_STATE_CULL_CW         |
+                           BGFX_STATE_MSAA            ) &&
+
+    STATE_DEFAULT      == (STATE_WRITE_RGB            |
+                           STATE_WRITE_A              |
+                           STATE_WRITE_Z              |
+                           STATE_DEPTH_TEST_LESS      |
+                           STATE_CULL_CW              |
+                           STATE_MSAA                 ) ,
+
+    "BGFX and MiNiMo default draw states don't match."
+);
+
+struct DrawState
+{
+    const InstanceData*        instances       = nullptr;
+    u32                        element_start   = 0;
+    u32                        element_count   = U32_MAX;
+    bgfx::ViewId               pass            = U16_MAX;
+    bgfx::FrameBufferHandle    framebuffer     = BGFX_INVALID_HANDLE;
+    bgfx::ProgramHandle        program         = BGFX_INVALID_HANDLE;
+    bgfx::TextureHandle        texture         = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle        sampler         = BGFX_INVALID_HANDLE;
+    u16                        texture_size[2] = {};
+    bgfx::VertexLayoutHandle   vertex_alias    = BGFX_INVALID_HANDLE;
+    bgfx::OcclusionQueryHandle condition       = BGFX_INVALID_HANDLE;
+    u32                        depth           = 0;
+    u16                        occlusion_query = U16_MAX;
+    u16                        scissor[4]      = {};
+    u16                        flags           = STATE_DEFAULT;
+    bool                       has_scissor     = false;
+    bool                       encoder_state   = false; // Uniforms set directly on the encoder, or scissor.
+    bool                       has_uniforms    = false; // User uniforms set directly on the encoder.
+};
+
+// Mirror of the draw state left in the encoder by the previous submission. Mesh
+// submissions preserve their state (`BGFX_DISCARD_NONE`), so that values that
+// didn't change don't have to be sent again. Any submission with another
+// discard mask (or an explicit `encoder.discard()`) must be followed by
+// `discard(shadow)`, otherwise the shadow claims bindings the encoder dropped.
+//
+// NOTE : Uniforms aren't shadowed, since BGFX applies them per draw call in the
+//        sorted order, so a skipped value would be taken from whatever draw
+//        call (possibly from another thread) happens to precede it.
+struct EncoderShadow
+{
+    Mat4                transform;                               // Value at `transform_cache` index.
+    u64                 state            = U64_MAX;
+    u32                 transform_cache  = U32_MAX;              // Valid till the end of the frame.
+    bgfx::TextureHandle texture          = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle sampler          = BGFX_INVALID_HANDLE;
+    bool                has_transform    = false;
+    bool                has_attribs      = false;
+    bool                has_index_buffer = false;
+    bool                has_instances    = false;
+    bool                has_scissor      = false;
+    bool                has_condition    = false;
+};
+
+// Called after the encoder's state was cleared, either explicitly or by a
+// non-preserving submission.
+void discard(EncoderShadow& shadow)
+{
+    const Mat4 transform       = shadow.transform;
+    const u32  transform_cache = shadow.transform_cache;
+
+    shadow = {};
+
+    shadow.transform       = transform;
+    shadow.transform_cache = transform_cache;
+}
+
+u64 translate_draw_state_flags(u16 flags)
+{
+    if (flags == STATE_DEFAULT)
+    {
+        return BGFX_STATE_DEFAULT;
+    }
+
+    constexpr u32 BLEND_STATE_MASK       = STATE_BLEND_ADD | STATE_BLEND_ALPHA | STATE_BLEND_MAX | STATE_BLEND_MIN;
+    constexpr u32 BLEND_STATE_SHIFT      = 0;
+
+    constexpr u32 CULL_STATE_MASK        = STATE_CULL_CCW | STATE_CULL_CW;
+    constexpr u32 CULL_STATE_SHIFT       = 4;
+
+    constexpr u32 DEPTH_TEST_STATE_MASK  = STATE_DEPTH_TEST_GEQUAL | STATE_DEPTH_TEST_GREATER | STATE_DEPTH_TEST_LEQUAL | STATE_DEPTH_TEST_LESS;
+    constexpr u32 DEPTH_TEST_STATE_SHIFT = 6;
+
+    constexpr u64 blend_table[] =
+    {
+        0,
+        BGFX_STATE_BLEND_ADD,
+        BGFX_STATE_BLEND_ALPHA,
+        BGFX_STATE_BLEND_LIGHTEN,
+        BGFX_STATE_BLEND_DARKEN,
+    };
+
+    constexpr u64 cull_table[] =
+    {
+        0,
+        BGFX_STATE_CULL_CCW,
+        BGFX_STATE_CULL_CW,
+    };
+
+    constexpr u64 depth_test_table[] =
+    {
+        0,
+        BGFX_STATE_DEPTH_TEST_GEQUAL,
+        BGFX_STATE_DEPTH_TEST_GREATER,
+        BGFX_STATE_DEPTH_TEST_LEQUAL,
+        BGFX_STATE_DEPTH_TEST_LESS,
+    };
+
+    // TODO : Remove the conditions from `STATE_MSAA` and onward.
+    return
+        blend_table     [(flags & BLEND_STATE_MASK     ) >> BLEND_STATE_SHIFT         ] |
+        cull_table      [(flags & CULL_STATE_MASK      ) >> CULL_STATE_SHIFT          ] |
+        depth_test_table[(flags & DEPTH_TEST_STATE_MASK) >> DEPTH_TEST_STATE_SHIFT    ] |
+        (                (flags & STATE_MSAA           ) ?  BGFX_STATE_MSAA        : 0) |
+        (                (flags & STATE_WRITE_A        ) ?  BGFX_STATE_WRITE_A     : 0) |
+        (                (flags & STATE_WRITE_RGB      ) ?  BGFX_STATE_WRITE_RGB   : 0) |
+        (                (flags & STATE_WRITE_Z        ) ?  BGFX_STATE_WRITE_Z     : 0) ;
+}
+
+u64 translate_draw_state_flags(u16 flags, u32 mesh_flags)
+{
+    constexpr u64 primitive_flags[] =
+    {
+        0, // Triangles.
+        0, // Quads (for users, triangles internally).
+        BGFX_STATE_PT_TRISTRIP,
+        BGFX_STATE_PT_LINES,
+        BGFX_STATE_PT_LINESTRIP,
+        BGFX_STATE_PT_POINTS,
+    };
+
+    return translate_draw_state_flags(flags) |
+        primitive_flags[(mesh_flags & PRIMITIVE_TYPE_MASK) >> PRIMITIVE_TYPE_SHIFT];
+}
+
+void texture_size_uniform_data(const u16 (&texture_size)[2], f32 (&data)[4])
+{
+    data[0] = f32(texture_size[0]);
+    data[1] = f32(texture_size[1]);
+    data[2] = texture_size[0] ? 1.0f / f32(texture_size[0]) : 0.0f;
+    data[3] = texture_size[1] ? 1.0f / f32(texture_size[1]) : 0.0f;
+}
+
+void set_mesh_buffers
+(
+    const Mesh&                              mesh,
+    u32                                      element_start,
+    u32                                      element_count,
+    bgfx::VertexLayoutHandle                 vertex_alias,
+    const Span<bgfx::TransientVertexBuffer>& transient_buffers,
+    bgfx::Encoder&                           encoder
+)
+{
+    const u16  type        = mesh_type(mesh.flags);
+    const bool has_attribs = has_attrib_stream(mesh.flags);
+
+    // NOTE : Interleaved meshes have the aliased attributes in the only stream.
+    const bgfx::VertexLayoutHandle position_alias = (mesh.flags & VERTEX_INTERLEAVED)
+        ? vertex_alias
+        : bgfx::VertexLayoutHandle(BGFX_INVALID_HANDLE);
+
+    if (type == MESH_STATIC)
+    {
+                         encoder.setVertexBuffer(0, mesh.positions.static_buffer, 0, U32_MAX, position_alias);
+        if (has_attribs) encoder.setVertexBuffer(1, mesh.attribs  .static_buffer, 0, U32_MAX, vertex_alias);
+                         encoder.setIndexBuffer (   mesh.indices  .static_buffer, element_start, element_count);
+    }
+    else if (type == MESH_TRANSIENT)
+    {
+                         encoder.setVertexBuffer(0, &transient_buffers[mesh.positions.transient_index], element_start, element_count);
+        if (has_attribs) encoder.setVertexBuffer(1, &transient_buffers[mesh.attribs  .transient_index], element_start, element_count, vertex_alias);
+    }
+    else if (type == MESH_DYNAMIC)
+    {
+                         encoder.setVertexBuffer(0, mesh.positions.static_buffer, 0, U32_MAX, position_alias);
+        if (has_attribs) encoder.setVertexBuffer(1, mesh.attribs  .static_buffer, 0, U32_MAX, vertex_alias);
+                         encoder.setIndexBuffer (   mesh.indices  .static_buffer, element_start, element_count);
+    }
+}
+
+void submit_mesh
+(
+    const Mesh&                              mesh,
+    const Mat4&                              transform,
+    const DrawState&                         state,
+    const Span<bgfx::TransientVertexBuffer>& transient_buffers,
+    const DefaultUniforms&                   default_uniforms,
+    EncoderShadow&                           shadow,
+    bgfx::Encoder&                           encoder
+)
+{
+    const bool has_attribs      = has_attrib_stream(mesh.flags);
+    const bool has_index_buffer = mesh_type(mesh.flags) != MESH_TRANSIENT;
+    const bool has_instances    = state.instances != nullptr;
+    const bool has_condition    = bgfx::isValid(state.condition);
+
+    // Index and instance buffers, and occlusion conditions can't be unset
+    // individually.
+    if ((shadow.has_index_buffer && !has_index_buffer) ||
+        (shadow.has_instances    && !has_instances   ) ||
+        (shadow.has_condition    && !has_condition   )
+    )
+    {
+        encoder.discard();
+        discard(shadow);
+    }
+
+    set_mesh_buffers(
+        mesh,
+        state.element_start,
+        state.element_count,
+        state.vertex_alias,
+        transient_buffers,
+        encoder
+    );
+
+    if (shadow.has_attribs && !has_attribs)
+    {
+        const bgfx::VertexBufferHandle invalid_buffer = BGFX_INVALID_HANDLE;
+
+        encoder.setVertexBuffer(1, invalid_buffer);
+    }
+
+    if (has_instances)
+    {
+        encoder.setInstanceDataBuffer(&state.instances->buffer);
+    }
+
+    shadow.has_attribs      = has_attribs;
+    shadow.has_index_buffer = has_index_buffer;
+    shadow.has_instances    = has_instances;
+
+    if (has_condition)
+    {
+        encoder.setCondition(state.condition, true);
+    }
+
+    shadow.has_condition = has_condition;
+
+    if (bgfx::isValid(state.texture) && bgfx::isValid(state.sampler) && (
+        state.texture.idx != shadow.texture.idx ||
+        state.sampler.idx != shadow.sampler.idx)
+    )
+    {
+        encoder.setTexture(0, state.sampler, state.texture);
+
+        shadow.texture = state.texture;
+        shadow.sampler = state.sampler;
+    }
+
+    if (state.has_scissor)
+    {
+        encoder.setScissor(state.scissor[0], state.scissor[1], state.scissor[2], state.scissor[3]);
+    }
+    else if (shadow.has_scissor)
+    {
+        encoder.setScissor(U16_MAX);
+    }
+
+    shadow.has_scissor = state.has_scissor;
+
+    if (mesh.flags & VERTEX_PIXCOORD)
+    {
+        f32 data[4];
+        texture_size_uniform_data(state.texture_size, data);
+
+        encoder.setUniform(default_uniforms[u32(DefaultUniform::TEXTURE_SIZE)], data);
+    }
+
+    if (shadow.transform_cache == U32_MAX ||
+        bx::memCmp(&transform, &shadow.transform, sizeof(Mat4)) != 0
+    )
+    {
+        bgfx::Transform cache;
+        shadow.transform_cache = encoder.allocTransform(&cache, 1);
+        shadow.transform       = transform;
+
+        bx::memCopy(cache.data, &transform, sizeof(Mat4));
+
+        encoder.setTransform(shadow.transform_cache);
+    }
+    else if (!shadow.has_transform)
+    {
+        encoder.setTransform(shadow.transform_cache);
+    }
+
+    shadow.has_transform = true;
+
+    const u64 flags = translate_draw_state_flags(state.flags, mesh.flags);
+
+    if (flags != shadow.state)
+    {
+        encoder.setState(flags);
+
+        shadow.state = flags;
+    }
+
+    ASSERT(bgfx::isValid(state.program), "Invalid draw state program.");
+    encoder.submit(state.pass, state.program, state.depth, BGFX_DISCARD_NONE);
+}
+
+// Submits the mesh into another pass, reusing the encoder state preserved by
+// the immediately preceding `submit_mesh` call with the same arguments.
+void resubmit_mesh
+(
+    const Mesh&            mesh,
+    const DrawState&       state,
+    bgfx::ViewId           pass,
+    u32                    depth,
+    const DefaultUniforms& default_uniforms,
+    bgfx::Encoder&         encoder
+)
+{
+    ASSERT(!state.has_uniforms, "User uniforms can't be resubmitted.");
+
+    // NOTE : Uniforms aren't part of the preserved draw state.
+    if (mesh.flags & VERTEX_PIXCOORD)
+    {
+        f32 data[4];
+        texture_size_uniform_data(state.texture_size, data);
+
+        encoder.setUniform(default_uniforms[u32(DefaultUniform::TEXTURE_SIZE)], data);
+    }
+
+    encoder.submit(pass, state.program, depth, BGFX_DISCARD_NONE);
+}
+
+// Sort key from the view-space distance of the mesh's bounding box center.
+u32 depth_key(const Mesh& mesh, const Mat4& model, const Mat4& view)
+{
+    const Vec3 center   = (mesh.bounds_min + mesh.bounds_max) * 0.5f;
+    const Vec4 position = view * (model * HMM_Vec4v(center, 1.0f));
+
+    // View space is right-handed (camera looks down the negative Z axis). Bit
+    // pattern of non-negative floats has the same ordering as their values.
+    const f32 distance = bx::max(-position.Z, 0.0f);
+
+    u32 key;
+    bx::memCopy(&key, &distance, sizeof(key));
+
+    return key;
+}
+
+
+// -----------------------------------------------------------------------------
+// AUTOMATIC INSTANCING
+// -----------------------------------------------------------------------------
+
+// Everything that has to match for two submissions to end up in the same
+// instanced draw call. Only 16-bit members, so there's no padding and the keys
+// can be compared bytewise.
+struct InstancingKey
+{
+    Handle                   mesh;               // Mesh can be destroyed before the flush.
+    bgfx::ViewId             pass;
+    bgfx::ProgramHandle      program;            // Instancing variant.
+    bgfx::ProgramHandle      sequential_program; // Used if instance memory runs out.
+    bgfx::TextureHandle      texture;
+    bgfx::UniformHandle      sampler;
+    u16                      texture_size[2];
+    bgfx::VertexLayoutHandle vertex_alias;
+    u16                      flags;
+};
+
+struct InstancingDraw
+{
+    Mat4          transform;
+    InstancingKey key;
+};
+
+// Range of (sorted) draws with the same key.
+struct InstancingBatch
+{
+    u32 first;
+    u32 last;
+};
+
+struct InstancingBatcher
+{
+    DynamicArray<InstancingDraw>  draws;
+    DynamicArray<InstancingBatch> batches;
+};
+
+void init(InstancingBatcher& batcher, Allocator* allocator)
+{
+    init(batcher.draws  , allocator);
+    init(batcher.batches, allocator);
+}
+
+void deinit(InstancingBatcher& batcher)
+{
+    deinit(batcher.draws  );
+    deinit(batcher.batches);
+}
+
+void add_draw
+(
+    InstancingBatcher&  batcher,
+    Handle              mesh,
+    const Mat4&         transform,
+    const DrawState&    state,
+    bgfx::ProgramHandle instancing_program
+)
+{
+    InstancingDraw draw;
+    draw.transform              = transform;
+    draw.key.mesh               = mesh;
+    draw.key.pass               = state.pass;
+    draw.key.program            = instancing_program;
+    draw.key.sequential_program = state.program;
+    draw.key.texture            = state.texture;
+    draw.key.sampler            = state.sampler;
+    draw.key.texture_size[0]    = state.texture_size[0];
+    draw.key.texture_size[1]    = state.texture_size[1];
+    draw.key.vertex_alias       = state.vertex_alias;
+    draw.key.flags              = state.flags;
+
+    append(batcher.draws, draw);
+}
+
+// Sorts the deferred draws by their keys and groups them into batches. Returns
+// the number of the batches.
+u32 prepare(InstancingBatcher& batcher)
+{
+    const auto less = [](const InstancingDraw& lhs, const InstancingDraw& rhs)
+    {
+        return bx::memCmp(&lhs.key, &rhs.key, sizeof(InstancingKey)) < 0;
+    };
+
+    std::stable_sort(batcher.draws.data, batcher.draws.data + batcher.draws.size, less);
+
+    resize(batcher.batches, 0);
+
+    for (u32 first = 0, last = 0; first < batcher.draws.size; first = last)
+    {
+        const InstancingKey& key = batcher.draws[first].key;
+
+        for (last = first + 1; last < batcher.draws.size; last++)
+        {
+            if (bx::memCmp(&key, &batcher.draws[last].key, sizeof(InstancingKey)) != 0)
+            {
+                break;
+            }
+        }
+
+        append(batcher.batches, { first, last });
+    }
+
+    return batcher.batches.size;
+}
+
+// Submits all deferred draws, one instanced draw call per unique key, and
+// returns the number of the draw calls. Order of the submissions within a
+// single batch is not preserved.
+u32 flush
+(
+    InstancingBatcher&     batcher,
+    MeshCache&             mesh_cache,
+    InstanceCache&         instance_cache,
+    const DefaultUniforms& default_uniforms,
+    EncoderShadow&         shadow,
+    bgfx::Encoder&         encoder
+)
+{
+    if (!batcher.draws.size)
+    {
+        return 0;
+    }
+
+    prepare(batcher);
+
+    constexpr u16  stride   = sizeof(Mat4);
+    const     Mat4 identity = HMM_Mat4d(1.0f);
+
+    u32 draw_count = 0;
+
+    for (u32 i = 0; i < batcher.batches.size; i++)
+    {
+        const u32            first = batcher.batches[i].first;
+        const u32            last  = batcher.batches[i].last;
+        const u32            count = last - first;
+        const InstancingKey& key   = batcher.draws[first].key;
+
+        Mesh mesh;
+        {
+            MutexScope lock(mesh_cache.mutex);
+
+            if (is_current(mesh_cache.meshes, key.mesh))
+            {
+                mesh = mesh_cache.meshes[key.mesh.id];
+            }
+        }
+
+        // NOTE : Mesh destroyed (or recreated) after the draws were deferred.
+        if (!is_valid(mesh))
+        {
+            continue;
+        }
+
+        DrawState state;
+        state.pass            = key.pass;
+        state.texture         = key.texture;
+        state.sampler         = key.sampler;
+        state.texture_size[0] = key.texture_size[0];
+        state.texture_size[1] = key.texture_size[1];
+        state.vertex_alias    = key.vertex_alias;
+        state.flags           = key.flags;
+
+        InstanceData instances;
+        instances.is_transform = true;
+
+        {
+            // NOTE : See `add_instances` regarding the mutex.
+            MutexScope lock(instance_cache.mutex);
+
+            if (count > 1 && bgfx::getAvailInstanceDataBuffer(count, stride) == count)
+            {
+                bgfx::allocInstanceDataBuffer(&instances.buffer, count, stride);
+            }
+        }
+
+        if (instances.buffer.data)
+        {
+            for (u32 j = 0; j < count; j++)
+            {
+                bx::memCopy(instances.buffer.data + j * stride, &batcher.draws[first + j].transform, stride);
+            }
+
+            state.program   = key.program;
+            state.instances = &instances;
+
+            submit_mesh(mesh, identity, state, mesh_cache.transient_buffers, default_uniforms, shadow, encoder);
+
+            draw_count++;
+        }
+        else
+        {
+            WARN(count > 1, "Instance buffer memory exhausted, submitting sequentially.");
+
+            state.program = key.sequential_program;
+
+            for (u32 j = first; j < last; j++)
+            {
+                submit_mesh(mesh, batcher.draws[j].transform, state, mesh_cache.transient_buffers, default_uniforms, shadow, encoder);
+            }
+
+            draw_count += count;
+        }
+    }
+
+    resize(batcher.draws  , 0);
+    resize(batcher.batches, 0);
+
+    return draw_count;
+}
+
+
+// -----------------------------------------------------------------------------
+// 2D SHAPE BATCHING
+// -----------------------------------------------------------------------------
+
+// Shapes are tessellated right away (with the current transform baked in) and
+// accumulated per thread. At the end of the frame, they get sorted by pass,
+// layer and texture, and each run of compatible shapes is submitted as a single
+// indexed draw call.
+
+constexpr u32 SHAPE_VERTEX_ATTRIBS     = VERTEX_COLOR | VERTEX_TEXCOORD_F32;
+constexpr u16 SHAPE_DRAW_STATE         = STATE_BLEND_ALPHA | STATE_WRITE_RGB;
+constexpr u32 MAX_SHAPE_DRAW_VERTICES  = U16_MAX + 1; // 16-bit indices.
+constexpr u32 MIN_SHAPE_SEGMENTS       = 8;
+constexpr u32 MAX_SHAPE_SEGMENTS       = 256;
+
+struct ShapeAttribs
+{
+    u32 abgr;
+    f32 uv[2];
+};
+
+// Only 16-bit members, so there's no padding and the keys can be compared
+// bytewise.
+struct ShapeKey
+{
+    bgfx::ViewId             pass;
+    u16                      layer;
+    bgfx::TextureHandle      texture;
+    bgfx::UniformHandle      sampler;
+    bgfx::ProgramHandle      program;
+    bgfx::VertexLayoutHandle vertex_alias; // Untextured shapes skip the UVs.
+};
+
+// Consecutively added shapes with the same key. Indices are relative to the
+// run's first vertex.
+struct ShapeRun
+{
+    ShapeKey key;
+    u32      first_vertex;
+    u32      vertex_count;
+    u32      first_index;
+    u32      index_count;
+};
+
+// Range of (sorted) runs submitted with one draw call.
+struct ShapeDraw
+{
+    u32 first_run;
+    u32 last_run;
+    u32 vertex_count;
+    u32 index_count;
+};
+
+struct ShapeBatcher
+{
+    DynamicArray<Vec3>         positions;
+    DynamicArray<ShapeAttribs> attribs;
+    DynamicArray<u16>          indices;
+    DynamicArray<ShapeRun>     runs;
+    DynamicArray<ShapeDraw>    draws;
+};
+
+void init(ShapeBatcher& batcher, Allocator* allocator)
+{
+    init(batcher.positions, allocator);
+    init(batcher.attribs  , allocator);
+    init(batcher.indices  , allocator);
+    init(batcher.runs     , allocator);
+    init(batcher.draws    , allocator);
+}
+
+void deinit(ShapeBatcher& batcher)
+{
+    deinit(batcher.positions);
+    deinit(batcher.attribs  );
+    deinit(batcher.indices  );
+    deinit(batcher.runs     );
+    deinit(batcher.draws    );
+}
+
+// Keeps the allocated memory for the next frame.
+void reset(ShapeBatcher& batcher)
+{
+    resize(batcher.positions, 0);
+    resize(batcher.attribs  , 0);
+    resize(batcher.indices  , 0);
+    resize(batcher.runs     , 0);
+    resize(batcher.draws    , 0);
+}
+
+// Segment count of a full circle, so that the tessellation doesn't deviate
+// more than a quarter of a unit (pixel, with the usual 2D projections) from the
+// ideal shape. Always a multiple of four, so it can be split into corners.
+u32 shape_segments(f32 radius)
+{
+    constexpr f32 tolerance = 0.25f;
+
+    u32 count = MIN_SHAPE_SEGMENTS;
+
+    if (radius > tolerance)
+    {
+        count = u32(ceilf(HMM_PI32 / acosf(1.0f - tolerance / radius)));
+    }
+
+    return bx::clamp((count + 3u) & ~3u, MIN_SHAPE_SEGMENTS, MAX_SHAPE_SEGMENTS);
+}
+
+// Largest scale of the transform's X and Y axes.
+f32 shape_scale(const Mat4& transform)
+{
+    const f32 x = HMM_LengthSquaredVec3(HMM_Vec3(
+        transform.Elements[0][0],
+        transform.Elements[0][1],
+        transform.Elements[0][2]
+    ));
+
+    const f32 y = HMM_LengthSquaredVec3(HMM_Vec3(
+        transform.Elements[1][0],
+        transform.Elements[1][1],
+        transform.Elements[1][2]
+    ));
+
+    return sqrtf(bx::max(x, y));
+}
+
+Vec3 transform_2d(const Mat4& transform, f32 x, f32 y)
+{
+    const f32 (&m)[4][4] = transform.Elements;
+
+    return HMM_Vec3(
+        m[0][0] * x + m[1][0] * y + m[3][0],
+        m[0][1] * x + m[1][1] * y + m[3][1],
+        m[0][2] * x + m[1][2] * y + m[3][2]
+    );
+}
+
+// Reserves space for the shape's geometry and returns the index of its first
+// vertex relative to its run.
+u32 add_shape(ShapeBatcher& batcher, const ShapeKey& key, u32 vertex_count, u32 index_count)
+{
+    ASSERT(
+        vertex_count <= MAX_SHAPE_DRAW_VERTICES,
+        "Too many shape vertices %" PRIu32 ".",
+        vertex_count
+    );
+
+    ShapeRun* run = batcher.runs.size ? &batcher.runs[batcher.runs.size - 1] : nullptr;
+
+    if (!run ||
+        run->vertex_count + vertex_count > MAX_SHAPE_DRAW_VERTICES ||
+        bx::memCmp(&run->key, &key, sizeof(ShapeKey)) != 0
+    )
+    {
+        ShapeRun new_run;
+        new_run.key          = key;
+        new_run.first_vertex = batcher.positions.size;
+        new_run.vertex_count = 0;
+        new_run.first_index  = batcher.indices.size;
+        new_run.index_count  = 0;
+
+        run = &append(batcher.runs, new_run);
+    }
+
+    const u32 base = run->vertex_count;
+
+    run->vertex_count += vertex_count;
+    run->index_count  += index_count;
+
+    resize(batcher.positions, batcher.positions.size + vertex_count);
+    resize(batcher.attribs  , batcher.attribs  .size + vertex_count);
+    resize(batcher.indices  , batcher.indices  .size + index_count );
+
+    return base;
+}
+
+void add_quad
+(
+    ShapeBatcher&   batcher,
+    const ShapeKey& key,
+    const Mat4&     transform,
+    f32             x0,
+    f32             y0,
+    f32             x1,
+    f32             y1,
+    f32             u0,
+    f32             v0,
+    f32             u1,
+    f32             v1,
+    u32             abgr
+)
+{
+    const u32 base = add_shape(batcher, key, 4, 6);
+
+    Vec3*         positions = batcher.positions.data + batcher.positions.size - 4;
+    ShapeAttribs* attribs   = batcher.attribs  .data + batcher.attribs  .size - 4;
+    u16*          indices   = batcher.indices  .data + batcher.indices  .size - 6;
+
+    positions[0] = transform_2d(transform, x0, y0);
+    positions[1] = transform_2d(transform, x1, y0);
+    positions[2] = transform_2d(transform, x1, y1);
+    positions[3] = transform_2d(transform, x0, y1);
+
+    attribs[0] = { abgr, { u0, v0 } };
+    attribs[1] = { abgr, { u1, v0 } };
+    attribs[2] = { abgr, { u1, v1 } };
+    attribs[3] = { abgr, { u0, v1 } };
+
+    const u16 indices_[] = { 0, 1, 2, 0, 2, 3 };
+
+    for (u32 i = 0; i < BX_COUNTOF(indices_); i++)
+    {
+        indices[i] = u16(base + indices_[i]);
+    }
+}
+
+// Rectangle with circular corners, tessellated as a triangle fan around its
+// center. Circles are rounded rectangles with the radius of half their size.
+void add_rounded_rect
+(
+    ShapeBatcher&   batcher,
+    const ShapeKey& key,
+    const Mat4&     transform,
+    f32             x,
+    f32             y,
+    f32             width,
+    f32             height,
+    f32             radius,
+    u32             abgr
+)
+{
+    const u32 segments      = shape_segments(radius * shape_scale(transform));
+    const u32 corner_points = segments / 4 + 1;
+    const u32 point_count   = corner_points * 4;
+    const u32 base          = add_shape(batcher, key, point_count + 1, point_count * 3);
+
+    Vec3*         positions = batcher.positions.data + batcher.positions.size - point_count - 1;
+    ShapeAttribs* attribs   = batcher.attribs  .data + batcher.attribs  .size - point_count - 1;
+    u16*          indices   = batcher.indices  .data + batcher.indices  .size - point_count * 3;
+
+    ASSERT(
+        radius >= 0.0f && radius * 2.0f <= bx::min(width, height),
+        "Invalid corner radius %f.",
+        radius
+    );
+
+    // Extents of the rectangle spanned by the corner centers.
+    const f32 half_width  = width  * 0.5f - radius;
+    const f32 half_height = height * 0.5f - radius;
+    const f32 center_x    = x + width  * 0.5f;
+    const f32 center_y    = y + height * 0.5f;
+
+    positions[0] = transform_2d(transform, center_x, center_y);
+    attribs  [0] = { abgr, { 0.5f, 0.5f } };
+
+    // Unit vector rotated by a constant step, avoiding per-vertex `sin` and
+    // `cos` calls.
+    const f32 step_cos = cosf(HMM_PI32 * 2.0f / f32(segments));
+    const f32 step_sin = sinf(HMM_PI32 * 2.0f / f32(segments));
+
+    f32 dir_x = 1.0f;
+    f32 dir_y = 0.0f;
+
+    constexpr f32 corner_signs[4][2] = { { 1, 1 }, { -1, 1 }, { -1, -1 }, { 1, -1 } };
+
+    const f32 inv_width  = width  > 0.0f ? 1.0f / width  : 0.0f;
+    const f32 inv_height = height > 0.0f ? 1.0f / height : 0.0f;
+
+    for (u32 corner = 0, i = 1; corner < 4; corner++)
+    {
+        const f32 corner_x = center_x + corner_signs[corner][0] * half_width;
+        const f32 corner_y = center_y + corner_signs[corner][1] * half_height;
+
+        for (u32 j = 0; j < corner_points; j++, i++)
+        {
+            const f32 px = corner_x + dir_x * radius;
+            const f32 py = corner_y + dir_y * radius;
+
+            positions[i] = transform_2d(transform, px, py);
+            attribs  [i] = { abgr, { (px - x) * inv_width, (py - y) * inv_height } };
+
+            // Last point of a corner is also the first one of the next one
+            // (offset by the corner position), so the direction isn't advanced.
+            if (j + 1 < corner_points)
+            {
+                const f32 next_x = dir_x * step_cos - dir_y * step_sin;
+                const f32 next_y = dir_x * step_sin + dir_y * step_cos;
+
+                dir_x = next_x;
+                dir_y = next_y;
+            }
+        }
+    }
+
+    for (u32 i = 0; i < point_count; i++)
+    {
+        indices[i * 3 + 0] = u16(base);
+        indices[i * 3 + 1] = u16(base + 1 + i);
+        indices[i * 3 + 2] = u16(base + 1 + (i + 1) % point_count);
+    }
+}
+
+ShapeKey shape_key
+(
+    u16                    pass,
+    u16                    layer,
+    const Texture*         texture,
+    DefaultPrograms&       programs,
+    const DefaultUniforms& uniforms,
+    VertexLayoutCache&     layouts
+)
+{
+    ShapeKey key;
+    key.pass  = pass;
+    key.layer = layer;
+
+    if (texture)
+    {
+        const bgfx::UniformHandle sampler = default_sampler(uniforms, texture->format);
+
+        const u32 attribs = sampler.idx == uniforms[u32(DefaultUniform::COLOR_TEXTURE_RED)].idx
+            ? VERTEX_COLOR | VERTEX_TEXCOORD | SAMPLER_COLOR_R
+            : VERTEX_COLOR | VERTEX_TEXCOORD;
+
+        key.texture      = texture->handle;
+        key.sampler      = sampler;
+        key.program      = default_program(programs, attribs);
+        key.vertex_alias = vertex_layout_handle(layouts, SHAPE_VERTEX_ATTRIBS);
+    }
+    else
+    {
+        key.texture      = BGFX_INVALID_HANDLE;
+        key.sampler      = BGFX_INVALID_HANDLE;
+        key.program      = default_program(programs, VERTEX_COLOR);
+        key.vertex_alias = vertex_layout_handle(layouts, VERTEX_COLOR, VERTEX_TEXCOORD_F32);
+    }
+
+    return key;
+}
+
+// Sorts the runs and groups them into draw calls. Returns the draw count.
+u32 prepare(ShapeBatcher& batcher)
+{
+    // NOTE : Pass and layer have to be compared numerically, the rest of the
+    //        key just has to group the same values together.
+    const auto less = [](const ShapeRun& lhs, const ShapeRun& rhs)
+    {
+        if (lhs.key.pass  != rhs.key.pass ) { return lhs.key.pass  < rhs.key.pass ; }
+        if (lhs.key.layer != rhs.key.layer) { return lhs.key.layer < rhs.key.layer; }
+
+        return bx::memCmp(&lhs.key, &rhs.key, sizeof(ShapeKey)) < 0;
+    };
+
+    std::stable_sort(batcher.runs.data, batcher.runs.data + batcher.runs.size, less);
+
+    resize(batcher.draws, 0);
+
+    for (u32 i = 0; i < batcher.runs.size; i++)
+    {
+        const ShapeRun& run  = batcher.runs[i];
+        ShapeDraw*      draw = batcher.draws.size ? &batcher.draws[batcher.draws.size - 1] : nullptr;
+
+        if (!draw ||
+            draw->vertex_count + run.vertex_count > MAX_SHAPE_DRAW_VERTICES ||
+            bx::memCmp(&batcher.runs[draw->first_run].key, &run.key, sizeof(ShapeKey)) != 0
+        )
+        {
+            draw = &append(batcher.draws, { i, i, 0, 0 });
+        }
+
+        draw->last_run      = i + 1;
+        draw->vertex_count += run.vertex_count;
+        draw->index_count  += run.index_count;
+    }
+
+    return batcher.draws.size;
+}
+
+void flush
+(
+    ShapeBatcher&      batcher,
+    MeshCache&         mesh_cache,
+    VertexLayoutCache& layouts,
+    EncoderShadow&     shadow,
+    bgfx::Encoder&     encoder
+)
+{
+    if (!batcher.runs.size)
+    {
+        return;
+    }
+
+    prepare(batcher);
+
+    const bgfx::VertexLayout& position_layout = vertex_layout(layouts, VERTEX_POSITION);
+    const bgfx::VertexLayout& attribs_layout  = vertex_layout(layouts, SHAPE_VERTEX_ATTRIBS);
+
+    const u64 state = translate_draw_state_flags(SHAPE_DRAW_STATE);
+
+    // NOTE : Shapes don't use (nor preserve) any state of the previous
+    //        submissions.
+    encoder.discard();
+
+    for (u32 i = 0; i < batcher.draws.size; i++)
+    {
+        const ShapeDraw& draw = batcher.draws[i];
+        const ShapeKey&  key  = batcher.runs[draw.first_run].key;
+
+        bgfx::TransientVertexBuffer positions;
+        bgfx::TransientVertexBuffer attribs;
+        bgfx::TransientIndexBuffer  indices;
+
+        bool success;
+        {
+            // NOTE : See `add_mesh` regarding the mutex.
+            MutexScope lock(mesh_cache.mutex);
+
+            success =
+                bgfx::getAvailTransientVertexBuffer(draw.vertex_count, position_layout) == draw.vertex_count &&
+                bgfx::getAvailTransientVertexBuffer(draw.vertex_count, attribs_layout ) == draw.vertex_count &&
+                bgfx::getAvailTransientIndexBuffer (draw.index_count                  ) == draw.index_count  ;
+
+            if (success)
+            {
+                bgfx::allocTransientVertexBuffer(&positions, draw.vertex_count, position_layout);
+                bgfx::allocTransientVertexBuffer(&attribs  , draw.vertex_count, attribs_layout );
+                bgfx::allocTransientIndexBuffer (&indices  , draw.index_count                  );
+            }
+        }
+
+        WARN(
+            success,
+            "Transient memory exhausted, dropping %" PRIu32 " shape draw call(s).",
+            batcher.draws.size - i
+        );
+
+        if (!success)
+        {
+            break;
+        }
+
+        u8*  dst_positions = positions.data;
+        u8*  dst_attribs   = attribs  .data;
+        u16* dst_indices   = reinterpret_cast<u16*>(indices.data);
+        u32  offset        = 0;
+
+        for (u32 j = draw.first_run; j < draw.last_run; j++)
+        {
+            const ShapeRun& run = batcher.runs[j];
+
+            bx::memCopy(dst_positions, &batcher.positions[run.first_vertex], run.vertex_count * sizeof(Vec3        ));
+            bx::memCopy(dst_attribs  , &batcher.attribs  [run.first_vertex], run.vertex_count * sizeof(ShapeAttribs));
+
+            dst_positions += run.vertex_count * sizeof(Vec3        );
+            dst_attribs   += run.vertex_count * sizeof(ShapeAttribs);
+
+            const u16* src_indices = &batcher.indices[run.first_index];
+
+            for (u32 k = 0; k < run.index_count; k++)
+            {
+                *dst_indices++ = u16(src_indices[k] + offset);
+            }
+
+            offset += run.vertex_count;
+        }
+
+        encoder.setVertexBuffer(0, &positions);
+        encoder.setVertexBuffer(1, &attribs, 0, draw.vertex_count, key.vertex_alias);
+        encoder.setIndexBuffer (   &indices);
+
+        if (bgfx::isValid(key.texture))
+        {
+            encoder.setTexture(0, key.sampler, key.texture);
+        }
+
+        encoder.setState(state);
+
+        // NOTE : Each shape draw sets all of its state, so nothing is left
+        //        bound for the following mesh submissions.
+        encoder.submit(key.pass, key.program, key.layer, BGFX_DISCARD_ALL);
+    }
+
+    discard(shadow);
+
+    reset(batcher);
+}
+
+
+// -----------------------------------------------------------------------------
+// POLYLINE TESSELLATION
+// -----------------------------------------------------------------------------
+
+// Thick polylines are tessellated into the shape batcher. Segments, joins and
+// caps are independent pieces with a vertex and index count given only by the
+// flags, so the output location of each piece is known up front, and any range
+// of segments can be tessellated in isolation (e.g., by different tasks). All
+// pieces have an extra transparent fringe along their outline, which gives
+// anti-aliased edges without MSAA.
+//
+// NOTE : Pieces overlap at the inner side of the joins, which is visible with
+//        translucent colors.
+
+constexpr u32 POLYLINE_SEGMENT_VERTICES = 8;
+constexpr u32 POLYLINE_SEGMENT_INDICES  = 18;
+constexpr u32 POLYLINE_MITER_VERTICES   = 7;
+constexpr u32 POLYLINE_MITER_INDICES    = 18;
+constexpr u32 POLYLINE_BUTT_VERTICES    = 8;
+constexpr u32 POLYLINE_BUTT_INDICES     = 18;
+constexpr u32 POLYLINE_SQUARE_VERTICES  = 12;
+constexpr u32 POLYLINE_SQUARE_INDICES   = 36;
+constexpr u32 POLYLINE_TASK_SEGMENTS    = 1024; // Minimum segment count per task.
+constexpr f32 POLYLINE_MITER_LIMIT      = 4.0f; // Miter length to line width ratio.
+
+struct PolylineLayout
+{
+    u32 segment_count      = 0;
+    u32 join_count         = 0;
+    u32 cap_count          = 0;
+    u32 arc_segments       = 0; // Of round joins and caps (half circle at most).
+    u32 join_vertices      = 0;
+    u32 join_indices       = 0;
+    u32 cap_vertices       = 0;
+    u32 cap_indices        = 0;
+    u32 segments_per_chunk = 0; // Each chunk is added to the batcher separately.
+    u32 chunk_count        = 0;
+};
+
+// Output location of the chunk's pieces, laid out as segments, joins and caps.
+struct PolylineChunk
+{
+    u32 first_vertex;
+    u32 first_index;
+    u32 base; // First vertex's index, relative to its run.
+};
+
+struct Polyline
+{
+    PolylineLayout       layout;
+    Mat4                 transform;
+    const Vec2*          points      = nullptr;
+    const Vec2*          directions  = nullptr; // Normalized, one per segment.
+    const PolylineChunk* chunks      = nullptr;
+    Vec3*                positions   = nullptr; // Batcher's arrays.
+    ShapeAttribs*        attribs     = nullptr;
+    u16*                 indices     = nullptr;
+    u32                  point_count = 0;
+    f32                  half_width  = 0.0f;
+    f32                  feather     = 0.0f;    // Width of the transparent fringe.
+    u32                  abgr        = 0;
+    u16                  flags       = 0;
+};
+
+u32 arc_vertex_count(u32 segments)
+{
+    return 1 + (segments + 1) * 2;
+}
+
+u32 arc_index_count(u32 segments)
+{
+    return segments * 9;
+}
+
+PolylineLayout polyline_layout(u32 point_count, u16 flags, u32 arc_segments)
+{
+    ASSERT(point_count >= 2, "Polyline needs at least two points.");
+
+    const bool closed = flags & LINE_CLOSED;
+
+    PolylineLayout layout;
+    layout.segment_count = closed ? point_count : point_count - 1;
+    layout.join_count    = closed ? point_count : point_count - 2;
+    layout.cap_count     = closed ? 0 : 2;
+    layout.arc_segments  = arc_segments;
+
+    if ((flags & LINE_JOIN_MASK) == LINE_JOIN_ROUND)
+    {
+        layout.join_vertices = arc_vertex_count(arc_segments);
+        layout.join_indices  = arc_index_count (arc_segments);
+    }
+    else
+    {
+        layout.join_vertices = POLYLINE_MITER_VERTICES;
+        layout.join_indices  = POLYLINE_MITER_INDICES;
+    }
+
+    switch (flags & LINE_CAP_MASK)
+    {
+    case LINE_CAP_ROUND:
+        layout.cap_vertices = arc_vertex_count(arc_segments);
+        layout.cap_indices  = arc_index_count (arc_segments);
+        break;
+    case LINE_CAP_SQUARE:
+        layout.cap_vertices = POLYLINE_SQUARE_VERTICES;
+        layout.cap_indices  = POLYLINE_SQUARE_INDICES;
+        break;
+    default:
+        layout.cap_vertices = POLYLINE_BUTT_VERTICES;
+        layout.cap_indices  = POLYLINE_BUTT_INDICES;
+    }
+
+    layout.segments_per_chunk =
+        (MAX_SHAPE_DRAW_VERTICES - 2 * layout.cap_vertices) /
+        (POLYLINE_SEGMENT_VERTICES + layout.join_vertices);
+
+    layout.chunk_count =
+        (layout.segment_count + layout.segments_per_chunk - 1) /
+        layout.segments_per_chunk;
+
+    return layout;
+}
+
+struct PolylineChunkSize
+{
+    u32 segment_count;
+    u32 join_count;
+    u32 cap_count;
+    u32 vertex_count;
+    u32 index_count;
+};
+
+PolylineChunkSize chunk_size(const PolylineLayout& layout, u32 chunk)
+{
+    const u32 first = chunk * layout.segments_per_chunk;
+    const u32 last  = bx::min(first + layout.segments_per_chunk, layout.segment_count);
+
+    PolylineChunkSize size;
+    size.segment_count = last - first;
+    size.join_count    = bx::min(last, layout.join_count) - bx::min(first, layout.join_count);
+    size.cap_count     = layout.cap_count
+        ? u32(chunk == 0) + u32(chunk + 1 == layout.chunk_count)
+        : 0;
+
+    size.vertex_count =
+        size.segment_count * POLYLINE_SEGMENT_VERTICES +
+        size.join_count    * layout.join_vertices      +
+        size.cap_count     * layout.cap_vertices       ;
+
+    size.index_count =
+        size.segment_count * POLYLINE_SEGMENT_INDICES +
+        size.join_count    * layout.join_indices      +
+        size.cap_count     * layout.cap_indices       ;
+
+    return size;
+}
+
+// Normalized segment directions. Zero-length segments take the direction of
+// the closest preceding (or following) proper segment.
+void polyline_directions(const Vec2* points, u32 point_count, u32 segment_count, Vec2* directions)
+{
+    const auto direction = [](const Vec2& a, const Vec2& b)
+    {
+        const f32 dx     = b.X - a.X;
+        const f32 dy     = b.Y - a.Y;
+        const f32 length = sqrtf(dx * dx + dy * dy);
+        const f32 scale  = length > 1e-6f ? 1.0f / length : 0.0f;
+
+        return HMM_Vec2(dx * scale, dy * scale);
+    };
+
+    // NOTE : Closing segment of a loop is peeled off, so the main loop is free
+    //        of the wrap-around indexing and of dependencies between
+    //        iterations, and the compiler can vectorize it.
+    const u32 open_count = bx::min(segment_count, point_count - 1);
+
+    for (u32 i = 0; i < open_count; i++)
+    {
+        directions[i] = direction(points[i], points[i + 1]);
+    }
+
+    if (segment_count > open_count)
+    {
+        directions[open_count] = direction(points[point_count - 1], points[0]);
+    }
+
+    const auto is_zero = [](const Vec2& v)
+    {
+        return v.X == 0.0f && v.Y == 0.0f;
+    };
+
+    for (u32 i = 1; i < segment_count; i++)
+    {
+        if (is_zero(directions[i])) { directions[i] = directions[i - 1]; }
+    }
+
+    for (u32 i = segment_count - 1; i > 0; i--)
+    {
+        if (is_zero(directions[i - 1])) { directions[i - 1] = directions[i]; }
+    }
+
+    if (is_zero(directions[0]))
+    {
+        // All points are the same.
+        for (u32 i = 0; i < segment_count; i++)
+        {
+            directions[i] = HMM_Vec2(1.0f, 0.0f);
+        }
+    }
+}
+
+struct PolylineEmitter
+{
+    const Polyline* polyline;
+    Vec3*           positions;
+    ShapeAttribs*   attribs;
+    u16*            indices;
+    u32             base;
+    u32             count = 0; // Emitted vertices.
+};
+
+PolylineEmitter chunk_emitter(const Polyline& polyline, const PolylineChunk& chunk, u32 vertex_offset, u32 index_offset)
+{
+    PolylineEmitter emitter;
+    emitter.polyline  = &polyline;
+    emitter.positions = polyline.positions + chunk.first_vertex + vertex_offset;
+    emitter.attribs   = polyline.attribs   + chunk.first_vertex + vertex_offset;
+    emitter.indices   = polyline.indices   + chunk.first_index  + index_offset;
+    emitter.base      = chunk.base + vertex_offset;
+
+    return emitter;
+}
+
+void emit_vertex(PolylineEmitter& emitter, const Vec2& position, bool opaque)
+{
+    const Polyline& polyline = *emitter.polyline;
+
+    emitter.positions[emitter.count] = transform_2d(polyline.transform, position.X, position.Y);
+    emitter.attribs  [emitter.count] = { opaque ? polyline.abgr : polyline.abgr & 0x00ffffff, { 0.0f, 0.0f } };
+    emitter.count++;
+}
+
+void emit_triangle(PolylineEmitter& emitter, u32 a, u32 b, u32 c)
+{
+    *emitter.indices++ = u16(emitter.base + a);
+    *emitter.indices++ = u16(emitter.base + b);
+    *emitter.indices++ = u16(emitter.base + c);
+}
+
+void emit_quad(PolylineEmitter& emitter, u32 a, u32 b, u32 c, u32 d)
+{
+    emit_triangle(emitter, a, b, c);
+    emit_triangle(emitter, a, c, d);
+}
+
+Vec2 perpendicular(const Vec2& v)
+{
+    return HMM_Vec2(-v.Y, v.X);
+}
+
+// Cross-section of the line at `point`, from the left fringe to the right one.
+void emit_section(PolylineEmitter& emitter, const Vec2& point, const Vec2& normal, bool opaque)
+{
+    const f32 inner = emitter.polyline->half_width;
+    const f32 outer = emitter.polyline->half_width + emitter.polyline->feather;
+
+    emit_vertex(emitter, point + normal * outer, false );
+    emit_vertex(emitter, point + normal * inner, opaque);
+    emit_vertex(emitter, point - normal * inner, opaque);
+    emit_vertex(emitter, point - normal * outer, false );
+}
+
+// Connects two consecutive cross-sections.
+void emit_section_quads(PolylineEmitter& emitter, u32 first, u32 second)
+{
+    for (u32 i = 0; i < 3; i++)
+    {
+        emit_quad(emitter, first + i, first + i + 1, second + i + 1, second + i);
+    }
+}
+
+// Circular arc around `center` with the fringe, starting at unit vector `from`
+// and sweeping `angle` radians counter-clockwise (or clockwise, if negative).
+void emit_arc(PolylineEmitter& emitter, const Vec2& center, const Vec2& from, f32 angle)
+{
+    const u32 segments = emitter.polyline->layout.arc_segments;
+    const f32 inner    = emitter.polyline->half_width;
+    const f32 outer    = emitter.polyline->half_width + emitter.polyline->feather;
+    const f32 step_cos = cosf(angle / f32(segments));
+    const f32 step_sin = sinf(angle / f32(segments));
+
+    emit_vertex(emitter, center, true);
+
+    Vec2 dir = from;
+
+    for (u32 i = 0; i <= segments; i++)
+    {
+        emit_vertex(emitter, center + dir * inner, true);
+
+        dir = HMM_Vec2(
+            dir.X * step_cos - dir.Y * step_sin,
+            dir.X * step_sin + dir.Y * step_cos
+        );
+    }
+
+    dir = from;
+
+    for (u32 i = 0; i <= segments; i++)
+    {
+        emit_vertex(emitter, center + dir * outer, false);
+
+        dir = HMM_Vec2(
+            dir.X * step_cos - dir.Y * step_sin,
+            dir.X * step_sin + dir.Y * step_cos
+        );
+    }
+
+    for (u32 i = 0; i < segments; i++)
+    {
+        const u32 body   = 1 + i;
+        const u32 fringe = 2 + segments + i;
+
+        emit_triangle(emitter, 0, body, body + 1);
+        emit_quad    (emitter, body, fringe, fringe + 1, body + 1);
+    }
+}
+
+void emit_segment(PolylineEmitter& emitter, u32 segment)
+{
+    const Polyline& polyline = *emitter.polyline;
+
+    const Vec2& a      = polyline.points[segment];
+    const Vec2& b      = polyline.points[(segment + 1) % polyline.point_count];
+    const Vec2  normal = perpendicular(polyline.directions[segment]);
+
+    emit_section      (emitter, a, normal, true);
+    emit_section      (emitter, b, normal, true);
+    emit_section_quads(emitter, 0, 4);
+}
+
+// Fills the gap at the outer side of the join between the segment and the
+// next one.
+void emit_join(PolylineEmitter& emitter, u32 segment)
+{
+    const Polyline& polyline = *emitter.polyline;
+
+    const Vec2& point = polyline.points[(segment + 1) % polyline.point_count];
+    const Vec2& dir0  = polyline.directions[segment];
+    const Vec2& dir1  = polyline.directions[(segment + 1) % polyline.layout.segment_count];
+
+    // Outer side is the right one for left turns and vice versa.
+    const f32  cross = dir0.X * dir1.Y - dir0.Y * dir1.X;
+    const Vec2 out0  = perpendicular(dir0) * (cross > 0.0f ? -1.0f : 1.0f);
+    const Vec2 out1  = perpendicular(dir1) * (cross > 0.0f ? -1.0f : 1.0f);
+
+    if ((polyline.flags & LINE_JOIN_MASK) == LINE_JOIN_ROUND)
+    {
+        const f32 angle = acosf(bx::clamp(HMM_DotVec2(out0, out1), -1.0f, 1.0f));
+
+        emit_arc(emitter, point, out0, cross > 0.0f ? angle : -angle);
+
+        return;
+    }
+
+    const f32 inner = polyline.half_width;
+    const f32 outer = polyline.half_width + polyline.feather;
+
+    // Cosine of the half angle between the outer normals. Its inverse is the
+    // ratio of the miter length to the line width.
+    const Vec2 sum        = out0 + out1;
+    const f32  sum_length = HMM_LengthVec2(sum);
+    const f32  half_cos   = sum_length * 0.5f;
+    const Vec2 miter_dir  = sum_length > 1e-6f ? sum * (1.0f / sum_length) : dir0;
+
+    Vec2 miter;
+    Vec2 miter_fringe;
+
+    if ((polyline.flags & LINE_JOIN_MASK) == LINE_JOIN_BEVEL ||
+        half_cos * POLYLINE_MITER_LIMIT < 1.0f
+    )
+    {
+        // Bevel is a miter with the tip in the middle of the bevel edge.
+        miter        = point + (out0 + out1) * (inner * 0.5f);
+        miter_fringe = miter + miter_dir * polyline.feather;
+    }
+    else
+    {
+        miter        = point + miter_dir * (inner / half_cos);
+        miter_fringe = point + miter_dir * (outer / half_cos);
+    }
+
+    emit_vertex(emitter, point               , true ); // 0
+    emit_vertex(emitter, point + out0 * inner, true ); // 1
+    emit_vertex(emitter, miter               , true ); // 2
+    emit_vertex(emitter, point + out0 * outer, false); // 3
+    emit_vertex(emitter, point + out1 * inner, true ); // 4
+    emit_vertex(emitter, point + out1 * outer, false); // 5
+    emit_vertex(emitter, miter_fringe        , false); // 6
+
+    emit_triangle(emitter, 0, 1, 2);
+    emit_triangle(emitter, 0, 2, 4);
+    emit_quad    (emitter, 1, 3, 6, 2);
+    emit_quad    (emitter, 2, 6, 5, 4);
+}
+
+// Cap at the first point (if `end` is false), or the last one.
+void emit_cap(PolylineEmitter& emitter, bool end)
+{
+    const Polyline& polyline = *emitter.polyline;
+
+    const u32   segment = end ? polyline.layout.segment_count - 1 : 0;
+    const Vec2& point   = polyline.points[end ? polyline.point_count - 1 : 0];
+    const Vec2  out     = polyline.directions[segment] * (end ? 1.0f : -1.0f);
+    const Vec2  normal  = perpendicular(out);
+
+    switch (polyline.flags & LINE_CAP_MASK)
+    {
+    case LINE_CAP_ROUND:
+        emit_arc(emitter, point, normal * -1.0f, HMM_PI32);
+        break;
+
+    case LINE_CAP_SQUARE:
+    {
+        const Vec2 extended = point + out * polyline.half_width;
+
+        emit_section      (emitter, point   , normal, true );
+        emit_section      (emitter, extended, normal, true );
+        emit_section      (emitter, extended + out * polyline.feather, normal, false);
+        emit_section_quads(emitter, 0, 4);
+        emit_section_quads(emitter, 4, 8);
+        break;
+    }
+
+    default:
+        emit_section      (emitter, point, normal, true );
+        emit_section      (emitter, point + out * polyline.feather, normal, false);
+        emit_section_quads(emitter, 0, 4);
+    }
+}
+
+// Tessellates segments in range `first ... last - 1`, together with the joins
+// following them, and the caps at the ends of the polyline.
+void tessellate(const Polyline& polyline, u32 first, u32 last)
+{
+    const PolylineLayout& layout = polyline.layout;
+
+    for (u32 i = first; i < last; i++)
+    {
+        const u32               chunk = i / layout.segments_per_chunk;
+        const u32               local = i - chunk * layout.segments_per_chunk;
+        const PolylineChunk&    info  = polyline.chunks[chunk];
+        const PolylineChunkSize size  = chunk_size(layout, chunk);
+
+        PolylineEmitter segment = chunk_emitter(
+            polyline, info,
+            local * POLYLINE_SEGMENT_VERTICES,
+            local * POLYLINE_SEGMENT_INDICES
+        );
+        emit_segment(segment, i);
+
+        const u32 joins_vertex_offset = size.segment_count * POLYLINE_SEGMENT_VERTICES;
+        const u32 joins_index_offset  = size.segment_count * POLYLINE_SEGMENT_INDICES;
+
+        if (i < layout.join_count)
+        {
+            PolylineEmitter join = chunk_emitter(
+                polyline, info,
+                joins_vertex_offset + local * layout.join_vertices,
+                joins_index_offset  + local * layout.join_indices
+            );
+            emit_join(join, i);
+        }
+
+        if (layout.cap_count && (i == 0 || i + 1 == layout.segment_count))
+        {
+            const u32 caps_vertex_offset = joins_vertex_offset + size.join_count * layout.join_vertices;
+            const u32 caps_index_offset  = joins_index_offset  + size.join_count * layout.join_indices;
+
+            // Chunk with both caps has the starting one first.
+            const bool end  = i + 1 == layout.segment_count;
+            const u32  slot = end && chunk == 0 ? 1 : 0;
+
+            if (i == 0)
+            {
+                PolylineEmitter cap = chunk_emitter(polyline, info, caps_vertex_offset, caps_index_offset);
+                emit_cap(cap, false);
+            }
+
+            if (end)
+            {
+                PolylineEmitter cap = chunk_emitter(
+                    polyline, info,
+                    caps_vertex_offset + slot * layout.cap_vertices,
+                    caps_index_offset  + slot * layout.cap_indices
+                );
+                emit_cap(cap, true);
+            }
+        }
+    }
+}
+
+struct PolylineTask : enki::ITaskSet
+{
+    const Polyline* polyline = nullptr;
+
+    PolylineTask(const Polyline* polyline)
+        : enki::ITaskSet(polyline->layout.segment_count, POLYLINE_TASK_SEGMENTS)
+        , polyline(polyline)
+    {
+    }
+
+    void ExecuteRange(enki::TaskSetPartition range, u32) override
+    {
+        tessellate(*polyline, range.start, range.end);
+    }
+};
+
+// Reserves the space for the polyline in the batcher and tessellates it, split
+// among tasks if the polyline is long enough and a scheduler is given. Points
+// are in the local space of `transform`.
+void add_polyline
+(
+    ShapeBatcher&        batcher,
+    const ShapeKey&      key,
+    const Mat4&          transform,
+    const Vec2*          points,
+    u32                  point_count,
+    f32                  width,
+    f32                  feather,
+    u16                  flags,
+    u32                  abgr,
+    Allocator*           temp_allocator,
+    enki::TaskScheduler* scheduler
+)
+{
+    ASSERT(temp_allocator, "Invalid temporary allocator pointer.");
+
+    Polyline polyline;
+    polyline.layout = polyline_layout(
+        point_count, flags, shape_segments(width * 0.5f * shape_scale(transform)) / 2
+    );
+    polyline.transform   = transform;
+    polyline.points      = points;
+    polyline.point_count = point_count;
+    polyline.half_width  = width * 0.5f;
+    polyline.feather     = feather;
+    polyline.abgr        = abgr;
+    polyline.flags       = flags;
+
+    const PolylineLayout& layout = polyline.layout;
+
+    Vec2*          directions = static_cast<Vec2*         >(BX_ALLOC(temp_allocator, layout.segment_count * sizeof(Vec2         )));
+    PolylineChunk* chunks     = static_cast<PolylineChunk*>(BX_ALLOC(temp_allocator, layout.chunk_count   * sizeof(PolylineChunk)));
+
+    ASSERT(directions && chunks, "Polyline temporary memory allocation failed.");
+
+    polyline_directions(points, point_count, layout.segment_count, directions);
+
+    // NOTE : Output pointers are only taken once all chunks are added, since
+    //        the batcher's arrays can get reallocated meanwhile.
+    for (u32 i = 0; i < layout.chunk_count; i++)
+    {
+        const PolylineChunkSize size = chunk_size(layout, i);
+
+        chunks[i].base         = add_shape(batcher, key, size.vertex_count, size.index_count);
+        chunks[i].first_vertex = batcher.positions.size - size.vertex_count;
+        chunks[i].first_index  = batcher.indices  .size - size.index_count;
+    }
+
+    polyline.directions = directions;
+    polyline.chunks     = chunks;
+    polyline.positions  = batcher.positions.data;
+    polyline.attribs    = batcher.attribs  .data;
+    polyline.indices    = batcher.indices  .data;
+
+    if (scheduler && layout.segment_count >= POLYLINE_TASK_SEGMENTS * 2)
+    {
+        PolylineTask task(&polyline);
+
+        scheduler->AddTaskSetToPipe(&task);
+        scheduler->WaitforTask(&task);
+    }
+    else
+    {
+        tessellate(polyline, 0, layout.segment_count);
+    }
+
+    BX_FREE(temp_allocator, chunks);
+    BX_FREE(temp_allocator, directions);
+}
+
+
+// -----------------------------------------------------------------------------
+// PARTICLE SYSTEMS
+// -----------------------------------------------------------------------------
+
+// Particles are simulated on the CPU, with the state of each emitter kept in
+// structure-of-arrays form. Only the spawning consumes random numbers and it's
+// done sequentially, so the integration (and the instance data output) can be
+// split among tasks arbitrarily, without affecting the results.
+
+constexpr u32 MAX_PARTICLE_EMITTERS    = 64;
+constexpr u32 MAX_PARTICLE_CURVE_KEYS  = 8;
+constexpr u32 PARTICLE_CURVE_SAMPLES   = 64;
+constexpr u32 PARTICLE_CURVE_COLOR     = 3;    // After the public scalar curves.
+constexpr u32 PARTICLE_CURVE_COUNT     = 4;
+constexpr u32 PARTICLE_TASK_SIZE       = 4096; // Minimum particles per task.
+constexpr u16 PARTICLE_DRAW_STATE      = STATE_BLEND_ALPHA | STATE_DEPTH_TEST_LESS | STATE_MSAA | STATE_WRITE_RGB;
+constexpr u16 PARTICLE_INSTANCE_STRIDE = 2 * sizeof(Vec4); // Position and size, color.
+
+// Piecewise linear curve over the normalized particle age, baked into a table
+// of evenly spaced samples that's indexed directly during the simulation.
+struct ParticleCurve
+{
+    FixedArray<f32 , MAX_PARTICLE_CURVE_KEYS> times;
+    FixedArray<Vec4, MAX_PARTICLE_CURVE_KEYS> values;
+    FixedArray<Vec4, PARTICLE_CURVE_SAMPLES > samples;
+    u32                                       key_count = 0;
+};
+
+void add_key(ParticleCurve& curve, f32 time, const Vec4& value)
+{
+    ASSERT(
+        curve.key_count < MAX_PARTICLE_CURVE_KEYS,
+        "Particle curve key limit %" PRIu32 " reached.",
+        MAX_PARTICLE_CURVE_KEYS
+    );
+
+    time = bx::clamp(time, 0.0f, 1.0f);
+
+    // Keys are kept sorted, equal times in the order of addition.
+    u32 i = curve.key_count++;
+
+    for (; i > 0 && curve.times[i - 1] > time; i--)
+    {
+        curve.times [i] = curve.times [i - 1];
+        curve.values[i] = curve.values[i - 1];
+    }
+
+    curve.times [i] = time;
+    curve.values[i] = value;
+}
+
+void bake(ParticleCurve& curve, const Vec4& default_value)
+{
+    for (u32 i = 0; i < PARTICLE_CURVE_SAMPLES; i++)
+    {
+        const f32 time = f32(i) / f32(PARTICLE_CURVE_SAMPLES - 1);
+
+        u32 key = 0;
+
+        while (key < curve.key_count && curve.times[key] < time)
+        {
+            key++;
+        }
+
+        if (!curve.key_count)
+        {
+            curve.samples[i] = default_value;
+        }
+        else if (key == 0 || key == curve.key_count)
+        {
+            curve.samples[i] = curve.values[bx::min(key, curve.key_count - 1)];
+        }
+        else
+        {
+            const f32 t0 = curve.times[key - 1];
+            const f32 t1 = curve.times[key    ];
+            const f32 t  = (time - t0) / (t1 - t0); // `t1 > t0`, given the loop.
+
+            curve.samples[i] = curve.values[key - 1] + (curve.values[key] - curve.values[key - 1]) * t;
+        }
+    }
+}
+
+u32 curve_sample(f32 age, f32 lifetime)
+{
+    const f32 t = bx::clamp(age / lifetime, 0.0f, 1.0f);
+
+    return u32(t * f32(PARTICLE_CURVE_SAMPLES - 1) + 0.5f);
+}
+
+struct ParticleEmitter
+{
+    // Particle state. Each array has `capacity` elements, the first `count` of
+    // them being alive.
+    f32*          position[3]   = {};
+    f32*          velocity[3]   = {};
+    f32*          age           = nullptr;
+    f32*          lifetime      = nullptr;
+    Allocator*    allocator     = nullptr;
+    u32           capacity      = 0;
+    u32           count         = 0;
+
+    ParticleCurve curves[PARTICLE_CURVE_COUNT];
+    Vec3          velocity_base = {};
+    Vec3          acceleration  = {};
+    f32           spread        = 0.0f;
+    f32           rate          = 0.0f;
+    f32           lifetime_min  = 1.0f;
+    f32           lifetime_max  = 1.0f;
+    f32           spawn_debt    = 0.0f; // Fractional spawn count carried between steps.
+    u32           random_state  = 0;
+};
+
+void deinit(ParticleEmitter& emitter)
+{
+    if (emitter.allocator && emitter.position[0])
+    {
+        BX_FREE(emitter.allocator, emitter.position[0]);
+    }
+
+    emitter = {};
+}
+
+// Discards all particles and parameters. The memory is reallocated only if the
+// capacity changes.
+void reset(ParticleEmitter& emitter, Allocator* allocator, u32 capacity, u32 seed)
+{
+    ASSERT(allocator, "Invalid allocator pointer.");
+    ASSERT(capacity > 0, "Zero particle emitter capacity.");
+
+    f32*       memory         = emitter.position[0];
+    Allocator* prev_allocator = emitter.allocator;
+
+    if (emitter.capacity != capacity || prev_allocator != allocator)
+    {
+        if (memory)
+        {
+            BX_FREE(prev_allocator, memory);
+        }
+
+        memory = static_cast<f32*>(BX_ALLOC(allocator, 8 * capacity * sizeof(f32)));
+        ASSERT(memory, "Particle emitter memory allocation failed.");
+    }
+
+    emitter = {};
+
+    for (u32 i = 0; i < 3; i++)
+    {
+        emitter.position[i] = memory + capacity *  i;
+        emitter.velocity[i] = memory + capacity * (i + 3);
+    }
+
+    emitter.age       = memory + capacity * 6;
+    emitter.lifetime  = memory + capacity * 7;
+    emitter.allocator = allocator;
+    emitter.capacity  = capacity;
+
+    // NOTE : Xorshift state can't be zero.
+    emitter.random_state = seed ? seed : 0x9e3779b9;
+}
+
+void bake(ParticleEmitter& emitter)
+{
+    for (u32 i = 0; i < PARTICLE_CURVE_COUNT; i++)
+    {
+        bake(emitter.curves[i], HMM_Vec4(1.0f, 1.0f, 1.0f, 1.0f));
+    }
+}
+
+// Own generator, so that the sequence is the same on every platform.
+f32 random_unit(u32& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return f32(state >> 8) * (1.0f / 16777216.0f);
+}
+
+f32 random_range(u32& state, f32 low, f32 high)
+{
+    return low + (high - low) * random_unit(state);
+}
+
+void kill_expired(ParticleEmitter& emitter)
+{
+    for (u32 i = 0; i < emitter.count;)
+    {
+        if (emitter.age[i] < emitter.lifetime[i])
+        {
+            i++;
+            continue;
+        }
+
+        const u32 last = --emitter.count;
+
+        for (u32 j = 0; j < 3; j++)
+        {
+            emitter.position[j][i] = emitter.position[j][last];
+            emitter.velocity[j][i] = emitter.velocity[j][last];
+        }
+
+        emitter.age     [i] = emitter.age     [last];
+        emitter.lifetime[i] = emitter.lifetime[last];
+    }
+}
+
+void spawn(ParticleEmitter& emitter, f32 dt)
+{
+    emitter.spawn_debt += emitter.rate * dt;
+
+    const u32 requested = u32(emitter.spawn_debt);
+    const u32 available = emitter.capacity - emitter.count;
+
+    emitter.spawn_debt -= f32(requested);
+
+    for (u32 i = emitter.count, n = emitter.count + bx::min(requested, available); i < n; i++)
+    {
+        u32& state = emitter.random_state;
+
+        emitter.position[0][i] = 0.0f;
+        emitter.position[1][i] = 0.0f;
+        emitter.position[2][i] = 0.0f;
+        emitter.velocity[0][i] = emitter.velocity_base.X + random_range(state, -emitter.spread, emitter.spread);
+        emitter.velocity[1][i] = emitter.velocity_base.Y + random_range(state, -emitter.spread, emitter.spread);
+        emitter.velocity[2][i] = emitter.velocity_base.Z + random_range(state, -emitter.spread, emitter.spread);
+        emitter.age        [i] = 0.0f;
+        emitter.lifetime   [i] = random_range(state, emitter.lifetime_min, emitter.lifetime_max);
+    }
+
+    emitter.count += bx::min(requested, available);
+}
+
+// Semi-implicit Euler step. The speed curve scales the velocity only when it's
+// applied to the position, so that it doesn't compound over the steps.
+void integrate(ParticleEmitter& emitter, f32 dt, u32 first, u32 last)
+{
+    const Vec4* speed        = emitter.curves[PARTICLE_SPEED       ].samples.data;
+    const Vec4* acceleration = emitter.curves[PARTICLE_ACCELERATION].samples.data;
+
+    f32* BX_RESTRICT px = emitter.position[0];
+    f32* BX_RESTRICT py = emitter.position[1];
+    f32* BX_RESTRICT pz = emitter.position[2];
+    f32* BX_RESTRICT vx = emitter.velocity[0];
+    f32* BX_RESTRICT vy = emitter.velocity[1];
+    f32* BX_RESTRICT vz = emitter.velocity[2];
+    f32* BX_RESTRICT age = emitter.age;
+
+    const f32* BX_RESTRICT lifetime = emitter.lifetime;
+
+    for (u32 i = first; i < last; i++)
+    {
+        const u32 sample = curve_sample(age[i], lifetime[i]);
+        const f32 a      = acceleration[sample].X * dt;
+        const f32 s      = speed       [sample].X * dt;
+
+        vx[i] += emitter.acceleration.X * a;
+        vy[i] += emitter.acceleration.Y * a;
+        vz[i] += emitter.acceleration.Z * a;
+
+        px[i] += vx[i] * s;
+        py[i] += vy[i] * s;
+        pz[i] += vz[i] * s;
+
+        age[i] += dt;
+    }
+}
+
+// Writes the instance data of the billboard program. Positions are transformed
+// into the world space, the size is scaled by the transform's scale.
+void write_instances(const ParticleEmitter& emitter, const Mat4& transform, u8* output, u32 first, u32 last)
+{
+    const Vec4* size  = emitter.curves[PARTICLE_SIZE       ].samples.data;
+    const Vec4* color = emitter.curves[PARTICLE_CURVE_COLOR].samples.data;
+
+    const f32 scale = shape_scale(transform);
+
+    for (u32 i = first; i < last; i++)
+    {
+        const u32  sample   = curve_sample(emitter.age[i], emitter.lifetime[i]);
+        const Vec4 position = transform * HMM_Vec4(
+            emitter.position[0][i],
+            emitter.position[1][i],
+            emitter.position[2][i],
+            1.0f
+        );
+
+        Vec4* data = reinterpret_cast<Vec4*>(output + i * PARTICLE_INSTANCE_STRIDE);
+        data[0] = HMM_Vec4(position.X, position.Y, position.Z, size[sample].X * scale);
+        data[1] = color[sample];
+    }
+}
+
+struct ParticleTask : enki::ITaskSet
+{
+    ParticleEmitter* emitter   = nullptr;
+    const Mat4*      transform = nullptr;
+    u8*              output    = nullptr; // Integration if null.
+    f32              dt        = 0.0f;
+
+    ParticleTask(ParticleEmitter* emitter)
+        : enki::ITaskSet(emitter->count, PARTICLE_TASK_SIZE)
+        , emitter(emitter)
+    {
+    }
+
+    void ExecuteRange(enki::TaskSetPartition range, u32) override
+    {
+        if (output)
+        {
+            write_instances(*emitter, *transform, output, range.start, range.end);
+        }
+        else
+        {
+            integrate(*emitter, dt, range.start, range.end);
+        }
+    }
+};
+
+void execute(ParticleTask& task, enki::TaskScheduler* scheduler)
+{
+    if (scheduler && task.emitter->count >= PARTICLE_TASK_SIZE * 2)
+    {
+        scheduler->AddTaskSetToPipe(&task);
+        scheduler->WaitforTask(&task);
+    }
+    else
+    {
+        task.ExecuteRange({ 0, task.emitter->count }, 0);
+    }
+}
+
+// Advances the simulation by a single step. Given the same seed, parameters
+// and sequence of steps, the resulting state is always the same.
+void update(ParticleEmitter& emitter, f32 dt, enki::TaskScheduler* scheduler)
+{
+    ASSERT(emitter.capacity, "Particle emitter not defined.");
+    ASSERT(dt >= 0.0f, "Negative particle time step %f.", dt);
+
+    kill_expired(emitter);
+    spawn(emitter, dt);
+
+    ParticleTask task(&emitter);
+    task.dt = dt;
+
+    execute(task, scheduler);
+}
+
+struct ParticleCache
+{
+    Mutex                                              mutex;
+    FixedArray<ParticleEmitter, MAX_PARTICLE_EMITTERS> emitters;
+    Mesh                                               quad;
+    u32                                                quad_created = 0; // Updated atomically.
+};
+
+// Billboard quad shared by all emitters, created on the first use, so that
+// applications not using particles don't pay for it.
+const Mesh& particle_quad(ParticleCache& cache, VertexLayoutCache& layouts)
+{
+    if (0 == bx::atomicCompareAndSwap(&cache.quad_created, 0u, 0u))
+    {
+        MutexScope lock(cache.mutex);
+
+        if (!cache.quad_created)
+        {
+            // Unit quad in the XY plane, oriented towards the camera in the shader.
+            static const f32 s_quad_vertices[] =
+            {
+                -0.5f, -0.5f, 0.0f,
+                 0.5f, -0.5f, 0.0f,
+                -0.5f,  0.5f, 0.0f,
+                 0.5f,  0.5f, 0.0f,
+            };
+
+            static const u16 s_quad_indices[] =
+            {
+                0, 1, 2,   1, 3, 2,
+            };
+
+            cache.quad.flags         = MESH_STATIC | PRIMITIVE_TRIANGLES | BILLBOARD_MESH;
+            cache.quad.element_count = BX_COUNTOF(s_quad_indices);
+
+            cache.quad.positions.static_buffer = bgfx::createVertexBuffer(
+                bgfx::makeRef(s_quad_vertices, sizeof(s_quad_vertices)),
+                vertex_layout(layouts, VERTEX_POSITION)
+            );
+
+            cache.quad.indices.static_buffer = bgfx::createIndexBuffer(
+                bgfx::makeRef(s_quad_indices, sizeof(s_quad_indices))
+            );
+
+            bx::atomicCompareAndSwap(&cache.quad_created, 0u, 1u);
+        }
+    }
+
+    return cache.quad;
+}
+
+void deinit(ParticleCache& cache)
+{
+    for (u32 i = 0; i < cache.emitters.size; i++)
+    {
+        deinit(cache.emitters[i]);
+    }
+
+    destroy_if_valid(cache.quad.positions.static_buffer);
+    destroy_if_valid(cache.quad.indices  .static_buffer);
+}
+
+// Writes the particles directly into a transient instance buffer and submits
+// them as a single instanced draw call of the billboard quad.
+void submit_particles
+(
+    ParticleEmitter&                         emitter,
+    const Mesh&                              quad,
+    const Mat4&                              transform,
+    DrawState&                               state,
+    InstanceCache&                           instance_cache,
+    const Span<bgfx::TransientVertexBuffer>& transient_buffers,
+    const DefaultUniforms&                   default_uniforms,
+    EncoderShadow&                           shadow,
+    bgfx::Encoder&                           encoder,
+    enki::TaskScheduler*                     scheduler
+)
+{
+    if (!emitter.count)
+    {
+        return;
+    }
+
+    InstanceData instances;
+
+    {
+        // NOTE : See `add_instances` regarding the mutex.
+        MutexScope lock(instance_cache.mutex);
+
+        if (bgfx::getAvailInstanceDataBuffer(emitter.count, PARTICLE_INSTANCE_STRIDE) < emitter.count)
+        {
+            WARN(true, "Instance buffer memory exhausted.");
+            return;
+        }
+
+        bgfx::allocInstanceDataBuffer(&instances.buffer, emitter.count, PARTICLE_INSTANCE_STRIDE);
+    }
+
+    ParticleTask task(&emitter);
+    task.transform = &transform;
+    task.output    = instances.buffer.data;
+
+    execute(task, scheduler);
+
+    state.instances = &instances;
+
+    if (state.flags == STATE_DEFAULT)
+    {
+        state.flags = PARTICLE_DRAW_STATE;
+    }
+
+    submit_mesh(quad, HMM_Mat4d(1.0f), state, transient_buffers, default_uniforms, shadow, encoder);
+}
+
+
+// -----------------------------------------------------------------------------
+// DRAW LIST RECORDING & DRAW LIST CACHE
+// -----------------------------------------------------------------------------
+
+// Fully resolved `mesh` submission. The mesh itself is referenced by its ID, so
+// that re-recording it (or using a transient one) doesn't invalidate the list.
+struct DrawCommand
+{
+    Mat4                     transform;
+    u64                      state;
+    f32                      texture_size[4];
+    u32                      element_start;
+    u32                      element_count;
+    u32                      uniform_offset;
+    u32                      uniform_size;
+    Handle                   mesh;
+    bgfx::ProgramHandle      program;
+    bgfx::TextureHandle      texture;
+    bgfx::UniformHandle      sampler;
+    bgfx::VertexLayoutHandle vertex_alias;
+};
+
+// Header of a single uniform value in the `DrawList::uniforms` buffer, which
+// is immediately followed by `size` bytes of the value itself.
+struct DrawUniform
+{
+    bgfx::UniformHandle handle;
+    u16                 count;
+    u32                 size;
+};
+
+struct DrawList
+{
+    DynamicArray<DrawCommand> commands;
+    DynamicArray<u8>          uniforms;
+};
+
+struct DrawListRecorder
+{
+    DrawList list;
+    u32      uniform_start = 0;
+};
+
+void init(DrawList& list, Allocator* allocator)
+{
+    init(list.commands, allocator);
+    init(list.uniforms, allocator);
+}
+
+void deinit(DrawList& list)
+{
+    deinit(list.commands);
+    deinit(list.uniforms);
+}
+
+void init(DrawListRecorder& recorder, Allocator* allocator)
+{
+    init(recorder.list, allocator);
+}
+
+void deinit(DrawListRecorder& recorder)
+{
+    deinit(recorder.list);
+}
+
+void start(DrawListRecorder& recorder)
+{
+    resize(recorder.list.commands, 0);
+    resize(recorder.list.uniforms, 0);
+
+    recorder.uniform_start = 0;
+}
+
+void end(DrawListRecorder& recorder)
+{
+    start(recorder);
+}
+
+void add_uniform(DrawListRecorder& recorder, bgfx::UniformHandle handle, const void* value)
+{
+    constexpr u32 type_sizes[] =
+    {
+        sizeof(i32),     // Sampler.
+        0,               // End.
+        sizeof(f32) * 4, // Vec4.
+        sizeof(f32) * 9, // Mat3.
+        sizeof(f32) * 16 // Mat4.
+    };
+
+    static_assert(
+        bgfx::UniformType::Sampler == 0 &&
+        bgfx::UniformType::Vec4    == 2 &&
+        bgfx::UniformType::Mat3    == 3 &&
+        bgfx::UniformType::Mat4    == 4,
+        "Invalid uniform type order assumption."
+    );
+
+    bgfx::UniformInfo info;
+    bgfx::getUniformInfo(handle, info);
+
+    DrawUniform uniform;
+    uniform.handle = handle;
+    uniform.count  = info.num;
+    uniform.size   = type_sizes[info.type] * info.num;
+
+    append(recorder.list.uniforms, &uniform, sizeof(uniform));
+    append(recorder.list.uniforms, value, uniform.size);
+}
+
+void add_command
+(
+    DrawListRecorder& recorder,
+    Handle            mesh,
+    u32               mesh_flags,
+    const Mat4&       transform,
+    const DrawState&  state
+)
+{
+    DrawCommand command;
+    command.transform      = transform;
+    command.state          = translate_draw_state_flags(state.flags, mesh_flags);
+    command.element_start  = state.element_start;
+    command.element_count  = state.element_count;
+    command.uniform_offset = recorder.uniform_start;
+    command.uniform_size   = recorder.list.uniforms.size - recorder.uniform_start;
+    command.mesh           = mesh;
+    command.program        = state.program;
+    command.texture        = state.texture;
+    command.sampler        = state.sampler;
+    command.vertex_alias   = state.vertex_alias;
+
+    texture_size_uniform_data(state.texture_size, command.texture_size);
+
+    append(recorder.list.commands, command);
+
+    recorder.uniform_start = recorder.list.uniforms.size;
+}
+
+// Each list has its own mutex, so that different lists can be submitted in
+// parallel, while a list can't be re-recorded in the middle of its submission.
+struct DrawListCache
+{
+    FixedArray<Mutex   , MAX_DRAW_LISTS> mutexes;
+    FixedArray<DrawList, MAX_DRAW_LISTS> lists;
+};
+
+void deinit(DrawListCache& cache)
+{
+    for (u32 i = 0; i < cache.lists.size; i++)
+    {
+        if (cache.lists[i].commands.allocator)
+        {
+            deinit(cache.lists[i]);
+        }
+    }
+}
+
+void add_draw_list
+(
+    DrawListCache&          cache,
+    u16                     id,
+    const DrawListRecorder& recorder,
+    Allocator*              allocator
+)
+{
+    MutexScope lock(cache.mutexes[id]);
+
+    DrawList& list = cache.lists[id];
+
+    if (!list.commands.allocator)
+    {
+        init(list, allocator);
+    }
+
+    copy(list.commands, recorder.list.commands);
+    copy(list.uniforms, recorder.list.uniforms);
+}
+
+void submit_draw_list
+(
+    const DrawList&        list,
+    const Mat4&            root_transform,
+    bgfx::ViewId           pass,
+    const MeshCache&       mesh_cache,
+    const DefaultUniforms& default_uniforms,
+    EncoderShadow&         shadow,
+    bgfx::Encoder&         encoder
+)
+{
+    // NOTE : Draw lists don't preserve the state between their submissions.
+    if (list.commands.size)
+    {
+        encoder.discard();
+        discard(shadow);
+    }
+
+    for (u32 i = 0; i < list.commands.size; i++)
+    {
+        const DrawCommand& command = list.commands[i];
+        const Mesh&        mesh    = mesh_cache.meshes[command.mesh.id];
+
+        // NOTE : Mesh recreated after the list was recorded (this includes all
+        //        transient meshes from the previous frames).
+        if (!is_current(mesh_cache.meshes, command.mesh))
+        {
+            ASSERT(false, "Draw list references stale mesh %" PRIu16 ".", command.mesh.id);
+            continue;
+        }
+
+        if (!is_valid(mesh))
+        {
+            continue;
+        }
+
+        set_mesh_buffers(
+            mesh,
+            command.element_start,
+            command.element_count,
+            command.vertex_alias,
+            mesh_cache.transient_buffers,
+            encoder
+        );
+
+        for (u32 offset = command.uniform_offset; offset < command.uniform_offset + command.uniform_size; )
+        {
+            const DrawUniform* uniform = reinterpret_cast<const DrawUniform*>(list.uniforms.data + offset);
+            offset += sizeof(DrawUniform);
+
+            encoder.setUniform(uniform->handle, list.uniforms.data + offset, uniform->count);
+            offset += uniform->size;
+        }
+
+        if (bgfx::isValid(command.texture) && bgfx::isValid(command.sampler))
+        {
+            encoder.setTexture(0, command.sampler, command.texture);
+        }
+
+        if (mesh.flags & VERTEX_PIXCOORD)
+        {
+            encoder.setUniform(default_uniforms[u32(DefaultUniform::TEXTURE_SIZE)], command.texture_size);
+        }
+
+        // NOTE : Same order as in `multiply_top`, so the list behaves as if it
+        //        was recorded with `root_transform` on the matrix stack.
+        const Mat4 transform = command.transform * root_transform;
+
+        encoder.setTransform(&transform);
+
+        encoder.setState(command.state);
+
+        encoder.submit(pass, command.program);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// OCCLUSION QUERIES
+// -----------------------------------------------------------------------------
+
+struct OcclusionQueryCache
+{
+    Mutex                                   mutex;
+    HandleTable<bgfx::OcclusionQueryHandle> queries;
+    bgfx::VertexBufferHandle                box_vertices = BGFX_INVALID_HANDLE;
+    bgfx::IndexBufferHandle                 box_indices  = BGFX_INVALID_HANDLE;
+    bgfx::ProgramHandle                     program      = BGFX_INVALID_HANDLE;
+    bool                                    supported    = false;
+};
+
+// Noop renderer reports all capabilities, but never produces any results.
+bool occlusion_queries_supported(const bgfx::Caps& caps)
+{
+    return
+        (caps.supported & BGFX_CAPS_OCCLUSION_QUERY) &&
+        caps.rendererType != bgfx::RendererType::Noop;
+}
+
+void init
+(
+    OcclusionQueryCache& cache,
+    Allocator*           allocator,
+    u32                  query_count,
+    VertexLayoutCache&   layouts,
+    DefaultPrograms&     programs,
+    bool                 supported
+)
+{
+    init(cache.queries, allocator, query_count, BGFX_INVALID_HANDLE);
+
+    // NOTE : Without queries (e.g., with the Noop renderer), every query
+    //        reports the mesh as visible and nothing is ever submitted.
+    cache.supported = supported;
+
+    if (!supported)
+    {
+        return;
+    }
+
+    // Unit cube, scaled to the mesh's bounding box when submitted.
+    static const f32 s_box_vertices[] =
+    {
+        0.0f, 0.0f, 0.0f,
+        1.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f,
+        1.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 1.0f,
+        1.0f, 0.0f, 1.0f,
+        0.0f, 1.0f, 1.0f,
+        1.0f, 1.0f, 1.0f,
+    };
+
+    static const u16 s_box_indices[] =
+    {
+        0, 2, 1,   1, 2, 3, // -Z
+        4, 5, 6,   5, 7, 6, // +Z
+        0, 4, 2,   2, 4, 6, // -X
+        1, 3, 5,   3, 7, 5, // +X
+        0, 1, 4,   1, 5, 4, // -Y
+        2, 6, 3,   3, 6, 7, // +Y
+    };
+
+    cache.box_vertices = bgfx::createVertexBuffer(
+        bgfx::makeRef(s_box_vertices, sizeof(s_box_vertices)),
+        vertex_layout(layouts, VERTEX_POSITION)
+    );
+
+    cache.box_indices = bgfx::createIndexBuffer(
+        bgfx::makeRef(s_box_indices, sizeof(s_box_indices))
+    );
+
+    cache.program = default_program(programs, VERTEX_POSITION);
+}
+
+void deinit(OcclusionQueryCache& cache)
+{
+    for (u32 i = 0; i < cache.queries.size; i++)
+    {
+        destroy_if_valid(cache.queries[i]);
+    }
+
+    deinit(cache.queries);
+
+    destroy_if_valid(cache.box_vertices);
+    destroy_if_valid(cache.box_indices);
+}
+
+// Returns the query handle with the given ID, creating it on the first use.
+// Returns an invalid handle when queries aren't supported.
+bgfx::OcclusionQueryHandle acquire_query(OcclusionQueryCache& cache, u16 id)
+{
+    ASSERT(id < cache.queries.size, "Occlusion query ID %" PRIu16 " out of range.", id);
+
+    if (!cache.supported)
+    {
+        return BGFX_INVALID_HANDLE;
+    }
+
+    MutexScope lock(cache.mutex);
+
+    bgfx::OcclusionQueryHandle& query = cache.queries[id];
+
+    if (!bgfx::isValid(query))
+    {
+        query = bgfx::createOcclusionQuery();
+        WARN(bgfx::isValid(query), "Failed to create occlusion query %" PRIu16 ".", id);
+    }
+
+    return query;
+}
+
+// Result of the last completed query. Unused queries, or queries whose result
+// isn't available yet, report the mesh as visible, so that nothing disappears.
+bool is_visible(const OcclusionQueryCache& cache, u16 id)
+{
+    ASSERT(id < cache.queries.size, "Occlusion query ID %" PRIu16 " out of range.", id);
+
+    const bgfx::OcclusionQueryHandle query = cache.queries[id];
+
+    if (!cache.supported || !bgfx::isValid(query))
+    {
+        return true;
+    }
+
+    return bgfx::getResult(query) != bgfx::OcclusionQueryResult::Invisible;
+}
+
+// Submits mesh's bounding box with the query. The box only tests depth, so the
+// occluders must be drawn before it (in an earlier pass, or in the same pass
+// with sequential sort mode).
+void submit_occlusion_query
+(
+    const OcclusionQueryCache& cache,
+    bgfx::OcclusionQueryHandle query,
+    const Mesh&                mesh,
+    const Mat4&                transform,
+    bgfx::ViewId               pass,
+    EncoderShadow&             shadow,
+    bgfx::Encoder&             encoder
+)
+{
+    // NOTE : Query submission can't preserve the state, as it would leave the
+    //        query set for the following submissions.
+    encoder.discard();
+    discard(shadow);
+
+    const Mat4 box_transform = transform
+        * HMM_Translate(mesh.bounds_min)
+        * HMM_Scale(mesh.bounds_max - mesh.bounds_min);
+
+    encoder.setVertexBuffer(0, cache.box_vertices);
+    encoder.setIndexBuffer(cache.box_indices);
+    encoder.setTransform(&box_transform);
+    encoder.setState(BGFX_STATE_DEPTH_TEST_LEQUAL);
+    encoder.submit(pass, cache.program, query);
+}
+
+
+// -----------------------------------------------------------------------------
+// CODEPOINT MAP
+// -----------------------------------------------------------------------------
+
+struct CodepointMap
+{
+    struct Map
+    {
+        u32 codepoint;
+        u16 offset;
+    };
+
+    u32                  low_offset; // TODO : Expose use of this to the user.
+    FixedArray<u16, 512> low;
+    DynamicArray<Map>    high;
+};
+
+void clear(CodepointMap& map)
+{
+    map.low_offset = 0; // TODO : Set to 32 (ASCII space)?
+
+    for (u32 i = 0; i < map.low.size; i++)
+    {
+        map.low[i] = U16_MAX;
+    }
+
+    clear(map.high);
+}
+
+void init(CodepointMap& map, Allocator* allocator)
+{
+    init(map.high, allocator);
+
+    clear(map);
+}
+
+void deinit(CodepointMap& map)
+{
+    deinit(map.high);
+}
+
+u16 offset(const CodepointMap& map, u32 codepoint)
+{
+    if (codepoint >= map.low_offset &&
+        codepoint <  map.low_offset + map.low.size)
+    {
+        return map.low[codepoint - map.low_offset];
+    }
+
+    for (u32 i = 0; i < map.high.size; i++)
+    {
+        if (map.high[i].codepoint == codepoint)
+        {
+            return map.high[i].offset;
+        }
+    }
+
+    return U16_MAX;
+}
+
+bool contains(const CodepointMap& map, u32 codepoint)
+{
+    return offset(map, codepoint) != U16_MAX;
+}
+
+void insert(CodepointMap& map, u32 codepoint, u16 offset)
+{
+    ASSERT(
+        !contains(map, codepoint),
+        "Codepoint %" PRIu32 " already inserted.",
+        codepoint
+    );
+
+    if (codepoint >= map.low_offset &&
+        codepoint <  map.low_offset + map.low.size)
+    {
+        map.low[codepoint - map.low_offset] = offset;
+    }
+    else
+    {
+        append(map.high, { codepoint, offset });
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// FONT ATLAS
+// -----------------------------------------------------------------------------
+
+struct FontAtlas
+{
+    Mutex mutex;
+
+    stbtt_fontinfo                 font_info     = {};
+    f32                            font_size     = 0.0f; // Cap height, in pixels.
+
+    DynamicArray<u32>              requests;
+
+    // Packing.
+    stbrp_context                  pack_ctx      = {};
+    DynamicArray<stbrp_rect>       pack_rects;
+    DynamicArray<stbrp_node>       pack_nodes;
+
+    // Packed data.
+    DynamicArray<stbtt_packedchar> char_quads;
+    CodepointMap                   codepoints;
+
+    // Bitmap.
+    DynamicArray<u8>               bitmap_data;
+    u16                            bitmap_width  = 0;
+    u16                            bitmap_height = 0;
+
+    u16                            texture       = U16_MAX;
+    u16                            flags         = ATLAS_FREE;
+    u8                             padding       = 1;
+    bool                           locked        = false;
+};
+
+void init(FontAtlas& atlas, Allocator* allocator)
+{
+    init(atlas.requests   , allocator);
+    init(atlas.pack_rects , allocator);
+    init(atlas.pack_nodes , allocator);
+    init(atlas.char_quads , allocator);
+    init(atlas.codepoints , allocator);
+    init(atlas.bitmap_data, allocator);
+}
+
+void deinit(FontAtlas& atlas)
+{
+    deinit(atlas.requests   );
+    deinit(atlas.pack_rects );
+    deinit(atlas.pack_nodes );
+    deinit(atlas.char_quads );
+    deinit(atlas.codepoints );
+    deinit(atlas.bitmap_data);
+}
+
+void reset
+(
+    FontAtlas&    atlas,
+    TextureCache& textures,
+    ReleaseQueue& release_queue,
+    u16           texture,
+    u16           flags,
+    const void*   font,
+    f32           size
+)
+{
+    MutexScope lock(atlas.mutex);
+
+    if (atlas.texture != U16_MAX)
+    {
+        remove_texture(textures, release_queue, atlas.texture);
+    }
+
+    clear(atlas.requests   );
+    clear(atlas.pack_rects );
+    clear(atlas.pack_nodes );
+    clear(atlas.codepoints );
+    clear(atlas.bitmap_data);
+
+    atlas.font_info     = {};
+    atlas.pack_ctx      = {};
+    atlas.bitmap_width  = 0;
+    atlas.bitmap_height = 0;
+    atlas.padding       = 1; // TODO : Padding should probably reflect whether an SDF atlas is required.
+    atlas.locked        = false;
+    atlas.font_size     = size;
+    atlas.texture       = texture;
+    atlas.flags         = flags;
+
+    // TODO : Check return value.
+    (void)stbtt_InitFont(&atlas.font_info, static_cast<const u8*>(font), 0);
+
+    const int table = stbtt__find_table(
+        atlas.font_info.data,
+        atlas.font_info.fontstart,
+        "OS/2"
+    );
+
+    if (table)
+    {
+        if (ttUSHORT(atlas.font_info.data + table     ) >= 1 && // Version.
+            ttBYTE  (atlas.font_info.data + table + 32) == 2 && // PANOSE / Kind == `Latin Text`.
+            ttBYTE  (atlas.font_info.data + table + 35) == 9)   // PANOSE / bProportion == "Monospaced"
+        {
+            atlas.flags |= ATLAS_MONOSPACED;
+        }
+    }
+}
+
+// Frees atlas' glyph and bitmap data, schedules release of its texture, and
+// returns it to the pool of free atlases.
+void release
+(
+    FontAtlas&    atlas,
+    TextureCache& textures,
+    ReleaseQueue& release_queue
+)
+{
+    MutexScope lock(atlas.mutex);
+
+    if (atlas.texture != U16_MAX)
+    {
+        remove_texture(textures, release_queue, atlas.texture);
+    }
+
+    clear(atlas.requests   );
+    clear(atlas.pack_rects );
+    clear(atlas.pack_nodes );
+    clear(atlas.char_quads );
+    clear(atlas.codepoints );
+    clear(atlas.bitmap_data);
+
+    atlas.font_info     = {};
+    atlas.pack_ctx      = {};
+    atlas.bitmap_width  = 0;
+    atlas.bitmap_height = 0;
+    atlas.font_size     = 0.0f;
+    atlas.locked        = false;
+    atlas.texture       = U16_MAX;
+    atlas.flags         = ATLAS_FREE;
+}
+
+bool is_updatable(const FontAtlas& atlas)
+{
+    return atlas.flags & ATLAS_ALLOW_UPDATE;
+}
+
+void add_glyph_range(FontAtlas& atlas, u32 first, u32 last)
+{
+    if (!is_updatable(atlas) && atlas.locked)
+    {
+        ASSERT(false, "Atlas is not updatable.");
+        return;
+    }
+
+    if (first > last)
+    {
+        bx::swap(first, last);
+    }
+
+    reserve(atlas.requests, atlas.requests.size + last - first + 1u);
+
+    for (u32 codepoint = first; codepoint <= last; codepoint++)
+    {
+        if (!contains(atlas.codepoints, codepoint))
+        {
+            append(atlas.requests, codepoint);
+        }
+    }
+}
+
+void add_glyphs_from_string(FontAtlas& atlas, const char* start, const char* end)
+{
+    if (!is_updatable(atlas) && atlas.locked)
+    {
+        ASSERT(false, "Atlas is not updatable.");
+        return;
+    }
+
+    u32 codepoint;
+    u32 state = 0;
+
+    for (const char* string = start; end ? string < end : *string; string++)
+    {
+        if (UTF8_ACCEPT == utf8_decode(state, *reinterpret_cast<const u8*>(string), codepoint))
+        {
+            if (!contains(atlas.codepoints, codepoint))
+            {
+                append(atlas.requests, codepoint);
+            }
+        }
+    }
+
+    ASSERT(state == UTF8_ACCEPT, "Ill-formated UTF-8 string.");
+}
+
+void check_stbrp_context_validity
+(
+    const stbrp_context&            ctx,
+    const DynamicArray<stbrp_node>& nodes
+)
+{
+#ifndef NDEBUG
+    const auto check_node =[&](const stbrp_node* node)
+    {
+        const bool is_in_range = node >= nodes.data && node < nodes.data + nodes.size;
+        const bool is_extra    = node == &ctx.extra[0] || node == &ctx.extra[1];
+        const bool is_null     = node == nullptr;
+
+        ASSERT(
+            is_in_range || is_extra || is_null,
+            "Invalid stbrp node state."
+        );
+    };
+
+    const auto count_nodes = [](const stbrp_node* node, bool check_zero)
+    {
+        int count = 0;
+
+        while (node)
+        {
+            ASSERT(
+                !check_zero || (node->x == 0 && node->y == 0),
+                "Non-zero stbrp node position."
+            );
+
+            node = node->next;
+            count++;
+        }
+
+        return count;
+    };
+
+    const int active_nodes_count = count_nodes(ctx.active_head, false);
+    const int free_nodes_count   = count_nodes(ctx.free_head  , true );
+
+    ASSERT(
+        2 + ctx.num_nodes == active_nodes_count + free_nodes_count,
+        "Unexpected stbrp node count."
+    );
+
+    check_node(ctx.active_head);
+    check_node(ctx.active_head->next);
+
+    check_node(ctx.free_head);
+    check_node(ctx.free_head->next);
+
+    check_node(ctx.extra[0].next);
+    check_node(ctx.extra[1].next);
+
+    for (u32 i = 0; i < nodes.size; i++)
+    {
+        check_node(nodes[i].next);
+    }
+#endif // NDEBUG
+}
+
+void patch_stbrp_context
+(
+    u32                       width,
+    u32                       height,
+    u32                       padding,
+    stbrp_context&            inout_ctx,
+    DynamicArray<stbrp_node>& inout_nodes
+)
+{
+    check_stbrp_context_validity(inout_ctx, inout_nodes);
+
+    // When changing only height, number of nodes or the sentinel node don't
+    // change.
+    if (width - padding == u32(inout_ctx.width))
+    {
+        inout_ctx.height = int(height - padding);
+
+        return;
+    }
+
+    DynamicArray<stbrp_node> nodes;
+    init(nodes, inout_nodes.allocator);
+    defer(deinit(nodes));
+
+    resize(nodes, width - padding);
+
+    const auto find_node = [&](stbrp_node* node)
+    {
+        // Node can either point to one of the given array members, the two
+        // `extra` nodes allocated within the `stbrp_context` structure, or
+        // be `NULL`.
+        const uintptr_t offset = node - inout_nodes.data; // Fine even if `nullptr`.
+
+        // We're intentionally not adjusting the nodes that point to one of
+        // the context's `extra` nodes, so that we don't have to repeatedly
+        // patch them when the context would be swapped.
+        return offset < inout_nodes.size ? &nodes[offset] : node;
+    };
+
+    stbrp_context ctx = {};
+
+    stbrp_init_target(
+        &ctx,
+        int(width  - padding),
+        int(height - padding),
+        nodes.data,
+        int(nodes.size)
+    );
+
+    ctx.active_head   = find_node(inout_ctx.active_head  );
+    ctx.free_head     = find_node(inout_ctx.free_head    );
+    ctx.extra[0].next = find_node(inout_ctx.extra[0].next);
+    ctx.extra[0].x    =           inout_ctx.extra[0].x    ;
+    ctx.extra[0].y    =           inout_ctx.extra[0].y    ;
+    // NOTE : Node `extra[1]` is a sentinel, so no need to patch it.
+
+    // TODO : It's possible that some special handling will be necessary if
+    //        the old context ran out of free nodes, but we're increasing
+    //        width. So do some special logic here (will need artifical test
+    //        as it's quite unlikely, I think).
+    ASSERT(
+        inout_ctx.free_head,
+        "stbrp context out of free nodes; handling not implemented."
+    );
+
+    for (size_t i = 0; i < inout_nodes.size - 1; i++)
+    {
+        nodes[i].x    =           inout_nodes[i].x;
+        nodes[i].y    =           inout_nodes[i].y;
+        nodes[i].next = find_node(inout_nodes[i].next);
+    }
+
+    inout_ctx = ctx; // We can do this safely as no nodes point to `ctx.extra`.
+    bx::swap(inout_nodes, nodes);
+
+    check_stbrp_context_validity(inout_ctx, inout_nodes);
+}
+
+bool pick_next_size(u32 min_area, u32 padding, u32* inout_size)
+{
+    const u32 max_size = bgfx::getCaps()->limits.maxTextureSize;
+    u32       size[2]  = { 64, 64 };
+
+    for (bool i = false;; i = !i)
+    {
+        if (size[0] > inout_size[0] || size[1] > inout_size[1])
+        {
+            const u32 area = (size[0] - padding) * (size[1] - padding);
+
+            if (area >= min_area * 1.075f) // 7.5 % extra space, as the packing won't be perfect.
+            {
+                break;
+            }
+        }
+
+        if (size[0] == max_size && size[1] == max_size)
+        {
+            TRACE("Maximum atlas size (%" PRIu32"^2) reached.", max_size);
+            return false;
+        }
+
+        size[i] *= 2;
+    }
+
+    inout_size[0] = size[0];
+    inout_size[1] = size[1];
+
+    return true;
+}
+
+void pack_rects(FontAtlas& atlas, u32 offset, u32 count, u32* inout_pack_size)
+{
+    constexpr f32 extra_area = 1.05f;
+
+    u32 min_area = 0;
+
+    for (u32 i = 0; i < atlas.pack_rects.size; i++)
+    {
+        min_area += u32(atlas.pack_rects[i].w * atlas.pack_rects[i].h);
+    }
+
+    min_area = u32(f32(min_area) * extra_area);
+
+    for (;;)
+    {
+        if (inout_pack_size[0] > 0 && inout_pack_size[1] > 0)
+        {
+            // TODO : It's maybe possible to revert the packing context without
+            //        having to make its full copy beforehand.
+            stbrp_context ctx = atlas.pack_ctx;
 
             DynamicArray<stbrp_node> nodes_backup;
             init(nodes_backup, atlas.pack_nodes.allocator); // TODO : Use temp allocator.
@@ -4550,864 +10455,1283 @@ void pack_rects(FontAtlas& atlas, u32 offset, u32 count, u32* inout_pack_size)
     }
 }
 
-void update(FontAtlas& atlas, TextureCache& textures, Allocator* temp_allocator)
+void update
+(
+    FontAtlas&    atlas,
+    TextureCache& textures,
+    ReleaseQueue& release_queue,
+    Allocator*    temp_allocator
+)
+{
+    ASSERT(
+        is_updatable(atlas) || !atlas.locked,
+        "Atlas not updatable or already locked."
+    );
+
+    if (!atlas.requests.size || atlas.locked)
+    {
+        return;
+    }
+
+    std::sort(
+        atlas.requests.data,
+        atlas.requests.data + atlas.requests.size
+    );
+
+    const u32* end = std::unique(
+        atlas.requests.data,
+        atlas.requests.data + atlas.requests.size
+    );
+
+    resize(atlas.requests, u32(end - atlas.requests.data));
+
+    ASSERT(
+        atlas.pack_rects.size == atlas.char_quads.size,
+        "Different packed rects and character quads sizes (%"
+        PRIu32 " != %" PRIu32 ").",
+        atlas.pack_rects.size,
+        atlas.char_quads.size
+    );
+
+    const u32 count  = atlas.requests  .size;
+    const u32 offset = atlas.pack_rects.size;
+
+    resize(atlas.pack_rects, offset + count, stbrp_rect       {});
+    resize(atlas.char_quads, offset + count, stbtt_packedchar {});
+
+    constexpr int H_OVERSAMPLE_MASK  = ATLAS_H_OVERSAMPLE_2X |
+                                       ATLAS_H_OVERSAMPLE_3X |
+                                       ATLAS_H_OVERSAMPLE_4X ;
+    constexpr int H_OVERSAMPLE_SHIFT = 3;
+    constexpr int V_OVERSAMPLE_MASK  = ATLAS_V_OVERSAMPLE_2X;
+    constexpr int V_OVERSAMPLE_SHIFT = 6;
+
+    const int h_oversample = 1 + ((atlas.flags & H_OVERSAMPLE_MASK) >> H_OVERSAMPLE_SHIFT);
+    const int v_oversample = 1 + ((atlas.flags & V_OVERSAMPLE_MASK) >> V_OVERSAMPLE_SHIFT);
+
+    ASSERT(
+        h_oversample >= 1 && h_oversample <= 4,
+        "Invalid horizontal oversampling %i.",
+        h_oversample
+    );
+
+    ASSERT(
+        v_oversample >= 1 && v_oversample <= 2,
+        "Invalid vertical oversampling %i.",
+        v_oversample
+    );
+
+    i16 cap_height = 0;
+    {
+        const int table = stbtt__find_table(
+            atlas.font_info.data,
+            atlas.font_info.fontstart,
+            "OS/2"
+        );
+
+        if (table && ttUSHORT(atlas.font_info.data + table) >= 2) // Version.
+        {
+            cap_height = ttSHORT(atlas.font_info.data + table + 88); // sCapHeight.
+        }
+
+        // TODO : Estimate cap height from capital `H` bounding box?
+        ASSERT(cap_height, "Can't determine cap height.");
+    };
+
+    int ascent, descent;
+    stbtt_GetFontVMetrics(&atlas.font_info, &ascent, &descent, nullptr);
+
+    // TODO : Fix possible division by zero.
+    const f32 font_scale = (ascent - descent) * atlas.font_size / cap_height;
+
+    stbtt_pack_context ctx            = {};
+    ctx.padding                       = atlas.padding;
+    ctx.h_oversample                  = h_oversample;
+    ctx.v_oversample                  = v_oversample;
+    ctx.skip_missing                  = 0;
+
+    stbtt_pack_range range            = {};
+    range.font_size                   = font_scale;
+    range.h_oversample                = h_oversample;
+    range.v_oversample                = v_oversample;
+    range.chardata_for_range          = atlas.char_quads.data + offset;
+    range.array_of_unicode_codepoints = reinterpret_cast<int*>(atlas.requests.data);
+    range.num_chars                   = int(atlas.requests.size);
+
+    (void)stbtt_PackFontRangesGatherRects(
+        &ctx,
+        &atlas.font_info,
+        &range,
+        1,
+        atlas.pack_rects.data + offset
+    );
+
+    u32 pack_size[] = { atlas.bitmap_width, atlas.bitmap_height };
+    pack_rects(atlas, offset, count, pack_size);
+
+    if (atlas.bitmap_width  != pack_size[0] ||
+        atlas.bitmap_height != pack_size[1])
+    {
+        DynamicArray<u8> data;
+        init(data, atlas.bitmap_data.allocator);
+        defer(deinit(data));
+        
+        resize(data, pack_size[0] * pack_size[1], u8(0));
+
+        for (u32 y = 0, src_offset = 0, dst_offset = 0; y < atlas.bitmap_height; y++)
+        {
+            bx::memCopy(
+                data.data + dst_offset,
+                atlas.bitmap_data.data + src_offset,
+                atlas.bitmap_width
+            );
+
+            src_offset += atlas.bitmap_width;
+            dst_offset += pack_size[0];
+        }
+
+        atlas.bitmap_width  = pack_size[0];
+        atlas.bitmap_height = pack_size[1];
+
+        bx::swap(data, atlas.bitmap_data);
+    }
+
+    ctx.width           = atlas.bitmap_width;
+    ctx.height          = atlas.bitmap_height;
+    ctx.stride_in_bytes = atlas.bitmap_width;
+    ctx.pixels          = atlas.bitmap_data.data;
+
+    // TODO : Utilize the return value.
+    (void)stbtt_PackFontRangesRenderIntoRects(
+        &ctx,
+        &atlas.font_info,
+        &range,
+        1,
+        atlas.pack_rects.data + offset
+    );
+
+    // TODO : We should only update the texture if the size didn't change.
+    add_texture(
+        textures,
+        release_queue,
+        atlas.texture,
+        TEXTURE_R8,
+        atlas.bitmap_width,
+        atlas.bitmap_height,
+        0,
+        atlas.bitmap_data.data,
+        temp_allocator
+    );
+
+    for (u32 i = 0; i < atlas.requests.size; i++)
+    {
+        insert(atlas.codepoints, atlas.requests[i], u16(offset + i));
+    }
+
+    clear(atlas.requests);
+
+    if (!is_updatable(atlas))
+    {
+        atlas.locked = true;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// TEXT MESH RECORDING
+// -----------------------------------------------------------------------------
+
+using QuadCharPackFunc = void (*)(const stbtt_packedchar&, f32, f32, f32&, stbtt_aligned_quad&);
+
+template <bool YAxisDown, bool UseTexCoord, bool AlignToInt>
+void pack_char_quad
+(
+    const stbtt_packedchar& char_info,
+    f32                     inv_width,
+    f32                     inv_height,
+    f32&                    inout_xpos,
+    stbtt_aligned_quad&     out_quad
+)
+{
+    if constexpr (AlignToInt)
+    {
+        const f32 x = floorf(inout_xpos + char_info.xoff + 0.5f);
+        const f32 y = floorf(             char_info.yoff + 0.5f);
+
+        out_quad.x0 = x;
+        out_quad.x1 = x + char_info.xoff2 - char_info.xoff;
+
+        if constexpr (YAxisDown)
+        {
+            out_quad.y0 = y;
+            out_quad.y1 = y + char_info.yoff2 - char_info.yoff;
+        }
+        else
+        {
+            out_quad.y0 = -y;
+            out_quad.y1 = -y - char_info.yoff2 + char_info.yoff;
+        }
+    }
+    else
+    {
+        out_quad.x0 = inout_xpos + char_info.xoff;
+        out_quad.x1 = inout_xpos + char_info.xoff2;
+
+        if constexpr (YAxisDown)
+        {
+            out_quad.y0 = char_info.yoff;
+            out_quad.y1 = char_info.yoff2;
+        }
+        else
+        {
+            out_quad.y0 = -char_info.yoff;
+            out_quad.y1 = -char_info.yoff2;
+        }
+    }
+
+    if constexpr (UseTexCoord)
+    {
+        out_quad.s0 = char_info.x0 * inv_width;
+        out_quad.t0 = char_info.y0 * inv_height;
+        out_quad.s1 = char_info.x1 * inv_width;
+        out_quad.t1 = char_info.y1 * inv_height;
+    }
+    else
+    {
+        out_quad.s0 = char_info.x0;
+        out_quad.t0 = char_info.y0;
+        out_quad.s1 = char_info.x1;
+        out_quad.t1 = char_info.y1;
+    }
+
+    inout_xpos += char_info.xadvance;
+}
+
+const FixedArray<QuadCharPackFunc, 8> quad_char_pack_funcs =
+{{
+    //        +------------------- YAxisDown
+    //        |  +---------------- UseTexCoord
+    //        |  |  +------------- AlignToInt
+    //        |  |  |
+    pack_char_quad<0, 0, 0>,
+    pack_char_quad<0, 0, 1>,
+    pack_char_quad<0, 1, 0>,
+    pack_char_quad<0, 1, 1>,
+    pack_char_quad<1, 0, 0>,
+    pack_char_quad<1, 0, 1>,
+    pack_char_quad<1, 1, 0>,
+    pack_char_quad<1, 1, 1>,
+}};
+
+constexpr u32 quad_char_pack_func_index
+(
+    bool y_axis_down,
+    bool use_tex_coord,
+    bool align_to_int
+)
 {
-    ASSERT(
-        is_updatable(atlas) || !atlas.locked,
-        "Atlas not updatable or already locked."
-    );
+    constexpr u8 axes  [] = { 0, 0b100 }; // Bit 2.
+    constexpr u8 coords[] = { 0, 0b010 }; // Bit 1.
+    constexpr u8 aligns[] = { 0, 0b001 }; // Bit 0.
 
-    if (!atlas.requests.size || atlas.locked)
+    return
+        axes  [y_axis_down  ] |
+        coords[use_tex_coord] |
+        aligns[align_to_int ] ;
+}
+
+// Glyph corner with the transform that the text mesh's positions get in
+// `vertex`, i.e., only the 2D affine part of it for `TEXT_POSITION_2D`.
+template <bool IsPosition2D>
+Vec3 transform_glyph_corner(const Mat4& transform, f32 x, f32 y)
+{
+    if constexpr (IsPosition2D)
     {
-        return;
+        return transform_affine_2d(transform, x, y);
+    }
+    else
+    {
+        return (transform * HMM_Vec4(x, y, 0.0f, 1.0f)).XYZ;
     }
+}
 
-    std::sort(
-        atlas.requests.data,
-        atlas.requests.data + atlas.requests.size
-    );
+template <bool IsPosition2D>
+const char* record_quads_without_lock
+(
+    const FontAtlas&        atlas,
+    const char*             start,
+    const char*             end,
+    const QuadCharPackFunc& pack_func,
+    const Mat4&             transform,
+    MeshRecorder&           inout_recorder
+)
+{
+    // NOTE : This routine assumes all needed glyphs are loaded in the atlas!
 
-    const u32* end = std::unique(
-        atlas.requests.data,
-        atlas.requests.data + atlas.requests.size
-    );
+    const f32 inv_width  = 1.0f / f32(atlas.bitmap_width );
+    const f32 inv_height = 1.0f / f32(atlas.bitmap_height);
 
-    resize(atlas.requests, u32(end - atlas.requests.data));
+    u32 codepoint;
+    u32 state = 0;
+    f32 x     = 0.0f;
 
-    ASSERT(
-        atlas.pack_rects.size == atlas.char_quads.size,
-        "Different packed rects and character quads sizes (%"
-        PRIu32 " != %" PRIu32 ").",
-        atlas.pack_rects.size,
-        atlas.char_quads.size
-    );
+    stbtt_aligned_quad quad = {};
 
-    const u32 count  = atlas.requests  .size;
-    const u32 offset = atlas.pack_rects.size;
+    for (; end ? start < end : *start; start++)
+    {
+        if (UTF8_ACCEPT == utf8_decode(state, *reinterpret_cast<const u8*>(start), codepoint))
+        {
+            if (codepoint == '\n') // TODO : Other line terminators?
+            {
+                start++;
+                break;
+            }
 
-    resize(atlas.pack_rects, offset + count, stbrp_rect       {});
-    resize(atlas.char_quads, offset + count, stbtt_packedchar {});
+            const u16 idx = offset(atlas.codepoints, codepoint);
+            ASSERT(
+                idx != U16_MAX,
+                "Codepoint %" PRIu32 " not in the atlas.",
+                codepoint
+            );
 
-    constexpr int H_OVERSAMPLE_MASK  = ATLAS_H_OVERSAMPLE_2X |
-                                       ATLAS_H_OVERSAMPLE_3X |
-                                       ATLAS_H_OVERSAMPLE_4X ;
-    constexpr int H_OVERSAMPLE_SHIFT = 3;
-    constexpr int V_OVERSAMPLE_MASK  = ATLAS_V_OVERSAMPLE_2X;
-    constexpr int V_OVERSAMPLE_SHIFT = 6;
+            (*pack_func)(atlas.char_quads[idx], inv_width, inv_height, x, quad);
 
-    const int h_oversample = 1 + ((atlas.flags & H_OVERSAMPLE_MASK) >> H_OVERSAMPLE_SHIFT);
-    const int v_oversample = 1 + ((atlas.flags & V_OVERSAMPLE_MASK) >> V_OVERSAMPLE_SHIFT);
+            #define CORNER(i, j) \
+                (*inout_recorder.attrib_state.store_texcoord)( \
+                    inout_recorder.attrib_state, \
+                    quad.s##i, quad.t##j \
+                ); \
+                (*inout_recorder.store_vertex)( \
+                    transform_glyph_corner<IsPosition2D>(transform, quad.x##i, quad.y##j), \
+                    inout_recorder.attrib_state, \
+                    inout_recorder \
+                )
 
-    ASSERT(
-        h_oversample >= 1 && h_oversample <= 4,
-        "Invalid horizontal oversampling %i.",
-        h_oversample
-    );
+            CORNER(0, 0);
+            CORNER(0, 1);
+            CORNER(1, 1);
+            CORNER(1, 0);
+        }
+    }
 
-    ASSERT(
-        v_oversample >= 1 && v_oversample <= 2,
-        "Invalid vertical oversampling %i.",
-        v_oversample
-    );
+    ASSERT(state == UTF8_ACCEPT, "Ill-formated UTF-8 string.");
 
-    i16 cap_height = 0;
+    return start;
+}
+
+const char* record_quads
+(
+    FontAtlas&              atlas,
+    const char*             start,
+    const char*             end,
+    const QuadCharPackFunc& pack_func,
+    const Mat4&             transform,
+    bool                    position_2d,
+    MeshRecorder&           inout_recorder
+)
+{
+    const auto record_quads_func = position_2d
+        ? record_quads_without_lock<true >
+        : record_quads_without_lock<false>;
+
+    if (!is_updatable(atlas) || (atlas.flags & ATLAS_NOT_THREAD_SAFE))
     {
-        const int table = stbtt__find_table(
-            atlas.font_info.data,
-            atlas.font_info.fontstart,
-            "OS/2"
+        return (*record_quads_func)(
+            atlas, start, end, pack_func, transform, inout_recorder
         );
+    }
+    else
+    {
+        MutexScope lock(atlas.mutex);
 
-        if (table && ttUSHORT(atlas.font_info.data + table) >= 2) // Version.
-        {
-            cap_height = ttSHORT(atlas.font_info.data + table + 88); // sCapHeight.
-        }
+        return (*record_quads_func)(
+            atlas, start, end, pack_func, transform, inout_recorder
+        );
+    }
+}
 
-        // TODO : Estimate cap height from capital `H` bounding box?
-        ASSERT(cap_height, "Can't determine cap height.");
+
+// -----------------------------------------------------------------------------
+// TEXT RECORDING
+// -----------------------------------------------------------------------------
+
+struct TextRecorder
+{
+    // MeshRecorder mesh_recorder = nullptr;
+    FontAtlas* atlas;
+    f32        line_height;
+    u16        h_alignment;
+    u16        v_alignment;
+    bool       y_axis_down;
+    bool       align_to_int;
+    bool       position_2d;
+};
+
+void start(TextRecorder& recorder, u32 flags, FontAtlas& atlas)
+{
+    constexpr u16 h_aligns[] =
+    {
+        TEXT_H_ALIGN_LEFT  ,
+        TEXT_H_ALIGN_CENTER,
+        TEXT_H_ALIGN_RIGHT ,
     };
 
-    int ascent, descent;
-    stbtt_GetFontVMetrics(&atlas.font_info, &ascent, &descent, nullptr);
+    constexpr u16 v_aligns[] =
+    {
+        TEXT_V_ALIGN_BASELINE  ,
+        TEXT_V_ALIGN_MIDDLE    ,
+        TEXT_V_ALIGN_CAP_HEIGHT,
+    };
 
-    // TODO : Fix possible division by zero.
-    const f32 font_scale = (ascent - descent) * atlas.font_size / cap_height;
+    constexpr u16 y_axes[] =
+    {
+        TEXT_Y_AXIS_DOWN,
+        TEXT_Y_AXIS_UP  ,
+    };
 
-    stbtt_pack_context ctx            = {};
-    ctx.padding                       = atlas.padding;
-    ctx.h_oversample                  = h_oversample;
-    ctx.v_oversample                  = v_oversample;
-    ctx.skip_missing                  = 0;
+    recorder.atlas        = &atlas;
+    recorder.line_height  = 2.0f;
+    recorder.h_alignment  = h_aligns[(flags & TEXT_H_ALIGN_MASK) >> TEXT_H_ALIGN_SHIFT];
+    recorder.v_alignment  = v_aligns[(flags & TEXT_V_ALIGN_MASK) >> TEXT_V_ALIGN_SHIFT];
+    recorder.y_axis_down  = y_axes  [(flags & TEXT_Y_AXIS_MASK ) >> TEXT_Y_AXIS_SHIFT ];
+    recorder.align_to_int = flags & TEXT_ALIGN_TO_INTEGER;
+    recorder.position_2d  = flags & TEXT_POSITION_2D;
+}
 
-    stbtt_pack_range range            = {};
-    range.font_size                   = font_scale;
-    range.h_oversample                = h_oversample;
-    range.v_oversample                = v_oversample;
-    range.chardata_for_range          = atlas.char_quads.data + offset;
-    range.array_of_unicode_codepoints = reinterpret_cast<int*>(atlas.requests.data);
-    range.num_chars                   = int(atlas.requests.size);
+// Two-pass:
+// 1) Gather info about text; possibly signal missing glyphs and return.
+// 2) Submit quads to the recorder.
+bool record_text
+(
+    const char*         start,
+    const char*         end,
+    const TextRecorder& recorder,
+    const Mat4&         transform,
+    Allocator*          temp_allocator,
+    MeshRecorder&       out_mesh_recorder
+)
+{
+    const f32 font_size   = recorder.atlas->font_size;
+    const f32 line_sign   = recorder.y_axis_down ? 1.0f : -1.0f;
+    const f32 line_height = roundf(font_size * recorder.line_height);
+    f32       line_width  = 0.0f;
+    f32       box_width   = 0.0f;
+    f32       box_height  = font_size;
 
-    (void)stbtt_PackFontRangesGatherRects(
-        &ctx,
-        &atlas.font_info,
-        &range,
-        1,
-        atlas.pack_rects.data + offset
-    );
+    const bool needs_line_widths = recorder.h_alignment != TEXT_H_ALIGN_LEFT;
 
-    u32 pack_size[] = { atlas.bitmap_width, atlas.bitmap_height };
-    pack_rects(atlas, offset, count, pack_size);
+    DynamicArray<f32> line_widths;
+    init(line_widths, temp_allocator);
+    defer(deinit(line_widths));
 
-    if (atlas.bitmap_width  != pack_size[0] ||
-        atlas.bitmap_height != pack_size[1])
+    if (needs_line_widths)
     {
-        DynamicArray<u8> data;
-        init(data, atlas.bitmap_data.allocator);
-        defer(deinit(data));
-        
-        resize(data, pack_size[0] * pack_size[1], u8(0));
+        reserve(line_widths, 16);
+    }
 
-        for (u32 y = 0, src_offset = 0, dst_offset = 0; y < atlas.bitmap_height; y++)
+    u32 codepoint = 0;
+    u32 state     = 0;
+
+    // Pass 1: Gather info about text, signal missing glyphs.
+    for (const char* string = start; end ? string < end : *string; string++)
+    {
+        if (UTF8_ACCEPT == utf8_decode(state, *reinterpret_cast<const u8*>(string), codepoint))
         {
-            bx::memCopy(
-                data.data + dst_offset,
-                atlas.bitmap_data.data + src_offset,
-                atlas.bitmap_width
-            );
+            if (codepoint == '\n') // TODO : Other line terminators?
+            {
+                if (needs_line_widths)
+                {
+                    append(line_widths, line_width);
+                }
 
-            src_offset += atlas.bitmap_width;
-            dst_offset += pack_size[0];
-        }
+                box_height += line_height;
+                box_width   = bx::max(box_width, line_width);
+                line_width  = 0.0f;
 
-        atlas.bitmap_width  = pack_size[0];
-        atlas.bitmap_height = pack_size[1];
+                continue;
+            }
 
-        bx::swap(data, atlas.bitmap_data);
-    }
+            const u16 idx = offset(recorder.atlas->codepoints, codepoint);
 
-    ctx.width           = atlas.bitmap_width;
-    ctx.height          = atlas.bitmap_height;
-    ctx.stride_in_bytes = atlas.bitmap_width;
-    ctx.pixels          = atlas.bitmap_data.data;
+            if (idx == U16_MAX)
+            {
+                if (is_updatable(*recorder.atlas))
+                {
+                    return false;
+                }
+                else
+                {
+                    // TODO : Probably just print some warning and skip the
+                    //        glyph (try using the atlas' "missing" glyph).
+                    ASSERT(false, "Immutable atlas cannot be updated.");
+                }
+            }
 
-    // TODO : Utilize the return value.
-    (void)stbtt_PackFontRangesRenderIntoRects(
-        &ctx,
-        &atlas.font_info,
-        &range,
-        1,
-        atlas.pack_rects.data + offset
-    );
+            // TODO : Needs to reflect `align_to_integer`.
+            line_width += recorder.atlas->char_quads[idx].xadvance;
+        }
+    }
 
-    // TODO : We should only update the texture if the size didn't change.
-    add_texture(
-        textures,
-        atlas.texture,
-        TEXTURE_R8,
-        atlas.bitmap_width,
-        atlas.bitmap_height,
-        0,
-        atlas.bitmap_data.data,
-        temp_allocator
-    );
+    ASSERT(state == UTF8_ACCEPT, "Ill-formated UTF-8 string.");
 
-    for (u32 i = 0; i < atlas.requests.size; i++)
+    if (needs_line_widths)
     {
-        insert(atlas.codepoints, atlas.requests[i], u16(offset + i));
+        append(line_widths, line_width);
     }
 
-    clear(atlas.requests);
+    box_width = bx::max(box_width, line_width);
 
-    if (!is_updatable(atlas))
+    if (box_width == 0.0f)
     {
-        atlas.locked = true;
+        return true;
     }
-}
-
-
-// -----------------------------------------------------------------------------
-// TEXT MESH RECORDING
-// -----------------------------------------------------------------------------
 
-using QuadCharPackFunc = void (*)(const stbtt_packedchar&, f32, f32, f32&, stbtt_aligned_quad&);
+    // Pass 2: Submit quads to the recorder.
+    Vec3 offset   = HMM_Vec3(0.0f, 0.0f, 0.0f);
+    u16  line_idx = 0;
 
-template <bool YAxisDown, bool UseTexCoord, bool AlignToInt>
-void pack_char_quad
-(
-    const stbtt_packedchar& char_info,
-    f32                     inv_width,
-    f32                     inv_height,
-    f32&                    inout_xpos,
-    stbtt_aligned_quad&     out_quad
-)
-{
-    if constexpr (AlignToInt)
+    switch (recorder.v_alignment)
     {
-        const f32 x = floorf(inout_xpos + char_info.xoff + 0.5f);
-        const f32 y = floorf(             char_info.yoff + 0.5f);
+    case TEXT_V_ALIGN_BASELINE:
+        offset.Y = line_sign * (font_size - box_height);
+        break;
+    case TEXT_V_ALIGN_MIDDLE:
+        offset.Y = roundf(line_sign * (box_height * -0.5f + font_size));
+        break;
+    case TEXT_V_ALIGN_CAP_HEIGHT:
+        offset.Y = line_sign * font_size;
+        break;
+    default:;
+    }
 
-        out_quad.x0 = x;
-        out_quad.x1 = x + char_info.xoff2 - char_info.xoff;
+    const u32 idx = quad_char_pack_func_index(
+        recorder.y_axis_down,
+        !is_updatable(*recorder.atlas),
+        recorder.align_to_int
+    );
 
-        if constexpr (YAxisDown)
-        {
-            out_quad.y0 = y;
-            out_quad.y1 = y + char_info.yoff2 - char_info.yoff;
-        }
-        else
-        {
-            out_quad.y0 = -y;
-            out_quad.y1 = -y - char_info.yoff2 + char_info.yoff;
-        }
-    }
-    else
-    {
-        out_quad.x0 = inout_xpos + char_info.xoff;
-        out_quad.x1 = inout_xpos + char_info.xoff2;
+    const QuadCharPackFunc pack_func = quad_char_pack_funcs[idx];
 
-        if constexpr (YAxisDown)
-        {
-            out_quad.y0 = char_info.yoff;
-            out_quad.y1 = char_info.yoff2;
-        }
-        else
+    for (const char* string = start; end ? string < end : *string; line_idx++)
+    {
+        switch (recorder.h_alignment)
         {
-            out_quad.y0 = -char_info.yoff;
-            out_quad.y1 = -char_info.yoff2;
+        case TEXT_H_ALIGN_CENTER:
+            offset.X = line_widths[line_idx] * -0.5f;
+            break;
+        case TEXT_H_ALIGN_RIGHT:
+            offset.X = -line_widths[line_idx];
+            break;
+        default:;
         }
-    }
 
-    if constexpr (UseTexCoord)
-    {
-        out_quad.s0 = char_info.x0 * inv_width;
-        out_quad.t0 = char_info.y0 * inv_height;
-        out_quad.s1 = char_info.x1 * inv_width;
-        out_quad.t1 = char_info.y1 * inv_height;
-    }
-    else
-    {
-        out_quad.s0 = char_info.x0;
-        out_quad.t0 = char_info.y0;
-        out_quad.s1 = char_info.x1;
-        out_quad.t1 = char_info.y1;
+        string = record_quads
+        (
+            *recorder.atlas,
+            string,
+            end,
+            pack_func,
+            transform * HMM_Translate(offset),
+            recorder.position_2d,
+            out_mesh_recorder
+        );
+
+        offset.Y += line_sign * line_height;
     }
 
-    inout_xpos += char_info.xadvance;
+    return true;
 }
 
-const FixedArray<QuadCharPackFunc, 8> quad_char_pack_funcs =
-{{
-    //        +------------------- YAxisDown
-    //        |  +---------------- UseTexCoord
-    //        |  |  +------------- AlignToInt
-    //        |  |  |
-    pack_char_quad<0, 0, 0>,
-    pack_char_quad<0, 0, 1>,
-    pack_char_quad<0, 1, 0>,
-    pack_char_quad<0, 1, 1>,
-    pack_char_quad<1, 0, 0>,
-    pack_char_quad<1, 0, 1>,
-    pack_char_quad<1, 1, 0>,
-    pack_char_quad<1, 1, 1>,
-}};
 
-constexpr u32 quad_char_pack_func_index
-(
-    bool y_axis_down,
-    bool use_tex_coord,
-    bool align_to_int
-)
+// -----------------------------------------------------------------------------
+// TASK MANAGEMENT
+// -----------------------------------------------------------------------------
+
+using TaskScheduler = enki::TaskScheduler;
+
+struct TaskPool;
+
+struct Task : enki::ITaskSet
+{
+    void    (*func)(void*) = nullptr;
+    void*     data         = nullptr;
+    TaskPool* pool         = nullptr;
+
+    void ExecuteRange(enki::TaskSetPartition, u32) override;
+};
+
+struct TaskPool
+{
+    Mutex                       mutex;
+    FixedArray<Task, MAX_TASKS> tasks;
+    FixedArray<u8  , MAX_TASKS> nexts;
+    u8                          head = 0;
+
+    static_assert(
+        MAX_TASKS < U8_MAX,
+        "`MAX_TASKS` too big, change the ID type to a bigger type."
+    );
+};
+
+void init(TaskPool& pool)
 {
-    constexpr u8 axes  [] = { 0, 0b100 }; // Bit 2.
-    constexpr u8 coords[] = { 0, 0b010 }; // Bit 1.
-    constexpr u8 aligns[] = { 0, 0b001 }; // Bit 0.
-
-    return
-        axes  [y_axis_down  ] |
-        coords[use_tex_coord] |
-        aligns[align_to_int ] ;
+    for (u8 i = 0; i < pool.tasks.size; i++)
+    {
+        pool.tasks[i].pool = &pool;
+        pool.nexts[i]      = i + 1;
+    }
 }
 
-const char* record_quads_without_lock
-(
-    const FontAtlas&        atlas,
-    const char*             start,
-    const char*             end,
-    const QuadCharPackFunc& pack_func,
-    const Mat4&             transform,
-    MeshRecorder&           inout_recorder
-)
+Task* acquire_task(TaskPool& pool)
 {
-    // NOTE : This routine assumes all needed glyphs are loaded in the atlas!
-
-    const f32 inv_width  = 1.0f / f32(atlas.bitmap_width );
-    const f32 inv_height = 1.0f / f32(atlas.bitmap_height);
-
-    u32 codepoint;
-    u32 state = 0;
-    f32 x     = 0.0f;
+    MutexScope lock(pool.mutex);
 
-    stbtt_aligned_quad quad = {};
+    Task* task = nullptr;
 
-    for (; end ? start < end : *start; start++)
+    if (pool.head < pool.tasks.size)
     {
-        if (UTF8_ACCEPT == utf8_decode(state, *reinterpret_cast<const u8*>(start), codepoint))
-        {
-            if (codepoint == '\n') // TODO : Other line terminators?
-            {
-                start++;
-                break;
-            }
+        const u32 i = pool.head;
 
-            const u16 idx = offset(atlas.codepoints, codepoint);
-            ASSERT(
-                idx != U16_MAX,
-                "Codepoint %" PRIu32 " not in the atlas.",
-                codepoint
-            );
+        task          = &pool.tasks[i];
+        pool.head     =  pool.nexts[i];
+        pool.nexts[i] =  pool.tasks.size;
+    }
 
-            (*pack_func)(atlas.char_quads[idx], inv_width, inv_height, x, quad);
+    return task;
+}
 
-            #define CORNER(i, j) \
-                (*inout_recorder.attrib_state.store_texcoord)( \
-                    inout_recorder.attrib_state, \
-                    quad.s##i, quad.t##j \
-                ); \
-                (*inout_recorder.store_vertex)( \
-                    (transform * HMM_Vec4(quad.x##i, quad.y##j, 0.0f, 1.0f)).XYZ, \
-                    inout_recorder.attrib_state, \
-                    inout_recorder \
-                )
+void release_task(TaskPool& pool, const Task* task)
+{
+    ASSERT(task, "Invalid task pointer.");
+    ASSERT(
+        task >= &pool.tasks[0] && task <= &pool.tasks[pool.tasks.size - 1],
+        "Task not owned by the pool."
+    );
 
-            CORNER(0, 0);
-            CORNER(0, 1);
-            CORNER(1, 1);
-            CORNER(1, 0);
-        }
-    }
+    MutexScope lock(pool.mutex);
 
-    ASSERT(state == UTF8_ACCEPT, "Ill-formated UTF-8 string.");
+    const ptrdiff_t i = task - &pool.tasks[0];
 
-    return start;
+    pool.tasks[i].func = nullptr;
+    pool.tasks[i].data = nullptr;
+    pool.nexts[i]      = pool.head;
+    pool.head          = u8(i);
 }
 
-const char* record_quads
-(
-    FontAtlas&              atlas,
-    const char*             start,
-    const char*             end,
-    const QuadCharPackFunc& pack_func,
-    const Mat4&             transform,
-    MeshRecorder&           inout_recorder
-)
+void Task::ExecuteRange(enki::TaskSetPartition, u32)
 {
-    if (!is_updatable(atlas) || (atlas.flags & ATLAS_NOT_THREAD_SAFE))
-    {
-        return record_quads_without_lock(
-            atlas, start, end, pack_func, transform, inout_recorder
-        );
-    }
-    else
-    {
-        MutexScope lock(atlas.mutex);
+    ASSERT(func, "Invalid task function pointer.");
+    ASSERT(pool, "Invalid taks pool pointer.");
 
-        return record_quads_without_lock(
-            atlas, start, end, pack_func, transform, inout_recorder
-        );
-    }
+    (*func)(data);
+
+    release_task(*pool, this);
 }
 
 
 // -----------------------------------------------------------------------------
-// TEXT RECORDING
+// FONT ATLAS CACHE
 // -----------------------------------------------------------------------------
 
-struct TextRecorder
+struct FontAtlasCache
 {
-    // MeshRecorder mesh_recorder = nullptr;
-    FontAtlas* atlas;
-    f32        line_height;
-    u16        h_alignment;
-    u16        v_alignment;
-    bool       y_axis_down;
-    bool       align_to_int;
+    Mutex                                   mutex;
+    FixedArray<FontAtlas, MAX_FONT_ATLASES> atlases;
+    DynamicArray<u8>                        indices; // Indexed by texture ID.
+
+    static_assert(
+        MAX_FONT_ATLASES < U8_MAX,
+        "Insufficient texture-to-atlas mapping index. Change type size."
+    );
 };
 
-void start(TextRecorder& recorder, u32 flags, FontAtlas& atlas)
+void init(FontAtlasCache& cache, Allocator* allocator, u32 texture_count)
 {
-    constexpr u16 h_aligns[] =
-    {
-        TEXT_H_ALIGN_LEFT  ,
-        TEXT_H_ALIGN_CENTER,
-        TEXT_H_ALIGN_RIGHT ,
-    };
+    ASSERT(allocator, "Invalid allocator pointer.");
 
-    constexpr u16 v_aligns[] =
+    for (u32 i = 0; i < cache.atlases.size; i++)
     {
-        TEXT_V_ALIGN_BASELINE  ,
-        TEXT_V_ALIGN_MIDDLE    ,
-        TEXT_V_ALIGN_CAP_HEIGHT,
-    };
+        init(cache.atlases[i], allocator);
+    }
 
-    constexpr u16 y_axes[] =
+    init(cache.indices, allocator);
+    resize(cache.indices, texture_count, u8(U8_MAX));
+}
+
+void deinit(FontAtlasCache& cache)
+{
+    for (u32 i = 0; i < cache.atlases.size; i++)
     {
-        TEXT_Y_AXIS_DOWN,
-        TEXT_Y_AXIS_UP  ,
-    };
+        deinit(cache.atlases[i]);
+    }
 
-    recorder.atlas        = &atlas;
-    recorder.line_height  = 2.0f;
-    recorder.h_alignment  = h_aligns[(flags & TEXT_H_ALIGN_MASK) >> TEXT_H_ALIGN_SHIFT];
-    recorder.v_alignment  = v_aligns[(flags & TEXT_V_ALIGN_MASK) >> TEXT_V_ALIGN_SHIFT];
-    recorder.y_axis_down  = y_axes  [(flags & TEXT_Y_AXIS_MASK ) >> TEXT_Y_AXIS_SHIFT ];
-    recorder.align_to_int = flags & TEXT_ALIGN_TO_INTEGER;
+    deinit(cache.indices);
 }
 
-// Two-pass:
-// 1) Gather info about text; possibly signal missing glyphs and return.
-// 2) Submit quads to the recorder.
-bool record_text
-(
-    const char*         start,
-    const char*         end,
-    const TextRecorder& recorder,
-    const Mat4&         transform,
-    Allocator*          temp_allocator,
-    MeshRecorder&       out_mesh_recorder
-)
+FontAtlas* acquire_atlas(FontAtlasCache& cache, u32 id)
 {
-    const f32 font_size   = recorder.atlas->font_size;
-    const f32 line_sign   = recorder.y_axis_down ? 1.0f : -1.0f;
-    const f32 line_height = roundf(font_size * recorder.line_height);
-    f32       line_width  = 0.0f;
-    f32       box_width   = 0.0f;
-    f32       box_height  = font_size;
+    MutexScope lock(cache.mutex);
 
-    const bool needs_line_widths = recorder.h_alignment != TEXT_H_ALIGN_LEFT;
+    if (cache.indices[id] != U8_MAX)
+    {
+        return &cache.atlases[cache.indices[id]];
+    }
 
-    DynamicArray<f32> line_widths;
-    init(line_widths, temp_allocator);
-    defer(deinit(line_widths));
+    for (u32 i = 0; i < cache.atlases.size; i++)
+    {
+        if (cache.atlases[i].flags & ATLAS_FREE)
+        {
+            cache.indices[id] = u8(i);
 
-    if (needs_line_widths)
+            // TODO : Consider "locking" the atlas for others until it's released.
+
+            return &cache.atlases[i];
+        }
+    }
+
+    TRACE("No more free atlas slots.");
+
+    return nullptr;
+}
+
+FontAtlas* fetch_atlas(FontAtlasCache& cache, u32 id)
+{
+    if (cache.indices[id] != U8_MAX)
     {
-        reserve(line_widths, 16);
+        return &cache.atlases[cache.indices[id]];
     }
 
-    u32 codepoint = 0;
-    u32 state     = 0;
+    return nullptr;
+}
 
-    // Pass 1: Gather info about text, signal missing glyphs.
-    for (const char* string = start; end ? string < end : *string; string++)
+void release_atlas
+(
+    FontAtlasCache& cache,
+    u32             id,
+    TextureCache&   textures,
+    ReleaseQueue&   release_queue
+)
+{
+    MutexScope lock(cache.mutex);
+
+    if (cache.indices[id] != U8_MAX)
     {
-        if (UTF8_ACCEPT == utf8_decode(state, *reinterpret_cast<const u8*>(string), codepoint))
-        {
-            if (codepoint == '\n') // TODO : Other line terminators?
-            {
-                if (needs_line_widths)
-                {
-                    append(line_widths, line_width);
-                }
+        release(cache.atlases[cache.indices[id]], textures, release_queue);
 
-                box_height += line_height;
-                box_width   = bx::max(box_width, line_width);
-                line_width  = 0.0f;
+        cache.indices[id] = U8_MAX;
+    }
+}
 
-                continue;
-            }
+// Releases all atlases created from given font data.
+void release_atlases
+(
+    FontAtlasCache& cache,
+    const void*     font,
+    TextureCache&   textures,
+    ReleaseQueue&   release_queue
+)
+{
+    MutexScope lock(cache.mutex);
 
-            const u16 idx = offset(recorder.atlas->codepoints, codepoint);
+    for (u32 i = 0; i < cache.atlases.size; i++)
+    {
+        FontAtlas& atlas = cache.atlases[i];
 
-            if (idx == U16_MAX)
+        if (!(atlas.flags & ATLAS_FREE) && atlas.font_info.data == font)
+        {
+            if (atlas.texture != U16_MAX)
             {
-                if (is_updatable(*recorder.atlas))
-                {
-                    return false;
-                }
-                else
-                {
-                    // TODO : Probably just print some warning and skip the
-                    //        glyph (try using the atlas' "missing" glyph).
-                    ASSERT(false, "Immutable atlas cannot be updated.");
-                }
+                cache.indices[atlas.texture] = U8_MAX;
             }
 
-            // TODO : Needs to reflect `align_to_integer`.
-            line_width += recorder.atlas->char_quads[idx].xadvance;
+            release(atlas, textures, release_queue);
         }
     }
+}
 
-    ASSERT(state == UTF8_ACCEPT, "Ill-formated UTF-8 string.");
 
-    if (needs_line_widths)
+// -----------------------------------------------------------------------------
+// FONT DATA CACHE
+// -----------------------------------------------------------------------------
+
+using FontDataCache = FixedArray<const void*, MAX_FONTS>;
+
+void add_font_data(FontDataCache& cache, u32 id, const void* data)
+{
+    cache[id] = data;
+}
+
+
+// -----------------------------------------------------------------------------
+// MEMORY MANAGEMENT & CACHING
+// -----------------------------------------------------------------------------
+
+struct PersistentMemoryCache
+{
+    Mutex               mutex;
+    DynamicArray<void*> blocks;
+};
+
+void init(PersistentMemoryCache& cache, Allocator* allocator)
+{
+    ASSERT(allocator, "Invalid allocator pointer.");
+
+    init(cache.blocks, allocator);
+}
+
+void deinit(PersistentMemoryCache& cache)
+{
+    for (u32 i = 0; i < cache.blocks.size; i++)
     {
-        append(line_widths, line_width);
+        BX_ALIGNED_FREE(
+            cache.blocks.allocator,
+            cache.blocks[i],
+            MANAGED_MEMORY_ALIGNMENT
+        );
     }
 
-    box_width = bx::max(box_width, line_width);
+    deinit(cache.blocks);
+}
 
-    if (box_width == 0.0f)
+void* alloc(PersistentMemoryCache& cache, u32 size)
+{
+    if (!size)
     {
-        return true;
+        return nullptr;
     }
 
-    // Pass 2: Submit quads to the recorder.
-    Vec3 offset   = HMM_Vec3(0.0f, 0.0f, 0.0f);
-    u16  line_idx = 0;
+    void* memory = BX_ALIGNED_ALLOC(
+        cache.blocks.allocator,
+        size,
+        MANAGED_MEMORY_ALIGNMENT
+    );
+    WARN(memory, "Persistent memory allocation of %" PRIu32 " bytes failed.", size);
 
-    switch (recorder.v_alignment)
+    if (memory)
     {
-    case TEXT_V_ALIGN_BASELINE:
-        offset.Y = line_sign * (font_size - box_height);
-        break;
-    case TEXT_V_ALIGN_MIDDLE:
-        offset.Y = roundf(line_sign * (box_height * -0.5f + font_size));
-        break;
-    case TEXT_V_ALIGN_CAP_HEIGHT:
-        offset.Y = line_sign * font_size;
-        break;
-    default:;
+        MutexScope lock(cache.mutex);
+
+        append(cache.blocks, memory);
     }
 
-    const u32 idx = quad_char_pack_func_index(
-        recorder.y_axis_down,
-        !is_updatable(*recorder.atlas),
-        recorder.align_to_int
-    );
+    return memory;
+}
 
-    const QuadCharPackFunc pack_func = quad_char_pack_funcs[idx];
+void dealloc(PersistentMemoryCache& cache, void* memory)
+{
+    if (!memory)
+    {
+        return;
+    }
 
-    for (const char* string = start; end ? string < end : *string; line_idx++)
+    MutexScope lock(cache.mutex);
+
+    for (u32 i = 0; i < cache.blocks.size; i++)
     {
-        switch (recorder.h_alignment)
+        if (cache.blocks[i] == memory)
         {
-        case TEXT_H_ALIGN_CENTER:
-            offset.X = line_widths[line_idx] * -0.5f;
-            break;
-        case TEXT_H_ALIGN_RIGHT:
-            offset.X = -line_widths[line_idx];
-            break;
-        default:;
-        }
+            BX_ALIGNED_FREE(
+                cache.blocks.allocator,
+                cache.blocks[i],
+                MANAGED_MEMORY_ALIGNMENT
+            );
 
-        string = record_quads
-        (
-            *recorder.atlas,
-            string,
-            end,
-            pack_func,
-            transform * HMM_Translate(offset),
-            out_mesh_recorder
-        );
+            if (i + 1 < cache.blocks.size)
+            {
+                cache.blocks[i] = cache.blocks[cache.blocks.size - 1];
+            }
 
-        offset.Y += line_sign * line_height;
-    }
+            resize(cache.blocks, cache.blocks.size - 1);
 
-    return true;
+            break;
+        }
+    }
 }
 
 
 // -----------------------------------------------------------------------------
-// TASK MANAGEMENT
+// CODEPOINT QUEUE
 // -----------------------------------------------------------------------------
 
-using TaskScheduler = enki::TaskScheduler;
-
-struct TaskPool;
-
-struct Task : enki::ITaskSet
+struct CodepointQueue
 {
-    void    (*func)(void*) = nullptr;
-    void*     data         = nullptr;
-    TaskPool* pool         = nullptr;
+    static constexpr u32 CAPACITY = 32;
 
-    void ExecuteRange(enki::TaskSetPartition, u32) override;
+    bx::RingBufferControl     buffer = { CAPACITY };
+    FixedArray<u32, CAPACITY> codepoints;
 };
 
-struct TaskPool
-{
-    Mutex                       mutex;
-    FixedArray<Task, MAX_TASKS> tasks;
-    FixedArray<u8  , MAX_TASKS> nexts;
-    u8                          head = 0;
 
-    static_assert(
-        MAX_TASKS < U8_MAX,
-        "`MAX_TASKS` too big, change the ID type to a bigger type."
-    );
-};
+void flush(CodepointQueue& queue)
+{
+    queue.buffer.reset();
+}
 
-void init(TaskPool& pool)
+u32 next(CodepointQueue& queue)
 {
-    for (u8 i = 0; i < pool.tasks.size; i++)
+    if (queue.buffer.available())
     {
-        pool.tasks[i].pool = &pool;
-        pool.nexts[i]      = i + 1;
+        const u32 codepoint = queue.codepoints[queue.buffer.m_read];
+        queue.buffer.consume(1);
+
+        return codepoint;
     }
+
+    return 0;
 }
 
-Task* acquire_task(TaskPool& pool)
+void append(CodepointQueue& queue, u32 codepoint)
 {
-    MutexScope lock(pool.mutex);
-
-    Task* task = nullptr;
-
-    if (pool.head < pool.tasks.size)
+    while (!queue.buffer.reserve(1))
     {
-        const u32 i = pool.head;
-
-        task          = &pool.tasks[i];
-        pool.head     =  pool.nexts[i];
-        pool.nexts[i] =  pool.tasks.size;
+        next(queue);
     }
 
-    return task;
+    queue.codepoints[queue.buffer.m_current] = codepoint;
+    queue.buffer.commit(1);
 }
 
-void release_task(TaskPool& pool, const Task* task)
+
+// -----------------------------------------------------------------------------
+// BINARY CACHE
+// -----------------------------------------------------------------------------
+
+// On-disk cache for blobs that BGFX passes through its `CallbackI` cache hooks
+// (i.e., driver-compiled programs). Each blob is stored in a separate file
+// named after its key, while the index file keeps the blob sizes in the order
+// they were written, so that the oldest ones can be evicted when the size limit
+// is reached. Files are always written under a temporary name and renamed
+// afterwards, so an interrupted write can't leave a torn file behind.
+
+constexpr u32 BINARY_CACHE_MAGIC     = BX_MAKEFOURCC('M', 'N', 'B', 'C');
+constexpr u32 BINARY_CACHE_VERSION   = 1;
+constexpr u32 MAX_BINARY_CACHE_PATH  = 256;
+constexpr u32 MAX_BINARY_CACHE_FILE  = MAX_BINARY_CACHE_PATH + 32;
+
+struct BinaryCacheEntry
 {
-    ASSERT(task, "Invalid task pointer.");
-    ASSERT(
-        task >= &pool.tasks[0] && task <= &pool.tasks[pool.tasks.size - 1],
-        "Task not owned by the pool."
-    );
+    u64 key;
+    u32 size;
+};
 
-    MutexScope lock(pool.mutex);
+struct BinaryCache
+{
+    Mutex                          mutex;
+    DynamicArray<BinaryCacheEntry> entries;    // Oldest first.
+    u64                            total_size = 0;
+    u64                            max_size   = 0;
+    char                           directory[MAX_BINARY_CACHE_PATH] = {}; // Empty if disabled.
+};
 
-    const ptrdiff_t i = task - &pool.tasks[0];
+bool is_enabled(const BinaryCache& cache)
+{
+    return cache.directory[0] != '\0';
+}
 
-    pool.tasks[i].func = nullptr;
-    pool.tasks[i].data = nullptr;
-    pool.nexts[i]      = pool.head;
-    pool.head          = u8(i);
+void file_path(const BinaryCache& cache, const char* name, char (&path)[MAX_BINARY_CACHE_FILE])
+{
+    bx::snprintf(path, i32(sizeof(path)), "%s/%s", cache.directory, name);
 }
 
-void Task::ExecuteRange(enki::TaskSetPartition, u32)
+void file_path(const BinaryCache& cache, u64 key, char (&path)[MAX_BINARY_CACHE_FILE])
 {
-    ASSERT(func, "Invalid task function pointer.");
-    ASSERT(pool, "Invalid taks pool pointer.");
+    bx::snprintf(path, i32(sizeof(path)), "%s/%016" PRIx64 ".bin", cache.directory, key);
+}
 
-    (*func)(data);
+FILE* begin_atomic_write(const char* path, char (&tmp_path)[MAX_BINARY_CACHE_FILE])
+{
+    bx::snprintf(tmp_path, i32(sizeof(tmp_path)), "%s.tmp", path);
 
-    release_task(*pool, this);
+    return fopen(tmp_path, "wb");
 }
 
+bool end_atomic_write(FILE* file, const char* path, const char* tmp_path, bool success)
+{
+    success = (fflush(file) == 0) && success;
+    success = (fclose(file) == 0) && success;
 
-// -----------------------------------------------------------------------------
-// FONT ATLAS CACHE
-// -----------------------------------------------------------------------------
+    if (success)
+    {
+#if BX_PLATFORM_WINDOWS
+        // NOTE : `rename` doesn't replace existing files on Windows.
+        ::remove(path);
+#endif
 
-struct FontAtlasCache
-{
-    Mutex                                   mutex;
-    FixedArray<FontAtlas, MAX_FONT_ATLASES> atlases;
-    FixedArray<u8, MAX_TEXTURES>            indices;
+        success = ::rename(tmp_path, path) == 0;
+    }
 
-    static_assert(
-        MAX_FONT_ATLASES < U8_MAX,
-        "Insufficient texture-to-atlas mapping index. Change type size."
-    );
-};
+    if (!success)
+    {
+        ::remove(tmp_path);
+    }
+
+    return success;
+}
 
-void init(FontAtlasCache& cache, Allocator* allocator)
+bool save_index(const BinaryCache& cache)
 {
-    ASSERT(allocator, "Invalid allocator pointer.");
+    char path    [MAX_BINARY_CACHE_FILE];
+    char tmp_path[MAX_BINARY_CACHE_FILE];
 
-    for (u32 i = 0; i < cache.atlases.size; i++)
+    file_path(cache, "index", path);
+
+    FILE* file = begin_atomic_write(path, tmp_path);
+
+    if (!file)
     {
-        init(cache.atlases[i], allocator);
+        return false;
     }
 
-    for (u32 i = 0; i < cache.indices.size; i++)
+    const u32 header[] = { BINARY_CACHE_MAGIC, BINARY_CACHE_VERSION, cache.entries.size };
+
+    bool success = fwrite(header, sizeof(header), 1, file) == 1;
+
+    for (u32 i = 0; success && i < cache.entries.size; i++)
     {
-        cache.indices[i] = U8_MAX;
+        const BinaryCacheEntry& entry = cache.entries[i];
+
+        success =
+            fwrite(&entry.key , sizeof(entry.key ), 1, file) == 1 &&
+            fwrite(&entry.size, sizeof(entry.size), 1, file) == 1;
     }
+
+    return end_atomic_write(file, path, tmp_path, success);
 }
 
-void deinit(FontAtlasCache& cache)
+void load_index(BinaryCache& cache)
 {
-    for (u32 i = 0; i < cache.atlases.size; i++)
+    clear(cache.entries);
+    cache.total_size = 0;
+
+    char path[MAX_BINARY_CACHE_FILE];
+    file_path(cache, "index", path);
+
+    FILE* file = fopen(path, "rb");
+
+    if (!file)
     {
-        deinit(cache.atlases[i]);
+        return;
     }
-}
 
-FontAtlas* acquire_atlas(FontAtlasCache& cache, u32 id)
-{
-    MutexScope lock(cache.mutex);
+    defer(fclose(file));
 
-    if (cache.indices[id] != U8_MAX)
+    u32 header[3];
+
+    if (fread(header, sizeof(header), 1, file) != 1 ||
+        header[0] != BINARY_CACHE_MAGIC              ||
+        header[1] != BINARY_CACHE_VERSION
+    )
     {
-        return &cache.atlases[cache.indices[id]];
+        WARN(false, "Ignoring invalid binary cache index '%s'.", path);
+        return;
     }
 
-    for (u32 i = 0; i < cache.atlases.size; i++)
+    reserve(cache.entries, header[2]);
+
+    for (u32 i = 0; i < header[2]; i++)
     {
-        if (cache.atlases[i].flags & ATLAS_FREE)
+        BinaryCacheEntry entry;
+
+        if (fread(&entry.key , sizeof(entry.key ), 1, file) != 1 ||
+            fread(&entry.size, sizeof(entry.size), 1, file) != 1
+        )
         {
-            cache.indices[id] = u8(i);
+            WARN(false, "Truncated binary cache index '%s'.", path);
 
-            // TODO : Consider "locking" the atlas for others until it's released.
+            clear(cache.entries);
+            cache.total_size = 0;
 
-            return &cache.atlases[i];
+            return;
         }
-    }
-
-    TRACE("No more free atlas slots.");
 
-    return nullptr;
+        append(cache.entries, entry);
+        cache.total_size += entry.size;
+    }
 }
 
-FontAtlas* fetch_atlas(FontAtlasCache& cache, u32 id)
+u32 find_entry(const BinaryCache& cache, u64 key)
 {
-    if (cache.indices[id] != U8_MAX)
+    for (u32 i = 0; i < cache.entries.size; i++)
     {
-        return &cache.atlases[cache.indices[id]];
+        if (cache.entries[i].key == key)
+        {
+            return i;
+        }
     }
 
-    return nullptr;
+    return U32_MAX;
 }
 
-
-// -----------------------------------------------------------------------------
-// FONT DATA CACHE
-// -----------------------------------------------------------------------------
-
-using FontDataCache = FixedArray<const void*, MAX_FONTS>;
-
-void add_font_data(FontDataCache& cache, u32 id, const void* data)
+void remove_entry(BinaryCache& cache, u32 index)
 {
-    cache[id] = data;
-}
+    ASSERT(index < cache.entries.size, "Invalid binary cache entry index.");
 
+    char path[MAX_BINARY_CACHE_FILE];
+    file_path(cache, cache.entries[index].key, path);
 
-// -----------------------------------------------------------------------------
-// MEMORY MANAGEMENT & CACHING
-// -----------------------------------------------------------------------------
+    ::remove(path);
 
-struct PersistentMemoryCache
-{
-    Mutex               mutex;
-    DynamicArray<void*> blocks;
-};
+    cache.total_size -= cache.entries[index].size;
 
-void init(PersistentMemoryCache& cache, Allocator* allocator)
-{
-    ASSERT(allocator, "Invalid allocator pointer.");
+    bx::memMove(
+        cache.entries.data + index,
+        cache.entries.data + index + 1,
+        (cache.entries.size - index - 1) * sizeof(BinaryCacheEntry)
+    );
 
-    init(cache.blocks, allocator);
+    pop(cache.entries);
 }
 
-void deinit(PersistentMemoryCache& cache)
+void evict(BinaryCache& cache, u64 required_size)
 {
-    for (u32 i = 0; i < cache.blocks.size; i++)
+    while (cache.entries.size && cache.total_size + required_size > cache.max_size)
     {
-        BX_ALIGNED_FREE(
-            cache.blocks.allocator,
-            cache.blocks[i],
-            MANAGED_MEMORY_ALIGNMENT
-        );
+        remove_entry(cache, 0);
     }
-
-    deinit(cache.blocks);
 }
 
-void* alloc(PersistentMemoryCache& cache, u32 size)
+void init(BinaryCache& cache, Allocator* allocator, const char* directory, u64 max_size)
 {
-    if (!size)
+    init(cache.entries, allocator);
+
+    cache.total_size   = 0;
+    cache.max_size     = max_size;
+    cache.directory[0] = '\0';
+
+    if (!directory || !directory[0])
     {
-        return nullptr;
+        return;
     }
 
-    void* memory = BX_ALIGNED_ALLOC(
-        cache.blocks.allocator,
-        size,
-        MANAGED_MEMORY_ALIGNMENT
-    );
-    WARN(memory, "Persistent memory allocation of %" PRIu32 " bytes failed.", size);
+    bx::Error error;
 
-    if (memory)
+    if (!bx::makeAll(bx::FilePath(directory), &error) || !error.isOk())
     {
-        MutexScope lock(cache.mutex);
+        WARN(false, "Failed to create binary cache directory '%s'.", directory);
+        return;
+    }
 
-        append(cache.blocks, memory);
+    bx::strCopy(cache.directory, sizeof(cache.directory), directory);
+
+    load_index(cache);
+
+    if (cache.total_size > cache.max_size)
+    {
+        evict(cache, 0);
+        save_index(cache);
     }
+}
 
-    return memory;
+void deinit(BinaryCache& cache)
+{
+    deinit(cache.entries);
+
+    cache.total_size   = 0;
+    cache.directory[0] = '\0';
 }
 
-void dealloc(PersistentMemoryCache& cache, void* memory)
+u32 read_size(BinaryCache& cache, u64 key)
 {
-    if (!memory)
-    {
-        return;
-    }
+    MutexScope lock(cache.mutex);
+
+    const u32 index = is_enabled(cache) ? find_entry(cache, key) : U32_MAX;
 
+    return index != U32_MAX ? cache.entries[index].size : 0;
+}
+
+bool read(BinaryCache& cache, u64 key, void* data, u32 size)
+{
     MutexScope lock(cache.mutex);
 
-    for (u32 i = 0; i < cache.blocks.size; i++)
+    const u32 index = is_enabled(cache) ? find_entry(cache, key) : U32_MAX;
+
+    if (index == U32_MAX || cache.entries[index].size != size)
     {
-        if (cache.blocks[i] == memory)
-        {
-            BX_ALIGNED_FREE(
-                cache.blocks.allocator,
-                cache.blocks[i],
-                MANAGED_MEMORY_ALIGNMENT
-            );
+        return false;
+    }
 
-            if (i + 1 < cache.blocks.size)
-            {
-                cache.blocks[i] = cache.blocks[cache.blocks.size - 1];
-            }
+    char path[MAX_BINARY_CACHE_FILE];
+    file_path(cache, key, path);
 
-            resize(cache.blocks, cache.blocks.size - 1);
+    bool success = false;
 
-            break;
-        }
+    if (FILE* file = fopen(path, "rb"))
+    {
+        // NOTE : Also making sure the file isn't longer than expected.
+        success = fread(data, size, 1, file) == 1 && fgetc(file) == EOF;
+
+        fclose(file);
     }
-}
 
+    if (!success)
+    {
+        // Missing or corrupted blob, let BGFX recompile and write it again.
+        remove_entry(cache, index);
+        save_index(cache);
+    }
 
-// -----------------------------------------------------------------------------
-// CODEPOINT QUEUE
-// -----------------------------------------------------------------------------
+    return success;
+}
 
-struct CodepointQueue
+bool write(BinaryCache& cache, u64 key, const void* data, u32 size)
 {
-    static constexpr u32 CAPACITY = 32;
+    MutexScope lock(cache.mutex);
 
-    bx::RingBufferControl     buffer = { CAPACITY };
-    FixedArray<u32, CAPACITY> codepoints;
-};
+    if (!is_enabled(cache) || !size || size > cache.max_size)
+    {
+        return false;
+    }
 
+    const u32 index = find_entry(cache, key);
 
-void flush(CodepointQueue& queue)
-{
-    queue.buffer.reset();
-}
+    if (index != U32_MAX)
+    {
+        remove_entry(cache, index);
+    }
 
-u32 next(CodepointQueue& queue)
-{
-    if (queue.buffer.available())
+    evict(cache, size);
+
+    char path    [MAX_BINARY_CACHE_FILE];
+    char tmp_path[MAX_BINARY_CACHE_FILE];
+
+    file_path(cache, key, path);
+
+    FILE* file    = begin_atomic_write(path, tmp_path);
+    bool  success = file != nullptr;
+
+    if (success)
     {
-        const u32 codepoint = queue.codepoints[queue.buffer.m_read];
-        queue.buffer.consume(1);
+        success = end_atomic_write(file, path, tmp_path, fwrite(data, size, 1, file) == 1);
+    }
 
-        return codepoint;
+    if (success)
+    {
+        append(cache.entries, { key, size });
+        cache.total_size += size;
     }
 
-    return 0;
+    // NOTE : Saved even on failure, as entries might have been evicted.
+    return save_index(cache) && success;
 }
 
-void append(CodepointQueue& queue, u32 codepoint)
+void clear(BinaryCache& cache)
 {
-    while (!queue.buffer.reserve(1))
+    MutexScope lock(cache.mutex);
+
+    if (!is_enabled(cache))
     {
-        next(queue);
+        return;
     }
 
-    queue.codepoints[queue.buffer.m_current] = codepoint;
-    queue.buffer.commit(1);
+    while (cache.entries.size)
+    {
+        remove_entry(cache, cache.entries.size - 1);
+    }
+
+    char path[MAX_BINARY_CACHE_FILE];
+    file_path(cache, "index", path);
+
+    ::remove(path);
 }
 
 
@@ -5438,16 +11762,66 @@ namespace
 // CONTEXTS
 // -----------------------------------------------------------------------------
 
+// Sizes of the resource tables. Can only be changed in the `init` callback.
+struct Limits
+{
+    u32 encoders          = 0; // Set to the thread count in `run`.
+    u32 framebuffers      = MAX_FRAMEBUFFERS;
+    u32 instance_buffers  = MAX_INSTANCE_BUFFERS;
+    u32 meshes            = MAX_MESHES;
+    u32 occlusion_queries = MAX_OCCLUSION_QUERIES;
+    u32 passes            = MAX_PASSES;
+    u32 programs          = MAX_PROGRAMS;
+    u32 textures          = MAX_TEXTURES;
+    u32 uniforms          = MAX_UNIFORMS;
+};
+
+u32* limit_value(Limits& limits, int resource)
+{
+    switch (resource)
+    {
+    case ::MAX_ENCODERS:
+        return &limits.encoders;
+    case ::MAX_FRAMEBUFFERS:
+        return &limits.framebuffers;
+    case ::MAX_INSTANCE_BUFFERS:
+        return &limits.instance_buffers;
+    case ::MAX_MESHES:
+        return &limits.meshes;
+    case ::MAX_OCCLUSION_QUERIES:
+        return &limits.occlusion_queries;
+    case ::MAX_PASSES:
+        return &limits.passes;
+    case ::MAX_SHADERS:
+        return &limits.programs;
+    case ::MAX_TEXTURES:
+        return &limits.textures;
+    case ::MAX_UNIFORMS:
+        return &limits.uniforms;
+    default:
+        return nullptr;
+    }
+}
+
 struct GlobalContext
 {
     KeyboardInput     keyboard;
     MouseInput        mouse;
 
     PassCache         pass_cache;
+    RenderGraph       render_graph;
+    RenderGraphPool   render_graph_pool;
     MeshCache         mesh_cache;
+    BinaryCache       binary_cache;
+    DrawListCache     draw_list_cache;
     InstanceCache     instance_cache;
+    OcclusionQueryCache occlusion_query_cache;
+    ParticleCache     particle_cache;
+    NodeHierarchy     node_hierarchy;
+    ReleaseQueue      release_queue;
     TextureCache      texture_cache;
     FramebufferCache  framebuffer_cache;
+    LayerCache        layer_cache;
     UniformCache      uniform_cache;
     ProgramCache      program_cache;
     VertexLayoutCache vertex_layout_cache;
@@ -5458,6 +11832,8 @@ struct GlobalContext
     FontAtlasCache    font_atlas_cache;
     FontDataCache     font_data_cache;
 
+    Limits            limits;
+
     Allocator*        default_allocator = nullptr;
 
     GLFWwindow*       window_handle     = nullptr;
@@ -5476,6 +11852,8 @@ struct GlobalContext
     u32               last_screenshot   = 0;
 
     u32               transient_memory  = 32_MB; // TODO : Make the name clearer.
+    u32               shader_cache_size = 64_MB;
+    char              shader_cache_path[MAX_BINARY_CACHE_PATH] = {}; // Disabled if empty.
     u32               frame_memory      = 8_MB;  // TODO : Make the name clearer.
     u32               vsync_on          = 0;
     bool              reset_back_buffer = true;
@@ -5484,6 +11862,8 @@ struct GlobalContext
 struct ThreadLocalContext
 {
     bgfx::Encoder*       encoder        = nullptr;
+    bool                 encoder_failed = false; // Current frame only.
+    EncoderShadow        encoder_shadow;
     DrawState            draw_state;
 
     MatrixStack<16>      matrix_stack;
@@ -5493,6 +11873,10 @@ struct ThreadLocalContext
     InstanceRecorder     instance_recorder;
     FramebufferRecorder  framebuffer_recorder;
     TextRecorder         text_recorder;
+    DrawListRecorder     draw_list_recorder;
+
+    InstancingBatcher    instancing_batcher;
+    ShapeBatcher         shape_batcher;
 
     Timer                stop_watch;
 
@@ -5501,6 +11885,7 @@ struct ThreadLocalContext
     DoubleFrameAllocator frame_allocator;
 
     bgfx::ViewId         active_pass    = 0;
+    u16                  shape_layer    = 0;
     bool                 is_main_thread = false;
 };
 
@@ -5530,6 +11915,10 @@ void init(ThreadLocalContext& ctx, Allocator* allocator, u32 arena_size, u32 sta
     init(ctx.mesh_recorder    , &ctx.stack_allocator);
     init(ctx.instance_recorder, &ctx.stack_allocator);
 
+    init(ctx.instancing_batcher, allocator);
+    init(ctx.shape_batcher     , allocator);
+    init(ctx.draw_list_recorder, allocator);
+
     init(ctx.matrix_stack);
 }
 
@@ -5537,6 +11926,10 @@ void deinit(ThreadLocalContext& ctx)
 {
     Allocator* allocator = ctx.backed_scratch_allocator.backing;
 
+    deinit(ctx.instancing_batcher);
+    deinit(ctx.shape_batcher);
+    deinit(ctx.draw_list_recorder);
+
     BX_ALIGNED_FREE(
         allocator,
         ctx.stack_allocator.buffer,
@@ -5552,6 +11945,33 @@ void deinit(ThreadLocalContext& ctx)
     deinit(ctx.frame_allocator);
 }
 
+// Returns the thread's encoder, beginning it on first use in the frame. When
+// BGFX runs out of encoders (i.e., the `MAX_ENCODERS` limit is lower than the
+// number of submitting threads), `nullptr` is returned and the caller is
+// expected to skip the submission, instead of crashing. Encoders are only
+// returned at the end of the frame, so there's no point in waiting for one, or
+// in trying again before then.
+//
+// NOTE : Sharing the main thread's encoder isn't an option, since the draw
+//        state (e.g., uniforms) is set on the encoder by separate API calls.
+bgfx::Encoder* acquire_encoder(ThreadLocalContext& ctx)
+{
+    if (!ctx.encoder && !ctx.encoder_failed)
+    {
+        ctx.encoder        = bgfx::begin(!ctx.is_main_thread);
+        ctx.encoder_failed = !ctx.encoder;
+
+        WARN(
+            ctx.encoder,
+            "Failed to acquire BGFX encoder, dropping the thread's submissions "
+            "till the end of the frame. Consider raising the `MAX_ENCODERS` "
+            "limit."
+        );
+    }
+
+    return ctx.encoder;
+}
+
 void alloc(ThreadLocalContext*& ctxs, Allocator* allocator, u32 count)
 {
     ASSERT(!ctxs, "Valid thread-local context pointer.");
@@ -5607,6 +12027,8 @@ thread_local ThreadLocalContext* t_ctx = nullptr;
 // `CallbackStub`.
 struct BgfxCallbacks : bgfx::CallbackI
 {
+    BinaryCache* binary_cache = nullptr; // Optional.
+
     virtual ~BgfxCallbacks()
     {
     }
@@ -5696,21 +12118,22 @@ struct BgfxCallbacks : bgfx::CallbackI
         TRACE("`profilerEnd` not implemented.");
     }
 
-    virtual u32 cacheReadSize(u64) override
+    virtual u32 cacheReadSize(u64 id) override
     {
-        TRACE("`cacheReadSize` not implemented.");
-        return 0;
+        return binary_cache ? read_size(*binary_cache, id) : 0;
     }
 
-    virtual bool cacheRead(u64, void*, u32) override
+    virtual bool cacheRead(u64 id, void* data, u32 size) override
     {
-        TRACE("`cacheRead` not implemented.");
-        return false;
+        return binary_cache ? read(*binary_cache, id, data, size) : false;
     }
 
-    virtual void cacheWrite(u64, const void*, u32) override
+    virtual void cacheWrite(u64 id, const void* data, u32 size) override
     {
-        TRACE("`cacheWrite` not implemented.");
+        if (binary_cache && !write(*binary_cache, id, data, size))
+        {
+            TRACE("Failed to cache binary %016" PRIx64 " (%" PRIu32 " B).", id, size);
+        }
     }
 
     virtual void captureBegin(u32, u32, u32, bgfx::TextureFormat::Enum, bool) override
@@ -5747,6 +12170,21 @@ int run(const Callbacks& callbacks)
 {
     MutexScope lock(g_mutex);
 
+    // NOTE : Created before the `init` callback, which can change the limits
+    //        and other settings stored in it.
+    GlobalContext ctx;
+    g_ctx = &ctx;
+
+    // Measures individual startup stages, reported after the first frame.
+    Timer startup_time;
+    tic(startup_time);
+
+    const u32 thread_count = bx::max(3u, std::thread::hardware_concurrency()) - 1u;
+
+    // NOTE : Each thread (main one included) holds its own encoder for the
+    //        whole frame, so by default there's one for every thread.
+    g_ctx->limits.encoders = bx::min(thread_count, MAX_BGFX_ENCODERS);
+
     if (callbacks.init)
     {
         (*callbacks.init)();
@@ -5763,14 +12201,9 @@ int run(const Callbacks& callbacks)
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
     glfwWindowHint(GLFW_SCALE_TO_MONITOR, GLFW_TRUE); // Note that this will be ignored when `glfwSetWindowSize` is specified.
 
-    GlobalContext ctx;
-    g_ctx = &ctx;
-
     CrtAllocator crt_allocator;
     g_ctx->default_allocator = &crt_allocator;
 
-    const u32 thread_count = bx::max(3u, std::thread::hardware_concurrency()) - 1u;
-
     ThreadLocalContext* local_ctxs = nullptr;
     alloc(local_ctxs, g_ctx->default_allocator, thread_count);
 
@@ -5852,10 +12285,20 @@ int run(const Callbacks& callbacks)
     gleqInit();
     gleqTrackWindow(g_ctx->window_handle);
 
+    const f64 window_time = toc(startup_time, true);
+
+    init(
+        g_ctx->binary_cache,
+        g_ctx->default_allocator,
+        g_ctx->shader_cache_path,
+        g_ctx->shader_cache_size
+    );
+    defer(deinit(g_ctx->binary_cache));
+
     BgfxCallbacks bgfx_callbacks;
+    bgfx_callbacks.binary_cache = &g_ctx->binary_cache;
 
     {
-        // TODO : Set Limits on number of encoders and transient memory.
         // TODO : Init resolution is needed for any backbuffer-size-related
         //        object creations in `setup` function. We should probably just
         //        call the code in the block exectured when
@@ -5865,6 +12308,7 @@ int run(const Callbacks& callbacks)
         init.resolution.width       = u32(g_ctx->window_info.framebuffer_size.X);
         init.resolution.height      = u32(g_ctx->window_info.framebuffer_size.Y);
         init.limits.transientVbSize = g_ctx->transient_memory;
+        init.limits.maxEncoders     = u16(g_ctx->limits.encoders);
 
         init.callback = &bgfx_callbacks;
 
@@ -5876,6 +12320,14 @@ int run(const Callbacks& callbacks)
 
     defer(bgfx::shutdown());
 
+    ASSERT(
+        g_ctx->limits.passes * 2 <= bgfx::getCaps()->limits.maxViews,
+        "Pass limit %" PRIu32 " exceeds half of available BGFX views.",
+        g_ctx->limits.passes
+    );
+
+    const f64 bgfx_time = toc(startup_time, true);
+
     init(g_ctx->window_cursors);
     defer(deinit(g_ctx->window_cursors));
 
@@ -5886,29 +12338,66 @@ int run(const Callbacks& callbacks)
     init(g_ctx->persistent_memory_cache, g_ctx->default_allocator);
     defer(deinit(g_ctx->persistent_memory_cache));
 
-    // NOTE : No `init` needed for these systems.
+    init(g_ctx->release_queue, g_ctx->default_allocator);
+    defer(deinit(g_ctx->release_queue));
+
+    {
+        const Limits& limits    = g_ctx->limits;
+        Allocator*    allocator = g_ctx->default_allocator;
+
+        init(g_ctx->pass_cache, allocator, limits.passes);
+        init(g_ctx->mesh_cache, allocator, limits.meshes);
+        init(g_ctx->instance_cache, allocator, limits.instance_buffers);
+        init(g_ctx->texture_cache, allocator, limits.textures);
+        init(g_ctx->framebuffer_cache, allocator, limits.framebuffers);
+    }
+
+    defer(deinit(g_ctx->pass_cache));
     defer(deinit(g_ctx->mesh_cache));
+    defer(deinit(g_ctx->instance_cache));
     defer(deinit(g_ctx->texture_cache));
     defer(deinit(g_ctx->framebuffer_cache));
 
+    // NOTE : No `init` needed for these systems.
+    defer(deinit(g_ctx->draw_list_cache));
+    defer(deinit(g_ctx->render_graph_pool));
+    defer(deinit(g_ctx->layer_cache));
+
     init(g_ctx->vertex_layout_cache);
     defer(deinit(g_ctx->vertex_layout_cache));
 
     init(g_ctx->default_uniforms);
     defer(deinit(g_ctx->default_uniforms));
 
-    init(g_ctx->uniform_cache);
+    init(g_ctx->uniform_cache, g_ctx->default_allocator, g_ctx->limits.uniforms);
     defer(deinit(g_ctx->uniform_cache));
 
     init(g_ctx->default_programs, bgfx::getRendererType());
     defer(deinit(g_ctx->default_programs));
 
-    init(g_ctx->program_cache);
+    init(
+        g_ctx->occlusion_query_cache,
+        g_ctx->default_allocator,
+        g_ctx->limits.occlusion_queries,
+        g_ctx->vertex_layout_cache,
+        g_ctx->default_programs,
+        occlusion_queries_supported(*bgfx::getCaps())
+    );
+    defer(deinit(g_ctx->occlusion_query_cache));
+
+    defer(deinit(g_ctx->particle_cache));
+
+    init(g_ctx->node_hierarchy, g_ctx->default_allocator);
+    defer(deinit(g_ctx->node_hierarchy));
+
+    init(g_ctx->program_cache, g_ctx->default_allocator, g_ctx->limits.programs);
     defer(deinit(g_ctx->program_cache));
 
-    init(g_ctx->font_atlas_cache, g_ctx->default_allocator);
+    init(g_ctx->font_atlas_cache, g_ctx->default_allocator, g_ctx->limits.textures);
     defer(deinit(g_ctx->font_atlas_cache));
 
+    const f64 caches_time = toc(startup_time, true);
+
     {
         init_frame(g_ctx->mesh_cache);
 
@@ -5925,6 +12414,21 @@ int run(const Callbacks& callbacks)
         g_ctx->bgfx_frame_number = bgfx::frame();
     }
 
+    {
+        const f64 setup_time = toc(startup_time);
+
+        INFO(
+            "Startup (%s): init & window %.2f ms, bgfx %.2f ms, caches %.2f ms, "
+            "setup & first frame %.2f ms, total %.2f ms.",
+            bgfx::getRendererName(bgfx::getRendererType()),
+            window_time * 1000.0,
+            bgfx_time   * 1000.0,
+            caches_time * 1000.0,
+            setup_time  * 1000.0,
+            (window_time + bgfx_time + caches_time + setup_time) * 1000.0
+        );
+    }
+
     u32 debug_state = BGFX_DEBUG_NONE;
     bgfx::setDebug(debug_state);
 
@@ -6038,6 +12542,8 @@ int run(const Callbacks& callbacks)
             bgfx::reset(width, height, BGFX_RESET_NONE | vsync);
 
             g_ctx->pass_cache.backbuffer_size_changed = true;
+
+            damage_all(g_ctx->pass_cache);
         }
 
         if (update_cursor_position)
@@ -6077,18 +12583,68 @@ int run(const Callbacks& callbacks)
         // TODO : Add some sort of sync mechanism for the tasks that intend to
         //        submit primitives for rendering in a given frame.
 
-        if (t_ctx->is_main_thread)
+        for (u32 i = 0; i < thread_count; i++)
         {
-            if (!t_ctx->encoder)
+            ThreadLocalContext& local_ctx = local_ctxs[i];
+
+            // NOTE : Batches of threads that didn't get an encoder are
+            //        flushed into the main thread's one.
+            if (local_ctx.instancing_batcher.draws.size ||
+                local_ctx.shape_batcher     .runs .size)
             {
-                t_ctx->encoder = bgfx::begin(!t_ctx->is_main_thread);
-                ASSERT(t_ctx->encoder, "Failed to acquire BGFX encoder.");
+                ThreadLocalContext& encoder_ctx = local_ctx.encoder
+                    ? local_ctx
+                    : *t_ctx;
+
+                if (!acquire_encoder(encoder_ctx))
+                {
+                    resize(local_ctx.instancing_batcher.draws, 0);
+                    reset(local_ctx.shape_batcher);
+                    continue;
+                }
+
+                flush(
+                    local_ctx.instancing_batcher,
+                    g_ctx->mesh_cache,
+                    g_ctx->instance_cache,
+                    g_ctx->default_uniforms,
+                    encoder_ctx.encoder_shadow,
+                    *encoder_ctx.encoder
+                );
+
+                flush(
+                    local_ctx.shape_batcher,
+                    g_ctx->mesh_cache,
+                    g_ctx->vertex_layout_cache,
+                    encoder_ctx.encoder_shadow,
+                    *encoder_ctx.encoder
+                );
             }
+        }
+
+        if (t_ctx->is_main_thread)
+        {
+            // NOTE : The main thread's encoder is always available.
+            acquire_encoder(*t_ctx);
+            ASSERT(t_ctx->encoder, "Failed to acquire main BGFX encoder.");
 
             // TODO : ??? Touch all active passes in all local contexts ???
-            g_ctx->pass_cache.passes[t_ctx->active_pass].dirty_flags |= Pass::DIRTY_TOUCH;
+            touch(g_ctx->pass_cache.passes[t_ctx->active_pass]);
+
+            update_passes(
+                g_ctx->pass_cache,
+                u16(g_ctx->window_info.framebuffer_size.X),
+                u16(g_ctx->window_info.framebuffer_size.Y),
+                t_ctx->encoder
+            );
 
-            update_passes(g_ctx->pass_cache, t_ctx->encoder);
+            composite_damage_targets(
+                g_ctx->pass_cache,
+                g_ctx->vertex_layout_cache,
+                g_ctx->default_programs,
+                g_ctx->default_uniforms,
+                t_ctx->encoder
+            );
         }
 
         for (u32 i = 0; i < thread_count; i++)
@@ -6097,12 +12653,19 @@ int run(const Callbacks& callbacks)
             {
                 bgfx::end(local_ctxs[i].encoder);
 
-                local_ctxs[i].encoder = nullptr;
+                local_ctxs[i].encoder        = nullptr;
+                local_ctxs[i].encoder_shadow = {};
             }
+
+            local_ctxs[i].encoder_failed = false;
         }
 
         g_ctx->bgfx_frame_number = bgfx::frame();
         bx::atomicFetchAndAdd(&g_ctx->frame_number, 1u);
+
+        release_frame(g_ctx->release_queue, g_ctx->frame_number);
+
+        end_frame(g_ctx->render_graph, g_ctx->pass_cache);
     }
 
     if (callbacks.cleanup)
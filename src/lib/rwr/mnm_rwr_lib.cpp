@@ -286,9 +286,20 @@ void begin_mesh(int id, int flags)
     );
 
     ASSERT(
-        id > 0 && id < int(MAX_MESHES),
+        id > 0 && id < int(g_ctx->limits.meshes),
         "Mesh ID %i out of available range 1 ... %i.",
-        id, int(MAX_MESHES - 1)
+        id, int(g_ctx->limits.meshes - 1)
+    );
+
+    ASSERT(
+        !(flags & VERTEX_SKINNED) || mesh_type(u32(flags)) == MESH_DYNAMIC,
+        "Only dynamic meshes can be skinned."
+    );
+
+    ASSERT(
+        !(flags & VERTEX_POSITION_2D) ||
+        !(flags & (VERTEX_SKINNED | GENEREATE_FLAT_NORMALS | GENEREATE_SMOOTH_NORMALS)),
+        "2D positions can't be skinned or used to generate normals."
     );
 
     t_ctx->record_info.flags      = u32(flags);
@@ -352,9 +363,10 @@ void end_mesh(void)
     // TODO : Figure out error handling - crash or just ignore the submission?
     add_mesh(
         g_ctx->mesh_cache,
+        g_ctx->release_queue,
         t_ctx->record_info,
         t_ctx->mesh_recorder,
-        g_ctx->vertex_layout_cache.layouts,
+        g_ctx->vertex_layout_cache,
         &t_ctx->stack_allocator
     );
 
@@ -363,6 +375,17 @@ void end_mesh(void)
     t_ctx->record_info = {};
 }
 
+void destroy_mesh(int id)
+{
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.meshes),
+        "Mesh ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.meshes - 1)
+    );
+
+    remove_mesh(g_ctx->mesh_cache, g_ctx->release_queue, u16(id));
+}
+
 void vertex(float x, float y, float z)
 {
     ASSERT(
@@ -372,7 +395,7 @@ void vertex(float x, float y, float z)
 
     // TODO : We should measure whether branch prediction minimizes the cost of
     //        having a condition in here.
-    if (!(t_ctx->record_info.flags & NO_VERTEX_TRANSFORM))
+    if (!(t_ctx->record_info.flags & (NO_VERTEX_TRANSFORM | VERTEX_POSITION_2D)))
     {
         (*t_ctx->mesh_recorder.store_vertex)(
             (t_ctx->matrix_stack.top * HMM_Vec4(x, y, z, 1.0f)).XYZ,
@@ -380,6 +403,14 @@ void vertex(float x, float y, float z)
             t_ctx->mesh_recorder
         );
     }
+    else if (!(t_ctx->record_info.flags & NO_VERTEX_TRANSFORM))
+    {
+        (*t_ctx->mesh_recorder.store_vertex)(
+            transform_affine_2d(t_ctx->matrix_stack.top, x, y),
+            t_ctx->mesh_recorder.attrib_state,
+            t_ctx->mesh_recorder
+        );
+    }
     else
     {
         (*t_ctx->mesh_recorder.store_vertex)(
@@ -430,47 +461,161 @@ void texcoord(float u, float v)
     );
 }
 
+void joints(int j0, int j1, int j2, int j3)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::MESH,
+        "Mesh recording not started. Call `begin_mesh` first."
+    );
+
+    ASSERT(
+        j0 >= 0 && j0 < int(MAX_SKIN_JOINTS) &&
+        j1 >= 0 && j1 < int(MAX_SKIN_JOINTS) &&
+        j2 >= 0 && j2 < int(MAX_SKIN_JOINTS) &&
+        j3 >= 0 && j3 < int(MAX_SKIN_JOINTS),
+        "Joint indices out of available range 0 ... %i.",
+        int(MAX_SKIN_JOINTS - 1)
+    );
+
+    SkinVertex& state = t_ctx->mesh_recorder.skin_state;
+
+    state.joints[0] = u8(j0);
+    state.joints[1] = u8(j1);
+    state.joints[2] = u8(j2);
+    state.joints[3] = u8(j3);
+}
+
+void weights(float w0, float w1, float w2, float w3)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::MESH,
+        "Mesh recording not started. Call `begin_mesh` first."
+    );
+
+    SkinVertex& state = t_ctx->mesh_recorder.skin_state;
+
+    state.weights[0] = w0;
+    state.weights[1] = w1;
+    state.weights[2] = w2;
+    state.weights[3] = w3;
+}
+
+void skin(int id, const float* joint_matrices, int joint_count)
+{
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.meshes),
+        "Mesh ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.meshes - 1)
+    );
+
+    ASSERT(
+        joint_count > 0 && joint_count <= int(MAX_SKIN_JOINTS),
+        "Joint count %i out of available range 1 ... %i.",
+        joint_count, int(MAX_SKIN_JOINTS)
+    );
+
+    skin(
+        g_ctx->mesh_cache,
+        u16(id),
+        joint_matrices,
+        u32(joint_count),
+        &t_ctx->stack_allocator,
+        &g_ctx->task_scheduler
+    );
+}
+
 
 // -----------------------------------------------------------------------------
 // PUBLIC API IMPLEMENTATION - MESH SUBMISSION
 // -----------------------------------------------------------------------------
 
 void mesh(int id)
+{
+    const int pass = int(t_ctx->active_pass);
+
+    mesh_multi(id, &pass, 1);
+}
+
+void mesh_multi(int id, const int* passes, int count)
 {
     ASSERT(
-        id > 0 && id < int(MAX_MESHES),
+        id > 0 && id < int(g_ctx->limits.meshes),
         "Mesh ID %i out of available range 1 ... %i.",
-        id, int(MAX_MESHES - 1)
+        id, int(g_ctx->limits.meshes - 1)
+    );
+
+    ASSERT(
+        passes && count > 0 && count <= int(g_ctx->limits.passes),
+        "Invalid pass list (count %i).",
+        count
+    );
+
+    ASSERT(
+        count == 1 || t_ctx->record_info.type != RecordType::DRAW_LIST,
+        "Multi-pass submissions can't be recorded into draw lists."
+    );
+
+    ASSERT(
+        count == 1 || t_ctx->draw_state.occlusion_query == U16_MAX,
+        "Multi-pass submissions can't be occlusion-queried."
+    );
+
+    // NOTE : BGFX applies uniforms only to the draw call that follows them, and
+    //        the encoder doesn't keep a copy we could re-send for extra passes.
+    ASSERT(
+        count == 1 || !t_ctx->draw_state.has_uniforms,
+        "Multi-pass submissions can't use uniforms set for the draw call."
     );
 
     DrawState& state = t_ctx->draw_state;
-    state.pass = t_ctx->active_pass;
-    state.framebuffer = g_ctx->pass_cache.passes[t_ctx->active_pass].framebuffer;
 
     const Mesh& mesh = g_ctx->mesh_cache.meshes[u16(id)];
 
+    // NOTE : Instanced and recorded submissions have unknown final transforms.
+    bgfx::ViewId visible[MAX_BGFX_VIEWS / 2];
+    const u32    visible_count = visible_passes(
+        g_ctx->pass_cache,
+        passes,
+        u32(count),
+        mesh,
+        t_ctx->matrix_stack.top,
+        !state.instances && t_ctx->record_info.type != RecordType::DRAW_LIST,
+        u16(g_ctx->window_info.framebuffer_size.X),
+        u16(g_ctx->window_info.framebuffer_size.Y),
+        t_ctx->active_pass,
+        visible
+    );
+
+    if (!visible_count)
+    {
+        state = {};
+
+        return;
+    }
+
+    state.pass        = visible[0];
+    state.framebuffer = g_ctx->pass_cache.passes[state.pass].framebuffer;
+
     u32 mesh_flags = mesh.flags;
 
     if (bgfx::isValid(state.vertex_alias))
     {
         const u32 skips = vertex_layout_skips(mesh_flags, state.vertex_alias.idx);
-        const u32 index = vertex_layout_index(mesh_flags, skips);
 
         mesh_flags &= ~skips;
 
-        state.vertex_alias = g_ctx->vertex_layout_cache.handles[index];
-    }
-
-    if (!t_ctx->encoder)
-    {
-        t_ctx->encoder = bgfx::begin(!t_ctx->is_main_thread);
-        ASSERT(t_ctx->encoder, "Failed to acquire BGFX encoder.");
+        state.vertex_alias = vertex_layout_handle(
+            g_ctx->vertex_layout_cache, mesh_flags, skips
+        );
     }
 
     // TODO : Check whether instancing works together with the aliasing.
     if (state.instances)
     {
-        t_ctx->encoder->setInstanceDataBuffer(&state.instances->buffer);
+        ASSERT(
+            t_ctx->record_info.type != RecordType::DRAW_LIST,
+            "Instance buffers can't be recorded into draw lists."
+        );
 
         if (state.instances->is_transform)
         {
@@ -501,10 +646,41 @@ void mesh(int id)
             mesh_flags |= SAMPLER_COLOR_R;
         }
 
-        const u32 index = default_program_index(mesh_flags);
-        state.program = g_ctx->default_programs[index];
+        state.program = default_program(g_ctx->default_programs, mesh_flags);
 
         ASSERT(bgfx::isValid(state.program), "Invalid state program.");
+
+        // Submissions that only differ in their transform get deferred until
+        // the end of the frame and then merged into instanced draw calls.
+        if (g_ctx->pass_cache.passes[state.pass].auto_instancing &&
+            t_ctx->record_info.type != RecordType::DRAW_LIST     &&
+             visible_count == 1                                  &&
+            !state.instances                                     &&
+            !state.encoder_state                                 &&
+             state.occlusion_query == U16_MAX                    &&
+             state.element_start == 0                            &&
+             state.element_count == U32_MAX
+        )
+        {
+            const bgfx::ProgramHandle instancing_program = default_program(
+                g_ctx->default_programs, mesh_flags | INSTANCING_SUPPORTED
+            );
+
+            if (bgfx::isValid(instancing_program))
+            {
+                add_draw(
+                    t_ctx->instancing_batcher,
+                    handle(g_ctx->mesh_cache.meshes, u16(id)),
+                    t_ctx->matrix_stack.top,
+                    state,
+                    instancing_program
+                );
+
+                state = {};
+
+                return;
+            }
+        }
     }
 
     if (state.element_start != 0 || state.element_count != U32_MAX)
@@ -532,15 +708,93 @@ void mesh(int id)
         }
     }
 
+    const Pass& pass = g_ctx->pass_cache.passes[state.pass];
+
+    if (pass.sort_mode == SORT_FRONT_TO_BACK ||
+        pass.sort_mode == SORT_BACK_TO_FRONT)
+    {
+        state.depth = depth_key(mesh, t_ctx->matrix_stack.top, pass.view_matrix);
+    }
+
+    if (t_ctx->record_info.type == RecordType::DRAW_LIST)
+    {
+        add_command(
+            t_ctx->draw_list_recorder,
+            handle(g_ctx->mesh_cache.meshes, u16(id)),
+            mesh_flags,
+            t_ctx->matrix_stack.top,
+            state
+        );
+
+        state = {};
+
+        return;
+    }
+
+    if (!acquire_encoder(*t_ctx))
+    {
+        state = {};
+
+        return;
+    }
+
+    // NOTE : The condition uses the result of the query from the previous
+    //        frame (or earlier), while the query itself is re-issued now.
+    bgfx::OcclusionQueryHandle query = BGFX_INVALID_HANDLE;
+
+    if (state.occlusion_query != U16_MAX)
+    {
+        query = acquire_query(g_ctx->occlusion_query_cache, state.occlusion_query);
+        state.condition = query;
+    }
+
     submit_mesh(
         mesh,
         t_ctx->matrix_stack.top,
         state,
         g_ctx->mesh_cache.transient_buffers,
         g_ctx->default_uniforms,
+        t_ctx->encoder_shadow,
         *t_ctx->encoder
     );
 
+    if (bgfx::isValid(query))
+    {
+        submit_occlusion_query(
+            g_ctx->occlusion_query_cache,
+            query,
+            mesh,
+            t_ctx->matrix_stack.top,
+            state.pass,
+            t_ctx->encoder_shadow,
+            *t_ctx->encoder
+        );
+    }
+
+    // NOTE : Encoder keeps the state of the previous submission, so only the
+    //        view and the sort depth change for the remaining passes.
+    for (u32 i = 1; i < visible_count; i++)
+    {
+        const Pass& extra_pass = g_ctx->pass_cache.passes[visible[i]];
+
+        u32 depth = 0;
+
+        if (extra_pass.sort_mode == SORT_FRONT_TO_BACK ||
+            extra_pass.sort_mode == SORT_BACK_TO_FRONT)
+        {
+            depth = depth_key(mesh, t_ctx->matrix_stack.top, extra_pass.view_matrix);
+        }
+
+        resubmit_mesh(
+            mesh,
+            state,
+            visible[i],
+            depth,
+            g_ctx->default_uniforms,
+            *t_ctx->encoder
+        );
+    }
+
     state = {};
 }
 
@@ -569,191 +823,626 @@ void scissor(int x, int y, int width, int height)
     ASSERT(width >= 0, "Negative scissor width (%i).", width);
     ASSERT(height >= 0, "Negative scissor height (%i).", height);
 
-    if (!t_ctx->encoder)
-    {
-        t_ctx->encoder = bgfx::begin(!t_ctx->is_main_thread);
-        ASSERT(t_ctx->encoder, "Failed to acquire BGFX encoder.");
-    }
-
-    t_ctx->encoder->setScissor(u16(x), u16(y), u16(width), u16(height));
-}
-
-
-// -----------------------------------------------------------------------------
-// PUBLIC API IMPLEMENTATION - TEXTURING
-// -----------------------------------------------------------------------------
-
-void load_texture(int id, int flags, int width, int height, int stride, const void* data)
-{
     ASSERT(
-        id > 0 && id < int(MAX_TEXTURES),
-        "Texture ID %i out of available range 1 ... %i.",
-        id, int(MAX_TEXTURES - 1)
+        t_ctx->record_info.type != RecordType::DRAW_LIST,
+        "Scissor can't be recorded into draw lists."
     );
 
-    ASSERT(width > 0, "Non-positive texture width (%i).", width);
+    DrawState& state = t_ctx->draw_state;
 
-    ASSERT(height > 0, "Non-positive texture height (%i).", height);
+    state.scissor[0]    = u16(x);
+    state.scissor[1]    = u16(y);
+    state.scissor[2]    = u16(width);
+    state.scissor[3]    = u16(height);
+    state.has_scissor   = true;
+    state.encoder_state = true;
+}
 
+void occlusion_query(int id)
+{
     ASSERT(
-        (width < SIZE_EQUAL && height < SIZE_EQUAL) ||
-        (width <= SIZE_DOUBLE && width == height), // TODO : Inspect necessity of this.
-        "Non-conforming texture width (%i) or height (%i).",
-        width, height
+        id >= 0 && id < int(g_ctx->limits.occlusion_queries),
+        "Occlusion query ID %i out of available range 0 ... %i.",
+        id, int(g_ctx->limits.occlusion_queries - 1)
     );
 
-    ASSERT(stride >= 0, "Negative texture stride (%i).", stride);
-
-    add_texture(
-        g_ctx->texture_cache,
-        u16(id),
-        u16(flags),
-        u16(width),
-        u16(height),
-        u16(stride),
-        data,
-        &t_ctx->frame_allocator
+    ASSERT(
+        t_ctx->record_info.type != RecordType::DRAW_LIST,
+        "Occlusion queries can't be recorded into draw lists."
     );
-}
 
-void create_texture(int id, int flags, int width, int height)
-{
-    load_texture(id, flags, width, height, 0, nullptr);
+    t_ctx->draw_state.occlusion_query = u16(id);
 }
 
-void texture(int id)
+int occlusion_visible(int id)
 {
     ASSERT(
-        id > 0 && id < int(MAX_TEXTURES),
-        "Texture ID %i out of available range 1 ... %i.",
-        id, int(MAX_TEXTURES - 1)
+        id >= 0 && id < int(g_ctx->limits.occlusion_queries),
+        "Occlusion query ID %i out of available range 0 ... %i.",
+        id, int(g_ctx->limits.occlusion_queries - 1)
     );
 
-    const Texture& texture = g_ctx->texture_cache.textures[u16(id)];
-
-    if (t_ctx->record_info.type != RecordType::FRAMEBUFFER)
-    {
-        // TODO : Samplers should be set by default state and only overwritten when
-        //        non-default shader is used.
-        t_ctx->draw_state.texture = texture.handle;
-        t_ctx->draw_state.sampler = default_sampler(g_ctx->default_uniforms, texture.format);
-        t_ctx->draw_state.texture_size[0] = texture.width;
-        t_ctx->draw_state.texture_size[1] = texture.height;
-    }
-    else
-    {
-        add_attachment(t_ctx->framebuffer_recorder, texture);
-    }
+    return is_visible(g_ctx->occlusion_query_cache, u16(id));
 }
 
 
 // -----------------------------------------------------------------------------
-// PUBLIC API IMPLEMENTATION - TEXTURE READBACK
+// PUBLIC API IMPLEMENTATION - PROCEDURAL MESHES
 // -----------------------------------------------------------------------------
 
-void read_texture(int id, void* data)
+void box_mesh(int id, int flags)
 {
     ASSERT(
-        id > 0 && id < int(MAX_TEXTURES),
-        "Texture ID %i out of available range 1 ... %i.",
-        id, int(MAX_TEXTURES - 1)
+        id > 0 && id < int(g_ctx->limits.meshes),
+        "Mesh ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.meshes - 1)
     );
 
-    ASSERT(data, "Invalid data pointer.");
-
-    if (!t_ctx->encoder)
-    {
-        t_ctx->encoder = bgfx::begin(!t_ctx->is_main_thread);
-        ASSERT(t_ctx->encoder, "Failed to acquire BGFX encoder.");
-    }
-
-    schedule_texture_read(
-        g_ctx->texture_cache,
-        u16(id),
-        t_ctx->active_pass + MAX_PASSES, // TODO : It might be better to let the user specify the pass explicitly.
-        t_ctx->encoder,
-        data
+    add_primitive(
+        g_ctx->mesh_cache, g_ctx->release_queue, g_ctx->vertex_layout_cache,
+        u16(id), u32(flags), t_ctx->matrix_stack.top, box_size(),
+        [&](PrimitiveWriter& writer) { generate_box(writer); }
     );
 }
 
-int read_screen(void* data)
+void plane_mesh(int id, int flags, int columns, int rows)
 {
-    ASSERT(data, "Invalid data pointer.");
-
-    const u32 id = MAX_TEXTURES + g_ctx->bgfx_frame_number;
-
-    if (id <= g_ctx->last_screenshot)
-    {
-        return 0;
-    }
-
-    g_ctx->last_screenshot = id;
-
-    char string[16];
-    encode_pointer(data, string, sizeof(string));
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.meshes),
+        "Mesh ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.meshes - 1)
+    );
 
-    bgfx::requestScreenShot(BGFX_INVALID_HANDLE, string);
+    ASSERT(columns > 0 && rows > 0, "Plane needs at least one column and row.");
 
-    return -int(id);
+    add_primitive(
+        g_ctx->mesh_cache, g_ctx->release_queue, g_ctx->vertex_layout_cache,
+        u16(id), u32(flags), t_ctx->matrix_stack.top,
+        plane_size(u32(columns), u32(rows)),
+        [&](PrimitiveWriter& writer) { generate_plane(writer, u32(columns), u32(rows)); }
+    );
 }
 
-int readable(int id)
+void sphere_mesh(int id, int flags, int segments, int rings)
 {
-    u32 read_frame;
-
-    if (id <= -int(MAX_TEXTURES))
-    {
-        read_frame = u32(-id) - MAX_TEXTURES + 2u;
-    }
-    else
-    {
-        ASSERT(
-            id > 0 && id < int(MAX_TEXTURES),
-            "Texture ID %i out of available range 1 ... %i.",
-            id, int(MAX_TEXTURES - 1)
-        );
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.meshes),
+        "Mesh ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.meshes - 1)
+    );
 
-        read_frame = g_ctx->texture_cache.textures[u16(id)].read_frame;
-    }
+    ASSERT(segments >= 3 && rings >= 2, "Sphere needs at least 3 segments and 2 rings.");
 
-    return g_ctx->bgfx_frame_number >= read_frame;
+    add_primitive(
+        g_ctx->mesh_cache, g_ctx->release_queue, g_ctx->vertex_layout_cache,
+        u16(id), u32(flags), t_ctx->matrix_stack.top,
+        sphere_size(u32(segments), u32(rings)),
+        [&](PrimitiveWriter& writer) { generate_sphere(writer, u32(segments), u32(rings)); }
+    );
 }
 
-
-// -----------------------------------------------------------------------------
-// PUBLIC API IMPLEMENTATION - INSTANCING
-// -----------------------------------------------------------------------------
-
-void begin_instancing(int id, int type)
+void icosphere_mesh(int id, int flags, int subdivisions)
 {
     ASSERT(
-        t_ctx->record_info.type == RecordType::NONE,
-        "Another recording in progress. Call respective `end_*` first."
+        id > 0 && id < int(g_ctx->limits.meshes),
+        "Mesh ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.meshes - 1)
     );
 
     ASSERT(
-        id > 0 && id < int(MAX_INSTANCE_BUFFERS),
-        "Instance buffer ID %i out of available range 1 ... %i.",
-        id, int(MAX_INSTANCE_BUFFERS - 1)
+        subdivisions >= 0 && subdivisions <= int(MAX_ICOSPHERE_SUBDIVISIONS),
+        "Icosphere subdivisions %i out of available range 0 ... %i.",
+        subdivisions, int(MAX_ICOSPHERE_SUBDIVISIONS)
     );
 
-    ASSERT(
-        type >= INSTANCE_TRANSFORM && type <= INSTANCE_DATA_112,
-        "Invalid instance buffer data type %i.",
-        type
+    add_primitive(
+        g_ctx->mesh_cache, g_ctx->release_queue, g_ctx->vertex_layout_cache,
+        u16(id), u32(flags), t_ctx->matrix_stack.top,
+        icosphere_size(u32(subdivisions)),
+        [&](PrimitiveWriter& writer)
+        {
+            generate_icosphere(writer, u32(subdivisions), &t_ctx->stack_allocator);
+        }
     );
-
-    start(t_ctx->instance_recorder, u32(type));
-
-    t_ctx->record_info.id           = u16(id);
-    t_ctx->record_info.is_transform = type == INSTANCE_TRANSFORM;
-    t_ctx->record_info.type         = RecordType::INSTANCES;
 }
 
-void end_instancing(void)
+void cylinder_mesh(int id, int flags, int segments)
 {
     ASSERT(
-        t_ctx->record_info.type == RecordType::INSTANCES,
+        id > 0 && id < int(g_ctx->limits.meshes),
+        "Mesh ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.meshes - 1)
+    );
+
+    ASSERT(segments >= 3, "Cylinder needs at least 3 segments.");
+
+    add_primitive(
+        g_ctx->mesh_cache, g_ctx->release_queue, g_ctx->vertex_layout_cache,
+        u16(id), u32(flags), t_ctx->matrix_stack.top,
+        cylinder_size(u32(segments)),
+        [&](PrimitiveWriter& writer) { generate_cylinder(writer, u32(segments)); }
+    );
+}
+
+void cone_mesh(int id, int flags, int segments)
+{
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.meshes),
+        "Mesh ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.meshes - 1)
+    );
+
+    ASSERT(segments >= 3, "Cone needs at least 3 segments.");
+
+    add_primitive(
+        g_ctx->mesh_cache, g_ctx->release_queue, g_ctx->vertex_layout_cache,
+        u16(id), u32(flags), t_ctx->matrix_stack.top,
+        cone_size(u32(segments)),
+        [&](PrimitiveWriter& writer) { generate_cone(writer, u32(segments)); }
+    );
+}
+
+void torus_mesh(int id, int flags, float thickness, int segments, int sides)
+{
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.meshes),
+        "Mesh ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.meshes - 1)
+    );
+
+    ASSERT(thickness > 0.0f, "Non-positive torus thickness %f.", thickness);
+    ASSERT(segments >= 3 && sides >= 3, "Torus needs at least 3 segments and sides.");
+
+    add_primitive(
+        g_ctx->mesh_cache, g_ctx->release_queue, g_ctx->vertex_layout_cache,
+        u16(id), u32(flags), t_ctx->matrix_stack.top,
+        torus_size(u32(segments), u32(sides)),
+        [&](PrimitiveWriter& writer)
+        {
+            generate_torus(writer, thickness, u32(segments), u32(sides));
+        }
+    );
+}
+
+void capsule_mesh(int id, int flags, float radius, int segments, int rings)
+{
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.meshes),
+        "Mesh ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.meshes - 1)
+    );
+
+    ASSERT(radius > 0.0f && radius <= 0.5f, "Capsule radius %f out of range (0, 0.5].", radius);
+    ASSERT(segments >= 3 && rings >= 1, "Capsule needs at least 3 segments and 1 ring.");
+
+    add_primitive(
+        g_ctx->mesh_cache, g_ctx->release_queue, g_ctx->vertex_layout_cache,
+        u16(id), u32(flags), t_ctx->matrix_stack.top,
+        capsule_size(u32(segments), u32(rings)),
+        [&](PrimitiveWriter& writer)
+        {
+            generate_capsule(writer, radius, u32(segments), u32(rings));
+        }
+    );
+}
+
+
+// -----------------------------------------------------------------------------
+// PUBLIC API IMPLEMENTATION - SHAPES
+// -----------------------------------------------------------------------------
+
+void shape_layer(int layer)
+{
+    ASSERT(
+        layer >= 0 && layer <= int(U16_MAX),
+        "Shape layer %i out of available range 0 ... %i.",
+        layer, int(U16_MAX)
+    );
+
+    t_ctx->shape_layer = u16(layer);
+}
+
+void rect(float x, float y, float width, float height, unsigned int rgba)
+{
+    if (g_ctx->pass_cache.passes[t_ctx->active_pass].graph_culled)
+    {
+        return;
+    }
+
+    const ShapeKey key = shape_key(
+        t_ctx->active_pass,
+        t_ctx->shape_layer,
+        nullptr,
+        g_ctx->default_programs,
+        g_ctx->default_uniforms,
+        g_ctx->vertex_layout_cache
+    );
+
+    add_quad(
+        t_ctx->shape_batcher, key, t_ctx->matrix_stack.top,
+        x, y, x + width, y + height, 0.0f, 0.0f, 1.0f, 1.0f, bx::endianSwap(rgba)
+    );
+}
+
+void rounded_rect(float x, float y, float width, float height, float radius, unsigned int rgba)
+{
+    radius = bx::clamp(radius, 0.0f, bx::min(width, height) * 0.5f);
+
+    if (radius <= 0.0f)
+    {
+        rect(x, y, width, height, rgba);
+
+        return;
+    }
+
+    if (g_ctx->pass_cache.passes[t_ctx->active_pass].graph_culled)
+    {
+        return;
+    }
+
+    const ShapeKey key = shape_key(
+        t_ctx->active_pass,
+        t_ctx->shape_layer,
+        nullptr,
+        g_ctx->default_programs,
+        g_ctx->default_uniforms,
+        g_ctx->vertex_layout_cache
+    );
+
+    add_rounded_rect(
+        t_ctx->shape_batcher, key, t_ctx->matrix_stack.top,
+        x, y, width, height, radius, bx::endianSwap(rgba)
+    );
+}
+
+void circle(float x, float y, float radius, unsigned int rgba)
+{
+    ASSERT(radius >= 0.0f, "Negative circle radius %f.", radius);
+
+    rounded_rect(x - radius, y - radius, radius * 2.0f, radius * 2.0f, radius, rgba);
+}
+
+void sprite(int texture, float x, float y, float width, float height, float u0, float v0, float u1, float v1, unsigned int rgba)
+{
+    ASSERT(
+        texture > 0 && texture < int(g_ctx->limits.textures),
+        "Texture ID %i out of available range 1 ... %i.",
+        texture, int(g_ctx->limits.textures - 1)
+    );
+
+    if (g_ctx->pass_cache.passes[t_ctx->active_pass].graph_culled)
+    {
+        return;
+    }
+
+    const ShapeKey key = shape_key(
+        t_ctx->active_pass,
+        t_ctx->shape_layer,
+        &g_ctx->texture_cache.textures[u16(texture)],
+        g_ctx->default_programs,
+        g_ctx->default_uniforms,
+        g_ctx->vertex_layout_cache
+    );
+
+    add_quad(
+        t_ctx->shape_batcher, key, t_ctx->matrix_stack.top,
+        x, y, x + width, y + height, u0, v0, u1, v1, bx::endianSwap(rgba)
+    );
+}
+
+void polyline(const float* points, int count, float width, int flags, unsigned int rgba)
+{
+    ASSERT(points, "Invalid polyline points pointer.");
+    ASSERT(count >= 2, "Polyline needs at least two points, got %i.", count);
+    ASSERT(width >= 0.0f, "Negative polyline width %f.", width);
+
+    ASSERT(
+        (flags & LINE_JOIN_MASK) != LINE_JOIN_MASK &&
+        (flags & LINE_CAP_MASK ) != LINE_CAP_MASK,
+        "Invalid polyline flags 0x%x.", flags
+    );
+
+    if (g_ctx->pass_cache.passes[t_ctx->active_pass].graph_culled)
+    {
+        return;
+    }
+
+    const ShapeKey key = shape_key(
+        t_ctx->active_pass,
+        t_ctx->shape_layer,
+        nullptr,
+        g_ctx->default_programs,
+        g_ctx->default_uniforms,
+        g_ctx->vertex_layout_cache
+    );
+
+    const Mat4& transform = t_ctx->matrix_stack.top;
+    const f32   scale     = shape_scale(transform);
+
+    static_assert(sizeof(Vec2) == 2 * sizeof(float), "Unexpected `Vec2` layout.");
+
+    add_polyline(
+        t_ctx->shape_batcher,
+        key,
+        transform,
+        reinterpret_cast<const Vec2*>(points),
+        u32(count),
+        width,
+        scale > 0.0f ? 1.0f / scale : 0.0f,
+        u16(flags),
+        bx::endianSwap(rgba),
+        &t_ctx->frame_allocator,
+        &g_ctx->task_scheduler
+    );
+}
+
+
+// -----------------------------------------------------------------------------
+// PUBLIC API IMPLEMENTATION - TEXTURING
+// -----------------------------------------------------------------------------
+
+void load_texture(int id, int flags, int width, int height, int stride, const void* data)
+{
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.textures),
+        "Texture ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.textures - 1)
+    );
+
+    ASSERT(width > 0, "Non-positive texture width (%i).", width);
+
+    ASSERT(height > 0, "Non-positive texture height (%i).", height);
+
+    ASSERT(
+        (width < SIZE_EQUAL && height < SIZE_EQUAL) ||
+        (width <= SIZE_DOUBLE && width == height), // TODO : Inspect necessity of this.
+        "Non-conforming texture width (%i) or height (%i).",
+        width, height
+    );
+
+    ASSERT(stride >= 0, "Negative texture stride (%i).", stride);
+
+    add_texture(
+        g_ctx->texture_cache,
+        g_ctx->release_queue,
+        u16(id),
+        u16(flags),
+        u16(width),
+        u16(height),
+        u16(stride),
+        data,
+        &t_ctx->frame_allocator
+    );
+}
+
+void create_texture(int id, int flags, int width, int height)
+{
+    load_texture(id, flags, width, height, 0, nullptr);
+}
+
+void destroy_texture(int id)
+{
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.textures),
+        "Texture ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.textures - 1)
+    );
+
+    // NOTE : Font atlases share the IDs with their textures.
+    release_atlas(
+        g_ctx->font_atlas_cache,
+        u32(id),
+        g_ctx->texture_cache,
+        g_ctx->release_queue
+    );
+
+    remove_texture(g_ctx->texture_cache, g_ctx->release_queue, u16(id));
+}
+
+void texture(int id)
+{
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.textures),
+        "Texture ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.textures - 1)
+    );
+
+    const Texture& texture = g_ctx->texture_cache.textures[u16(id)];
+
+    if (t_ctx->record_info.type != RecordType::FRAMEBUFFER)
+    {
+        // TODO : Samplers should be set by default state and only overwritten when
+        //        non-default shader is used.
+        t_ctx->draw_state.texture = texture.handle;
+        t_ctx->draw_state.sampler = default_sampler(g_ctx->default_uniforms, texture.format);
+        t_ctx->draw_state.texture_size[0] = texture.width;
+        t_ctx->draw_state.texture_size[1] = texture.height;
+    }
+    else
+    {
+        add_attachment(t_ctx->framebuffer_recorder, texture);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// PUBLIC API IMPLEMENTATION - TEXTURE READBACK
+// -----------------------------------------------------------------------------
+
+void read_texture(int id, void* data)
+{
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.textures),
+        "Texture ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.textures - 1)
+    );
+
+    ASSERT(data, "Invalid data pointer.");
+
+    if (!acquire_encoder(*t_ctx))
+    {
+        return;
+    }
+
+    schedule_texture_read(
+        g_ctx->texture_cache,
+        u16(id),
+        t_ctx->active_pass + g_ctx->limits.passes, // TODO : It might be better to let the user specify the pass explicitly.
+        t_ctx->encoder,
+        data
+    );
+}
+
+int read_screen(void* data)
+{
+    ASSERT(data, "Invalid data pointer.");
+
+    const u32 id = g_ctx->limits.textures + g_ctx->bgfx_frame_number;
+
+    if (id <= g_ctx->last_screenshot)
+    {
+        return 0;
+    }
+
+    g_ctx->last_screenshot = id;
+
+    char string[16];
+    encode_pointer(data, string, sizeof(string));
+
+    bgfx::requestScreenShot(BGFX_INVALID_HANDLE, string);
+
+    return -int(id);
+}
+
+int readable(int id)
+{
+    u32 read_frame;
+
+    if (id <= -int(g_ctx->limits.textures))
+    {
+        read_frame = u32(-id) - g_ctx->limits.textures + 2u;
+    }
+    else
+    {
+        ASSERT(
+            id > 0 && id < int(g_ctx->limits.textures),
+            "Texture ID %i out of available range 1 ... %i.",
+            id, int(g_ctx->limits.textures - 1)
+        );
+
+        read_frame = g_ctx->texture_cache.textures[u16(id)].read_frame;
+    }
+
+    return g_ctx->bgfx_frame_number >= read_frame;
+}
+
+
+// -----------------------------------------------------------------------------
+// PUBLIC API IMPLEMENTATION - TEXTURE COPY
+// -----------------------------------------------------------------------------
+
+int copy_texture_mip(int dst, int dst_mip, int dst_x, int dst_y, int src, int src_mip, int src_x, int src_y, int width, int height)
+{
+    ASSERT(
+        dst > 0 && dst < int(g_ctx->limits.textures),
+        "Texture ID %i out of available range 1 ... %i.",
+        dst, int(g_ctx->limits.textures - 1)
+    );
+
+    ASSERT(
+        src > 0 && src < int(g_ctx->limits.textures),
+        "Texture ID %i out of available range 1 ... %i.",
+        src, int(g_ctx->limits.textures - 1)
+    );
+
+    ASSERT(dst_mip >= 0 && dst_mip <= U8_MAX, "Invalid destination mip level %i.", dst_mip);
+
+    ASSERT(src_mip >= 0 && src_mip <= U8_MAX, "Invalid source mip level %i.", src_mip);
+
+    ASSERT(
+        dst_x >= 0 && dst_y >= 0 && src_x >= 0 && src_y >= 0,
+        "Negative copy coordinates (%i, %i) <- (%i, %i).",
+        dst_x, dst_y, src_x, src_y
+    );
+
+    ASSERT(width >= 0 && height >= 0, "Negative copy size %i x %i.", width, height);
+
+    if (!(bgfx::getCaps()->supported & BGFX_CAPS_TEXTURE_BLIT))
+    {
+        WARN(false, "Texture copy skipped, the %s renderer doesn't support blits.",
+            bgfx::getRendererName(bgfx::getRendererType())
+        );
+        return 0;
+    }
+
+    if (!acquire_encoder(*t_ctx))
+    {
+        WARN(false, "Texture copy dropped, no BGFX encoder available in this frame.");
+        return 0;
+    }
+
+    TextureCopy copy;
+    copy.dst_x   = u16(bx::min(dst_x , int(U16_MAX)));
+    copy.dst_y   = u16(bx::min(dst_y , int(U16_MAX)));
+    copy.src_x   = u16(bx::min(src_x , int(U16_MAX)));
+    copy.src_y   = u16(bx::min(src_y , int(U16_MAX)));
+    copy.width   = u16(bx::min(width , int(U16_MAX)));
+    copy.height  = u16(bx::min(height, int(U16_MAX)));
+    copy.dst_mip = u8(dst_mip);
+    copy.src_mip = u8(src_mip);
+
+    return schedule_texture_copy(
+        g_ctx->texture_cache,
+        u16(dst),
+        u16(src),
+        copy,
+        u16(g_ctx->window_info.framebuffer_size.X),
+        u16(g_ctx->window_info.framebuffer_size.Y),
+        t_ctx->active_pass + g_ctx->limits.passes,
+        t_ctx->encoder
+    );
+}
+
+int copy_texture(int dst, int dst_x, int dst_y, int src, int src_x, int src_y, int width, int height)
+{
+    return copy_texture_mip(dst, 0, dst_x, dst_y, src, 0, src_x, src_y, width, height);
+}
+
+
+// -----------------------------------------------------------------------------
+// PUBLIC API IMPLEMENTATION - INSTANCING
+// -----------------------------------------------------------------------------
+
+void begin_instancing(int id, int type)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::NONE,
+        "Another recording in progress. Call respective `end_*` first."
+    );
+
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.instance_buffers),
+        "Instance buffer ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.instance_buffers - 1)
+    );
+
+    ASSERT(
+        type >= INSTANCE_TRANSFORM && type <= INSTANCE_DATA_112,
+        "Invalid instance buffer data type %i.",
+        type
+    );
+
+    start(t_ctx->instance_recorder, u32(type));
+
+    t_ctx->record_info.id           = u16(id);
+    t_ctx->record_info.is_transform = type == INSTANCE_TRANSFORM;
+    t_ctx->record_info.type         = RecordType::INSTANCES;
+}
+
+void end_instancing(void)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::INSTANCES,
         "Instance buffer recording not started. Call `begin_instancing` first."
     );
 
@@ -788,9 +1477,9 @@ void instance(const void* data)
 void instances(int id)
 {
     ASSERT(
-        id > 0 && id < int(MAX_INSTANCE_BUFFERS),
+        id > 0 && id < int(g_ctx->limits.instance_buffers),
         "Instance buffer ID %i out of available range 1 ... %i.",
-        id, int(MAX_INSTANCE_BUFFERS - 1)
+        id, int(g_ctx->limits.instance_buffers - 1)
     );
 
     // TODO : Assert that instance ID is active in the cache in the current frame.
@@ -798,6 +1487,296 @@ void instances(int id)
 }
 
 
+// -----------------------------------------------------------------------------
+// PUBLIC API IMPLEMENTATION - PARTICLES
+// -----------------------------------------------------------------------------
+
+void begin_particles(int id, int capacity, unsigned int seed)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::NONE,
+        "Another recording in progress. Call respective `end_*` first."
+    );
+
+    ASSERT(
+        id >= 0 && id < int(MAX_PARTICLE_EMITTERS),
+        "Particle emitter ID %i out of available range 0 ... %i.",
+        id, int(MAX_PARTICLE_EMITTERS - 1)
+    );
+
+    ASSERT(capacity > 0, "Non-positive particle emitter capacity %i.", capacity);
+
+    reset(
+        g_ctx->particle_cache.emitters[u32(id)],
+        g_ctx->default_allocator,
+        u32(capacity),
+        seed
+    );
+
+    t_ctx->record_info.id   = u16(id);
+    t_ctx->record_info.type = RecordType::PARTICLES;
+}
+
+void end_particles(void)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::PARTICLES,
+        "Particle emitter definition not started. Call `begin_particles` first."
+    );
+
+    bake(g_ctx->particle_cache.emitters[t_ctx->record_info.id]);
+
+    t_ctx->record_info = {};
+}
+
+void particle_rate(float rate)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::PARTICLES,
+        "Particle emitter definition not started. Call `begin_particles` first."
+    );
+
+    ASSERT(rate >= 0.0f, "Negative particle spawn rate %f.", rate);
+
+    g_ctx->particle_cache.emitters[t_ctx->record_info.id].rate = rate;
+}
+
+void particle_lifetime(float shortest, float longest)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::PARTICLES,
+        "Particle emitter definition not started. Call `begin_particles` first."
+    );
+
+    ASSERT(
+        shortest > 0.0f && longest >= shortest,
+        "Invalid particle lifetime range %f ... %f.",
+        shortest, longest
+    );
+
+    ParticleEmitter& emitter = g_ctx->particle_cache.emitters[t_ctx->record_info.id];
+
+    emitter.lifetime_min = shortest;
+    emitter.lifetime_max = longest;
+}
+
+void particle_velocity(float x, float y, float z, float spread)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::PARTICLES,
+        "Particle emitter definition not started. Call `begin_particles` first."
+    );
+
+    ASSERT(spread >= 0.0f, "Negative particle velocity spread %f.", spread);
+
+    ParticleEmitter& emitter = g_ctx->particle_cache.emitters[t_ctx->record_info.id];
+
+    emitter.velocity_base = HMM_Vec3(x, y, z);
+    emitter.spread        = spread;
+}
+
+void particle_acceleration(float x, float y, float z)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::PARTICLES,
+        "Particle emitter definition not started. Call `begin_particles` first."
+    );
+
+    g_ctx->particle_cache.emitters[t_ctx->record_info.id].acceleration = HMM_Vec3(x, y, z);
+}
+
+void particle_curve(int curve, float t, float value)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::PARTICLES,
+        "Particle emitter definition not started. Call `begin_particles` first."
+    );
+
+    ASSERT(
+        curve >= PARTICLE_SIZE && curve <= PARTICLE_ACCELERATION,
+        "Invalid particle curve %i.",
+        curve
+    );
+
+    add_key(
+        g_ctx->particle_cache.emitters[t_ctx->record_info.id].curves[curve],
+        t,
+        HMM_Vec4(value, value, value, value)
+    );
+}
+
+void particle_color(float t, unsigned int rgba)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::PARTICLES,
+        "Particle emitter definition not started. Call `begin_particles` first."
+    );
+
+    add_key(
+        g_ctx->particle_cache.emitters[t_ctx->record_info.id].curves[PARTICLE_CURVE_COLOR],
+        t,
+        HMM_Vec4(
+            ((rgba >> 24) & 0xff) / 255.0f,
+            ((rgba >> 16) & 0xff) / 255.0f,
+            ((rgba >>  8) & 0xff) / 255.0f,
+            ((rgba      ) & 0xff) / 255.0f
+        )
+    );
+}
+
+void update_particles(int id, float dt)
+{
+    ASSERT(
+        id >= 0 && id < int(MAX_PARTICLE_EMITTERS),
+        "Particle emitter ID %i out of available range 0 ... %i.",
+        id, int(MAX_PARTICLE_EMITTERS - 1)
+    );
+
+    update(g_ctx->particle_cache.emitters[u32(id)], dt, &g_ctx->task_scheduler);
+}
+
+int particle_count(int id)
+{
+    ASSERT(
+        id >= 0 && id < int(MAX_PARTICLE_EMITTERS),
+        "Particle emitter ID %i out of available range 0 ... %i.",
+        id, int(MAX_PARTICLE_EMITTERS - 1)
+    );
+
+    return int(g_ctx->particle_cache.emitters[u32(id)].count);
+}
+
+void particles(int id)
+{
+    ASSERT(
+        id >= 0 && id < int(MAX_PARTICLE_EMITTERS),
+        "Particle emitter ID %i out of available range 0 ... %i.",
+        id, int(MAX_PARTICLE_EMITTERS - 1)
+    );
+
+    ASSERT(
+        t_ctx->record_info.type != RecordType::DRAW_LIST,
+        "Particles can't be recorded into draw lists."
+    );
+
+    DrawState& state = t_ctx->draw_state;
+
+    ASSERT(!state.instances, "Particles use their own instance buffer.");
+
+    ParticleEmitter& emitter = g_ctx->particle_cache.emitters[u32(id)];
+
+    if (!emitter.count ||
+        g_ctx->pass_cache.passes[t_ctx->active_pass].graph_culled ||
+        !acquire_encoder(*t_ctx)
+    )
+    {
+        state = {};
+
+        return;
+    }
+
+    state.pass        = t_ctx->active_pass;
+    state.framebuffer = g_ctx->pass_cache.passes[state.pass].framebuffer;
+
+    if (!bgfx::isValid(state.program))
+    {
+        state.program = default_program(
+            g_ctx->default_programs, BILLBOARD_MESH | INSTANCING_SUPPORTED
+        );
+    }
+
+    submit_particles(
+        emitter,
+        particle_quad(g_ctx->particle_cache, g_ctx->vertex_layout_cache),
+        t_ctx->matrix_stack.top,
+        state,
+        g_ctx->instance_cache,
+        g_ctx->mesh_cache.transient_buffers,
+        g_ctx->default_uniforms,
+        t_ctx->encoder_shadow,
+        *t_ctx->encoder,
+        &g_ctx->task_scheduler
+    );
+
+    state = {};
+}
+
+
+// -----------------------------------------------------------------------------
+// PUBLIC API IMPLEMENTATION - DRAW LISTS
+// -----------------------------------------------------------------------------
+
+void begin_draw_list(int id)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::NONE,
+        "Another recording in progress. Call respective `end_*` first."
+    );
+
+    ASSERT(
+        id > 0 && id < int(MAX_DRAW_LISTS),
+        "Draw list ID %i out of available range 1 ... %i.",
+        id, int(MAX_DRAW_LISTS - 1)
+    );
+
+    start(t_ctx->draw_list_recorder);
+
+    t_ctx->record_info.id   = u16(id);
+    t_ctx->record_info.type = RecordType::DRAW_LIST;
+}
+
+void end_draw_list(void)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::DRAW_LIST,
+        "Draw list recording not started. Call `begin_draw_list` first."
+    );
+
+    add_draw_list(
+        g_ctx->draw_list_cache,
+        t_ctx->record_info.id,
+        t_ctx->draw_list_recorder,
+        g_ctx->default_allocator
+    );
+
+    end(t_ctx->draw_list_recorder);
+
+    t_ctx->record_info = {};
+}
+
+void draw_list(int id)
+{
+    ASSERT(
+        id > 0 && id < int(MAX_DRAW_LISTS),
+        "Draw list ID %i out of available range 1 ... %i.",
+        id, int(MAX_DRAW_LISTS - 1)
+    );
+
+    ASSERT(
+        t_ctx->record_info.type != RecordType::DRAW_LIST,
+        "Draw lists can't be nested."
+    );
+
+    if (!acquire_encoder(*t_ctx))
+    {
+        return;
+    }
+
+    // NOTE : Re-recording can reallocate the list's arrays.
+    MutexScope lock(g_ctx->draw_list_cache.mutexes[u16(id)]);
+
+    submit_draw_list(
+        g_ctx->draw_list_cache.lists[u16(id)],
+        t_ctx->matrix_stack.top,
+        t_ctx->active_pass,
+        g_ctx->mesh_cache,
+        g_ctx->default_uniforms,
+        t_ctx->encoder_shadow,
+        *t_ctx->encoder
+    );
+}
+
+
 // -----------------------------------------------------------------------------
 // PUBLIC API IMPLEMENTATION - FONT ATLASING
 // -----------------------------------------------------------------------------
@@ -812,12 +1791,36 @@ void create_font(int id, const void* data)
 
     ASSERT(data, "Invalid data pointer.");
 
-    // TODO : Should we invalidate all atlases using the font data previously
-    //        associated with given `id`?
-    bx::atomicExchangePtr(
+    // TODO : Should we invalidate all atlases using the font data previously
+    //        associated with given `id`?
+    bx::atomicExchangePtr(
+        const_cast<void**>(&g_ctx->font_data_cache[u32(id)]),
+        const_cast<void*>(data)
+    );
+}
+
+void destroy_font(int id)
+{
+    ASSERT(
+        id > 0 && id < int(mnm::rwr::MAX_FONTS),
+        "Font ID %i out of available range 1 ... %i.",
+        id, int(mnm::rwr::MAX_FONTS - 1)
+    );
+
+    const void* data = bx::atomicExchangePtr(
         const_cast<void**>(&g_ctx->font_data_cache[u32(id)]),
-        const_cast<void*>(data)
+        nullptr
     );
+
+    if (data)
+    {
+        release_atlases(
+            g_ctx->font_atlas_cache,
+            data,
+            g_ctx->texture_cache,
+            g_ctx->release_queue
+        );
+    }
 }
 
 void begin_atlas(int id, int flags, int font, float size)
@@ -828,9 +1831,9 @@ void begin_atlas(int id, int flags, int font, float size)
     );
 
     ASSERT(
-        id > 0 && id < int(MAX_TEXTURES),
+        id > 0 && id < int(g_ctx->limits.textures),
         "Atlas ID %i out of available range 1 ... %i.",
-        id, int(MAX_TEXTURES - 1)
+        id, int(g_ctx->limits.textures - 1)
     );
 
     // TODO : Check `flags`.
@@ -856,6 +1859,7 @@ void begin_atlas(int id, int flags, int font, float size)
         reset(
             *atlas,
             g_ctx->texture_cache,
+            g_ctx->release_queue,
             u16(id),
             u16(flags),
             g_ctx->font_data_cache[u32(font)],
@@ -874,7 +1878,7 @@ void end_atlas(void)
     FontAtlas* atlas = fetch_atlas(g_ctx->font_atlas_cache, t_ctx->record_info.id);
     ASSERT(atlas, "Invalid atlas ID %i.", t_ctx->record_info.id);
 
-    update(*atlas, g_ctx->texture_cache, &t_ctx->frame_allocator);
+    update(*atlas, g_ctx->texture_cache, g_ctx->release_queue, &t_ctx->frame_allocator);
 
     t_ctx->record_info = {};
 }
@@ -948,9 +1952,9 @@ void begin_text(int mesh_id, int atlas_id, int flags)
     );
 
     ASSERT(
-        atlas_id > 0 && atlas_id < int(MAX_TEXTURES),
+        atlas_id > 0 && atlas_id < int(g_ctx->limits.textures),
         "Atlas ID %i out of available range 1 ... %i.",
-        atlas_id, int(MAX_TEXTURES - 1)
+        atlas_id, int(g_ctx->limits.textures - 1)
     );
 
     // TODO : Check `flags`.
@@ -964,7 +1968,8 @@ void begin_text(int mesh_id, int atlas_id, int flags)
           VERTEX_COLOR            |
           TEXT_MESH               |
          (TEXT_TYPE_MASK & flags) |
-        ((TEXCOORD_F32 | VERTEX_PIXCOORD) * is_updatable(*atlas));
+        ((TEXCOORD_F32 | VERTEX_PIXCOORD) * is_updatable(*atlas)) |
+        ( VERTEX_POSITION_2D * bool(flags & TEXT_POSITION_2D));
 
     start(t_ctx->text_recorder, u32(flags), *atlas);
 
@@ -1053,179 +2058,575 @@ void text(const char* start, const char* end)
     if (!success && is_updatable(atlas))
     {
         add_glyphs_from_string(atlas, start, end);
-        update(atlas, g_ctx->texture_cache, &t_ctx->frame_allocator);
+        update(atlas, g_ctx->texture_cache, g_ctx->release_queue, &t_ctx->frame_allocator);
 
         success = try_record_text();
     }
 
-    WARN(
-        success,
-        "Failed to lay text '...' due to missing glyphs." // TODO : Add text excerpt.
+    WARN(
+        success,
+        "Failed to lay text '...' due to missing glyphs." // TODO : Add text excerpt.
+    );
+}
+
+
+// -----------------------------------------------------------------------------
+// PUBLIC API IMPLEMENTATION - PASSES
+// -----------------------------------------------------------------------------
+
+void pass(int id)
+{
+    ASSERT(
+        id >= 0 && id < int(g_ctx->limits.passes),
+        "Pass ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.passes - 1)
+    );
+
+    t_ctx->active_pass = u16(id);
+    touch(g_ctx->pass_cache.passes[t_ctx->active_pass]);
+}
+
+void no_clear(void)
+{
+    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+
+    if (pass.clear_flags != BGFX_CLEAR_NONE)
+    {
+        pass.clear_flags  = BGFX_CLEAR_NONE;
+        pass.dirty_flags |= Pass::DIRTY_CLEAR;
+    }
+}
+
+void clear_depth(float depth)
+{
+    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+
+    if (  pass.clear_depth != depth            ||
+        !(pass.dirty_flags & BGFX_CLEAR_DEPTH) ||
+        !(pass.clear_flags & BGFX_CLEAR_DEPTH)
+    )
+    {
+        pass.clear_flags |= BGFX_CLEAR_DEPTH;
+        pass.clear_depth  = depth;
+        pass.dirty_flags |= Pass::DIRTY_CLEAR;
+    }
+}
+
+void clear_color(unsigned int rgba)
+{
+    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+
+    if (  pass.clear_rgba != rgba              ||
+        !(pass.dirty_flags & BGFX_CLEAR_COLOR) ||
+        !(pass.clear_flags & BGFX_CLEAR_COLOR)
+    )
+    {
+        pass.clear_flags |= BGFX_CLEAR_COLOR;
+        pass.clear_rgba   = rgba;
+        pass.dirty_flags |= Pass::DIRTY_CLEAR;
+    }
+}
+
+void no_framebuffer(void)
+{
+    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+
+    pass.framebuffer  = BGFX_INVALID_HANDLE;
+    pass.dirty_flags |= Pass::DIRTY_FRAMEBUFFER;
+}
+
+void framebuffer(int id)
+{
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.framebuffers),
+        "Framebuffer ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.framebuffers - 1)
+    );
+
+    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+
+    pass.framebuffer  = g_ctx->framebuffer_cache.framebuffers[u16(id)].handle;
+    pass.dirty_flags |= Pass::DIRTY_FRAMEBUFFER;
+}
+
+void viewport(int x, int y, int width, int height)
+{
+    ASSERT(x >= 0, "Negative viewport X (%i).", x);
+
+    ASSERT(y >= 0, "Negative viewport Y (%i).", y);
+
+    ASSERT(width >= 0, "Negative viewport width (%i).", width);
+
+    ASSERT(height >= 0, "Negative viewport height (%i).", height);
+
+    ASSERT(
+        (width < SIZE_EQUAL && height < SIZE_EQUAL) ||
+        (width <= SIZE_DOUBLE && width == height), // TODO : Inspect necessity of this.
+        "Non-conforming texture width (%i) or height (%i).",
+        width, height
+    );
+
+    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+
+    ASSERT(
+        !pass.dirty_regions ||
+        (x == 0 && y == 0 && width == SIZE_EQUAL && height == SIZE_EQUAL),
+        "Passes with dirty regions must have full viewport."
+    );
+
+    if (pass.viewport_x      != x     ||
+        pass.viewport_y      != y     ||
+        pass.viewport_width  != width ||
+        pass.viewport_height != height)
+    {
+        pass.viewport_x      = u16(x);
+        pass.viewport_y      = u16(y);
+        pass.viewport_width  = u16(width);
+        pass.viewport_height = u16(height);
+        pass.dirty_flags    |= Pass::DIRTY_RECT;
+    }
+}
+
+void full_viewport(void)
+{
+    viewport(0, 0, SIZE_EQUAL, SIZE_EQUAL);
+}
+
+void pass_sort(int mode)
+{
+    ASSERT(
+        mode >= SORT_STATE && mode <= SORT_BACK_TO_FRONT,
+        "Invalid pass sort mode %i.",
+        mode
+    );
+
+    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+
+    if (pass.sort_mode != mode)
+    {
+        pass.sort_mode    = u8(mode);
+        pass.dirty_flags |= Pass::DIRTY_SORT;
+    }
+}
+
+void frustum_culling(int enabled)
+{
+    g_ctx->pass_cache.passes[t_ctx->active_pass].frustum_culling = enabled != 0;
+}
+
+int culled_count(void)
+{
+    return int(g_ctx->pass_cache.passes[t_ctx->active_pass].culled_last);
+}
+
+void auto_instancing(int enabled)
+{
+    g_ctx->pass_cache.passes[t_ctx->active_pass].auto_instancing = enabled != 0;
+}
+
+void dirty_regions(int enabled)
+{
+    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+
+    ASSERT(
+        !enabled || !bgfx::isValid(pass.framebuffer),
+        "Dirty regions only supported in passes rendering into the backbuffer."
+    );
+
+    ASSERT(
+        !enabled || is_full_viewport(pass),
+        "Dirty regions only supported in passes with full viewport."
+    );
+
+    if (pass.dirty_regions == (enabled != 0))
+    {
+        return;
+    }
+
+    // NOTE : Dirty regions override the view's clear, transform, rectangle and
+    //        framebuffer, so they all have to be restored once disabled.
+    pass.dirty_regions  = enabled != 0;
+    pass.dirty_flags   |=
+        Pass::DIRTY_CLEAR     |
+        Pass::DIRTY_TRANSFORM |
+        Pass::DIRTY_RECT      |
+        Pass::DIRTY_FRAMEBUFFER;
+
+    if (pass.dirty_regions)
+    {
+        add_damage(pass, 0, 0, U16_MAX, U16_MAX);
+    }
+    else
+    {
+        release(g_ctx->release_queue, ReleaseType::FRAMEBUFFER, pass.damage_target.idx);
+
+        pass.damage_target = BGFX_INVALID_HANDLE;
+        reset_damage(pass);
+    }
+}
+
+void damage(int x, int y, int width, int height)
+{
+    ASSERT(x >= 0, "Negative damage X (%i).", x);
+
+    ASSERT(y >= 0, "Negative damage Y (%i).", y);
+
+    ASSERT(width >= 0, "Negative damage width (%i).", width);
+
+    ASSERT(height >= 0, "Negative damage height (%i).", height);
+
+    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+
+    ASSERT(pass.dirty_regions, "Dirty regions not enabled in pass %" PRIu16 ".", t_ctx->active_pass);
+
+    if (width && height)
+    {
+        add_damage(
+            pass,
+            u16(bx::min(x, int(U16_MAX))),
+            u16(bx::min(y, int(U16_MAX))),
+            u16(bx::min(x + width , int(U16_MAX))),
+            u16(bx::min(y + height, int(U16_MAX)))
+        );
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// PUBLIC API IMPLEMENTATION - FRAMEBUFFERS
+// -----------------------------------------------------------------------------
+
+void begin_framebuffer(int id)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::NONE,
+        "Another recording in progress. Call respective `end_*` first."
+    );
+
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.framebuffers),
+        "Framebuffer ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.framebuffers - 1)
+    );
+
+    start(t_ctx->framebuffer_recorder);
+
+    t_ctx->record_info.id   = u16(id);
+    t_ctx->record_info.type = RecordType::FRAMEBUFFER;
+}
+
+void end_framebuffer(void)
+{
+    ASSERT(
+        t_ctx->record_info.type == RecordType::FRAMEBUFFER,
+        "Framebuffer recording not started. Call `begin_framebuffer` first."
+    );
+
+    add_framebuffer(
+        g_ctx->framebuffer_cache,
+        g_ctx->release_queue,
+        t_ctx->record_info.id,
+        t_ctx->framebuffer_recorder.width,
+        t_ctx->framebuffer_recorder.height,
+        {
+            t_ctx->framebuffer_recorder.attachments.data,
+            t_ctx->framebuffer_recorder.count
+        }
+    );
+
+    end(t_ctx->framebuffer_recorder);
+
+    t_ctx->record_info = {};
+}
+
+void destroy_framebuffer(int id)
+{
+    ASSERT(
+        id > 0 && id < int(g_ctx->limits.framebuffers),
+        "Framebuffer ID %i out of available range 1 ... %i.",
+        id, int(g_ctx->limits.framebuffers - 1)
+    );
+
+    const bgfx::FrameBufferHandle handle =
+        g_ctx->framebuffer_cache.framebuffers[u16(id)].handle;
+
+    remove_framebuffer(g_ctx->framebuffer_cache, g_ctx->release_queue, u16(id));
+
+    if (bgfx::isValid(handle))
+    {
+        detach_framebuffer(g_ctx->pass_cache, handle);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// PUBLIC API IMPLEMENTATION - RENDER GRAPH
+// -----------------------------------------------------------------------------
+
+void graph_target(int id, int flags, int width, int height)
+{
+    ASSERT(
+        t_ctx->is_main_thread,
+        "`graph_target` must be called from main thread only."
+    );
+
+    ASSERT(
+        id >= 0 && id < int(MAX_GRAPH_TARGETS),
+        "Graph target ID %i out of available range 0 ... %i.",
+        id, int(MAX_GRAPH_TARGETS - 1)
+    );
+
+    ASSERT(width > 0 && height > 0, "Invalid graph target size %i x %i.", width, height);
+
+    ASSERT(
+        (width < SIZE_EQUAL && height < SIZE_EQUAL) ||
+        (width <= SIZE_DOUBLE && width == height),
+        "Non-conforming graph target width (%i) or height (%i).",
+        width, height
+    );
+
+    ASSERT(
+        !(flags & TEXTURE_READ_BACK),
+        "Graph targets are transient and can't be read back."
     );
-}
 
+    const GraphTargetDesc desc =
+    {
+        u16(width),
+        u16(height),
+        u16(flags & ~TEXTURE_TARGET),
+    };
 
-// -----------------------------------------------------------------------------
-// PUBLIC API IMPLEMENTATION - PASSES
-// -----------------------------------------------------------------------------
+    add_target(g_ctx->render_graph, u16(id), desc);
+}
 
-void pass(int id)
+void begin_graph_pass(int id, int flags)
 {
     ASSERT(
-        id >= 0 && id < int(MAX_PASSES),
-        "Pass ID %i out of available range 1 ... %i.",
-        id, int(MAX_PASSES - 1)
+        t_ctx->is_main_thread,
+        "`begin_graph_pass` must be called from main thread only."
     );
 
-    t_ctx->active_pass = u16(id);
-    g_ctx->pass_cache.passes[t_ctx->active_pass].dirty_flags |= Pass::DIRTY_TOUCH;
+    ASSERT(
+        id >= 0 && id < int(g_ctx->limits.passes),
+        "Pass ID %i out of available range 0 ... %i.",
+        id, int(g_ctx->limits.passes - 1)
+    );
+
+    begin_pass(g_ctx->render_graph, u16(id), (flags & GRAPH_OUTPUT) != 0);
 }
 
-void no_clear(void)
+void graph_read(int id)
 {
-    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+    ASSERT(
+        id >= 0 && id < int(MAX_GRAPH_TARGETS),
+        "Graph target ID %i out of available range 0 ... %i.",
+        id, int(MAX_GRAPH_TARGETS - 1)
+    );
 
-    if (pass.clear_flags != BGFX_CLEAR_NONE)
-    {
-        pass.clear_flags  = BGFX_CLEAR_NONE;
-        pass.dirty_flags |= Pass::DIRTY_CLEAR;
-    }
+    add_read(g_ctx->render_graph, u16(id));
 }
 
-void clear_depth(float depth)
+void graph_write(int id)
 {
-    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+    ASSERT(
+        id >= 0 && id < int(MAX_GRAPH_TARGETS),
+        "Graph target ID %i out of available range 0 ... %i.",
+        id, int(MAX_GRAPH_TARGETS - 1)
+    );
 
-    if (  pass.clear_depth != depth            ||
-        !(pass.dirty_flags & BGFX_CLEAR_DEPTH) ||
-        !(pass.clear_flags & BGFX_CLEAR_DEPTH)
-    )
-    {
-        pass.clear_flags |= BGFX_CLEAR_DEPTH;
-        pass.clear_depth  = depth;
-        pass.dirty_flags |= Pass::DIRTY_CLEAR;
-    }
+    add_write(g_ctx->render_graph, u16(id));
 }
 
-void clear_color(unsigned int rgba)
+void end_graph_pass(void)
 {
-    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
-
-    if (  pass.clear_rgba != rgba              ||
-        !(pass.dirty_flags & BGFX_CLEAR_COLOR) ||
-        !(pass.clear_flags & BGFX_CLEAR_COLOR)
-    )
-    {
-        pass.clear_flags |= BGFX_CLEAR_COLOR;
-        pass.clear_rgba   = rgba;
-        pass.dirty_flags |= Pass::DIRTY_CLEAR;
-    }
+    end_pass(g_ctx->render_graph);
 }
 
-void no_framebuffer(void)
+void compile_graph(void)
 {
-    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+    ASSERT(
+        t_ctx->is_main_thread,
+        "`compile_graph` must be called from main thread only."
+    );
 
-    pass.framebuffer  = BGFX_INVALID_HANDLE;
-    pass.dirty_flags |= Pass::DIRTY_FRAMEBUFFER;
+    compile(g_ctx->render_graph);
+
+    apply(
+        g_ctx->render_graph,
+        g_ctx->render_graph_pool,
+        g_ctx->pass_cache,
+        g_ctx->release_queue,
+        g_ctx->frame_number
+    );
 }
 
-void framebuffer(int id)
+void graph_texture(int id)
 {
     ASSERT(
-        id > 0 && id < int(MAX_FRAMEBUFFERS),
-        "Framebuffer ID %i out of available range 1 ... %i.",
-        id, int(MAX_FRAMEBUFFERS - 1)
+        id >= 0 && id < int(MAX_GRAPH_TARGETS),
+        "Graph target ID %i out of available range 0 ... %i.",
+        id, int(MAX_GRAPH_TARGETS - 1)
     );
 
-    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+    const RenderGraph& graph  = g_ctx->render_graph;
+    const GraphTarget& target = graph.targets[u16(id)];
 
-    pass.framebuffer  = g_ctx->framebuffer_cache.framebuffers[u16(id)].handle;
-    pass.dirty_flags |= Pass::DIRTY_FRAMEBUFFER;
+    ASSERT(graph.compiled, "Render graph not compiled in this frame.");
+
+    WARN(target.physical != U16_MAX, "Graph target %i not used by any pass.", id);
+
+    if (target.physical == U16_MAX)
+    {
+        return;
+    }
+
+    const u16           index   = g_ctx->render_graph_pool.assigned[target.physical];
+    const GraphTexture& texture = g_ctx->render_graph_pool.textures[index];
+
+    t_ctx->draw_state.texture = texture.handle;
+    t_ctx->draw_state.sampler = default_sampler(
+        g_ctx->default_uniforms, texture_format(texture.desc.flags).type
+    );
+    t_ctx->draw_state.texture_size[0] = texture.desc.width;
+    t_ctx->draw_state.texture_size[1] = texture.desc.height;
 }
 
-void viewport(int x, int y, int width, int height)
+
+// -----------------------------------------------------------------------------
+// PUBLIC API IMPLEMENTATION - LAYERS
+// -----------------------------------------------------------------------------
+
+int begin_layer(int id, int width, int height)
 {
-    ASSERT(x >= 0, "Negative viewport X (%i).", x);
+    ASSERT(
+        t_ctx->is_main_thread,
+        "`begin_layer` must be called from main thread only."
+    );
 
-    ASSERT(y >= 0, "Negative viewport Y (%i).", y);
+    ASSERT(
+        g_ctx->layer_cache.active == U16_MAX,
+        "Another layer in progress. Call `end_layer` first."
+    );
 
-    ASSERT(width >= 0, "Negative viewport width (%i).", width);
+    ASSERT(
+        id >= 0 && id < int(MAX_LAYERS),
+        "Layer ID %i out of available range 0 ... %i.",
+        id, int(MAX_LAYERS - 1)
+    );
 
-    ASSERT(height >= 0, "Negative viewport height (%i).", height);
+    ASSERT(width > 0 && height > 0, "Invalid layer size %i x %i.", width, height);
 
     ASSERT(
         (width < SIZE_EQUAL && height < SIZE_EQUAL) ||
-        (width <= SIZE_DOUBLE && width == height), // TODO : Inspect necessity of this.
-        "Non-conforming texture width (%i) or height (%i).",
+        (width <= SIZE_DOUBLE && width == height),
+        "Non-conforming layer width (%i) or height (%i).",
         width, height
     );
 
-    Pass& pass = g_ctx->pass_cache.passes[t_ctx->active_pass];
+    const bool redraw = mnm::rwr::begin_layer(
+        g_ctx->layer_cache,
+        g_ctx->pass_cache,
+        t_ctx->active_pass,
+        u16(id),
+        g_ctx->release_queue,
+        backbuffer_relative_size(u16(width ), u16(g_ctx->window_info.framebuffer_size.X)),
+        backbuffer_relative_size(u16(height), u16(g_ctx->window_info.framebuffer_size.Y))
+    );
 
-    if (pass.viewport_x      != x     ||
-        pass.viewport_y      != y     ||
-        pass.viewport_width  != width ||
-        pass.viewport_height != height)
-    {
-        pass.viewport_x      = u16(x);
-        pass.viewport_y      = u16(y);
-        pass.viewport_width  = u16(width);
-        pass.viewport_height = u16(height);
-        pass.dirty_flags    |= Pass::DIRTY_RECT;
-    }
+    const Layer& layer = g_ctx->layer_cache.layers[u32(id)];
+
+    viewport(0, 0, layer.texture.width, layer.texture.height);
+
+    return redraw;
 }
 
-void full_viewport(void)
+void end_layer(void)
 {
-    viewport(0, 0, SIZE_EQUAL, SIZE_EQUAL);
+    ASSERT(
+        t_ctx->is_main_thread,
+        "`end_layer` must be called from main thread only."
+    );
+
+    ASSERT(g_ctx->layer_cache.active != U16_MAX, "No layer in progress.");
+
+    mnm::rwr::end_layer(g_ctx->layer_cache, g_ctx->pass_cache);
 }
 
+void invalidate_layer(int id)
+{
+    ASSERT(
+        id >= 0 && id < int(MAX_LAYERS),
+        "Layer ID %i out of available range 0 ... %i.",
+        id, int(MAX_LAYERS - 1)
+    );
 
-// -----------------------------------------------------------------------------
-// PUBLIC API IMPLEMENTATION - FRAMEBUFFERS
-// -----------------------------------------------------------------------------
+    g_ctx->layer_cache.layers[u32(id)].invalid = true;
+}
 
-void begin_framebuffer(int id)
+void destroy_layer(int id)
 {
     ASSERT(
-        t_ctx->record_info.type == RecordType::NONE,
-        "Another recording in progress. Call respective `end_*` first."
+        t_ctx->is_main_thread,
+        "`destroy_layer` must be called from main thread only."
     );
 
     ASSERT(
-        id > 0 && id < int(MAX_FRAMEBUFFERS),
-        "Framebuffer ID %i out of available range 1 ... %i.",
-        id, int(MAX_FRAMEBUFFERS - 1)
+        id >= 0 && id < int(MAX_LAYERS),
+        "Layer ID %i out of available range 0 ... %i.",
+        id, int(MAX_LAYERS - 1)
     );
 
-    start(t_ctx->framebuffer_recorder);
+    ASSERT(
+        g_ctx->layer_cache.active != u16(id),
+        "Layer %i can't be destroyed while in progress.", id
+    );
 
-    t_ctx->record_info.id   = u16(id);
-    t_ctx->record_info.type = RecordType::FRAMEBUFFER;
+    Layer& layer = g_ctx->layer_cache.layers[u32(id)];
+
+    if (bgfx::isValid(layer.framebuffer))
+    {
+        detach_framebuffer(g_ctx->pass_cache, layer.framebuffer);
+    }
+
+    remove_layer(layer, g_ctx->release_queue);
 }
 
-void end_framebuffer(void)
+void layer(int id)
 {
     ASSERT(
-        t_ctx->record_info.type == RecordType::FRAMEBUFFER,
-        "Framebuffer recording not started. Call `begin_framebuffer` first."
+        id >= 0 && id < int(MAX_LAYERS),
+        "Layer ID %i out of available range 0 ... %i.",
+        id, int(MAX_LAYERS - 1)
     );
 
-    add_framebuffer(
-        g_ctx->framebuffer_cache,
-        t_ctx->record_info.id,
-        t_ctx->framebuffer_recorder.width,
-        t_ctx->framebuffer_recorder.height,
-        {
-            t_ctx->framebuffer_recorder.attachments.data,
-            t_ctx->framebuffer_recorder.count
-        }
+    const Layer& layer = g_ctx->layer_cache.layers[u32(id)];
+
+    if (!bgfx::isValid(layer.framebuffer) ||
+        g_ctx->pass_cache.passes[t_ctx->active_pass].graph_culled)
+    {
+        return;
+    }
+
+    ASSERT(
+        layer.pass != t_ctx->active_pass,
+        "Layer %i can't be drawn into the pass it's rendered in.", id
     );
 
-    end(t_ctx->framebuffer_recorder);
+    const ShapeKey key = shape_key(
+        t_ctx->active_pass,
+        t_ctx->shape_layer,
+        &layer.texture,
+        g_ctx->default_programs,
+        g_ctx->default_uniforms,
+        g_ctx->vertex_layout_cache
+    );
 
-    t_ctx->record_info = {};
+    add_quad(
+        t_ctx->shape_batcher, key, t_ctx->matrix_stack.top,
+        0.0f, 0.0f, f32(layer.texture.width), f32(layer.texture.height),
+        0.0f, 0.0f, 1.0f, 1.0f, U32_MAX
+    );
 }
 
 
@@ -1236,9 +2637,9 @@ void end_framebuffer(void)
 void create_uniform(int id, int type, int count, const char* name)
 {
     ASSERT(
-        id > 0 && id < int(MAX_UNIFORMS),
+        id > 0 && id < int(g_ctx->limits.uniforms),
         "Uniform ID %i out of available range 1 ... %i.",
-        id, int(MAX_UNIFORMS - 1)
+        id, int(g_ctx->limits.uniforms - 1)
     );
 
     ASSERT(
@@ -1263,17 +2664,27 @@ void create_uniform(int id, int type, int count, const char* name)
 void uniform(int id, const void* value)
 {
     ASSERT(
-        id > 0 && id < int(MAX_UNIFORMS),
+        id > 0 && id < int(g_ctx->limits.uniforms),
         "Uniform ID %i out of available range 1 ... %i.",
-        id, int(MAX_UNIFORMS - 1)
+        id, int(g_ctx->limits.uniforms - 1)
     );
 
     ASSERT(value, "Invalid uniform value pointer.");
 
-    if (!t_ctx->encoder)
+    if (t_ctx->record_info.type == RecordType::DRAW_LIST)
+    {
+        add_uniform(
+            t_ctx->draw_list_recorder,
+            g_ctx->uniform_cache.handles[u16(id)],
+            value
+        );
+
+        return;
+    }
+
+    if (!acquire_encoder(*t_ctx))
     {
-        t_ctx->encoder = bgfx::begin(!t_ctx->is_main_thread);
-        ASSERT(t_ctx->encoder, "Failed to acquire BGFX encoder.");
+        return;
     }
 
     t_ctx->encoder->setUniform(
@@ -1281,14 +2692,17 @@ void uniform(int id, const void* value)
         value,
         U16_MAX
     );
+
+    t_ctx->draw_state.encoder_state = true;
+    t_ctx->draw_state.has_uniforms  = true;
 }
 
 void create_shader(int id, const void* vs_data, int vs_size, const void* fs_data, int fs_size)
 {
     ASSERT(
-        id > 0 && id < int(MAX_PROGRAMS),
+        id > 0 && id < int(g_ctx->limits.programs),
         "Program ID %i out of available range 1 ... %i.",
-        id, int(MAX_PROGRAMS - 1)
+        id, int(g_ctx->limits.programs - 1)
     );
 
     ASSERT(vs_data, "Invalid vertex shader data pointer.");
@@ -1312,9 +2726,9 @@ void create_shader(int id, const void* vs_data, int vs_size, const void* fs_data
 void shader(int id)
 {
     ASSERT(
-        id > 0 && id < int(MAX_PROGRAMS),
+        id > 0 && id < int(g_ctx->limits.programs),
         "Program ID %i out of available range 1 ... %i.",
-        id, int(MAX_PROGRAMS - 1)
+        id, int(g_ctx->limits.programs - 1)
     );
 
     t_ctx->draw_state.program = g_ctx->program_cache.handles[u16(id)];
@@ -1331,6 +2745,8 @@ void view(void)
 
     pass.view_matrix  = t_ctx->matrix_stack.top;
     pass.dirty_flags |= Pass::DIRTY_TRANSFORM;
+
+    update_view_proj(pass);
 }
 
 void projection(void)
@@ -1339,6 +2755,8 @@ void projection(void)
 
     pass.proj_matrix  = t_ctx->matrix_stack.top;
     pass.dirty_flags |= Pass::DIRTY_TRANSFORM;
+
+    update_view_proj(pass);
 }
 
 void push(void)
@@ -1392,30 +2810,104 @@ void rotate(float angle, float x, float y, float z)
 
 void rotate_x(float angle)
 {
-    // TODO : General rotation matrix is wasteful here.
-    rotate(angle, 1.0f, 0.0f, 0.0f);
+    rotate_top(t_ctx->matrix_stack, 0, angle);
 }
 
 void rotate_y(float angle)
 {
-    // TODO : General rotation matrix is wasteful here.
-    rotate(angle, 0.0f, 1.0f, 0.0f);
+    rotate_top(t_ctx->matrix_stack, 1, angle);
 }
 
 void rotate_z(float angle)
 {
-    // TODO : General rotation matrix is wasteful here.
-    rotate(angle, 0.0f, 0.0f, 1.0f);
+    rotate_top(t_ctx->matrix_stack, 2, angle);
 }
 
 void scale(float scale)
 {
-    multiply_top(t_ctx->matrix_stack, HMM_Scale(HMM_Vec3(scale, scale, scale)));
+    scale_top(t_ctx->matrix_stack, scale, scale, scale);
 }
 
 void translate(float x, float y, float z)
 {
-    multiply_top(t_ctx->matrix_stack, HMM_Translate(HMM_Vec3(x, y, z)));
+    translate_top(t_ctx->matrix_stack, x, y, z);
+}
+
+
+// -----------------------------------------------------------------------------
+// PUBLIC API IMPLEMENTATION - TRANSFORM HIERARCHY
+// -----------------------------------------------------------------------------
+
+void node(int id, int parent)
+{
+    ASSERT(
+        t_ctx->is_main_thread,
+        "`node` must be called from main thread only."
+    );
+
+    ASSERT(
+        id >= 0 && id < int(MAX_NODES),
+        "Node ID %i out of available range 0 ... %i.",
+        id, int(MAX_NODES - 1)
+    );
+
+    set_parent(g_ctx->node_hierarchy, u32(id), parent < 0 ? NODE_ROOT : u32(parent));
+}
+
+void node_translation(int id, float x, float y, float z)
+{
+    NodeHierarchy& hierarchy = g_ctx->node_hierarchy;
+
+    ASSERT(is_valid(hierarchy, u32(id)), "Invalid node ID %i.", id);
+
+    hierarchy.translations[u32(id)]  = HMM_Vec3(x, y, z);
+    hierarchy.flags       [u32(id)] |= NODE_LOCAL_DIRTY;
+}
+
+void node_rotation(int id, float angle, float x, float y, float z)
+{
+    NodeHierarchy& hierarchy = g_ctx->node_hierarchy;
+
+    ASSERT(is_valid(hierarchy, u32(id)), "Invalid node ID %i.", id);
+
+    hierarchy.rotations[u32(id)] = HMM_QuaternionFromAxisAngle(
+        HMM_Vec3(x, y, z), HMM_ToRadians(angle)
+    );
+    hierarchy.flags[u32(id)] |= NODE_LOCAL_DIRTY;
+}
+
+void node_scale(int id, float x, float y, float z)
+{
+    NodeHierarchy& hierarchy = g_ctx->node_hierarchy;
+
+    ASSERT(is_valid(hierarchy, u32(id)), "Invalid node ID %i.", id);
+
+    hierarchy.scales[u32(id)]  = HMM_Vec3(x, y, z);
+    hierarchy.flags [u32(id)] |= NODE_LOCAL_DIRTY;
+}
+
+void update_nodes(void)
+{
+    ASSERT(
+        t_ctx->is_main_thread,
+        "`update_nodes` must be called from main thread only."
+    );
+
+    update(g_ctx->node_hierarchy, &g_ctx->task_scheduler);
+}
+
+void node_transform(int id)
+{
+    ASSERT(is_valid(g_ctx->node_hierarchy, u32(id)), "Invalid node ID %i.", id);
+
+    multiply_top(t_ctx->matrix_stack, g_ctx->node_hierarchy.worlds[u32(id)]);
+}
+
+const float* node_matrix(int id)
+{
+    ASSERT(is_valid(g_ctx->node_hierarchy, u32(id)), "Invalid node ID %i.", id);
+
+    return g_ctx->node_hierarchy.worlds[u32(id)].Elements[0];
 }
 
 
@@ -1513,9 +3005,10 @@ int renderer(void)
 
 void transient_memory(int megabytes)
 {
+    // NOTE : Thread-local contexts don't exist yet in the `init` callback.
     ASSERT(
-        t_ctx->is_main_thread,
-        "`transient_memory` must be called from main thread only."
+        !t_ctx,
+        "`transient_memory` must be called from the `init` callback only."
     );
 
     ASSERT(
@@ -1527,6 +3020,35 @@ void transient_memory(int megabytes)
     g_ctx->transient_memory = u32(megabytes << 20);
 }
 
+void shader_cache(const char* directory, int megabytes)
+{
+    ASSERT(
+        !t_ctx,
+        "`shader_cache` must be called from the `init` callback only."
+    );
+
+    ASSERT(
+        megabytes > 0,
+        "Non-positive shader cache size requested (%i).",
+        megabytes
+    );
+
+    const char* path = directory ? directory : "";
+
+    ASSERT(
+        bx::strLen(path) < i32(sizeof(g_ctx->shader_cache_path)),
+        "Shader cache path '%s' too long.",
+        path
+    );
+
+    if (!t_ctx)
+    {
+        bx::strCopy(g_ctx->shader_cache_path, sizeof(g_ctx->shader_cache_path), path);
+
+        g_ctx->shader_cache_size = u32(bx::clamp(megabytes, 1, 4095)) << 20;
+    }
+}
+
 int frame(void)
 {
     return int(g_ctx->frame_number);
@@ -1539,10 +3061,54 @@ int limit(int resource)
     case ::MAX_FONTS:
         return int(mnm::rwr::MAX_FONTS);
 
-    // TODO : Remaining limits.
+    default:
+        break;
+    }
+
+    const u32* value = limit_value(g_ctx->limits, resource);
+
+    return value ? int(*value) : 0;
+}
+
+void set_limit(int resource, int count)
+{
+    ASSERT(
+        !t_ctx,
+        "`set_limit` must be called from the `init` callback only."
+    );
+
+    u32* value = limit_value(g_ctx->limits, resource);
+
+    ASSERT(value, "Resource limit %i can't be changed.", resource);
+
+    // NOTE : Resource IDs are 16-bit, and passes also index BGFX views (half
+    //        of which is reserved for texture readback blits).
+    int max_count = int(U16_MAX);
+
+    switch (resource)
+    {
+    case ::MAX_ENCODERS:
+        max_count = int(MAX_BGFX_ENCODERS);
+        break;
+
+    case ::MAX_PASSES:
+        max_count = int(MAX_BGFX_VIEWS / 2);
+        break;
 
     default:
-        return 0;
+        break;
+    }
+
+    ASSERT(
+        count > 0 && count <= max_count,
+        "Resource limit %i out of available range 1 ... %i.",
+        count, max_count
+    );
+
+    // NOTE : Resource tables are already allocated outside of `init`.
+    if (value && !t_ctx)
+    {
+        *value = u32(bx::clamp(count, 1, max_count));
     }
 }
 
@@ -1,5 +1,6 @@
 #include "mnm_rwr_lib.cpp"
 
+#undef INFO
 #undef WARN
 
 #include <catch2/catch_test_macros.hpp>
@@ -244,6 +245,2496 @@ TEST_CASE("Dynamic Array", "[basic]")
 }
 
 
+// -----------------------------------------------------------------------------
+// HANDLE TABLE
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Handle Table", "[basic]")
+{
+    CrtAllocator allocator;
+
+    HandleTable<int> table;
+    init(table, &allocator, 10, -1);
+    REQUIRE(table.size == 10);
+
+    for (u32 i = 0; i < table.size; i++)
+    {
+        REQUIRE(table[i] == -1);
+    }
+
+    const Handle first = handle(table, 3);
+    REQUIRE(is_current(table, first));
+
+    table[3] = 30;
+    next_generation(table, 3);
+    REQUIRE(!is_current(table, first));
+    REQUIRE(is_current(table, handle(table, 3)));
+    REQUIRE(is_current(table, handle(table, 4)));
+
+    REQUIRE(!is_current(table, { 10, 0 }));
+
+    deinit(table);
+    REQUIRE(table.data == nullptr);
+    REQUIRE(table.size == 0);
+}
+
+TEST_CASE("Mesh Generations", "[basic]")
+{
+    CrtAllocator allocator;
+
+    ReleaseQueue release_queue;
+    init(release_queue, &allocator);
+    defer(deinit(release_queue));
+
+    MeshCache cache;
+    init(cache, &allocator, 4);
+    defer(deinit(cache));
+
+    // Re-recorded meshes stay valid for the draw lists referencing them.
+    const Handle first = handle(cache.meshes, 2);
+    replace_mesh(cache, release_queue, 2, Mesh(), SkinnedMesh());
+    REQUIRE(is_current(cache.meshes, first));
+
+    remove_mesh(cache, release_queue, 2);
+    REQUIRE(!is_current(cache.meshes, first));
+}
+
+
+// -----------------------------------------------------------------------------
+// AUTOMATIC INSTANCING
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Automatic Instancing", "[basic]")
+{
+    bgfx::Init init_desc;
+    init_desc.type = bgfx::RendererType::Noop;
+
+    REQUIRE(bgfx::init(init_desc));
+    defer(bgfx::shutdown());
+
+    CrtAllocator allocator;
+
+    ReleaseQueue release_queue;
+    init(release_queue, &allocator);
+    defer(deinit(release_queue));
+
+    MeshCache mesh_cache;
+    init(mesh_cache, &allocator, 4);
+    defer(deinit(mesh_cache));
+
+    InstanceCache   instance_cache;
+    DefaultUniforms default_uniforms;
+    EncoderShadow   shadow;
+
+    InstancingBatcher batcher;
+    init(batcher, &allocator);
+    defer(deinit(batcher));
+
+    bgfx::Encoder* encoder = bgfx::begin();
+    REQUIRE(encoder);
+    defer(bgfx::end(encoder));
+
+    SECTION("Destroyed Mesh")
+    {
+        DrawState state;
+        state.pass = 0;
+
+        const Handle mesh = handle(mesh_cache.meshes, 1);
+
+        add_draw(batcher, mesh, HMM_Mat4d(1.0f), state, BGFX_INVALID_HANDLE);
+        add_draw(batcher, mesh, HMM_Translate(HMM_Vec3(1.0f, 0.0f, 0.0f)), state, BGFX_INVALID_HANDLE);
+
+        remove_mesh(mesh_cache, release_queue, 1);
+
+        // Mesh recorded into the same slot afterwards (only pretending to have
+        // buffers) mustn't be picked by the draws deferred before the removal.
+        Mesh recreated;
+        recreated.element_count       = 3;
+        recreated.flags               = MESH_STATIC | PRIMITIVE_TRIANGLES;
+        recreated.positions.raw_index = 0;
+        recreated.indices  .raw_index = 0;
+
+        mesh_cache.meshes[1] = recreated;
+
+        const u32 draw_count = flush(batcher, mesh_cache, instance_cache, default_uniforms, shadow, *encoder);
+
+        mesh_cache.meshes[1] = {};
+
+        REQUIRE(draw_count == 0);
+        REQUIRE(batcher.draws.size == 0);
+    }
+
+    SECTION("Sequential Equivalence")
+    {
+        // Three meshes with two textures, interleaved as if they were submitted
+        // one by one.
+        DrawState states[2];
+        states[0].pass        = 0;
+        states[0].texture.idx = 1;
+        states[1].pass        = 0;
+        states[1].texture.idx = 2;
+
+        constexpr u32 count = 60;
+
+        InstancingDraw sequential[count];
+
+        for (u32 i = 0; i < count; i++)
+        {
+            add_draw(
+                batcher,
+                handle(mesh_cache.meshes, u16(1 + i % 3)),
+                HMM_Translate(HMM_Vec3(f32(i), 0.0f, 0.0f)),
+                states[(i / 2) % 2],
+                BGFX_INVALID_HANDLE
+            );
+
+            sequential[i] = batcher.draws[i];
+        }
+
+        REQUIRE(prepare(batcher) == 6);
+        REQUIRE(batcher.draws.size == count);
+
+        // Each batch has a single key that no other batch has.
+        u32 total = 0;
+
+        for (u32 i = 0; i < batcher.batches.size; i++)
+        {
+            const InstancingBatch& batch = batcher.batches[i];
+            const InstancingKey&   key   = batcher.draws[batch.first].key;
+
+            REQUIRE(batch.first == total);
+            REQUIRE(batch.last  >  batch.first);
+
+            for (u32 j = batch.first; j < batch.last; j++)
+            {
+                REQUIRE(0 == bx::memCmp(&batcher.draws[j].key, &key, sizeof(InstancingKey)));
+            }
+
+            for (u32 j = 0; j < i; j++)
+            {
+                REQUIRE(0 != bx::memCmp(&batcher.draws[batcher.batches[j].first].key, &key, sizeof(InstancingKey)));
+            }
+
+            total = batch.last;
+        }
+
+        REQUIRE(total == count);
+
+        // Every sequential submission ends up in exactly one batch, with its
+        // own key and transform (only the order within the batch can differ).
+        for (u32 i = 0; i < count; i++)
+        {
+            u32 matches = 0;
+
+            for (u32 j = 0; j < batcher.draws.size; j++)
+            {
+                matches +=
+                    0 == bx::memCmp(&batcher.draws[j].key      , &sequential[i].key      , sizeof(InstancingKey)) &&
+                    0 == bx::memCmp(&batcher.draws[j].transform, &sequential[i].transform, sizeof(Mat4         ));
+            }
+
+            REQUIRE(matches == 1);
+        }
+
+        resize(batcher.draws  , 0);
+        resize(batcher.batches, 0);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// LAZY CREATION
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Lazy Creation", "[basic]")
+{
+    bgfx::Init init_desc;
+    init_desc.type = bgfx::RendererType::Noop;
+
+    REQUIRE(bgfx::init(init_desc));
+    defer(bgfx::shutdown());
+
+    VertexLayoutCache layouts;
+    init(layouts);
+
+    DefaultPrograms programs;
+    init(programs, bgfx::RendererType::Noop);
+
+    constexpr u32 attribs = VERTEX_COLOR | VERTEX_TEXCOORD;
+
+    const u32 layout_index  = vertex_layout_index  (attribs);
+    const u32 program_index = default_program_index(attribs);
+
+    // The second round checks that clearing the caches allows the resources
+    // to be created again.
+    for (u32 i = 0; i < 2; i++)
+    {
+        REQUIRE(!layouts .created[layout_index ]);
+        REQUIRE(!programs.created[program_index]);
+
+        REQUIRE(!bgfx::isValid(layouts .handles[layout_index ]));
+        REQUIRE(!bgfx::isValid(programs.handles[program_index]));
+
+        // First use creates the resource.
+        const bgfx::VertexLayoutHandle layout  = vertex_layout_handle(layouts , attribs);
+        const bgfx::ProgramHandle      program = default_program     (programs, attribs);
+
+        REQUIRE(bgfx::isValid(layout ));
+        REQUIRE(bgfx::isValid(program));
+
+        REQUIRE(layouts .created[layout_index ]);
+        REQUIRE(programs.created[program_index]);
+
+        // Later uses return the same one.
+        REQUIRE(vertex_layout_handle(layouts , attribs).idx == layout .idx);
+        REQUIRE(default_program     (programs, attribs).idx == program.idx);
+
+        deinit(layouts );
+        deinit(programs);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// OCCLUSION QUERIES
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Occlusion Query Fallback", "[basic]")
+{
+    CrtAllocator allocator;
+
+    VertexLayoutCache layouts;
+    init(layouts);
+
+    DefaultPrograms programs;
+    init(programs, bgfx::RendererType::Noop);
+
+    OcclusionQueryCache cache;
+    init(cache, &allocator, 16, layouts, programs, false);
+
+    REQUIRE(cache.queries.size == 16);
+
+    for (u16 i = 0; i < cache.queries.size; i++)
+    {
+        REQUIRE(!bgfx::isValid(acquire_query(cache, i)));
+        REQUIRE(is_visible(cache, i));
+    }
+
+    deinit(cache);
+
+    // Nothing gets created until it's actually used.
+    for (u32 i = 0; i < layouts.created.size; i++)
+    {
+        REQUIRE(!layouts.created[i]);
+        REQUIRE(!bgfx::isValid(layouts.handles[i]));
+    }
+
+    for (u32 i = 0; i < programs.created.size; i++)
+    {
+        REQUIRE(!programs.created[i]);
+        REQUIRE(!bgfx::isValid(programs.handles[i]));
+    }
+}
+
+TEST_CASE("Occlusion Queries", "[basic]")
+{
+    bgfx::Init init_desc;
+    init_desc.type = bgfx::RendererType::Noop;
+
+    REQUIRE(bgfx::init(init_desc));
+    defer(bgfx::shutdown());
+
+    // Noop renderer claims the support, but never produces any results.
+    bgfx::Caps caps = *bgfx::getCaps();
+    caps.supported |= BGFX_CAPS_OCCLUSION_QUERY;
+
+    REQUIRE(!occlusion_queries_supported(caps));
+
+    caps.rendererType = bgfx::RendererType::Vulkan;
+    REQUIRE(occlusion_queries_supported(caps));
+
+    caps.supported &= ~BGFX_CAPS_OCCLUSION_QUERY;
+    REQUIRE(!occlusion_queries_supported(caps));
+
+    CrtAllocator allocator;
+
+    VertexLayoutCache layouts;
+    init(layouts);
+    defer(deinit(layouts));
+
+    DefaultPrograms programs;
+    init(programs, bgfx::RendererType::Noop);
+    defer(deinit(programs));
+
+    OcclusionQueryCache cache;
+    init(cache, &allocator, 4, layouts, programs, true);
+    defer(deinit(cache));
+
+    REQUIRE(bgfx::isValid(cache.box_vertices));
+    REQUIRE(bgfx::isValid(cache.box_indices));
+    REQUIRE(bgfx::isValid(cache.program));
+
+    // Queries are created on the first use, and reused afterwards.
+    REQUIRE(!bgfx::isValid(cache.queries[2]));
+
+    const bgfx::OcclusionQueryHandle query = acquire_query(cache, 2);
+    REQUIRE(bgfx::isValid(query));
+    REQUIRE(acquire_query(cache, 2).idx == query.idx);
+    REQUIRE(!bgfx::isValid(cache.queries[3]));
+
+    // No result yet, so the mesh is considered visible.
+    REQUIRE(is_visible(cache, 2));
+}
+
+
+// -----------------------------------------------------------------------------
+// BINARY CACHE
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Binary Cache", "[basic]")
+{
+    CrtAllocator allocator;
+
+    const char* directory = "mnm_binary_cache_test";
+
+    u8 blobs[3][32];
+    u8 buffer[32];
+
+    for (u32 i = 0; i < BX_COUNTOF(blobs); i++)
+    {
+        fill_value(blobs[i], u8(i + 1), sizeof(blobs[i]));
+    }
+
+    SECTION("Disabled")
+    {
+        BinaryCache cache;
+        init(cache, &allocator, nullptr, 64);
+        defer(deinit(cache));
+
+        REQUIRE(!write(cache, 1, blobs[0], sizeof(blobs[0])));
+        REQUIRE(read_size(cache, 1) == 0);
+        REQUIRE(!read(cache, 1, buffer, sizeof(buffer)));
+    }
+
+    SECTION("Round Trip & Eviction")
+    {
+        BinaryCache cache;
+        init(cache, &allocator, directory, 64);
+        clear(cache); // In case the previous run failed.
+
+        REQUIRE(write(cache, 1, blobs[0], sizeof(blobs[0])));
+        REQUIRE(write(cache, 2, blobs[1], 16));
+        REQUIRE(cache.total_size == 48);
+
+        REQUIRE(read_size(cache, 1) == 32);
+        REQUIRE(read_size(cache, 2) == 16);
+        REQUIRE(read_size(cache, 3) == 0);
+
+        REQUIRE(read(cache, 1, buffer, sizeof(buffer)));
+        REQUIRE(bx::memCmp(buffer, blobs[0], sizeof(buffer)) == 0);
+
+        REQUIRE(!read(cache, 2, buffer, sizeof(buffer)));
+
+        // Rewriting the key replaces the blob.
+        REQUIRE(write(cache, 2, blobs[1], sizeof(blobs[1])));
+        REQUIRE(read_size(cache, 2) == 32);
+        REQUIRE(cache.total_size == 64);
+
+        // Oldest blob gets evicted to fit the new one.
+        REQUIRE(write(cache, 3, blobs[2], sizeof(blobs[2])));
+        REQUIRE(read_size(cache, 1) == 0);
+        REQUIRE(read_size(cache, 2) == 32);
+        REQUIRE(read_size(cache, 3) == 32);
+        REQUIRE(cache.total_size == 64);
+
+        // Blobs over the limit are rejected.
+        REQUIRE(!write(cache, 4, blobs, sizeof(blobs)));
+        REQUIRE(read_size(cache, 4) == 0);
+
+        // Entries persist between runs.
+        deinit(cache);
+        init(cache, &allocator, directory, 64);
+
+        REQUIRE(cache.entries.size == 2);
+        REQUIRE(read(cache, 3, buffer, sizeof(buffer)));
+        REQUIRE(bx::memCmp(buffer, blobs[2], sizeof(buffer)) == 0);
+
+        // Missing blob files get dropped from the index.
+        char path[MAX_BINARY_CACHE_FILE];
+        file_path(cache, u64(2), path);
+        REQUIRE(::remove(path) == 0);
+
+        REQUIRE(!read(cache, 2, buffer, sizeof(buffer)));
+        REQUIRE(read_size(cache, 2) == 0);
+        REQUIRE(cache.total_size == 32);
+
+        clear(cache);
+        REQUIRE(cache.entries.size == 0);
+        REQUIRE(cache.total_size == 0);
+
+        deinit(cache);
+        bx::remove(bx::FilePath(directory));
+    }
+
+    SECTION("BGFX Callbacks")
+    {
+        BinaryCache cache;
+        init(cache, &allocator, directory, 1024);
+
+        BgfxCallbacks callbacks;
+        callbacks.binary_cache = &cache;
+
+        callbacks.cacheWrite(0xdeadbeefcafe, blobs[1], sizeof(blobs[1]));
+        REQUIRE(callbacks.cacheReadSize(0xdeadbeefcafe) == sizeof(blobs[1]));
+        REQUIRE(callbacks.cacheReadSize(0xcafe) == 0);
+
+        REQUIRE(callbacks.cacheRead(0xdeadbeefcafe, buffer, sizeof(buffer)));
+        REQUIRE(bx::memCmp(buffer, blobs[1], sizeof(buffer)) == 0);
+
+        clear(cache);
+        deinit(cache);
+        bx::remove(bx::FilePath(directory));
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// TEXTURES
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Backbuffer Relative Size", "[basic]")
+{
+    REQUIRE(backbuffer_relative_size(300           , 1280) == 300 );
+    REQUIRE(backbuffer_relative_size(SIZE_EQUAL    , 1280) == 1280);
+    REQUIRE(backbuffer_relative_size(SIZE_HALF     , 1280) == 640 );
+    REQUIRE(backbuffer_relative_size(SIZE_SIXTEENTH, 8   ) == 1   );
+    REQUIRE(backbuffer_relative_size(SIZE_DOUBLE   , 1280) == 2560);
+}
+
+
+// -----------------------------------------------------------------------------
+// TEXTURE COPY
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Texture Copy", "[basic]")
+{
+    SECTION("Validation")
+    {
+        // Only the metadata is inspected, so the handles don't have to exist.
+        Texture src;
+        src.handle = { 1 };
+        src.width  = 256;
+        src.height = 128;
+        src.format = bgfx::TextureFormat::RGBA8;
+
+        Texture dst = src;
+        dst.handle = { 2 };
+        dst.width  = SIZE_HALF;
+        dst.height = SIZE_HALF;
+        dst.flags  = TEXTURE_BLIT_DST;
+
+        TextureCopy copy = {};
+        copy.width  = 64;
+        copy.height = 64;
+
+        REQUIRE( is_valid_copy(dst, src, copy, 800, 600));
+        REQUIRE(!is_valid_copy(src, dst, copy, 800, 600)); // Destination not blittable.
+
+        copy.src_x = 192;
+        REQUIRE( is_valid_copy(dst, src, copy, 800, 600));
+
+        copy.src_x = 193;
+        REQUIRE(!is_valid_copy(dst, src, copy, 800, 600));
+
+        // Destination is resolved to 400 x 300 pixels.
+        copy.src_x = 0;
+        copy.dst_y = 236;
+        REQUIRE( is_valid_copy(dst, src, copy, 800, 600));
+        REQUIRE(!is_valid_copy(dst, src, copy, 800, 598));
+
+        copy.dst_y = 0;
+        REQUIRE(!is_valid_copy(dst, src, TextureCopy{ 0, 0, 0, 0, 0, 64, 0, 0 }, 800, 600));
+
+        copy.src_mip = 1;
+        REQUIRE(!is_valid_copy(dst, src, copy, 800, 600)); // Single mip level.
+
+        copy.src_mip = 0;
+        src.format   = bgfx::TextureFormat::R8;
+        REQUIRE(!is_valid_copy(dst, src, copy, 800, 600));
+
+        // Depth textures only as a whole.
+        src.format = bgfx::TextureFormat::D24S8;
+        dst.format = bgfx::TextureFormat::D24S8;
+        dst.width  = 256;
+        dst.height = 128;
+        REQUIRE(!is_valid_copy(dst, src, copy, 800, 600));
+
+        copy.width  = 256;
+        copy.height = 128;
+        REQUIRE( is_valid_copy(dst, src, copy, 800, 600));
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// RENDER GRAPH
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Render Graph", "[basic]")
+{
+    RenderGraph graph;
+
+    const GraphTargetDesc color = { 256, 256, TEXTURE_DEFAULT };
+    const GraphTargetDesc mask  = { 256, 256, TEXTURE_R8      };
+
+    for (u16 i = 0; i < 5; i++)
+    {
+        add_target(graph, i, i == 3 ? mask : color);
+    }
+
+    // Chain A (10) -> B (11) -> C (12) -> D (13), declared out of order, with
+    // A also producing a mask for D, and E (14) contributing to nothing.
+    begin_pass(graph, 13, true);
+    add_read(graph, 2);
+    add_read(graph, 3);
+    end_pass(graph);
+
+    begin_pass(graph, 12, false);
+    add_read(graph, 1);
+    add_write(graph, 2);
+    end_pass(graph);
+
+    begin_pass(graph, 14, false);
+    add_write(graph, 4);
+    end_pass(graph);
+
+    begin_pass(graph, 11, false);
+    add_read(graph, 0);
+    add_write(graph, 1);
+    end_pass(graph);
+
+    begin_pass(graph, 10, false);
+    add_write(graph, 0);
+    add_write(graph, 3);
+    end_pass(graph);
+
+    REQUIRE(compile(graph));
+
+    REQUIRE(graph.order_count == 4);
+    REQUIRE(graph.passes[graph.order[0]].pass == 10);
+    REQUIRE(graph.passes[graph.order[1]].pass == 11);
+    REQUIRE(graph.passes[graph.order[2]].pass == 12);
+    REQUIRE(graph.passes[graph.order[3]].pass == 13);
+    REQUIRE(graph.passes[2].culled);
+
+    // Targets 0 and 2 never live at the same time, the mask has a different
+    // format, and the culled pass' target is never allocated.
+    REQUIRE(graph.physical_count == 3);
+    REQUIRE(graph.targets[0].physical == graph.targets[2].physical);
+    REQUIRE(graph.targets[1].physical != graph.targets[0].physical);
+    REQUIRE(graph.targets[3].physical != graph.targets[0].physical);
+    REQUIRE(graph.targets[3].physical != graph.targets[1].physical);
+    REQUIRE(graph.targets[4].physical == U16_MAX);
+
+    reset(graph);
+    REQUIRE(!graph.compiled);
+    REQUIRE(graph.pass_count == 0);
+    REQUIRE(!graph.targets[0].declared);
+}
+
+
+// -----------------------------------------------------------------------------
+// FRUSTUM CULLING
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Frustum Culling", "[basic]")
+{
+    // Camera at Z = 10 looking at the origin, where the frustum is 20 units
+    // wide and high.
+    Pass pass;
+    pass.view_matrix = HMM_LookAt(HMM_Vec3(0.0f, 0.0f, 10.0f), HMM_Vec3(0.0f, 0.0f, 0.0f), HMM_Vec3(0.0f, 1.0f, 0.0f));
+    pass.proj_matrix = HMM_Perspective(90.0f, 1.0f, 1.0f, 100.0f);
+    update_view_proj(pass);
+
+    SECTION("Plane Extraction")
+    {
+        const auto distance = [&](u32 plane, f32 x, f32 y, f32 z)
+        {
+            return HMM_DotVec3(pass.frustum[plane].XYZ, HMM_Vec3(x, y, z)) + pass.frustum[plane].W;
+        };
+
+        for (u32 i = 0; i < BX_COUNTOF(pass.frustum); i++)
+        {
+            REQUIRE(bx::abs(HMM_LengthVec3(pass.frustum[i].XYZ) - 1.0f) < 1e-5f);
+
+            // Planes point inside.
+            REQUIRE(distance(i, 0.0f, 0.0f, 0.0f) > 0.0f);
+        }
+
+        // Left, right, bottom, top, near and far, in this order.
+        REQUIRE(bx::abs(distance(0, -10.0f,   0.0f,   0.0f)) < 1e-4f);
+        REQUIRE(bx::abs(distance(1,  10.0f,   0.0f,   0.0f)) < 1e-4f);
+        REQUIRE(bx::abs(distance(2,   0.0f, -10.0f,   0.0f)) < 1e-4f);
+        REQUIRE(bx::abs(distance(3,   0.0f,  10.0f,   0.0f)) < 1e-4f);
+        REQUIRE(bx::abs(distance(4,   0.0f,   0.0f,   9.0f)) < 1e-4f);
+        REQUIRE(bx::abs(distance(5,   0.0f,   0.0f, -90.0f)) < 1e-3f);
+
+        REQUIRE(distance(1, 11.0f, 0.0f,  0.0f) < 0.0f);
+        REQUIRE(distance(4,  0.0f, 0.0f, 9.5f) < 0.0f);
+    }
+
+    SECTION("Visibility")
+    {
+        Mesh cube;
+        cube.bounds_min    = HMM_Vec3(-1.0f, -1.0f, -1.0f);
+        cube.bounds_max    = HMM_Vec3( 1.0f,  1.0f,  1.0f);
+        cube.bounds_radius = sqrtf(3.0f);
+
+        // Inside.
+        REQUIRE(is_visible(pass, cube, HMM_Mat4d(1.0f)));
+        REQUIRE(is_visible(pass, cube, HMM_Translate(HMM_Vec3(5.0f, -5.0f, -20.0f))));
+
+        // Outside.
+        REQUIRE(!is_visible(pass, cube, HMM_Translate(HMM_Vec3(50.0f,  0.0f,    0.0f))));
+        REQUIRE(!is_visible(pass, cube, HMM_Translate(HMM_Vec3( 0.0f,  0.0f,   20.0f))));
+        REQUIRE(!is_visible(pass, cube, HMM_Translate(HMM_Vec3( 0.0f,  0.0f, -200.0f))));
+
+        // Straddling a plane.
+        REQUIRE(is_visible(pass, cube, HMM_Translate(HMM_Vec3( 10.0f, 0.0f,   0.0f))));
+        REQUIRE(is_visible(pass, cube, HMM_Translate(HMM_Vec3(  0.0f, 0.0f,   9.5f))));
+        REQUIRE(is_visible(pass, cube, HMM_Translate(HMM_Vec3(  0.0f, 0.0f, -90.0f))));
+
+        // Scale is applied to the bounding sphere.
+        REQUIRE( is_visible(pass, cube, HMM_Translate(HMM_Vec3(14.0f, 0.0f, 0.0f)) * HMM_Scale(HMM_Vec3(5.0f, 5.0f, 5.0f))));
+        REQUIRE(!is_visible(pass, cube, HMM_Translate(HMM_Vec3(14.0f, 0.0f, 0.0f))));
+
+        // Flat quad next to the frustum's corner, so its bounding sphere still
+        // intersects two of the planes, but its box lies outside one of them.
+        Mesh quad;
+        quad.bounds_min    = HMM_Vec3(-1.0f, -1.0f, 0.0f);
+        quad.bounds_max    = HMM_Vec3( 1.0f,  1.0f, 0.0f);
+        quad.bounds_radius = sqrtf(2.0f);
+
+        const Mat4 corner = HMM_Translate(HMM_Vec3(11.2f, 11.2f, 0.0f));
+
+        REQUIRE(HMM_DotVec3(pass.frustum[1].XYZ, corner.Elements[3].XYZ) + pass.frustum[1].W > -quad.bounds_radius);
+        REQUIRE(!is_visible(pass, quad, corner));
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// SORT MODES
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Sort Modes", "[basic]")
+{
+    const Mat4 view = HMM_LookAt(HMM_Vec3(0.0f, 0.0f, 10.0f), HMM_Vec3(0.0f, 0.0f, 0.0f), HMM_Vec3(0.0f, 1.0f, 0.0f));
+
+    Mesh mesh;
+    mesh.bounds_min = HMM_Vec3(-1.0f, -1.0f, -1.0f);
+    mesh.bounds_max = HMM_Vec3( 1.0f,  1.0f,  1.0f);
+
+    const auto key_at = [&](f32 x, f32 y, f32 z)
+    {
+        return depth_key(mesh, HMM_Translate(HMM_Vec3(x, y, z)), view);
+    };
+
+    SECTION("Depth Key")
+    {
+        // Key is the view-space distance's bit pattern.
+        const f32 distance = 10.0f;
+        u32       expected;
+        bx::memCopy(&expected, &distance, sizeof(expected));
+
+        REQUIRE(key_at(0.0f, 0.0f, 0.0f) == expected);
+
+        // Only the distance along the view direction matters.
+        REQUIRE(key_at(5.0f, -3.0f, 0.0f) == expected);
+
+        // Nearer meshes have smaller keys, so that `SORT_FRONT_TO_BACK` (which
+        // sorts the keys in ascending order) draws them first.
+        u32 previous = 0;
+
+        for (f32 z = 9.0f; z > -1000.0f; z -= 7.5f)
+        {
+            const u32 key = key_at(0.0f, 0.0f, z);
+
+            REQUIRE(key > previous);
+
+            previous = key;
+        }
+
+        // Meshes behind the camera are all treated as being in its origin.
+        REQUIRE(key_at(0.0f, 0.0f, 11.0f) == 0);
+        REQUIRE(key_at(0.0f, 0.0f, 50.0f) == 0);
+
+        // Bounding box center is used, not the mesh origin.
+        Mesh offset = mesh;
+        offset.bounds_min = HMM_Vec3(-1.0f, -1.0f, -6.0f);
+        offset.bounds_max = HMM_Vec3( 1.0f,  1.0f, -4.0f);
+
+        REQUIRE(depth_key(offset, HMM_Mat4d(1.0f), view) == key_at(0.0f, 0.0f, -5.0f));
+    }
+
+    SECTION("View Mode")
+    {
+        bgfx::Init init_desc;
+        init_desc.type = bgfx::RendererType::Noop;
+
+        REQUIRE(bgfx::init(init_desc));
+        defer(bgfx::shutdown());
+
+        CrtAllocator allocator;
+
+        PassCache passes;
+        init(passes, &allocator, 4);
+        defer(deinit(passes));
+
+        REQUIRE(passes.passes[0].sort_mode == SORT_STATE);
+
+        const bgfx::ViewMode::Enum view_modes[] =
+        {
+            bgfx::ViewMode::Default,
+            bgfx::ViewMode::Sequential,
+            bgfx::ViewMode::DepthAscending,
+            bgfx::ViewMode::DepthDescending,
+        };
+
+        const int sort_modes[] =
+        {
+            SORT_STATE,
+            SORT_SEQUENTIAL,
+            SORT_FRONT_TO_BACK,
+            SORT_BACK_TO_FRONT,
+        };
+
+        bgfx::Encoder* encoder = bgfx::begin();
+        REQUIRE(encoder);
+        defer(bgfx::end(encoder));
+
+        for (u32 i = 0; i < BX_COUNTOF(sort_modes); i++)
+        {
+            Pass& pass = passes.passes[i];
+            pass.sort_mode    = u8(sort_modes[i]);
+            pass.dirty_flags |= Pass::DIRTY_SORT;
+
+            REQUIRE(bgfx::ViewMode::Enum(pass.sort_mode) == view_modes[i]);
+        }
+
+        update_passes(passes, 800, 600, encoder);
+
+        for (u32 i = 0; i < BX_COUNTOF(sort_modes); i++)
+        {
+            REQUIRE(passes.passes[i].dirty_flags == Pass::DIRTY_NONE);
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// DIRTY REGIONS
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Dirty Regions", "[basic]")
+{
+    constexpr u16 width  = 800;
+    constexpr u16 height = 600;
+
+    Pass pass;
+    pass.proj_matrix = HMM_Orthographic(0.0f, width, height, 0.0f, -1.0f, 1.0f);
+    update_view_proj(pass);
+
+    Mesh mesh;
+    mesh.bounds_min = HMM_Vec3(0.0f, 0.0f, 0.0f);
+    mesh.bounds_max = HMM_Vec3(1.0f, 1.0f, 0.0f);
+
+    // 10 x 10 pixels square with the top-left corner at given position.
+    const auto is_square_damaged = [&](f32 x, f32 y)
+    {
+        const Mat4 model = HMM_Translate(HMM_Vec3(x, y, 0.0f)) * HMM_Scale(HMM_Vec3(10.0f, 10.0f, 1.0f));
+
+        return is_damaged(pass, mesh, model, width, height);
+    };
+
+    SECTION("No Damage")
+    {
+        u16 rect[4];
+        redrawn_rect(pass, width, height, rect);
+
+        REQUIRE(rect[0] == 0);
+        REQUIRE(rect[1] == 0);
+        REQUIRE(rect[2] == 1);
+        REQUIRE(rect[3] == 1);
+
+        REQUIRE( is_square_damaged(  0.0f,   0.0f));
+        REQUIRE(!is_square_damaged(100.0f, 100.0f));
+    }
+
+    SECTION("Union")
+    {
+        add_damage(pass, 100, 100, 150, 150);
+
+        REQUIRE( is_square_damaged(120.0f, 120.0f));
+        REQUIRE( is_square_damaged( 95.0f,  95.0f)); // Partially overlapping.
+        REQUIRE(!is_square_damaged( 85.0f,  85.0f));
+        REQUIRE(!is_square_damaged(  0.0f,   0.0f));
+        REQUIRE(!is_square_damaged(200.0f, 200.0f));
+
+        add_damage(pass, 300, 300, 310, 310);
+
+        REQUIRE( is_square_damaged(200.0f, 200.0f));
+        REQUIRE(!is_square_damaged(400.0f, 200.0f));
+
+        reset_damage(pass);
+
+        REQUIRE(!is_square_damaged(120.0f, 120.0f));
+    }
+
+    SECTION("Whole Pass")
+    {
+        add_damage(pass, 0, 0, U16_MAX, U16_MAX);
+
+        REQUIRE(is_square_damaged(  0.0f,   0.0f));
+        REQUIRE(is_square_damaged(790.0f, 590.0f));
+
+        u16 rect[4];
+        redrawn_rect(pass, width, height, rect);
+
+        REQUIRE(rect[0] == 0);
+        REQUIRE(rect[1] == 0);
+        REQUIRE(rect[2] == width);
+        REQUIRE(rect[3] == height);
+    }
+
+    SECTION("Projection")
+    {
+        // Corners of the redrawn rectangle have to end up in the clip space
+        // corners, as the view rectangle is shrunk to it.
+        const u16  rect[4]    = { 100, 50, 300, 250 };
+        const Mat4 adjustment = damage_projection(rect, width, height);
+
+        const Vec4 top_left     = adjustment * HMM_Vec4(100.0f / width * 2.0f - 1.0f, 1.0f -  50.0f / height * 2.0f, 0.5f, 1.0f);
+        const Vec4 bottom_right = adjustment * HMM_Vec4(300.0f / width * 2.0f - 1.0f, 1.0f - 250.0f / height * 2.0f, 0.5f, 1.0f);
+
+        REQUIRE(bx::abs(top_left    .X + 1.0f) < 1e-5f);
+        REQUIRE(bx::abs(top_left    .Y - 1.0f) < 1e-5f);
+        REQUIRE(bx::abs(bottom_right.X - 1.0f) < 1e-5f);
+        REQUIRE(bx::abs(bottom_right.Y + 1.0f) < 1e-5f);
+        REQUIRE(bx::abs(bottom_right.Z - 0.5f) < 1e-5f);
+    }
+
+    SECTION("Behind Camera")
+    {
+        pass.proj_matrix = HMM_Perspective(60.0f, f32(width) / height, 0.1f, 100.0f);
+        update_view_proj(pass);
+
+        add_damage(pass, 0, 0, 1, 1);
+
+        // Can't be projected, so it's conservatively considered damaged.
+        REQUIRE(is_damaged(pass, mesh, HMM_Translate(HMM_Vec3(0.0f, 0.0f, 5.0f)), width, height));
+    }
+}
+
+TEST_CASE("Multi-Pass Submission", "[basic]")
+{
+    constexpr u16 width  = 800;
+    constexpr u16 height = 600;
+
+    CrtAllocator allocator;
+
+    PassCache cache;
+    init(cache, &allocator, 4);
+    defer(deinit(cache));
+
+    for (u32 i = 0; i < cache.passes.size; i++)
+    {
+        cache.passes[i].proj_matrix = HMM_Orthographic(0.0f, width, height, 0.0f, -1.0f, 1.0f);
+        update_view_proj(cache.passes[i]);
+    }
+
+    Mesh mesh;
+    mesh.bounds_min    = HMM_Vec3(0.0f, 0.0f, 0.0f);
+    mesh.bounds_max    = HMM_Vec3(1.0f, 1.0f, 0.0f);
+    mesh.bounds_radius = 0.7072f;
+
+    // Off-screen square, only visible in passes without culling.
+    const Mat4 model = HMM_Translate(HMM_Vec3(-100.0f, -100.0f, 0.0f)) * HMM_Scale(HMM_Vec3(10.0f, 10.0f, 1.0f));
+
+    cache.passes[1].frustum_culling = true;
+    cache.passes[2].graph_culled    = true;
+
+    const int    passes[] = { 0, 1, 2, 3 };
+    bgfx::ViewId visible[4];
+
+    SECTION("Culling")
+    {
+        const u32 count = visible_passes(cache, passes, 4, mesh, model, true, width, height, 0, visible);
+
+        REQUIRE(count == 2);
+        REQUIRE(visible[0] == 0);
+        REQUIRE(visible[1] == 3);
+
+        REQUIRE(cache.passes[1].culled_count == 1);
+        REQUIRE(cache.passes[2].culled_count == 0);
+
+        // Only the passes other than the active one need touching.
+        REQUIRE(!(cache.passes[0].dirty_flags & Pass::DIRTY_TOUCH));
+        REQUIRE( (cache.passes[3].dirty_flags & Pass::DIRTY_TOUCH));
+    }
+
+    SECTION("Unknown Transform")
+    {
+        const u32 count = visible_passes(cache, passes, 4, mesh, model, false, width, height, 0, visible);
+
+        REQUIRE(count == 3);
+        REQUIRE(visible[0] == 0);
+        REQUIRE(visible[1] == 1);
+        REQUIRE(visible[2] == 3);
+
+        REQUIRE(cache.passes[1].culled_count == 0);
+    }
+
+    SECTION("Dirty Regions")
+    {
+        // On-screen square, submitted into two passes with dirty regions, only
+        // one of them damaged where the square is.
+        const Mat4 on_screen = HMM_Translate(HMM_Vec3(100.0f, 100.0f, 0.0f)) * HMM_Scale(HMM_Vec3(10.0f, 10.0f, 1.0f));
+
+        cache.passes[0].dirty_regions = true;
+        cache.passes[3].dirty_regions = true;
+
+        add_damage(cache.passes[0], 400, 300, 500, 400);
+        add_damage(cache.passes[3],  90,  90, 120, 120);
+
+        const int damaged[] = { 0, 3 };
+
+        const u32 count = visible_passes(cache, damaged, 2, mesh, on_screen, true, width, height, 0, visible);
+
+        REQUIRE(count == 1);
+        REQUIRE(visible[0] == 3);
+
+        REQUIRE(cache.passes[0].culled_count == 1);
+        REQUIRE(cache.passes[3].culled_count == 0);
+
+        // Submission into the undamaged pass alone is skipped altogether.
+        REQUIRE(visible_passes(cache, damaged, 1, mesh, on_screen, true, width, height, 0, visible) == 0);
+
+        // Damage added later in the frame makes it visible again.
+        add_damage(cache.passes[0], 0, 0, 105, 105);
+
+        REQUIRE(visible_passes(cache, damaged, 1, mesh, on_screen, true, width, height, 0, visible) == 1);
+        REQUIRE(visible[0] == 0);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// CACHED LAYERS
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Cached Layers", "[basic]")
+{
+    bgfx::Init init_desc;
+    init_desc.type = bgfx::RendererType::Noop;
+
+    REQUIRE(bgfx::init(init_desc));
+    defer(bgfx::shutdown());
+
+    CrtAllocator allocator;
+
+    ReleaseQueue release_queue;
+    init(release_queue, &allocator);
+    defer(deinit(release_queue));
+
+    Layer layer;
+    defer(destroy_if_valid(layer.framebuffer));
+
+    REQUIRE(update_layer(layer, release_queue, 300, 200));
+    REQUIRE(bgfx::isValid(layer.framebuffer));
+    REQUIRE(layer.texture.width  == 300);
+    REQUIRE(layer.texture.height == 200);
+
+    layer.invalid = false;
+    REQUIRE(!update_layer(layer, release_queue, 300, 200));
+    REQUIRE(release_queue.items.size == 0);
+
+    layer.invalid = true;
+    REQUIRE(update_layer(layer, release_queue, 300, 200));
+    REQUIRE(release_queue.items.size == 0);
+
+    // Resizing recreates the target, and releases the old one.
+    layer.invalid = false;
+    REQUIRE(update_layer(layer, release_queue, 400, 200));
+    REQUIRE(release_queue.items.size == 1);
+    REQUIRE(layer.texture.width == 400);
+
+    // Passes rendering into clean layers mustn't be touched (and so cleared).
+    PassCache passes;
+    init(passes, &allocator, 2);
+    defer(deinit(passes));
+
+    LayerCache cache;
+    defer(deinit(cache));
+
+    bgfx::Encoder* encoder = bgfx::begin();
+    REQUIRE(encoder);
+    defer(bgfx::end(encoder));
+
+    for (u32 frame = 0; frame < 3; frame++)
+    {
+        Pass& pass = passes.passes[1];
+
+        touch(pass); // The `pass` call.
+
+        const bool redraw = begin_layer(cache, passes, 1, 0, release_queue, 300, 200);
+        REQUIRE(redraw == (frame == 0));
+        REQUIRE(pass.graph_culled == !redraw);
+
+        end_layer(cache, passes);
+        REQUIRE(!pass.graph_culled);
+
+        touch(pass); // The end of the frame.
+        REQUIRE(bool(pass.dirty_flags & Pass::DIRTY_TOUCH) == redraw);
+
+        update_passes(passes, 800, 600, encoder);
+    }
+
+    cache.layers[0].invalid = true;
+    REQUIRE(begin_layer(cache, passes, 1, 0, release_queue, 300, 200));
+    end_layer(cache, passes);
+    REQUIRE(passes.passes[1].dirty_flags & Pass::DIRTY_TOUCH);
+}
+
+
+// -----------------------------------------------------------------------------
+// SHAPE BATCHING
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Shape Batching", "[basic]")
+{
+    CrtAllocator allocator;
+
+    ShapeBatcher batcher;
+    init(batcher, &allocator);
+    defer(deinit(batcher));
+
+    const Mat4 identity = HMM_Mat4d(1.0f);
+
+    const auto key = [](u16 pass, u16 layer, u16 texture)
+    {
+        ShapeKey key = {};
+        key.pass        = pass;
+        key.layer       = layer;
+        key.texture.idx = texture;
+
+        return key;
+    };
+
+    // Consecutive shapes with the same key share a run.
+    add_quad(batcher, key(0, 1, 5), identity, 0, 0, 1, 1, 0, 0, 1, 1, U32_MAX);
+    add_quad(batcher, key(0, 1, 5), identity, 1, 0, 2, 1, 0, 0, 1, 1, U32_MAX);
+    REQUIRE(batcher.runs.size == 1);
+    REQUIRE(batcher.runs[0].vertex_count == 8);
+    REQUIRE(batcher.indices[6] == 4);
+
+    add_rounded_rect(batcher, key(0, 0, 7), identity, 0, 0, 20, 10, 5, U32_MAX);
+    add_quad(batcher, key(0, 1, 5), identity, 2, 0, 3, 1, 0, 0, 1, 1, U32_MAX);
+    REQUIRE(batcher.runs.size == 3);
+
+    const u32 points = (shape_segments(5.0f) / 4 + 1) * 4;
+    REQUIRE(batcher.runs[1].vertex_count == points + 1);
+    REQUIRE(batcher.runs[1].index_count  == points * 3);
+
+    // Fan points stay on the rounded rectangle's outline.
+    for (u32 i = 1; i <= points; i++)
+    {
+        const Vec3& p = batcher.positions[batcher.runs[1].first_vertex + i];
+
+        REQUIRE(p.X >= -0.001f); REQUIRE(p.X <= 20.001f);
+        REQUIRE(p.Y >= -0.001f); REQUIRE(p.Y <= 10.001f);
+    }
+
+    // Lower layer goes first, same keys get merged despite being interleaved.
+    REQUIRE(prepare(batcher) == 2);
+    REQUIRE(batcher.runs[batcher.draws[0].first_run].key.layer == 0);
+    REQUIRE(batcher.draws[1].vertex_count == 12);
+    REQUIRE(batcher.draws[1].index_count  == 18);
+
+    reset(batcher);
+    REQUIRE(batcher.positions.size == 0);
+}
+
+
+// -----------------------------------------------------------------------------
+// POLYLINE TESSELLATION
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Polyline Tessellation", "[basic]")
+{
+    CrtAllocator allocator;
+
+    ShapeBatcher batcher;
+    init(batcher, &allocator);
+    defer(deinit(batcher));
+
+    const Mat4     identity = HMM_Mat4d(1.0f);
+    const ShapeKey key      = {};
+    const u32      abgr     = 0xff00ff00;
+
+    const auto add = [&](const Vec2* points, u32 count, u16 flags)
+    {
+        reset(batcher);
+
+        add_polyline(batcher, key, identity, points, count, 2.0f, 1.0f, flags, abgr, &allocator, nullptr);
+
+        return polyline_layout(count, flags, shape_segments(1.0f) / 2);
+    };
+
+    const auto require_near = [](const Vec3& v, f32 x, f32 y)
+    {
+        REQUIRE(bx::abs(v.X - x) < 1e-4f);
+        REQUIRE(bx::abs(v.Y - y) < 1e-4f);
+    };
+
+    // Right angle, turning left, so the outer side is on the right.
+    const Vec2 corner[] = { { 0, 0 }, { 10, 0 }, { 10, 10 } };
+
+    SECTION("Vertex Counts")
+    {
+        add(corner, 3, LINE_JOIN_MITER | LINE_CAP_BUTT);
+        REQUIRE(batcher.positions.size == 2 * 8 + 7 + 2 * 8);
+        REQUIRE(batcher.indices  .size == 2 * 18 + 18 + 2 * 18);
+
+        add(corner, 3, LINE_JOIN_BEVEL | LINE_CAP_SQUARE);
+        REQUIRE(batcher.positions.size == 2 * 8 + 7 + 2 * 12);
+        REQUIRE(batcher.indices  .size == 2 * 18 + 18 + 2 * 36);
+
+        const PolylineLayout round = add(corner, 3, LINE_JOIN_ROUND | LINE_CAP_ROUND);
+        const u32            arc   = round.arc_segments;
+        REQUIRE(batcher.positions.size == 2 * 8 + 3 * (1 + (arc + 1) * 2));
+        REQUIRE(batcher.indices  .size == 2 * 18 + 3 * arc * 9);
+
+        const Vec2 square[] = { { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 } };
+
+        add(square, 4, LINE_CLOSED);
+        REQUIRE(batcher.positions.size == 4 * 8 + 4 * 7);
+        REQUIRE(batcher.indices  .size == 4 * 18 + 4 * 18);
+    }
+
+    SECTION("Join Geometry")
+    {
+        // Join follows the segments (8 vertices each), its tip is vertex 2,
+        // and the tip of the fringe is vertex 6.
+        add(corner, 3, LINE_JOIN_MITER);
+        require_near(batcher.positions[16 + 2], 11.0f, -1.0f);
+        require_near(batcher.positions[16 + 6], 12.0f, -2.0f);
+        REQUIRE(batcher.attribs[16 + 2].abgr == abgr);
+        REQUIRE(batcher.attribs[16 + 6].abgr == (abgr & 0x00ffffff));
+
+        add(corner, 3, LINE_JOIN_BEVEL);
+        require_near(batcher.positions[16 + 2], 10.5f, -0.5f);
+
+        // Sharp angle exceeds the miter limit and gets beveled.
+        const Vec2 sharp[] = { { 0, 0 }, { 10, 0 }, { 0, 1 } };
+
+        add(sharp, 3, LINE_JOIN_MITER);
+
+        const Vec3& a = batcher.positions[16 + 1];
+        const Vec3& b = batcher.positions[16 + 4];
+        require_near(batcher.positions[16 + 2], (a.X + b.X) * 0.5f, (a.Y + b.Y) * 0.5f);
+
+        // Round join's arc stays at the half width from the corner.
+        const PolylineLayout round = add(corner, 3, LINE_JOIN_ROUND);
+
+        for (u32 i = 0; i <= round.arc_segments; i++)
+        {
+            const Vec3 offset = batcher.positions[16 + 1 + i] - HMM_Vec3(10.0f, 0.0f, 0.0f);
+            REQUIRE(bx::abs(HMM_LengthVec3(offset) - 1.0f) < 1e-4f);
+            REQUIRE(offset.X >= -1e-4f);
+            REQUIRE(offset.Y <=  1e-4f);
+        }
+    }
+
+    SECTION("Chunking")
+    {
+        DynamicArray<Vec2> points;
+        init(points, &allocator);
+        defer(deinit(points));
+
+        for (u32 i = 0; i < 20000; i++)
+        {
+            append(points, HMM_Vec2(f32(i), f32(i % 2)));
+        }
+
+        const PolylineLayout layout = add(points.data, points.size, LINE_JOIN_MITER);
+        REQUIRE(layout.chunk_count > 1);
+        REQUIRE(batcher.runs.size == layout.chunk_count);
+
+        // Every vertex is written and every index stays within its run.
+        for (u32 i = 0; i < batcher.attribs.size; i++)
+        {
+            REQUIRE((batcher.attribs[i].abgr | 0xff000000) == abgr);
+        }
+
+        for (u32 i = 0; i < batcher.runs.size; i++)
+        {
+            const ShapeRun& run = batcher.runs[i];
+
+            for (u32 j = 0; j < run.index_count; j++)
+            {
+                REQUIRE(batcher.indices[run.first_index + j] < run.vertex_count);
+            }
+        }
+    }
+
+    SECTION("Parallel Tessellation")
+    {
+        DynamicArray<Vec2> points;
+        init(points, &allocator);
+        defer(deinit(points));
+
+        for (u32 i = 0; i < 20000; i++)
+        {
+            append(points, HMM_Vec2(f32(i), f32(i % 3)));
+        }
+
+        ShapeBatcher parallel;
+        init(parallel, &allocator);
+        defer(deinit(parallel));
+
+        enki::TaskScheduler scheduler;
+        scheduler.Initialize(4);
+
+        const u16 flags[] =
+        {
+            LINE_JOIN_MITER | LINE_CAP_SQUARE,
+            LINE_JOIN_ROUND | LINE_CAP_ROUND,
+            LINE_JOIN_BEVEL | LINE_CLOSED,
+        };
+
+        for (u32 i = 0; i < BX_COUNTOF(flags); i++)
+        {
+            const PolylineLayout layout = add(points.data, points.size, flags[i]);
+            REQUIRE(layout.segment_count >= POLYLINE_TASK_SEGMENTS * 2);
+
+            reset(parallel);
+            add_polyline(parallel, key, identity, points.data, points.size, 2.0f, 1.0f, flags[i], abgr, &allocator, &scheduler);
+
+            REQUIRE(batcher.positions.size == parallel.positions.size);
+            REQUIRE(batcher.attribs  .size == parallel.attribs  .size);
+            REQUIRE(batcher.indices  .size == parallel.indices  .size);
+
+            REQUIRE(0 == bx::memCmp(batcher.positions.data, parallel.positions.data, batcher.positions.size * sizeof(Vec3        )));
+            REQUIRE(0 == bx::memCmp(batcher.attribs  .data, parallel.attribs  .data, batcher.attribs  .size * sizeof(ShapeAttribs)));
+            REQUIRE(0 == bx::memCmp(batcher.indices  .data, parallel.indices  .data, batcher.indices  .size * sizeof(u16         )));
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// MATRIX STACK
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Matrix Stack", "[basic]")
+{
+    MatrixStack<4> stack;
+    init(stack);
+
+    // Projective top, so that the W row takes part too.
+    stack.top =
+        HMM_Perspective(60.0f, 1.5f, 0.1f, 100.0f) *
+        HMM_LookAt(HMM_Vec3(1.0f, 2.0f, 3.0f), HMM_Vec3(0.0f, 0.0f, 0.0f), HMM_Vec3(0.0f, 1.0f, 0.0f));
+
+    // Sign-magnitude bit patterns mapped onto a monotonic integer line, so
+    // that the difference counts the representable floats in between.
+    const auto ulp_distance = [](f32 a, f32 b)
+    {
+        const auto ordered = [](f32 x)
+        {
+            u32 bits;
+            bx::memCopy(&bits, &x, sizeof(bits));
+
+            return (bits & 0x80000000u) ? -i64(bits & 0x7fffffffu) : i64(bits);
+        };
+
+        const i64 distance = ordered(a) - ordered(b);
+
+        return distance < 0 ? -distance : distance;
+    };
+
+    const auto require_close = [&](const Mat4& actual, const Mat4& expected, i64 max_ulps)
+    {
+        for (u32 i = 0; i < 16; i++)
+        {
+            const f32 a = actual  .Elements[i / 4][i % 4];
+            const f32 b = expected.Elements[i / 4][i % 4];
+
+            REQUIRE(ulp_distance(a, b) <= max_ulps);
+        }
+    };
+
+    const Mat4 top = stack.top;
+
+    SECTION("Translation")
+    {
+        translate_top(stack, 1.0f, -2.0f, 3.0f);
+
+        // A single multiply-add per element, which may or may not get fused.
+        require_close(stack.top, HMM_Translate(HMM_Vec3(1.0f, -2.0f, 3.0f)) * top, 1);
+    }
+
+    SECTION("Scale")
+    {
+        scale_top(stack, 2.0f, 3.0f, 0.5f);
+        require_close(stack.top, HMM_Scale(HMM_Vec3(2.0f, 3.0f, 0.5f)) * top, 0);
+    }
+
+    SECTION("Rotation")
+    {
+        const Vec3 axes[] =
+        {
+            HMM_Vec3(1.0f, 0.0f, 0.0f),
+            HMM_Vec3(0.0f, 1.0f, 0.0f),
+            HMM_Vec3(0.0f, 0.0f, 1.0f),
+        };
+
+        for (u32 i = 0; i < 3; i++)
+        {
+            stack.top = top;
+            rotate_top(stack, i, 33.0f);
+
+            // HMM computes the diagonal ones as `(1 - cos) + cos`, and mixing
+            // of the two rows may get fused.
+            require_close(stack.top, HMM_Rotate(33.0f, axes[i]) * top, 4);
+        }
+    }
+
+    SECTION("Generic Product")
+    {
+        const Mat4 matrix = HMM_Rotate(20.0f, HMM_Vec3(1.0f, 2.0f, 3.0f));
+
+        multiply_top(stack, matrix);
+
+        // Same summation order, but HMM's scalar fallback can get contracted
+        // into FMAs, and the dot products partially cancel out.
+        require_close(stack.top, matrix * top, 16);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// TRANSFORM HIERARCHY
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Transform Hierarchy", "[basic]")
+{
+    CrtAllocator allocator;
+
+    NodeHierarchy hierarchy;
+    init(hierarchy, &allocator);
+    defer(deinit(hierarchy));
+
+    const auto require_near = [](const Mat4& a, const Mat4& b)
+    {
+        for (u32 i = 0; i < 16; i++)
+        {
+            REQUIRE(bx::abs(a.Elements[i / 4][i % 4] - b.Elements[i / 4][i % 4]) < 1e-5f);
+        }
+    };
+
+    SECTION("Matrix Product")
+    {
+        const Mat4 a = HMM_Perspective(60.0f, 1.5f, 0.1f, 100.0f) * HMM_Translate(HMM_Vec3(1.0f, 2.0f, 3.0f));
+        const Mat4 b = HMM_Rotate(30.0f, HMM_Vec3(1.0f, 1.0f, 0.0f)) * HMM_Scale(HMM_Vec3(2.0f, 3.0f, 4.0f));
+
+        require_near(multiply(a, b), a * b);
+        require_near(multiply(b, a), b * a);
+    }
+
+    SECTION("World Matrices")
+    {
+        // Parent with higher ID than its child, grandchild in between.
+        set_parent(hierarchy, 5, NODE_ROOT);
+        set_parent(hierarchy, 1, 5);
+        set_parent(hierarchy, 3, 1);
+
+        hierarchy.translations[5] = HMM_Vec3(1.0f, 0.0f, 0.0f);
+        hierarchy.rotations   [1] = HMM_QuaternionFromAxisAngle(HMM_Vec3(0.0f, 0.0f, 1.0f), HMM_ToRadians(90.0f));
+        hierarchy.translations[3] = HMM_Vec3(1.0f, 0.0f, 0.0f);
+        hierarchy.scales      [3] = HMM_Vec3(2.0f, 2.0f, 2.0f);
+
+        update(hierarchy, nullptr);
+
+        REQUIRE(hierarchy.levels.size == 4);
+        REQUIRE(hierarchy.order[0] == 5);
+        REQUIRE(hierarchy.order[1] == 1);
+        REQUIRE(hierarchy.order[2] == 3);
+        REQUIRE(!is_valid(hierarchy, 0));
+
+        require_near(
+            hierarchy.worlds[3],
+            HMM_Translate(HMM_Vec3(1.0f, 0.0f, 0.0f)) *
+            HMM_Rotate(90.0f, HMM_Vec3(0.0f, 0.0f, 1.0f)) *
+            HMM_Translate(HMM_Vec3(1.0f, 0.0f, 0.0f)) *
+            HMM_Scale(HMM_Vec3(2.0f, 2.0f, 2.0f))
+        );
+
+        // Only the changed node's subtree gets recomputed.
+        hierarchy.translations[1]  = HMM_Vec3(0.0f, 1.0f, 0.0f);
+        hierarchy.flags       [1] |= NODE_LOCAL_DIRTY;
+
+        update(hierarchy, nullptr);
+
+        REQUIRE(hierarchy.flags[5] == 0);
+        REQUIRE(hierarchy.flags[1] == NODE_WORLD_CHANGED);
+        REQUIRE(hierarchy.flags[3] == NODE_WORLD_CHANGED);
+
+        const Vec4 origin = hierarchy.worlds[3] * HMM_Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        REQUIRE(bx::abs(origin.X - 1.0f) < 1e-5f);
+        REQUIRE(bx::abs(origin.Y - 2.0f) < 1e-5f);
+
+        // Reparenting to the root.
+        set_parent(hierarchy, 3, NODE_ROOT);
+        update(hierarchy, nullptr);
+
+        REQUIRE(hierarchy.levels.size == 3);
+        REQUIRE(hierarchy.worlds[3].Elements[3][0] == 1.0f);
+        REQUIRE(hierarchy.worlds[3].Elements[3][1] == 0.0f);
+    }
+
+    SECTION("Parallel Update")
+    {
+        NodeHierarchy sequential;
+        init(sequential, &allocator);
+        defer(deinit(sequential));
+
+        constexpr u32 count = 3 * NODE_TASK_SIZE * 3;
+
+        for (NodeHierarchy* target : { &hierarchy, &sequential })
+        {
+            for (u32 i = 0; i < count; i++)
+            {
+                // Three levels, each wide enough to be split.
+                set_parent(*target, i, i < count / 3 ? NODE_ROOT : i - count / 3);
+
+                target->translations[i] = HMM_Vec3(f32(i % 7), f32(i % 5), f32(i % 3));
+                target->rotations   [i] = HMM_QuaternionFromAxisAngle(HMM_Vec3(0.0f, 1.0f, 0.0f), f32(i) * 0.01f);
+            }
+        }
+
+        enki::TaskScheduler scheduler;
+        scheduler.Initialize(4);
+
+        update(hierarchy , &scheduler);
+        update(sequential, nullptr   );
+
+        REQUIRE(hierarchy.levels.size == 4);
+        REQUIRE(0 == bx::memCmp(hierarchy.worlds.data, sequential.worlds.data, count * sizeof(Mat4)));
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// PARTICLE SIMULATION
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Particle Simulation", "[basic]")
+{
+    CrtAllocator allocator;
+
+    constexpr f32 dt = 1.0f / 60.0f;
+
+    ParticleEmitter emitter;
+    defer(deinit(emitter));
+
+    const auto simulate = [&](ParticleEmitter& target, u32 steps, enki::TaskScheduler* scheduler)
+    {
+        for (u32 i = 0; i < steps; i++)
+        {
+            update(target, dt, scheduler);
+        }
+    };
+
+    SECTION("Fixed Steps")
+    {
+        // Single particle, respawned only after it expires.
+        reset(emitter, &allocator, 1, 1);
+        emitter.rate          = 60.0f;
+        emitter.lifetime_min  = 0.21f;
+        emitter.lifetime_max  = 0.21f;
+        emitter.velocity_base = HMM_Vec3(1.0f, 2.0f, 0.0f);
+        emitter.acceleration  = HMM_Vec3(0.0f, -10.0f, 0.0f);
+        bake(emitter);
+
+        constexpr u32 steps = 12;
+
+        simulate(emitter, steps, nullptr);
+        REQUIRE(emitter.count == 1);
+
+        // Semi-implicit Euler, the velocity is updated first.
+        const f32 t = steps * dt;
+        const f32 y = 2.0f * t - 10.0f * dt * dt * (steps * (steps + 1) / 2);
+
+        REQUIRE(bx::abs(emitter.age        [0] - t                ) < 1e-4f);
+        REQUIRE(bx::abs(emitter.position[0][0] - t                ) < 1e-4f);
+        REQUIRE(bx::abs(emitter.position[1][0] - y                ) < 1e-4f);
+        REQUIRE(bx::abs(emitter.velocity[1][0] - (2.0f - 10.0f * t)) < 1e-4f);
+        REQUIRE(emitter.position[2][0] == 0.0f);
+
+        // Expires after the 13th step, replaced in the 14th one.
+        simulate(emitter, 2, nullptr);
+        REQUIRE(emitter.count == 1);
+        REQUIRE(bx::abs(emitter.age[0] - dt) < 1e-6f);
+        REQUIRE(bx::abs(emitter.position[1][0] - 2.0f * dt + 10.0f * dt * dt) < 1e-6f);
+    }
+
+    SECTION("Curves And Instances")
+    {
+        reset(emitter, &allocator, 1, 1);
+        emitter.rate         = 60.0f;
+        emitter.lifetime_min = 1.0f;
+        emitter.lifetime_max = 1.0f;
+        add_key(emitter.curves[PARTICLE_SIZE], 1.0f, HMM_Vec4(3.0f, 3.0f, 3.0f, 3.0f));
+        add_key(emitter.curves[PARTICLE_SIZE], 0.0f, HMM_Vec4(1.0f, 1.0f, 1.0f, 1.0f));
+        add_key(emitter.curves[PARTICLE_CURVE_COLOR], 0.5f, HMM_Vec4(1.0f, 0.0f, 0.0f, 0.5f));
+        bake(emitter);
+
+        const ParticleCurve& size = emitter.curves[PARTICLE_SIZE];
+        REQUIRE(size.samples[0].X == 1.0f);
+        REQUIRE(size.samples[PARTICLE_CURVE_SAMPLES - 1].X == 3.0f);
+        REQUIRE(bx::abs(size.samples[PARTICLE_CURVE_SAMPLES / 2].X - 2.0f) < 0.05f);
+
+        simulate(emitter, 30, nullptr);
+
+        Vec4 data[2];
+        write_instances(emitter, HMM_Translate(HMM_Vec3(5.0f, 0.0f, 0.0f)), reinterpret_cast<u8*>(data), 0, 1);
+
+        REQUIRE(data[0].X == 5.0f);
+        REQUIRE(bx::abs(data[0].W - 2.0f) < 0.05f);
+        REQUIRE(data[1].R == 1.0f);
+        REQUIRE(data[1].G == 0.0f);
+        REQUIRE(data[1].A == 0.5f);
+    }
+
+    SECTION("Determinism")
+    {
+        const auto define = [&](ParticleEmitter& target, u32 seed)
+        {
+            reset(target, &allocator, 20000, seed);
+            target.rate          = 12000.0f;
+            target.lifetime_min  = 0.5f;
+            target.lifetime_max  = 1.5f;
+            target.velocity_base = HMM_Vec3(0.0f, 5.0f, 0.0f);
+            target.spread        = 1.0f;
+            target.acceleration  = HMM_Vec3(0.0f, -10.0f, 0.0f);
+            add_key(target.curves[PARTICLE_SPEED], 1.0f, HMM_Vec4(0.5f, 0.5f, 0.5f, 0.5f));
+            bake(target);
+        };
+
+        const auto equal = [](const ParticleEmitter& a, const ParticleEmitter& b)
+        {
+            if (a.count != b.count)
+            {
+                return false;
+            }
+
+            const u32 size = a.count * sizeof(f32);
+
+            return
+                0 == bx::memCmp(a.position[0], b.position[0], size) &&
+                0 == bx::memCmp(a.position[1], b.position[1], size) &&
+                0 == bx::memCmp(a.position[2], b.position[2], size) &&
+                0 == bx::memCmp(a.velocity[0], b.velocity[0], size) &&
+                0 == bx::memCmp(a.velocity[1], b.velocity[1], size) &&
+                0 == bx::memCmp(a.velocity[2], b.velocity[2], size) &&
+                0 == bx::memCmp(a.age        , b.age        , size) &&
+                0 == bx::memCmp(a.lifetime   , b.lifetime   , size) ;
+        };
+
+        enki::TaskScheduler scheduler;
+        scheduler.Initialize(4);
+
+        ParticleEmitter parallel;
+        defer(deinit(parallel));
+
+        define(emitter , 1234);
+        define(parallel, 1234);
+
+        simulate(emitter , 120, nullptr);
+        simulate(parallel, 120, &scheduler);
+
+        REQUIRE(emitter.count >= PARTICLE_TASK_SIZE * 2);
+        REQUIRE(equal(emitter, parallel));
+
+        define(parallel, 4321);
+        simulate(parallel, 120, &scheduler);
+
+        REQUIRE(!equal(emitter, parallel));
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// MESH SKINNING
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Mesh Skinning", "[basic]")
+{
+    CrtAllocator allocator;
+
+    constexpr u32 vertex_count = SKIN_TASK_SIZE * 3 + 17;
+
+    DynamicArray<u8> positions;
+    init(positions, &allocator);
+    defer(deinit(positions));
+
+    DynamicArray<u8> vertices;
+    init(vertices, &allocator);
+    defer(deinit(vertices));
+
+    DynamicArray<u32> remap_table;
+    init(remap_table, &allocator);
+    defer(deinit(remap_table));
+
+    resize(positions  , vertex_count * sizeof(Vec3));
+    resize(vertices   , vertex_count * sizeof(SkinVertex));
+    resize(remap_table, vertex_count);
+
+    const Mat4 joints[] =
+    {
+        HMM_Mat4d(1.0f),
+        HMM_Translate(HMM_Vec3(1.0f, 2.0f, 3.0f)) * HMM_Rotate(45.0f, HMM_Vec3(0.0f, 1.0f, 0.0f)),
+        HMM_Rotate(-30.0f, HMM_Vec3(1.0f, 0.0f, 1.0f)) * HMM_Scale(HMM_Vec3(2.0f, 0.5f, 1.0f)),
+        HMM_Translate(HMM_Vec3(-4.0f, 0.0f, 1.0f)),
+    };
+
+    u32 random_state = 1;
+
+    for (u32 i = 0; i < vertex_count; i++)
+    {
+        SkinVertex& vertex = reinterpret_cast<SkinVertex*>(vertices.data)[i];
+
+        reinterpret_cast<Vec3*>(positions.data)[i] = HMM_Vec3(
+            random_range(random_state, -1.0f, 1.0f),
+            random_range(random_state, -1.0f, 1.0f),
+            random_range(random_state, -1.0f, 1.0f)
+        );
+
+        f32 sum = 0.0f;
+
+        for (u32 j = 0; j < 4; j++)
+        {
+            vertex.joints [j] = u8((i + j) % BX_COUNTOF(joints));
+            vertex.weights[j] = (i + j) % 3 ? random_unit(random_state) : 0.0f;
+            sum              += vertex.weights[j];
+        }
+
+        for (u32 j = 0; j < 4; j++)
+        {
+            vertex.weights[j] = sum > 0.0f ? vertex.weights[j] / sum : 0.25f;
+        }
+
+        remap_table[i] = i;
+    }
+
+    SkinnedMesh skin = {};
+    init(
+        skin, &allocator, vertex_count, vertex_count, remap_table.data,
+        positions, vertices, {}, nullptr
+    );
+    defer(deinit(skin));
+
+    REQUIRE(skin.joint_count == BX_COUNTOF(joints));
+
+    // Scalar reference, blending the transformed positions.
+    const auto reference = [&](u32 i)
+    {
+        const SkinVertex& vertex = skin.vertices[i];
+
+        Vec4 result = HMM_Vec4(0.0f, 0.0f, 0.0f, 0.0f);
+
+        for (u32 j = 0; j < 4; j++)
+        {
+            result += (joints[vertex.joints[j]] * HMM_Vec4v(skin.positions[i], 1.0f)) * vertex.weights[j];
+        }
+
+        return result.XYZ;
+    };
+
+    const auto require_near = [&](const Vec3* skinned)
+    {
+        for (u32 i = 0; i < vertex_count; i++)
+        {
+            const Vec3 expected = reference(i);
+
+            REQUIRE(HMM_EpsilonEqualVec3(skinned[i], expected, 1e-5f * bx::max(1.0f, HMM_LengthVec3(expected))));
+        }
+    };
+
+    DynamicArray<Vec3> skinned;
+    init(skinned, &allocator);
+    defer(deinit(skinned));
+    resize(skinned, vertex_count);
+
+    bx::simd128_t bounds[8];
+    REQUIRE(skin_chunk_count(skin) * 2 <= BX_COUNTOF(bounds));
+
+    SECTION("Reference")
+    {
+        skin_vertices(skin, joints, skinned.data, nullptr, bounds, nullptr);
+
+        require_near(skinned.data);
+
+        for (u32 i = 0; i < vertex_count; i++)
+        {
+            const bx::simd128_t* chunk = bounds + i / SKIN_TASK_SIZE * 2;
+
+            REQUIRE(skinned[i].X >= bx::simd_x(chunk[0]));
+            REQUIRE(skinned[i].Y >= bx::simd_y(chunk[0]));
+            REQUIRE(skinned[i].Z >= bx::simd_z(chunk[0]));
+            REQUIRE(skinned[i].X <= bx::simd_x(chunk[1]));
+            REQUIRE(skinned[i].Y <= bx::simd_y(chunk[1]));
+            REQUIRE(skinned[i].Z <= bx::simd_z(chunk[1]));
+        }
+    }
+
+    SECTION("Parallel")
+    {
+        enki::TaskScheduler scheduler;
+        scheduler.Initialize(4);
+
+        skin_vertices(skin, joints, skinned.data, nullptr, bounds, &scheduler);
+
+        require_near(skinned.data);
+
+        DynamicArray<Vec3> sequential;
+        init(sequential, &allocator);
+        defer(deinit(sequential));
+        resize(sequential, vertex_count);
+
+        bx::simd128_t sequential_bounds[8];
+        skin_vertices(skin, joints, sequential.data, nullptr, sequential_bounds, nullptr);
+
+        REQUIRE(0 == bx::memCmp(skinned.data, sequential.data, vertex_count * sizeof(Vec3)));
+        REQUIRE(0 == bx::memCmp(bounds, sequential_bounds, skin_chunk_count(skin) * 2 * sizeof(bx::simd128_t)));
+    }
+}
+
+TEST_CASE("Skinned Mesh Recording", "[basic]")
+{
+    bgfx::Init init_desc;
+    init_desc.type = bgfx::RendererType::Noop;
+
+    REQUIRE(bgfx::init(init_desc));
+    defer(bgfx::shutdown());
+
+    CrtAllocator allocator;
+
+    constexpr u32 stack_size = 1_MB;
+
+    void* stack_buffer = BX_ALIGNED_ALLOC(&allocator, stack_size, 16);
+    defer(BX_ALIGNED_FREE(&allocator, stack_buffer, 16));
+
+    StackAllocator stack_allocator;
+    init(stack_allocator, stack_buffer, stack_size);
+
+    VertexLayoutCache layouts;
+    init(layouts);
+    defer(deinit(layouts));
+
+    ReleaseQueue release_queue;
+    init(release_queue, &allocator);
+    defer(deinit(release_queue));
+
+    MeshCache cache;
+    init(cache, &allocator, 2);
+    defer(deinit(cache));
+
+    MeshRecorder recorder;
+    init(recorder, &stack_allocator);
+    defer(deinit(recorder));
+
+    const Mat4 joints[] =
+    {
+        HMM_Mat4d(1.0f),
+        HMM_Translate(HMM_Vec3(1.0f, 2.0f, 3.0f)) * HMM_Rotate(45.0f, HMM_Vec3(0.0f, 1.0f, 0.0f)),
+        HMM_Rotate(-30.0f, HMM_Vec3(1.0f, 0.0f, 1.0f)),
+        HMM_Translate(HMM_Vec3(-4.0f, 0.0f, 1.0f)) * HMM_Rotate(90.0f, HMM_Vec3(0.0f, 0.0f, 1.0f)),
+    };
+
+    // Everything stored for a grid corner is a function of its coordinates, so
+    // the duplicates of the shared corners get merged.
+    constexpr u32 grid = 4;
+
+    const auto corner_normal = [](u32 x, u32 y)
+    {
+        return HMM_NormalizeVec3(HMM_Vec3(f32(x) - 2.0f, f32(y) - 2.0f, 1.0f));
+    };
+
+    const auto corner_influences = [](u32 x, u32 y)
+    {
+        SkinVertex vertex;
+        vertex.joints [0] = u8(x % 4);
+        vertex.joints [1] = u8(y % 4);
+        vertex.weights[0] = 0.25f * f32(x % 4 + 1);
+        vertex.weights[1] = 1.0f - vertex.weights[0];
+        vertex.weights[2] = 0.0f;
+        vertex.weights[3] = 0.0f;
+
+        return vertex;
+    };
+
+    RecordInfo info;
+    info.flags = MESH_DYNAMIC | PRIMITIVE_QUADS | VERTEX_NORMAL | VERTEX_SKINNED;
+    info.id    = 1;
+    info.type  = RecordType::MESH;
+
+    start(recorder, info.flags);
+
+    for (u32 i = 0; i < grid * grid; i++)
+    {
+        const u32 corners[][2] =
+        {
+            { i % grid    , i / grid     },
+            { i % grid    , i / grid + 1 },
+            { i % grid + 1, i / grid + 1 },
+            { i % grid + 1, i / grid     },
+        };
+
+        for (u32 j = 0; j < BX_COUNTOF(corners); j++)
+        {
+            const u32  x = corners[j][0];
+            const u32  y = corners[j][1];
+            const Vec3 n = corner_normal(x, y);
+
+            (*recorder.attrib_state.store_normal)(recorder.attrib_state, n.X, n.Y, n.Z);
+            recorder.skin_state = corner_influences(x, y);
+
+            (*recorder.store_vertex)(HMM_Vec3(f32(x), f32(y), 0.0f), recorder.attrib_state, recorder);
+        }
+    }
+
+    REQUIRE(recorder.vertex_count == grid * grid * 6);
+
+    add_mesh(cache, release_queue, info, recorder, layouts, &stack_allocator);
+
+    end(recorder);
+
+    const SkinnedMesh& skinned_mesh = cache.skins[1];
+
+    REQUIRE(skinned_mesh.vertex_count  == (grid + 1) * (grid + 1));
+    REQUIRE(skinned_mesh.joint_count   == BX_COUNTOF(joints));
+    REQUIRE(skinned_mesh.attribs       != nullptr);
+    REQUIRE(skinned_mesh.attrib_stride == vertex_layout(layouts, info.flags).getStride());
+
+    // The remapped streams still agree with each other.
+    for (u32 i = 0; i < skinned_mesh.vertex_count; i++)
+    {
+        const Vec3& position = skinned_mesh.positions[i];
+        const u32   x        = u32(position.X);
+        const u32   y        = u32(position.Y);
+
+        const SkinVertex expected = corner_influences(x, y);
+
+        REQUIRE(0 == bx::memCmp(&skinned_mesh.vertices[i], &expected, sizeof(SkinVertex)));
+
+        f32 unpacked[3];
+        bx::unpackRgb8(unpacked, skinned_mesh.attribs + i * skinned_mesh.attrib_stride + skinned_mesh.normal_offset);
+
+        const Vec3 normal = HMM_Vec3(unpacked[0], unpacked[1], unpacked[2]) * 2.0f - HMM_Vec3(1.0f, 1.0f, 1.0f);
+
+        REQUIRE(HMM_EpsilonEqualVec3(normal, corner_normal(x, y), 2.0f / 255.0f));
+    }
+
+    // Scalar reference, blending the transformed positions and normals.
+    const auto reference = [&](u32 i, Vec3& position, Vec3& normal)
+    {
+        const SkinVertex& vertex = skinned_mesh.vertices[i];
+
+        f32 unpacked[3];
+        bx::unpackRgb8(unpacked, skinned_mesh.attribs + i * skinned_mesh.attrib_stride + skinned_mesh.normal_offset);
+
+        const Vec4 bind_normal = HMM_Vec4(unpacked[0] * 2.0f - 1.0f, unpacked[1] * 2.0f - 1.0f, unpacked[2] * 2.0f - 1.0f, 0.0f);
+
+        Vec4 p = HMM_Vec4(0.0f, 0.0f, 0.0f, 0.0f);
+        Vec4 n = HMM_Vec4(0.0f, 0.0f, 0.0f, 0.0f);
+
+        for (u32 j = 0; j < 4; j++)
+        {
+            p += (joints[vertex.joints[j]] * HMM_Vec4v(skinned_mesh.positions[i], 1.0f)) * vertex.weights[j];
+            n += (joints[vertex.joints[j]] * bind_normal) * vertex.weights[j];
+        }
+
+        position = p.XYZ;
+        normal   = HMM_NormalizeVec3(n.XYZ);
+    };
+
+    SECTION("Normals")
+    {
+        DynamicArray<Vec3> positions;
+        init(positions, &allocator);
+        defer(deinit(positions));
+        resize(positions, skinned_mesh.vertex_count);
+
+        DynamicArray<u8> attribs;
+        init(attribs, &allocator);
+        defer(deinit(attribs));
+        resize(attribs, skinned_mesh.vertex_count * skinned_mesh.attrib_stride);
+
+        bx::simd128_t bounds[2];
+        skin_vertices(skinned_mesh, joints, positions.data, attribs.data, bounds, nullptr);
+
+        for (u32 i = 0; i < skinned_mesh.vertex_count; i++)
+        {
+            Vec3 position;
+            Vec3 normal;
+            reference(i, position, normal);
+
+            REQUIRE(HMM_EpsilonEqualVec3(positions[i], position, 1e-5f * bx::max(1.0f, HMM_LengthVec3(position))));
+
+            f32 unpacked[3];
+            bx::unpackRgb8(unpacked, attribs.data + i * skinned_mesh.attrib_stride + skinned_mesh.normal_offset);
+
+            const Vec3 skinned = HMM_Vec3(unpacked[0], unpacked[1], unpacked[2]) * 2.0f - HMM_Vec3(1.0f, 1.0f, 1.0f);
+
+            REQUIRE(HMM_EpsilonEqualVec3(skinned, normal, 2.0f / 255.0f));
+        }
+    }
+
+    SECTION("Mesh Cache")
+    {
+        skin(cache, 1, &joints[0].Elements[0][0], BX_COUNTOF(joints), &allocator, nullptr);
+
+        Vec3 bounds_min = HMM_Vec3( FLT_MAX,  FLT_MAX,  FLT_MAX);
+        Vec3 bounds_max = HMM_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+        for (u32 i = 0; i < skinned_mesh.vertex_count; i++)
+        {
+            Vec3 position;
+            Vec3 normal;
+            reference(i, position, normal);
+
+            bounds_min = HMM_Vec3(bx::min(bounds_min.X, position.X), bx::min(bounds_min.Y, position.Y), bx::min(bounds_min.Z, position.Z));
+            bounds_max = HMM_Vec3(bx::max(bounds_max.X, position.X), bx::max(bounds_max.Y, position.Y), bx::max(bounds_max.Z, position.Z));
+        }
+
+        const Mesh& mesh = cache.meshes[1];
+
+        REQUIRE(HMM_EpsilonEqualVec3(mesh.bounds_min, bounds_min, 1e-4f));
+        REQUIRE(HMM_EpsilonEqualVec3(mesh.bounds_max, bounds_max, 1e-4f));
+        REQUIRE(bx::abs(mesh.bounds_radius - HMM_LengthVec3(bounds_max - bounds_min) * 0.5f) < 1e-4f);
+
+        // Too few joints leave the mesh as it was.
+        cache.meshes[1].bounds_radius = 0.0f;
+
+        skin(cache, 1, &joints[0].Elements[0][0], BX_COUNTOF(joints) - 1, &allocator, nullptr);
+
+        REQUIRE(cache.meshes[1].bounds_radius == 0.0f);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// PROCEDURAL PRIMITIVES
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Procedural Primitives", "[basic]")
+{
+    CrtAllocator allocator;
+
+    constexpr u32 stack_size = 16_MB;
+
+    void* stack_buffer = BX_ALIGNED_ALLOC(&allocator, stack_size, 16);
+    defer(BX_ALIGNED_FREE(&allocator, stack_buffer, 16));
+
+    StackAllocator stack_allocator;
+    init(stack_allocator, stack_buffer, stack_size);
+
+    DynamicArray<u8> memory;
+    init(memory, &allocator);
+    defer(deinit(memory));
+
+    // Checks the counts, the bounds, and that the faces agree with the normals
+    // (and point away from the center, if the primitive is convex).
+    const auto check = [&](const PrimitiveSize& size, bool convex, const auto& generate)
+    {
+        const u32 positions_size = size.vertex_count * sizeof(Vec3);
+        const u32 normals_size   = size.vertex_count * sizeof(PackedNormal);
+
+        resize(memory, positions_size + normals_size + size.index_count * sizeof(u32));
+
+        PrimitiveWriter writer;
+        init(writer, VERTEX_NORMAL, HMM_Mat4d(1.0f));
+
+        writer.index32   = size.vertex_count > U16_MAX;
+        writer.positions = reinterpret_cast<Vec3*>(memory.data);
+        writer.attribs   = memory.data + positions_size;
+        writer.indices   = memory.data + positions_size + normals_size;
+
+        generate(writer);
+
+        REQUIRE(writer.vertex_count == size.vertex_count);
+        REQUIRE(writer.index_count  == size.index_count );
+
+        REQUIRE(writer.bounds_min.X >= -0.5f - 1e-6f);
+        REQUIRE(writer.bounds_min.Y >= -0.5f - 1e-6f);
+        REQUIRE(writer.bounds_min.Z >= -0.5f - 1e-6f);
+        REQUIRE(writer.bounds_max.X <=  0.5f + 1e-6f);
+        REQUIRE(writer.bounds_max.Y <=  0.5f + 1e-6f);
+        REQUIRE(writer.bounds_max.Z <=  0.5f + 1e-6f);
+
+        // NOTE : Counting the failures, so that large meshes don't take ages.
+        u32 failures = 0;
+
+        for (u32 i = 0; i < writer.index_count; i += 3)
+        {
+            u32 indices[3];
+
+            for (u32 j = 0; j < 3; j++)
+            {
+                indices[j] = writer.index32
+                    ? reinterpret_cast<const u32*>(writer.indices)[i + j]
+                    : reinterpret_cast<const u16*>(writer.indices)[i + j];
+            }
+
+            if (indices[0] >= writer.vertex_count ||
+                indices[1] >= writer.vertex_count ||
+                indices[2] >= writer.vertex_count)
+            {
+                failures++;
+                continue;
+            }
+
+            const Vec3& a = writer.positions[indices[0]];
+            const Vec3& b = writer.positions[indices[1]];
+            const Vec3& c = writer.positions[indices[2]];
+            const Vec3  n = HMM_Cross(b - a, c - a);
+
+            f32 normal[3];
+            bx::unpackRgb8(normal, writer.attribs + indices[0] * sizeof(PackedNormal));
+
+            failures += HMM_LengthSquaredVec3(n) <= 0.0f;
+            failures += HMM_DotVec3(n, HMM_Vec3(normal[0] - 0.5f, normal[1] - 0.5f, normal[2] - 0.5f)) <= 0.0f;
+            failures += convex && HMM_DotVec3(n, a + b + c) <= 0.0f;
+        }
+
+        REQUIRE(failures == 0);
+    };
+
+    SECTION("Flat")
+    {
+        check(box_size()      , true , [&](PrimitiveWriter& writer) { generate_box  (writer); });
+        check(plane_size(3, 2), false, [&](PrimitiveWriter& writer) { generate_plane(writer, 3, 2); });
+    }
+
+    SECTION("Round")
+    {
+        check(sphere_size(16, 8)  , true , [&](PrimitiveWriter& writer) { generate_sphere  (writer, 16, 8); });
+        check(cylinder_size(16)   , true , [&](PrimitiveWriter& writer) { generate_cylinder(writer, 16); });
+        check(cone_size(16)       , true , [&](PrimitiveWriter& writer) { generate_cone    (writer, 16); });
+        check(torus_size(24, 12)  , false, [&](PrimitiveWriter& writer) { generate_torus   (writer, 0.2f, 24, 12); });
+        check(capsule_size(16, 4) , true , [&](PrimitiveWriter& writer) { generate_capsule (writer, 0.25f, 16, 4); });
+    }
+
+    SECTION("Icosphere")
+    {
+        for (u32 i = 0; i <= MAX_ICOSPHERE_SUBDIVISIONS; i++)
+        {
+            check(icosphere_size(i), true, [&](PrimitiveWriter& writer)
+            {
+                generate_icosphere(writer, i, &stack_allocator);
+            });
+        }
+
+        REQUIRE(icosphere_size(MAX_ICOSPHERE_SUBDIVISIONS).vertex_count > U16_MAX);
+    }
+}
+
+TEST_CASE("2D Vertex Positions", "[basic]")
+{
+    SECTION("Layout Index")
+    {
+        const u32 position    = vertex_layout_index(VERTEX_POSITION);
+        const u32 position_2d = vertex_layout_index(VERTEX_POSITION_2D);
+
+        REQUIRE(position    != position_2d);
+        REQUIRE(position_2d <  512);
+
+        for (u32 attribs = VERTEX_COLOR; attribs <= VERTEX_ATTRIB_MASK; attribs += VERTEX_COLOR)
+        {
+            REQUIRE(vertex_layout_index(attribs) != position_2d);
+        }
+    }
+
+    SECTION("Default Programs")
+    {
+        for (u32 i = 0; i < BX_COUNTOF(s_default_program_info); i++)
+        {
+            const u32 index = default_program_index(s_default_program_info[i].attribs);
+
+            REQUIRE(index < 256);
+
+            for (u32 j = 0; j < i; j++)
+            {
+                REQUIRE(index != default_program_index(s_default_program_info[j].attribs));
+            }
+        }
+
+        REQUIRE(
+            default_program_index(VERTEX_COLOR) !=
+            default_program_index(VERTEX_COLOR | VERTEX_POSITION_2D)
+        );
+
+        // Every mesh program (including the instancing one) has a 2D variant.
+        for (u32 i = 0; i < BX_COUNTOF(s_default_program_info); i++)
+        {
+            const u32 attribs = s_default_program_info[i].attribs;
+
+            if (attribs & (VERTEX_POSITION_2D | BILLBOARD_MESH))
+            {
+                continue;
+            }
+
+            const u32 index = default_program_index(attribs | VERTEX_POSITION_2D);
+            bool      found = false;
+
+            for (u32 j = 0; j < BX_COUNTOF(s_default_program_info); j++)
+            {
+                found |= default_program_index(s_default_program_info[j].attribs) == index;
+            }
+
+            REQUIRE(found);
+        }
+    }
+
+    SECTION("Recording")
+    {
+        CrtAllocator allocator;
+
+        MeshRecorder recorder;
+        init(recorder, &allocator);
+        defer(deinit(recorder));
+
+        start(recorder, PRIMITIVE_QUADS | VERTEX_COLOR | VERTEX_POSITION_2D);
+        defer(end(recorder));
+
+        const Mat4 transform =
+            HMM_Translate(HMM_Vec3(10.0f, 20.0f, 0.0f)) *
+            HMM_Rotate(90.0f, HMM_Vec3(0.0f, 0.0f, 1.0f)) *
+            HMM_Scale(HMM_Vec3(2.0f, 2.0f, 1.0f));
+
+        const Vec2 corners[] =
+        {
+            HMM_Vec2(0.0f, 0.0f),
+            HMM_Vec2(0.0f, 1.0f),
+            HMM_Vec2(1.0f, 1.0f),
+            HMM_Vec2(1.0f, 0.0f),
+        };
+
+        for (u32 i = 0; i < BX_COUNTOF(corners); i++)
+        {
+            const Vec3 affine = transform_affine_2d(transform, corners[i].X, corners[i].Y);
+            const Vec3 full   = (transform * HMM_Vec4(corners[i].X, corners[i].Y, 0.0f, 1.0f)).XYZ;
+
+            REQUIRE(bx::abs(affine.X - full.X) < 1e-5f);
+            REQUIRE(bx::abs(affine.Y - full.Y) < 1e-5f);
+
+            (*recorder.attrib_state.store_color)(recorder.attrib_state, 0xff0000ff);
+            (*recorder.store_vertex)(affine, recorder.attrib_state, recorder);
+        }
+
+        // Quads are emulated with two triangles.
+        REQUIRE(recorder.vertex_count         == 6);
+        REQUIRE(recorder.position_buffer.size == 6 * sizeof(Vec2));
+        REQUIRE(recorder.attrib_buffer.size   == 6 * sizeof(PackedColor));
+
+        const Vec2* positions = reinterpret_cast<const Vec2*>(recorder.position_buffer.data);
+
+        REQUIRE(positions[3].X == positions[0].X);
+        REQUIRE(positions[3].Y == positions[0].Y);
+        REQUIRE(positions[4].X == positions[2].X);
+        REQUIRE(positions[4].Y == positions[2].Y);
+
+        REQUIRE(bx::abs(bx::simd_x(recorder.bounds_min) -  8.0f) < 1e-5f);
+        REQUIRE(bx::abs(bx::simd_y(recorder.bounds_min) - 20.0f) < 1e-5f);
+        REQUIRE(bx::abs(bx::simd_x(recorder.bounds_max) - 10.0f) < 1e-5f);
+        REQUIRE(bx::abs(bx::simd_y(recorder.bounds_max) - 22.0f) < 1e-5f);
+
+        REQUIRE(bx::simd_z(recorder.bounds_min) == 0.0f);
+        REQUIRE(bx::simd_z(recorder.bounds_max) == 0.0f);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// VERTEX INTERLEAVING
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Interleaved Vertices", "[basic]")
+{
+    bgfx::Init init_desc;
+    init_desc.type = bgfx::RendererType::Noop;
+
+    REQUIRE(bgfx::init(init_desc));
+    defer(bgfx::shutdown());
+
+    CrtAllocator allocator;
+
+    constexpr u32 stack_size = 1_MB;
+
+    void* stack_buffer = BX_ALIGNED_ALLOC(&allocator, stack_size, 16);
+    defer(BX_ALIGNED_FREE(&allocator, stack_buffer, 16));
+
+    StackAllocator stack_allocator;
+    init(stack_allocator, stack_buffer, stack_size);
+
+    VertexLayoutCache layouts;
+    init(layouts);
+    defer(deinit(layouts));
+
+    constexpr u32 flags = MESH_STATIC | PRIMITIVE_QUADS | VERTEX_COLOR | VERTEX_NORMAL | VERTEX_TEXCOORD;
+
+    const bgfx::VertexLayout& position_layout    = vertex_layout(layouts, VERTEX_POSITION);
+    const bgfx::VertexLayout& attrib_layout      = vertex_layout(layouts, flags);
+    const bgfx::VertexLayout& interleaved_layout = vertex_layout(layouts, flags | VERTEX_INTERLEAVED);
+
+    const bgfx::Attrib::Enum attrib_types[] =
+    {
+        bgfx::Attrib::Color0,
+        bgfx::Attrib::Normal,
+        bgfx::Attrib::TexCoord0,
+    };
+
+    SECTION("Layout")
+    {
+        REQUIRE(interleaved_layout.has(bgfx::Attrib::Position));
+        REQUIRE(interleaved_layout.getOffset(bgfx::Attrib::Position) == 0);
+        REQUIRE(interleaved_layout.getStride() == position_layout.getStride() + attrib_layout.getStride());
+
+        // Attributes keep their order, just shifted by the position.
+        for (u32 i = 0; i < BX_COUNTOF(attrib_types); i++)
+        {
+            REQUIRE(interleaved_layout.has(attrib_types[i]));
+            REQUIRE(
+                interleaved_layout.getOffset(attrib_types[i]) ==
+                attrib_layout.getOffset(attrib_types[i]) + position_layout.getStride()
+            );
+        }
+    }
+
+    SECTION("Remapping")
+    {
+        ReleaseQueue release_queue;
+        init(release_queue, &allocator);
+        defer(deinit(release_queue));
+
+        MeshCache cache;
+        init(cache, &allocator, 2);
+        defer(deinit(cache));
+
+        MeshRecorder recorder;
+        init(recorder, &stack_allocator);
+        defer(deinit(recorder));
+
+        RecordInfo info;
+        info.flags = flags | VERTEX_INTERLEAVED;
+        info.id    = 1;
+        info.type  = RecordType::MESH;
+
+        start(recorder, info.flags);
+
+        // Every attribute is a function of the grid corner, so the duplicates
+        // of the shared corners get merged.
+        constexpr u32 grid = 4;
+
+        for (u32 i = 0; i < grid * grid; i++)
+        {
+            const u32 corners[][2] =
+            {
+                { i % grid    , i / grid     },
+                { i % grid    , i / grid + 1 },
+                { i % grid + 1, i / grid + 1 },
+                { i % grid + 1, i / grid     },
+            };
+
+            for (u32 j = 0; j < BX_COUNTOF(corners); j++)
+            {
+                const u32 x = corners[j][0];
+                const u32 y = corners[j][1];
+
+                (*recorder.attrib_state.store_color   )(recorder.attrib_state, (x << 24) | (y << 16) | 0xff);
+                (*recorder.attrib_state.store_normal  )(recorder.attrib_state, 0.25f * f32(x), -0.25f * f32(y), 1.0f);
+                (*recorder.attrib_state.store_texcoord)(recorder.attrib_state, 0.25f * f32(x), 0.25f * f32(y));
+
+                (*recorder.store_vertex)(HMM_Vec3(f32(x), f32(y), 0.0f), recorder.attrib_state, recorder);
+            }
+        }
+
+        REQUIRE(recorder.vertex_count == grid * grid * 6);
+
+        // Same merging of the streams as done by `add_mesh`.
+        DynamicArray<u8> interleaved;
+        init(interleaved, &allocator);
+        defer(deinit(interleaved));
+
+        interleave_vertices(
+            recorder.position_buffer, position_layout.getStride(),
+            recorder.attrib_buffer  , attrib_layout  .getStride(),
+            interleaved
+        );
+
+        REQUIRE(interleaved.size == recorder.vertex_count * interleaved_layout.getStride());
+
+        const meshopt_Stream stream = { interleaved.data, interleaved_layout.getStride(), interleaved_layout.getStride() };
+
+        DynamicArray<u32> remap_table;
+        init(remap_table, &allocator);
+        defer(deinit(remap_table));
+
+        resize(remap_table, recorder.vertex_count);
+
+        const u32 indexed_vertex_count = u32(meshopt_generateVertexRemap(
+            remap_table.data, nullptr, recorder.vertex_count, stream.data,
+            recorder.vertex_count, stream.size
+        ));
+
+        REQUIRE(indexed_vertex_count == (grid + 1) * (grid + 1));
+
+        void* remapped = nullptr;
+
+        const VertexBufferUnion buffer = create_persistent_vertex_buffer(
+            MESH_STATIC, stream, interleaved_layout, recorder.vertex_count,
+            indexed_vertex_count, remap_table.data, &stack_allocator, &remapped
+        );
+        defer(bgfx::destroy(buffer.static_buffer));
+
+        REQUIRE(bgfx::isValid(buffer.static_buffer));
+        REQUIRE(remapped != nullptr);
+
+        // Each remapped interleaved vertex decodes to the same values as the
+        // recorded vertex in the two separate streams.
+        for (u32 i = 0; i < recorder.vertex_count; i++)
+        {
+            const u32 index = remap_table[i];
+
+            REQUIRE(index < indexed_vertex_count);
+
+            f32 expected[4] = {};
+            f32 actual  [4] = {};
+
+            bgfx::vertexUnpack(expected, bgfx::Attrib::Position, position_layout   , recorder.position_buffer.data, i    );
+            bgfx::vertexUnpack(actual  , bgfx::Attrib::Position, interleaved_layout, remapped                     , index);
+
+            REQUIRE(expected[0] == actual[0]);
+            REQUIRE(expected[1] == actual[1]);
+            REQUIRE(expected[2] == actual[2]);
+
+            for (u32 j = 0; j < BX_COUNTOF(attrib_types); j++)
+            {
+                bgfx::vertexUnpack(expected, attrib_types[j], attrib_layout     , recorder.attrib_buffer.data, i    );
+                bgfx::vertexUnpack(actual  , attrib_types[j], interleaved_layout, remapped                   , index);
+
+                REQUIRE(0 == bx::memCmp(expected, actual, sizeof(expected)));
+            }
+        }
+
+        add_mesh(cache, release_queue, info, recorder, layouts, &stack_allocator);
+
+        end(recorder);
+
+        const Mesh& mesh = cache.meshes[1];
+
+        REQUIRE( (mesh.flags & VERTEX_INTERLEAVED));
+        REQUIRE(!has_attrib_stream(mesh.flags));
+        REQUIRE( bgfx::isValid(mesh.positions.static_buffer));
+        REQUIRE(!bgfx::isValid(mesh.attribs  .static_buffer));
+    }
+
+    SECTION("Vertex Alias")
+    {
+        const u32 aliases[] =
+        {
+            VERTEX_COLOR,
+            VERTEX_NORMAL,
+            VERTEX_TEXCOORD,
+            VERTEX_COLOR | VERTEX_TEXCOORD,
+            VERTEX_COLOR | VERTEX_NORMAL | VERTEX_TEXCOORD,
+        };
+
+        const u32 attrib_flags[] =
+        {
+            VERTEX_COLOR,
+            VERTEX_NORMAL,
+            VERTEX_TEXCOORD,
+        };
+
+        for (u32 i = 0; i < BX_COUNTOF(aliases); i++)
+        {
+            // Same conversion as done by `mesh_multi`.
+            const u32 mesh_flags = flags | VERTEX_INTERLEAVED;
+            const u32 skips      = vertex_layout_skips(mesh_flags, aliases[i]);
+
+            const bgfx::VertexLayout& alias_layout = vertex_layout(layouts, mesh_flags & ~skips, skips);
+
+            // The alias must fit the single stream, position included.
+            REQUIRE(alias_layout.getStride() == interleaved_layout.getStride());
+            REQUIRE(alias_layout.has(bgfx::Attrib::Position));
+            REQUIRE(alias_layout.getOffset(bgfx::Attrib::Position) == 0);
+
+            for (u32 j = 0; j < BX_COUNTOF(attrib_types); j++)
+            {
+                if (skips & attrib_flags[j])
+                {
+                    REQUIRE(!alias_layout.has(attrib_types[j]));
+                }
+                else
+                {
+                    REQUIRE(alias_layout.has(attrib_types[j]));
+                    REQUIRE(alias_layout.getOffset(attrib_types[j]) == interleaved_layout.getOffset(attrib_types[j]));
+                }
+            }
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// ENCODERS
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Encoder Exhaustion", "[basic]")
+{
+    // Only the main thread's encoder, so none is left for the other threads.
+    bgfx::Init init_desc;
+    init_desc.type               = bgfx::RendererType::Noop;
+    init_desc.limits.maxEncoders = 1;
+
+    REQUIRE(bgfx::init(init_desc));
+    defer(bgfx::shutdown());
+
+    ThreadLocalContext ctx;
+    ctx.is_main_thread = false;
+
+    REQUIRE(!acquire_encoder(ctx));
+    REQUIRE(ctx.encoder_failed);
+
+    // Failure is remembered till the end of the frame, when the flag is reset.
+    REQUIRE(!acquire_encoder(ctx));
+
+    ctx.encoder_failed = false;
+
+    ThreadLocalContext main_ctx;
+    main_ctx.is_main_thread = true;
+
+    REQUIRE(acquire_encoder(main_ctx));
+    REQUIRE(!main_ctx.encoder_failed);
+
+    bgfx::end(main_ctx.encoder);
+}
+
+
 // -----------------------------------------------------------------------------
 // MESH RECORDING
 // -----------------------------------------------------------------------------
@@ -342,6 +2833,475 @@ TEST_CASE("Mesh Recording", "[benchmark]")
     }
 }
 
+TEST_CASE("Procedural Primitives", "[benchmark]")
+{
+    CrtAllocator allocator;
+
+    constexpr u32 stack_size = 32_MB;
+
+    void* stack_buffer = BX_ALIGNED_ALLOC(&allocator, stack_size, 16);
+    defer(BX_ALIGNED_FREE(&allocator, stack_buffer, 16));
+
+    StackAllocator stack_allocator;
+    init(stack_allocator, stack_buffer, stack_size);
+
+    // Same resolution as the torus in the mesh recording benchmark.
+    constexpr u32 segments  = 250;
+    constexpr u32 sides     = 100;
+    constexpr f32 thickness = 0.15f;
+    constexpr u32 flags     = VERTEX_NORMAL;
+
+    const PrimitiveSize size = torus_size(segments, sides);
+
+    DynamicArray<u8> memory;
+    init(memory, &allocator);
+    defer(deinit(memory));
+
+    resize(memory, size.vertex_count * (sizeof(Vec3) + sizeof(PackedNormal)) + size.index_count * sizeof(u32));
+
+    // What `end_mesh` does on the CPU, minus the buffer creation.
+    const auto remap = [&](const MeshRecorder& recorder)
+    {
+        const meshopt_Stream streams[] =
+        {
+            { recorder.position_buffer.data, sizeof(Vec3)             , sizeof(Vec3)              },
+            { recorder.attrib_buffer  .data, recorder.attrib_state.size, recorder.attrib_state.size },
+        };
+
+        u32* remap_table = static_cast<u32*>(BX_ALLOC(&stack_allocator, recorder.vertex_count * sizeof(u32)));
+        u32* indices     = static_cast<u32*>(BX_ALLOC(&stack_allocator, recorder.vertex_count * sizeof(u32)));
+        u8*  vertices    = static_cast<u8* >(BX_ALLOC(&stack_allocator, recorder.vertex_count * sizeof(Vec3)));
+
+        const u32 indexed_vertex_count = u32(meshopt_generateVertexRemapMulti(
+            remap_table, nullptr, recorder.vertex_count, recorder.vertex_count, streams, BX_COUNTOF(streams)
+        ));
+
+        meshopt_remapIndexBuffer(indices, nullptr, recorder.vertex_count, remap_table);
+        meshopt_remapVertexBuffer(vertices, streams[0].data, recorder.vertex_count, streams[0].size, remap_table);
+        meshopt_remapVertexBuffer(vertices, streams[1].data, recorder.vertex_count, streams[1].size, remap_table);
+
+        BX_FREE(&stack_allocator, vertices);
+        BX_FREE(&stack_allocator, indices);
+        BX_FREE(&stack_allocator, remap_table);
+
+        return indexed_vertex_count;
+    };
+
+    BENCHMARK("Per-Vertex Recording")
+    {
+        MeshRecorder recorder;
+        init(recorder, &stack_allocator);
+        defer(deinit(recorder));
+
+        start(recorder, PRIMITIVE_QUADS | flags);
+        defer(end(recorder));
+
+        const auto torus_vertex = [&](u32 i, u32 j)
+        {
+            const f32 u = HMM_PI32 * 2.0f * f32(i) / f32(segments);
+            const f32 v = HMM_PI32 * 2.0f * f32(j) / f32(sides   );
+
+            const Vec3 normal = HMM_Vec3(cosf(v) * cosf(u), -sinf(v), -cosf(v) * sinf(u));
+            const Vec3 center = HMM_Vec3(0.5f * cosf(u), 0.0f, -0.5f * sinf(u));
+
+            (*recorder.attrib_state.store_normal)(recorder.attrib_state, normal.X, normal.Y, normal.Z);
+            (*recorder.store_vertex)(center + normal * thickness, recorder.attrib_state, recorder);
+        };
+
+        for (u32 j = 0; j < sides   ; j++)
+        for (u32 i = 0; i < segments; i++)
+        {
+            torus_vertex(i    , j    );
+            torus_vertex(i    , j + 1);
+            torus_vertex(i + 1, j + 1);
+            torus_vertex(i + 1, j    );
+        }
+
+        return remap(recorder);
+    };
+
+    BENCHMARK("Procedural Generator")
+    {
+        PrimitiveWriter writer;
+        init(writer, flags, HMM_Mat4d(1.0f));
+
+        writer.positions = reinterpret_cast<Vec3*>(memory.data);
+        writer.attribs   = memory.data + size.vertex_count * sizeof(Vec3);
+        writer.indices   = memory.data + size.vertex_count * (sizeof(Vec3) + sizeof(PackedNormal));
+
+        generate_torus(writer, thickness, segments, sides);
+
+        return writer.vertex_count;
+    };
+}
+
+TEST_CASE("Interleaved Vertex Stream", "[benchmark]")
+{
+    bgfx::Init init_desc;
+    init_desc.type = bgfx::RendererType::Noop;
+
+    REQUIRE(bgfx::init(init_desc));
+    defer(bgfx::shutdown());
+
+    CrtAllocator allocator;
+
+    constexpr u32 stack_size = 4_MB;
+
+    void* stack_buffer = BX_ALIGNED_ALLOC(&allocator, stack_size, 16);
+    defer(BX_ALIGNED_FREE(&allocator, stack_buffer, 16));
+
+    StackAllocator stack_allocator;
+    init(stack_allocator, stack_buffer, stack_size);
+
+    VertexLayoutCache layouts;
+    init(layouts);
+    defer(deinit(layouts));
+
+    DefaultPrograms programs;
+    init(programs, bgfx::RendererType::Noop);
+    defer(deinit(programs));
+
+    DefaultUniforms uniforms;
+    init(uniforms);
+    defer(deinit(uniforms));
+
+    ReleaseQueue release_queue;
+    init(release_queue, &allocator);
+    defer(deinit(release_queue));
+
+    MeshCache cache;
+    init(cache, &allocator, 3);
+    defer(deinit(cache));
+
+    MeshRecorder recorder;
+    init(recorder, &stack_allocator);
+    defer(deinit(recorder));
+
+    constexpr u32 flags = MESH_STATIC | PRIMITIVE_QUADS | VERTEX_COLOR | VERTEX_NORMAL;
+
+    // The same 16x16 grid, once with two streams and once interleaved.
+    for (u16 id = 1; id <= 2; id++)
+    {
+        RecordInfo info;
+        info.flags = flags | (id == 2 ? VERTEX_INTERLEAVED : 0);
+        info.id    = id;
+        info.type  = RecordType::MESH;
+
+        start(recorder, info.flags);
+
+        for (u32 i = 0; i < 16 * 16; i++)
+        {
+            const f32 x = f32(i % 16);
+            const f32 y = f32(i / 16);
+
+            (*recorder.attrib_state.store_color )(recorder.attrib_state, 0xff0000ff + (i << 8));
+            (*recorder.attrib_state.store_normal)(recorder.attrib_state, 0.0f, 0.0f, 1.0f);
+
+            (*recorder.store_vertex)(HMM_Vec3(x       , y       , 0.0f), recorder.attrib_state, recorder);
+            (*recorder.store_vertex)(HMM_Vec3(x       , y + 1.0f, 0.0f), recorder.attrib_state, recorder);
+            (*recorder.store_vertex)(HMM_Vec3(x + 1.0f, y + 1.0f, 0.0f), recorder.attrib_state, recorder);
+            (*recorder.store_vertex)(HMM_Vec3(x + 1.0f, y       , 0.0f), recorder.attrib_state, recorder);
+        }
+
+        add_mesh(cache, release_queue, info, recorder, layouts, &stack_allocator);
+
+        end(recorder);
+    }
+
+    const Mesh& separate    = cache.meshes[1];
+    const Mesh& interleaved = cache.meshes[2];
+
+    REQUIRE( bgfx::isValid(separate   .attribs.static_buffer));
+    REQUIRE(!bgfx::isValid(interleaved.attribs.static_buffer));
+
+    REQUIRE(
+        vertex_layout(layouts, flags | VERTEX_INTERLEAVED).getStride() ==
+        vertex_layout(layouts, VERTEX_POSITION).getStride() + vertex_layout(layouts, flags).getStride()
+    );
+
+    DrawState state;
+    state.pass    = 0;
+    state.program = default_program(programs, flags);
+
+    const FixedArray<bgfx::TransientVertexBuffer, 1> transient_buffers = {};
+
+    // Only the vertex buffer bindings differ, the rest of the state is shadowed.
+    const auto submit = [&](const Mesh& mesh)
+    {
+        constexpr u32 count = 10000;
+
+        bgfx::Encoder* encoder = bgfx::begin();
+
+        EncoderShadow shadow;
+
+        for (u32 i = 0; i < count; i++)
+        {
+            submit_mesh(mesh, HMM_Mat4d(1.0f), state, transient_buffers, uniforms, shadow, *encoder);
+        }
+
+        encoder->discard();
+        bgfx::end(encoder);
+
+        return bgfx::frame();
+    };
+
+    BENCHMARK("Separate Streams")
+    {
+        return submit(separate);
+    };
+
+    BENCHMARK("Interleaved Stream")
+    {
+        return submit(interleaved);
+    };
+}
+
+TEST_CASE("Shape Batching", "[benchmark]")
+{
+    bgfx::Init init_desc;
+    init_desc.type = bgfx::RendererType::Noop;
+
+    REQUIRE(bgfx::init(init_desc));
+    defer(bgfx::shutdown());
+
+    CrtAllocator allocator;
+
+    constexpr u32 stack_size = 1_MB;
+
+    void* stack_buffer = BX_ALIGNED_ALLOC(&allocator, stack_size, 16);
+    defer(BX_ALIGNED_FREE(&allocator, stack_buffer, 16));
+
+    StackAllocator stack_allocator;
+    init(stack_allocator, stack_buffer, stack_size);
+
+    VertexLayoutCache layouts;
+    init(layouts);
+    defer(deinit(layouts));
+
+    DefaultPrograms programs;
+    init(programs, bgfx::RendererType::Noop);
+    defer(deinit(programs));
+
+    DefaultUniforms uniforms;
+    init(uniforms);
+    defer(deinit(uniforms));
+
+    ReleaseQueue release_queue;
+    init(release_queue, &allocator);
+    defer(deinit(release_queue));
+
+    MeshCache mesh_cache;
+    init(mesh_cache, &allocator, 2);
+    defer(deinit(mesh_cache));
+
+    // 10k sprites with 8 different textures spread over 4 layers.
+    constexpr u32 count    = 10000;
+    constexpr u32 textures = 8;
+    constexpr u32 layers   = 4;
+
+    Texture sprite_textures[textures];
+
+    for (u32 i = 0; i < textures; i++)
+    {
+        sprite_textures[i].handle = bgfx::createTexture2D(1, 1, false, 1, bgfx::TextureFormat::RGBA8);
+        sprite_textures[i].format = { bgfx::TextureFormat::RGBA8 };
+    }
+
+    defer(
+        for (u32 i = 0; i < textures; i++)
+        {
+            bgfx::destroy(sprite_textures[i].handle);
+        }
+    );
+
+    const Mat4 identity = HMM_Mat4d(1.0f);
+
+    const auto sprite_key = [&](u32 i)
+    {
+        return shape_key(0, u16(i % layers), &sprite_textures[i % textures], programs, uniforms, layouts);
+    };
+
+    ShapeBatcher batcher;
+    init(batcher, &allocator);
+    defer(deinit(batcher));
+
+    const auto add_sprites = [&]()
+    {
+        for (u32 i = 0; i < count; i++)
+        {
+            const f32 x = f32(i % 100) * 8.0f;
+            const f32 y = f32(i / 100) * 8.0f;
+
+            add_quad(batcher, sprite_key(i), identity, x, y, x + 8, y + 8, 0, 0, 1, 1, U32_MAX);
+        }
+    };
+
+    // One draw call per unique (layer, texture) pair, instead of one per sprite.
+    add_sprites();
+    REQUIRE(prepare(batcher) == textures * layers);
+    reset(batcher);
+
+    // Both paths go all the way to the end of the (Noop) frame, so the batched
+    // one pays for the tessellation, sorting and transient buffer upload, and
+    // the mesh one for the per-draw call state and BGFX's sorting of the draws.
+    BENCHMARK("Batched Shapes (32 draw calls)")
+    {
+        add_sprites();
+
+        bgfx::Encoder* encoder = bgfx::begin();
+
+        EncoderShadow shadow;
+        flush(batcher, mesh_cache, layouts, shadow, *encoder);
+
+        bgfx::end(encoder);
+
+        return bgfx::frame();
+    };
+
+    // The mesh path submits the same recorded quad once per sprite, as the
+    // transient meshes are limited to `MAX_TRANSIENT_BUFFERS` per frame.
+    {
+        MeshRecorder recorder;
+        init(recorder, &stack_allocator);
+        defer(deinit(recorder));
+
+        RecordInfo info;
+        info.flags = MESH_STATIC | PRIMITIVE_QUADS | VERTEX_COLOR | VERTEX_TEXCOORD;
+        info.id    = 1;
+        info.type  = RecordType::MESH;
+
+        start(recorder, info.flags);
+
+        for (u32 i = 0; i < 4; i++)
+        {
+            const f32 u = f32(i == 1 || i == 2);
+            const f32 v = f32(i >> 1);
+
+            (*recorder.attrib_state.store_color   )(recorder.attrib_state, U32_MAX);
+            (*recorder.attrib_state.store_texcoord)(recorder.attrib_state, u, v);
+
+            (*recorder.store_vertex)(HMM_Vec3(u * 8.0f, v * 8.0f, 0.0f), recorder.attrib_state, recorder);
+        }
+
+        add_mesh(mesh_cache, release_queue, info, recorder, layouts, &stack_allocator);
+
+        end(recorder);
+    }
+
+    const Mesh& sprite = mesh_cache.meshes[1];
+    REQUIRE(is_valid(sprite));
+
+    const FixedArray<bgfx::TransientVertexBuffer, 1> transient_buffers = {};
+
+    BENCHMARK("Mesh Submission (10000 draw calls)")
+    {
+        bgfx::Encoder* encoder = bgfx::begin();
+
+        EncoderShadow shadow;
+
+        for (u32 i = 0; i < count; i++)
+        {
+            const f32 x = f32(i % 100) * 8.0f;
+            const f32 y = f32(i / 100) * 8.0f;
+
+            const Texture& texture = sprite_textures[i % textures];
+
+            DrawState state;
+            state.pass    = 0;
+            state.depth   = i % layers;
+            state.texture = texture.handle;
+            state.sampler = default_sampler(uniforms, texture.format);
+            state.program = default_program(programs, VERTEX_COLOR | VERTEX_TEXCOORD);
+            state.flags   = SHAPE_DRAW_STATE;
+
+            submit_mesh(sprite, HMM_Translate(HMM_Vec3(x, y, 0.0f)), state, transient_buffers, uniforms, shadow, *encoder);
+        }
+
+        encoder->discard();
+        bgfx::end(encoder);
+
+        return bgfx::frame();
+    };
+}
+
+
+// -----------------------------------------------------------------------------
+// MATRIX STACK
+// -----------------------------------------------------------------------------
+
+TEST_CASE("Matrix Stack", "[benchmark]")
+{
+    // Typical per-mesh pattern, push, place, rotate, pop, for 10k meshes.
+    constexpr u32 count = 10000;
+
+    MatrixStack<4> stack;
+    init(stack);
+
+    stack.top = HMM_Perspective(60.0f, 1.5f, 0.1f, 100.0f);
+
+    BENCHMARK("Scalar")
+    {
+        f32 sum = 0.0f;
+
+        for (u32 i = 0; i < count; i++)
+        {
+            push(stack);
+
+            stack.top = HMM_Translate(HMM_Vec3(f32(i), 0.0f, 1.0f)) * stack.top;
+            stack.top = HMM_Rotate(f32(i), HMM_Vec3(0.0f, 1.0f, 0.0f)) * stack.top;
+            stack.top = HMM_Scale(HMM_Vec3(2.0f, 2.0f, 2.0f)) * stack.top;
+            sum      += stack.top.Elements[3][0];
+
+            pop(stack);
+        }
+
+        return sum;
+    };
+
+    BENCHMARK("SIMD")
+    {
+        f32 sum = 0.0f;
+
+        for (u32 i = 0; i < count; i++)
+        {
+            push(stack);
+
+            translate_top(stack, f32(i), 0.0f, 1.0f);
+            rotate_top(stack, 1, f32(i));
+            scale_top(stack, 2.0f, 2.0f, 2.0f);
+            sum += stack.top.Elements[3][0];
+
+            pop(stack);
+        }
+
+        return sum;
+    };
+
+    BENCHMARK("Scalar Product")
+    {
+        Mat4 matrix = stack.top;
+
+        for (u32 i = 0; i < count; i++)
+        {
+            matrix = stack.top * matrix;
+        }
+
+        return matrix.Elements[0][0];
+    };
+
+    BENCHMARK("SIMD Product")
+    {
+        Mat4 matrix = stack.top;
+
+        for (u32 i = 0; i < count; i++)
+        {
+            matrix = multiply(stack.top, matrix);
+        }
+
+        return matrix.Elements[0][0];
+    };
+}
+
 
 // -----------------------------------------------------------------------------
 // EXAMPLES - COMMON SETUP
@@ -0,0 +1,14 @@
+$input  a_position, i_data0, i_data1
+$output v_color0
+
+#include <bgfx_shader.sh>
+
+void main()
+{
+    // Center and size in `i_data0`, quad corner offset in view space.
+    vec4 center = mul(u_view, vec4(i_data0.xyz, 1.0));
+    center.xy  += a_position.xy * i_data0.w;
+
+    gl_Position = mul(u_proj, center);
+    v_color0    = i_data1;
+}
@@ -39,7 +39,7 @@ static void setup(void)
     for (int v = 0, i = 0; v < 3; v++     )
     for (int h = 0       ; h < 3; h++, i++)
     {
-        begin_text(TEXT_ID + i, ATLAS_ID, h_align[h] | v_align[v]);
+        begin_text(TEXT_ID + i, ATLAS_ID, h_align[h] | v_align[v] | TEXT_POSITION_2D);
         {
             color(0xffffffff);
             text